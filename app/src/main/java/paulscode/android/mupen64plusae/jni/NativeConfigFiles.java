@@ -95,6 +95,7 @@ class NativeConfigFiles
         mupen64plus_cfg.put( "Audio-Android", "SAMPLING_RATE", String.valueOf( global.audioSamplingRate) );
         mupen64plus_cfg.put( "Audio-Android", "SAMPLING_TYPE", String.valueOf( global.audioSamplingType) );
         mupen64plus_cfg.put( "Audio-Android", "TIME_STRETCH_ENABLED", boolToTF( global.enableAudioTimeSretching) );
+        mupen64plus_cfg.put( "Audio-Android", "DYNAMIC_RATE_CONTROL", boolToTF( global.audioDynamicRateControl) );
 
         // Nubia devices don't implement AAudio correctly
         mupen64plus_cfg.put( "Audio-Android", "FORCE_SLES", boolToTF(appData.manufacturer.toLowerCase().contains("nubia")) );
@@ -119,6 +120,10 @@ class NativeConfigFiles
         mupen64plus_cfg.put( "Core", "RandomizeInterrupt", String.valueOf(game.randomizeInterrupts ? 1 : 0) );
         mupen64plus_cfg.put( "Core", "CountPerScanlineOverride", usingNetplay ?String.valueOf(0) : String.valueOf( game.viRefreshRate ) );
         mupen64plus_cfg.put( "Core", "GbCameraVideoCaptureBackend1", "" );
+        mupen64plus_cfg.put( "Core", "ThreadedRspAudio", usingNetplay ? "False" : boolToTF( game.threadedRspAudio ) );
+        // The GL video plugins can only process display lists on the GL thread
+        mupen64plus_cfg.put( "Core", "ThreadedRsp", "False" );
+        mupen64plus_cfg.put( "Core", "SaveFlushInterval", String.valueOf( global.saveFlushInterval ) );
 
         mupen64plus_cfg.put( "CoreEvents", "Version", "1.000000" );
         mupen64plus_cfg.put( "CoreEvents", "Kbd Mapping Stop", EMPTY );
@@ -35,6 +35,7 @@ import paulscode.android.mupen64plusae.preference.PrefUtil;
 import paulscode.android.mupen64plusae.util.LocaleContextWrapper;
 
 import static paulscode.android.mupen64plusae.persistent.GlobalPrefs.AUDIO_SAMPLING_TYPE;
+import static paulscode.android.mupen64plusae.persistent.GlobalPrefs.AUDIO_TIME_STRETCH;
 
 public class AudioPrefsActivity extends AppCompatPreferenceActivity implements OnSharedPreferenceChangeListener {
     // App data and user preferences
@@ -102,8 +103,10 @@ public class AudioPrefsActivity extends AppCompatPreferenceActivity implements O
         // Refresh the preferences object
         mGlobalPrefs = new GlobalPrefs(this, mAppData);
 
-        // Enable audio prefs if audio is enabled
-        PrefUtil.enablePreference(this, AUDIO_SAMPLING_TYPE, !mGlobalPrefs.enableAudioTimeSretching);
+        // Dynamic rate control replaces time stretching and always uses the polyphase resampler
+        PrefUtil.enablePreference(this, AUDIO_TIME_STRETCH, !mGlobalPrefs.audioDynamicRateControl);
+        PrefUtil.enablePreference(this, AUDIO_SAMPLING_TYPE,
+                !mGlobalPrefs.enableAudioTimeSretching && !mGlobalPrefs.audioDynamicRateControl);
     }
 
     @Override
@@ -270,6 +270,9 @@ public class GamePrefs
     /** True if we should randomize interrupts in the core */
     public final boolean randomizeInterrupts;
 
+    /** True if audio tasks run on a separate thread while the R4300 keeps running */
+    public final boolean threadedRspAudio;
+
     /** This is true if we want to display built-in cheat codes */
     public final boolean showBuiltInCheatCodes;
 
@@ -636,6 +639,7 @@ public class GamePrefs
         forceAlignmentOfPiDma = mPreferences.getBoolean( "screenAdvancedforceAlignmentOfPiDma", true ) ? -1 : 0;
         ignoreTlbExceptions = mPreferences.getBoolean( "screenAdvancedignoreTlbExceptions", false );
         randomizeInterrupts = mPreferences.getBoolean( "screenAdvancedRandomizeInterrupts", true );
+        threadedRspAudio = mPreferences.getBoolean( "screenAdvancedThreadedRspAudio", false );
         showBuiltInCheatCodes = mPreferences.getBoolean( "showBuiltInCheatCodes", true );
     }
 
@@ -298,6 +298,9 @@ public class GlobalPrefs
     /** Stretch audio to prevent crackling in audio plugin */
     public final boolean enableAudioTimeSretching;
 
+    /** Adjust the resampling ratio to keep the audio buffer filled, replaces time stretching */
+    public final boolean audioDynamicRateControl;
+
     /** Size of hardware buffer in output samples. This is a hardware buffer size, which directly affects latency. */
     public final int audioHardwareBufferSize;
 
@@ -328,6 +331,9 @@ public class GlobalPrefs
     /** Maximum number of auto saves */
     public final int maxAutoSaves;
 
+    /** Milliseconds after which changed save data is written by a background thread, 0 to write it synchronously */
+    public final int saveFlushInterval;
+
     /** True if specific game data should be saved in a flat file structure */
     final boolean useFlatGameDataPath;
 
@@ -413,6 +419,7 @@ public class GlobalPrefs
     public static final String ROOM_TCP_PORT = "roomTcpPort";
     public static final String SERVER_UDP_TCP_PORT = "serverTcpUdpPort";
 
+    public static final String AUDIO_TIME_STRETCH = "audioTimeStretch";
     public static final String AUDIO_SAMPLING_TYPE = "audioSamplingType";
     public static final String AUDIO_LOW_PERFORMANCE_MODE = "lowPerformanceMode";
     // ... add more as needed
@@ -628,7 +635,8 @@ public class GlobalPrefs
         // Audio prefs
         AudioManager audioManager = (AudioManager) context.getSystemService(Context.AUDIO_SERVICE);
         audioSwapChannels = mPreferences.getBoolean( "audioSwapChannels", false );
-        enableAudioTimeSretching = mPreferences.getBoolean( "audioTimeStretch", true );
+        enableAudioTimeSretching = mPreferences.getBoolean( AUDIO_TIME_STRETCH, true );
+        audioDynamicRateControl = mPreferences.getBoolean( "audioDynamicRateControl", false );
         audioVolume = getSafeInt( mPreferences, "audioVolume", 100 );
         audioBufferSizeMs = getSafeInt( mPreferences, "audioBufferSize", 64 );
         audioFloatingPoint = mPreferences.getBoolean( "audioFloatingPoint", false );
@@ -692,6 +700,7 @@ public class GlobalPrefs
         final String inGameMenuMode = mPreferences.getString( "inGameMenu", "back-key" );
 
         maxAutoSaves = mPreferences.getInt( "gameAutoSaves", 5 );
+        saveFlushInterval = mPreferences.getInt( "gameSaveFlushInterval", 0 );
 
         useFlatGameDataPath = mPreferences.getBoolean( "useFlatGameDataPath", false );
 
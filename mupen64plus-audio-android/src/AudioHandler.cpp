@@ -1,4 +1,8 @@
 #include "AudioHandler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstring>
 #include <thread>
 
 void AudioHandler::DebugMessage(int level, const char *message, ...) {
@@ -22,9 +26,15 @@ AudioHandler &AudioHandler::get() {
 }
 
 AudioHandler::AudioHandler() :
-		mOutStream(nullptr),
-		mSoundBufferPool(1024 * 1024 * 50),
+		mAudioConsumerQueue(consumerQueueSize),
+		mResampler(resamplerInputFrames),
+		mOutput(AudioOutput::create()),
+		mSampleRing(sampleRingSize),
+		mDroppedFrames(0),
+		mRateControlReport{},
+		mRateControlReports(16),
 		mPlaybackPaused(false),
+		mResetRequested(false),
 		mFeedTimes{},
 		mGameTimes{},
 		mSamplesWaiting(0)
@@ -36,11 +46,10 @@ AudioHandler::AudioHandler() :
 }
 
 void AudioHandler::closeAudio() {
-	if (mOutStream != nullptr) {
-		mOutStream->stop();
-		mOutStream->close();
-		mOutStream = nullptr;
-	}
+	mOutput->close();
+	mStreamOpenSuccess = false;
+	logStatistics();
+
 	/* Delete working buffer */
 	if (mWorkingBuffer != nullptr) {
 		delete[] mWorkingBuffer;
@@ -87,37 +96,23 @@ void AudioHandler::initializeAudio(int _freq) {
 	/* Close everything because InitializeAudio can be called more than once */
 	closeAudio();
 
-	oboe::DefaultStreamValues::SampleRate = (int32_t) mOutputFreq;
-	oboe::DefaultStreamValues::FramesPerBurst = (int32_t) mHardwareBufferSize;
-
-	oboe::AudioStreamBuilder builder;
-	// The builder set methods can be chained for convenience.
-	builder.setSharingMode(oboe::SharingMode::Exclusive);
-	builder.setPerformanceMode(oboe::PerformanceMode::LowLatency);
-	builder.setChannelCount(numberOfChannels);
-	builder.setSampleRate(mOutputFreq);
-	//builder.setSampleRateConversionQuality(oboe::SampleRateConversionQuality::Fastest);
-
-	if (mForceSles != 0) {
-		builder.setAudioApi(oboe::AudioApi::OpenSLES);
-	}
-
+	AudioOutput::Settings settings;
+	settings.sampleRate = mOutputFreq;
+	settings.framesPerBurst = mHardwareBufferSize;
+	settings.channels = numberOfChannels;
 #ifdef FP_ENABLED
-	builder.setFormat(oboe::AudioFormat::Float);
+	settings.floatSamples = true;
 #else
-	builder.setFormat(oboe::AudioFormat::I16);
+	settings.floatSamples = false;
 #endif
+	settings.forceSles = mForceSles != 0;
 
-	builder.setCallback(this);
-	mStreamOpenSuccess = builder.openStream(mOutStream) == oboe::Result::OK;
+	mStreamOpenSuccess = mOutput->open(settings, this);
 	if (mStreamOpenSuccess) {
-
-		if (mOutStream->getAudioApi() == oboe::AudioApi::AAudio) {
-			mOutputFreq = mOutStream->getSampleRate();
-			mHardwareBufferSize = mOutStream->getFramesPerBurst();
-		}
-		DebugMessage(M64MSG_INFO, "Requesting frequency: %iHz and buffer size %d", mOutputFreq,
-					 mOutStream->getFramesPerBurst());
+		mOutputFreq = settings.sampleRate;
+		mHardwareBufferSize = settings.framesPerBurst;
+		DebugMessage(M64MSG_INFO, "Requesting frequency: %iHz and buffer size %d from %s output", mOutputFreq,
+					 mHardwareBufferSize, mOutput->getName());
 	}
 
 	/* Create working buffer */
@@ -131,10 +126,12 @@ void AudioHandler::initializeAudio(int _freq) {
 	mSoundTouch.setTempo(speedFactor);
 	mSoundTouch.setRate((double) mInputFreq / (double) mOutputFreq);
 
+	mResampler.setRates(mInputFreq, mOutputFreq * 100 / mSpeedFactor);
+
 	reset();
 
-	if (mOutStream != nullptr) {
-		mOutStream->requestStart();
+	if (mStreamOpenSuccess) {
+		mOutput->requestStart();
 	}
 }
 
@@ -145,7 +142,7 @@ void AudioHandler::pushData(const int16_t *_data, int _samples,
     }
 
 	static int failedToStartCount = 0;
-	if (mOutStream == nullptr || mOutStream->getState() != oboe::StreamState::Started) {
+	if (!mOutput->isStarted()) {
 
 		if (failedToStartCount++ == 100) {
 			mForceSles = 1;
@@ -156,18 +153,22 @@ void AudioHandler::pushData(const int16_t *_data, int _samples,
 		return;
 	}
 
-	unsigned int numBytes = _samples * numberOfChannels*sizeof(int16_t);
+	if (mDynamicRateControl) {
+		logRateControlReports();
+	}
 
-	PoolBufferPointer data = mSoundBufferPool.createPoolBuffer(
-			reinterpret_cast<const char *>(_data), numBytes);
+	auto samplesWritten = static_cast<unsigned int>(mSampleRing.write(_data, _samples));
 
-	//Add data to the queue
+	if (samplesWritten != static_cast<unsigned int>(_samples)) {
+		mDroppedFrames += _samples - samplesWritten;
+	}
+
+	//Describe the data for time stretching, losing a description only loses one timing sample
 	QueueData theQueueData;
-	theQueueData.data = data;
-	theQueueData.samples = _samples;
+	theQueueData.samples = samplesWritten;
 	theQueueData.timeSinceStart = timeSinceStart.count();
 
-	mAudioConsumerQueue.enqueue(theQueueData);
+	mAudioConsumerQueue.try_enqueue(theQueueData);
 }
 
 void AudioHandler::waitForBufferToClear()
@@ -182,8 +183,14 @@ void AudioHandler::waitForBufferToClear()
 	);
 }
 
-oboe::DataCallbackResult
-AudioHandler::onAudioReady(oboe::AudioStream *oboeStream, void *audioData, int32_t numFrames) {
+void AudioHandler::onAudioReady(void *audioData, int32_t numFrames) {
+
+	auto callbackStart = std::chrono::steady_clock::now();
+	bool dataWritten = true;
+
+	if (mResetRequested.exchange(false)) {
+		reset();
+	}
 
 	mPrimingTimeMs += static_cast<int>(static_cast<double>(numFrames) / mOutputFreq * 1000);
 
@@ -194,17 +201,28 @@ AudioHandler::onAudioReady(oboe::AudioStream *oboeStream, void *audioData, int32
 	if (mTimeStretchEnabled) {
 		if (!audioProviderStretch(audioData, numFrames)) {
 			injectSilence(audioData, numFrames);
+			dataWritten = false;
 		}
 	} else {
 		if (!mPrimeComplete) {
 			injectSilence(audioData, numFrames);
+			dataWritten = false;
 		} else if (!audioProviderNoStretch(audioData, numFrames)) {
 			injectSilence(audioData, numFrames);
+			dataWritten = false;
 			mPrimeComplete = false;
 			mPrimingTimeMs = 0;
+			++mStatistics.underruns;
+			++mRateControlReport.underruns;
 		}
 	}
-	return oboe::DataCallbackResult::Continue;
+
+	std::chrono::duration<double> callbackTime = std::chrono::steady_clock::now() - callbackStart;
+	++mStatistics.callbacks;
+	mStatistics.silentCallbacks += dataWritten ? 0 : 1;
+	mStatistics.totalTime += callbackTime.count();
+	mStatistics.maxTime = std::max(mStatistics.maxTime, callbackTime.count());
+	mStatistics.totalQueuedMs += static_cast<double>(mSamplesWaiting) / mOutputFreq * 1000.0;
 }
 
 bool AudioHandler::audioProviderStretch(void *outAudioData, int32_t outNumFrames) {
@@ -228,16 +246,9 @@ bool AudioHandler::audioProviderStretch(void *outAudioData, int32_t outNumFrames
 
 	int queueLength = static_cast<int>(static_cast<float>(mSoundTouch.numSamples())/static_cast<float>(mOutputFreq)*1000);
 
-	int workingBufferValidBytes = 0;
 	QueueData currQueueData;
 
 	while (mAudioConsumerQueue.try_dequeue(currQueueData)) {
-		auto shortData = reinterpret_cast<const int16_t *>(mSoundBufferPool.getBufferFromPool(
-				currQueueData.data));
-		workingBufferValidBytes = convertBufferToHwBuffer(shortData, currQueueData.samples, mWorkingBuffer,
-														  workingBufferValidBytes);
-		mSoundBufferPool.removeBufferFromPool(currQueueData.data);
-
 		//Figure out how much to slow down by
 		double timeDiff = currQueueData.timeSinceStart - prevTime;
 
@@ -264,6 +275,8 @@ bool AudioHandler::audioProviderStretch(void *outAudioData, int32_t outNumFrames
 		}
 	}
 
+	int workingBufferValidBytes = readSampleRing(0);
+
 	double bufferMultiplier = static_cast<double>(mOutputFreq) / mInputFreq;
 	double currentGameRate = mAverageGameTimeMs / mAverageFeedTimeMs;
 	int queueSizeOffset = static_cast<int>(mAverageGameTimeMs - defaultSampleLength);
@@ -346,18 +359,15 @@ bool AudioHandler::audioProviderStretch(void *outAudioData, int32_t outNumFrames
 
 bool AudioHandler::audioProviderNoStretch(void *audioData, int32_t numFrames) {
 
+	// Timing is only needed for time stretching
 	QueueData currQueueData;
-
 	while (mAudioConsumerQueue.try_dequeue(currQueueData)) {
-		auto shortData = reinterpret_cast<const int16_t *>(mSoundBufferPool.getBufferFromPool(
-				currQueueData.data));
-		mWorkingBufferValidBytes = convertBufferToHwBuffer(shortData, currQueueData.samples, mWorkingBuffer,
-														   mWorkingBufferValidBytes);
-		mSoundBufferPool.removeBufferFromPool(currQueueData.data);
 	}
 
-	if (mSamplingType == 0) {
-		return processAudioTrivial(mWorkingBufferValidBytes, audioData, numFrames);
+	mWorkingBufferValidBytes = readSampleRing(mWorkingBufferValidBytes);
+
+	if (mSamplingType == 0 || mDynamicRateControl) {
+		return processAudioResampler(mWorkingBufferValidBytes, audioData, numFrames);
 	} else {
 		static int lastSpeedFactor = mSpeedFactor;
 
@@ -370,6 +380,24 @@ bool AudioHandler::audioProviderNoStretch(void *audioData, int32_t numFrames) {
 	}
 }
 
+int AudioHandler::readSampleRing(int outputBufferStart) {
+
+	SampleRingBuffer::ReadRegion region;
+	size_t frames = mSampleRing.acquireRead(region);
+
+	for (int regionIndex = 0; regionIndex < 2; ++regionIndex) {
+		if (region.frames[regionIndex] != 0) {
+			outputBufferStart = convertBufferToHwBuffer(region.data[regionIndex],
+														static_cast<unsigned int>(region.frames[regionIndex]),
+														mWorkingBuffer, outputBufferStart);
+		}
+	}
+
+	mSampleRing.releaseRead(frames);
+
+	return outputBufferStart;
+}
+
 int AudioHandler::convertBufferToHwBuffer(const int16_t *inputBuffer, unsigned int inputSamples,
 										  unsigned char *outputBuffer, int outputBufferStart) {
 
@@ -454,56 +482,27 @@ void AudioHandler::processAudioSoundTouchNoOutput(int& validBytes)
 	mSoundTouch.putSamples(reinterpret_cast<soundtouch::SAMPLETYPE *>(mWorkingBuffer), validBytes / hwSamplesBytes);
 }
 
-int AudioHandler::resample(const unsigned char *input, int bytesPerSample, int oldsamplerate, unsigned char *output,
-		 int output_needed, int newsamplerate) {
-	int consumedSamples = 0;
-
-	if (newsamplerate >= oldsamplerate) {
-		int sldf = oldsamplerate;
-		int const2 = 2 * sldf;
-		int dldf = newsamplerate;
-		int const1 = const2 - 2 * dldf;
-		int criteria = const2 - dldf;
-		for (int index = 0; index < output_needed / bytesPerSample; ++index) {
-			std::copy_n(input + consumedSamples * bytesPerSample, bytesPerSample,
-						output + index * bytesPerSample);
-			if (criteria >= 0) {
-				++consumedSamples;
-				criteria += const1;
-			} else criteria += const2;
-		}
-		return consumedSamples * bytesPerSample; //number of bytes consumed
-	}
-
-	// newsamplerate < oldsamplerate, this only happens when mSpeedFactor > 1
-	int index;
-	for (index = 0; index < output_needed / bytesPerSample; ++index) {
-		consumedSamples = index * oldsamplerate / newsamplerate;
-		std::copy_n(input + consumedSamples * bytesPerSample, bytesPerSample,
-					output + index * bytesPerSample);
-	}
-
-	return consumedSamples * bytesPerSample; //number of bytes consumed
-}
-
-
-bool AudioHandler::processAudioTrivial(int& validBytes, void *outAudioData, int32_t outNumFrames) {
+bool AudioHandler::processAudioResampler(int& validBytes, void *outAudioData, int32_t outNumFrames) {
 
 	bool dataWritten = false;
-	int hardwareBufferBytes = outNumFrames * hwSamplesBytes;
-	auto hardwareBuffer = reinterpret_cast<unsigned char*>(outAudioData);
 
-	int newsamplerate = mOutputFreq * 100 / mSpeedFactor;
+	mResampler.setRates(mInputFreq, mOutputFreq * 100 / mSpeedFactor);
 
-	if (validBytes >= ((hardwareBufferBytes * mInputFreq) / newsamplerate)) {
-		int input_used = resample(mWorkingBuffer, hwSamplesBytes, mInputFreq, hardwareBuffer,
-								  hardwareBufferBytes, newsamplerate);
+	if (validBytes != 0) {
+		mResampler.putSamples(reinterpret_cast<const Resampler::SampleType *>(mWorkingBuffer), validBytes / hwSamplesBytes);
+		validBytes = 0;
+	}
 
-		memmove(mWorkingBuffer, &mWorkingBuffer[input_used], validBytes - input_used);
-		validBytes -= input_used;
+	if (mDynamicRateControl) {
+		updateRateControl();
+	}
+
+	if (mResampler.numSamples() >= outNumFrames) {
+		mResampler.receiveSamples(reinterpret_cast<Resampler::SampleType *>(outAudioData), outNumFrames);
 		dataWritten = true;
+		mRateControlReportFrames += outNumFrames;
 
-		mSamplesWaiting = validBytes / hwSamplesBytes;
+		mSamplesWaiting = mResampler.numInputFrames();
 
 		{
 			std::unique_lock<std::mutex> lock(mWaitForBufferToClearMutex);
@@ -514,6 +513,55 @@ bool AudioHandler::processAudioTrivial(int& validBytes, void *outAudioData, int3
 	return dataWritten;
 }
 
+void AudioHandler::updateRateControl() {
+
+	double fillMs = static_cast<double>(mResampler.numInputFrames()) * 1000.0 / mInputFreq;
+	mRateControlFillMs += (fillMs - mRateControlFillMs) * rateControlSmoothing;
+
+	// Consume input slightly faster when above the target and slightly slower when below it
+	double deviation = (mRateControlFillMs - mTargetBuffersMs) / std::max(mTargetBuffersMs, 1);
+	deviation = std::min(1.0, std::max(-1.0, deviation));
+
+	if (std::abs(deviation) < rateControlIntegralRange) {
+		mRateControlIntegral += rateControlIntegralGain * deviation;
+	}
+	mRateControlIntegral = std::min(maxRateDeviation, std::max(-maxRateDeviation, mRateControlIntegral));
+
+	double adjustment = maxRateDeviation * deviation + mRateControlIntegral;
+	double ratio = 1.0 + std::min(maxRateDeviation, std::max(-maxRateDeviation, adjustment));
+
+	mResampler.setRatioAdjustment(ratio);
+
+	if (mRateControlReport.callbacks == 0) {
+		mRateControlReport.minFillMs = fillMs;
+		mRateControlReport.maxFillMs = fillMs;
+		mRateControlReport.minRatio = ratio;
+		mRateControlReport.maxRatio = ratio;
+	}
+
+	++mRateControlReport.callbacks;
+	mRateControlReport.minFillMs = std::min(mRateControlReport.minFillMs, fillMs);
+	mRateControlReport.maxFillMs = std::max(mRateControlReport.maxFillMs, fillMs);
+	mRateControlReport.totalFillMs += fillMs;
+	mRateControlReport.minRatio = std::min(mRateControlReport.minRatio, ratio);
+	mRateControlReport.maxRatio = std::max(mRateControlReport.maxRatio, ratio);
+
+	if (mRateControlReportFrames >= mOutputFreq * rateControlReportMs / 1000) {
+		mRateControlReports.try_enqueue(mRateControlReport);
+		mRateControlReport = RateControlReport();
+		mRateControlReportFrames = 0;
+	}
+}
+
+void AudioHandler::logRateControlReports() {
+	RateControlReport report;
+	while (mRateControlReports.try_dequeue(report)) {
+		DebugMessage(M64MSG_VERBOSE, "Rate control: fill_ms=%.1f min_fill_ms=%.1f max_fill_ms=%.1f min_ratio=%.5f max_ratio=%.5f underruns=%u",
+					 report.totalFillMs / report.callbacks, report.minFillMs, report.maxFillMs,
+					 report.minRatio, report.maxRatio, report.underruns);
+	}
+}
+
 double AudioHandler::getAverageTime(const double *feedTimes, int numTimes) {
 	double sum = 0;
 	for (int index = 0; index < numTimes; ++index) {
@@ -531,6 +579,10 @@ void AudioHandler::setTimeStretchEnabled(int _timeStretchEnabled) {
 	mTimeStretchEnabled = _timeStretchEnabled;
 }
 
+void AudioHandler::setDynamicRateControl(bool _dynamicRateControl) {
+	mDynamicRateControl = _dynamicRateControl;
+}
+
 void AudioHandler::setSamplingType(int _samplingType) {
 	mSamplingType = _samplingType;
 }
@@ -572,13 +624,19 @@ void AudioHandler::pausePlayback() {
 		mPlaybackPaused = true;
 
 		std::thread asyncCall( [this] {
-			if (mOutStream != nullptr) {
-				mOutStream->requestStop();
-			}
+			mOutput->requestStop();
 		});
 		asyncCall.detach();
 
-		reset();
+		// The stream stops asynchronously and the callback may still be running, leave the
+		// reset to it. Don't keep the emulation thread waiting for audio that won't play.
+		mResetRequested = true;
+		mSamplesWaiting = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(mWaitForBufferToClearMutex);
+			mWaitForBufferToClearCv.notify_one();
+		}
 	}
 }
 
@@ -588,8 +646,8 @@ void AudioHandler::resumePlayback() {
 		mPlaybackPaused = false;
 
 		std::thread asyncCall( [this] {
-			if (mOutStream != nullptr && mStreamOpenSuccess) {
-				mOutStream->requestStart();
+			if (mStreamOpenSuccess) {
+				mOutput->requestStart();
 			}
 		});
 		asyncCall.detach();
@@ -612,6 +670,7 @@ void AudioHandler::injectSilence (void *audioData, int32_t numFrames)
 
 void AudioHandler::reset()
 {
+	mResetRequested = false;
 	mPrimeComplete = false;
 	mPrimingTimeMs = 0;
 	mWorkingBufferValidBytes = 0;
@@ -621,12 +680,18 @@ void AudioHandler::reset()
 	mFeedTimesSet = false;
 
 	mSoundTouch.clear();
+	mResampler.clear();
+	mResampler.setRatioAdjustment(1.0);
+	mRateControlFillMs = static_cast<double>(mTargetBuffersMs);
+	mRateControlIntegral = 0.0;
+	mRateControlReport = RateControlReport();
+	mRateControlReportFrames = 0;
 
 	// Clear all pending buffers
 	QueueData currQueueData;
 	while (mAudioConsumerQueue.try_dequeue(currQueueData)) {
-		mSoundBufferPool.removeBufferFromPool(currQueueData.data);
 	}
+	mSampleRing.clear();
 
 	mSamplesWaiting = 0;
 
@@ -634,4 +699,17 @@ void AudioHandler::reset()
 		std::unique_lock<std::mutex> lock(mWaitForBufferToClearMutex);
 		mWaitForBufferToClearCv.notify_one();
 	}
-}
\ No newline at end of file
+}
+
+void AudioHandler::logStatistics()
+{
+	if (mStatistics.callbacks != 0) {
+		DebugMessage(M64MSG_VERBOSE, "%s output: %u callbacks, %u silent, %u underruns, callback time avg %.1fus max %.1fus, avg queued %.1fms, %u frames dropped",
+					 mOutput->getName(), mStatistics.callbacks, mStatistics.silentCallbacks, mStatistics.underruns,
+					 mStatistics.totalTime / mStatistics.callbacks * 1e6, mStatistics.maxTime * 1e6,
+					 mStatistics.totalQueuedMs / mStatistics.callbacks, mDroppedFrames.load());
+	}
+
+	mStatistics = CallbackStatistics();
+	mDroppedFrames = 0;
+}
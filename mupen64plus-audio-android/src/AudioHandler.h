@@ -1,16 +1,20 @@
 #pragma once
 
 #include "m64p_config.h"
-#include "RingBufferPool.h"
+#include "AudioOutput.h"
+#include "Resampler.h"
+#include "SampleRingBuffer.h"
 #include "readerwriterqueue.h"
 #include <SoundTouch.h>
-#include <oboe/Oboe.h>
 #include <thread>
 #include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 
 using namespace moodycamel;
 
-class AudioHandler : public oboe::AudioStreamCallback
+class AudioHandler : public AudioOutput::Callback
 {
 public:
 
@@ -38,9 +42,17 @@ public:
 	 */
 	void setTimeStretchEnabled(int _timeStretchEnabled);
 
+	/**
+	 * Enable dynamic rate control, used instead of a sampling type when time stretching is off.
+	 * The resampling ratio is nudged by a fraction of a percent to keep the buffered audio at
+	 * the priming target.
+	 * @param _dynamicRateControl True to enable dynamic rate control
+	 */
+	void setDynamicRateControl(bool _dynamicRateControl);
+
 	/**
 	 * Changing the sampling type
-	 * @param _samplingType 0 for trivial resampling, anything else for soundtouch resampling
+	 * @param _samplingType 0 for polyphase resampling, anything else for soundtouch resampling
 	 */
 	void setSamplingType(int _samplingType);
 
@@ -103,7 +115,8 @@ public:
 	void resumePlayback();
 
 	/**
-	 * Pushes audio data to be processed
+	 * Pushes audio data to be processed, never blocks. Data that doesn't fit in the sample
+	 * ring is dropped.
 	 * @param _data Input data
 	 * @param _samples How many samples the input data contains
 	 * @param _timeSinceStart Game time of this data
@@ -116,13 +129,11 @@ public:
 	void waitForBufferToClear();
 
 	/**
-	 * Oboe audio callback
-	 * @param oboeStream Oboe stream
+	 * Audio output callback
 	 * @param audioData Buffer used to copy data to
 	 * @param numFrames How may samples are in this data
-	 * @return Playback state
 	 */
-	oboe::DataCallbackResult onAudioReady(oboe::AudioStream *oboeStream, void *audioData, int32_t numFrames) override;
+	void onAudioReady(void *audioData, int32_t numFrames) override;
 
 	// Default start-time size of working buffer (in equivalent output samples).
 	// This is the buffer where audio is loaded after it's extracted from n64's memory.
@@ -140,13 +151,50 @@ public:
 
 private:
 
-	// Structure used for queuing data to be played back
+	// Describes a block of samples pushed to the sample ring, used for time stretching
 	struct QueueData {
-		PoolBufferPointer data;
 		unsigned int samples;
 		double timeSinceStart;
 	};
 
+	// Samples pushed, in N64 frames, that fit in the sample ring (about 1.4s at 48KHz)
+	static const int sampleRingSize = 64 * 1024;
+
+	// Input frames the resampler can buffer, twice what one read of the sample ring returns
+	static const int resamplerInputFrames = 2 * sampleRingSize;
+
+	// Number of pushes that can be described before the consumer catches up
+	static const int consumerQueueSize = 256;
+
+	// Dynamic rate control summary of one report period, passed from the audio callback to
+	// the emulation thread which logs it
+	struct RateControlReport {
+		unsigned int callbacks;
+		double minFillMs;
+		double maxFillMs;
+		double totalFillMs;
+		double minRatio;
+		double maxRatio;
+		unsigned int underruns;
+	};
+
+	// Largest change of the resampling ratio made by dynamic rate control
+	static constexpr double maxRateDeviation = 0.005;
+
+	// Weight of each new fill level measurement in the smoothed fill level
+	static constexpr double rateControlSmoothing = 0.05;
+
+	// Per callback gain of the integral term, which removes the steady state error left by
+	// the proportional term when the emulated and real clocks drift apart
+	static constexpr double rateControlIntegralGain = 0.000005;
+
+	// The integral term only follows deviations smaller than this, so the transients after
+	// priming or an underrun don't wind it up
+	static constexpr double rateControlIntegralRange = 0.5;
+
+	// How often dynamic rate control reports are logged
+	static const int rateControlReportMs = 1000;
+
 	/*
 	 * Default constructor
 	 */
@@ -176,26 +224,30 @@ private:
 	void processAudioSoundTouchNoOutput(int& validBytes);
 
 	/**
-	 * Performs trivial audio resampling
-	 * @param input Input data to sample
-	 * @param bytesPerSample How many bytes are in each sample
-	 * @param oldsamplerate The input data sampling rate
-	 * @param output Where data should be written
-	 * @param output_needed How much data should be written if possible
-	 * @param newsamplerate The desired sampling rate
-	 * @return How many bytes were actually written
-	 */
-	static int resample(const unsigned char *input, int bytesPerSample, int oldsamplerate, unsigned char *output,
-						   int output_needed, int newsamplerate);
-
-	/**
-	 * Processes input samples by using trivial resampling
+	 * Processes input samples by using the polyphase resampler
 	 * @param validBytes Number of valid bytes in the working buffer
 	 * @param outAudioData Data is written to this buffer
 	 * @param outNumFrames How may frames to write
 	 * @return True if data was written
 	 */
-	bool processAudioTrivial(int& validBytes, void *outAudioData, int32_t outNumFrames);
+	bool processAudioResampler(int& validBytes, void *outAudioData, int32_t outNumFrames);
+
+	/**
+	 * Adjusts the resampling ratio from the buffered audio and records it for reporting
+	 */
+	void updateRateControl();
+
+	/**
+	 * Logs rate control reports completed by the audio callback
+	 */
+	void logRateControlReports();
+
+	/**
+	 * Converts all samples waiting in the sample ring to the hardware format
+	 * @param outputBufferStart Where to start writing in the working buffer
+	 * @return Offset to where the data ends
+	 */
+	int readSampleRing(int outputBufferStart);
 
 	/**
 	 * Performs sound stretching processing, returns true if data was provided, returns true if data was provided
@@ -245,10 +297,15 @@ private:
 	static void injectSilence (void *audioData, int32_t numFrames);
 
 	/**
-	 * Reset Audio processing
+	 * Reset Audio processing, only called while the audio callback can't run or from it
 	 */
 	void reset();
 
+	/**
+	 * Logs and resets the callback statistics
+	 */
+	void logStatistics();
+
 #ifdef FP_ENABLED
     static const int hwSamplesBytes = 8;
 #else
@@ -269,7 +326,9 @@ private:
 	int mHardwareBufferSize = defaultHardwareBufferSize;
 	// Time stretched audio enabled */
 	bool mTimeStretchEnabled = true;
-	// Sampling type 0=trivial 1=Soundtouch*/
+	// Dynamic rate control enabled
+	bool mDynamicRateControl = false;
+	// Sampling type 0=polyphase 1=Soundtouch*/
 	int mSamplingType = 0;
 	// True to swap left/right channels
 	bool mSwapChannels = false;
@@ -289,22 +348,46 @@ private:
 	// Audio speed factor (0-100)
 	int mSpeedFactor = 100;
 
-	// Queue used to communicate with the audio consumer thread
-	BlockingReaderWriterQueue<QueueData> mAudioConsumerQueue;
+	// Queue used to pass timing of each push to the audio consumer thread
+	ReaderWriterQueue<QueueData> mAudioConsumerQueue;
 
 	// Soundtouch library
 	soundtouch::SoundTouch mSoundTouch;
 
-	// Oboe audio stream
-	std::shared_ptr<oboe::AudioStream> mOutStream;
+	// Polyphase resampler used when not using soundtouch
+	Resampler mResampler;
+
+	// Audio output stream
+	std::unique_ptr<AudioOutput> mOutput;
 
-	// Memory pool used to store samples until they are processed by the
-	// sound processing thread
-	RingBufferPool mSoundBufferPool;
+	// Samples waiting to be processed by the audio callback
+	SampleRingBuffer mSampleRing;
+
+	// Frames dropped because the sample ring was full
+	std::atomic_uint mDroppedFrames;
+
+	// Smoothed buffered audio used by dynamic rate control, in milliseconds
+	double mRateControlFillMs = 0.0;
+
+	// Integral term of the dynamic rate control
+	double mRateControlIntegral = 0.0;
+
+	// Report being accumulated by the audio callback
+	RateControlReport mRateControlReport;
+
+	// Output frames covered by mRateControlReport
+	int mRateControlReportFrames = 0;
+
+	// Completed reports waiting to be logged by the emulation thread
+	ReaderWriterQueue<RateControlReport> mRateControlReports;
 
 	// True if playback is paused
 	std::atomic<bool> mPlaybackPaused;
 
+	// Set when pausing, the audio callback resets audio processing the next time it runs since
+	// the stream may not have stopped yet
+	std::atomic<bool> mResetRequested;
+
 	// Amount of injected silence to allow the buffers to prime
 	int mPrimingTimeMs = 0;
 
@@ -347,5 +430,16 @@ private:
 
 	// True if we have successfully opened a stream
 	bool mStreamOpenSuccess = false;
+
+	// Audio callback statistics, only touched by the audio callback and while closed
+	struct CallbackStatistics {
+		unsigned int callbacks = 0;
+		unsigned int silentCallbacks = 0;
+		double totalTime = 0.0;
+		double maxTime = 0.0;
+		double totalQueuedMs = 0.0;
+		unsigned int underruns = 0;
+	};
+	CallbackStatistics mStatistics;
 };
 
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+/**
+ * Audio device the processed samples are played through. Every backend pulls data from a
+ * Callback on its own thread, once per burst.
+ */
+class AudioOutput
+{
+public:
+
+	class Callback
+	{
+	public:
+		virtual ~Callback() = default;
+
+		/**
+		 * Called by the output whenever it needs more data
+		 * @param audioData Buffer used to copy data to
+		 * @param numFrames How may frames should be written
+		 */
+		virtual void onAudioReady(void *audioData, int32_t numFrames) = 0;
+	};
+
+	// Requested stream parameters, open() replaces them with what the device actually uses
+	struct Settings {
+		int sampleRate;
+		int framesPerBurst;
+		int channels;
+		bool floatSamples;
+		bool forceSles;
+	};
+
+	/**
+	 * Creates the output backend this plugin was built with
+	 * @return New, not yet opened output
+	 */
+	static std::unique_ptr<AudioOutput> create();
+
+	virtual ~AudioOutput() = default;
+
+	/**
+	 * Opens the output stream
+	 * @param settings Requested parameters, updated with the parameters that were obtained
+	 * @param callback Object that provides the audio data
+	 * @return True on success
+	 */
+	virtual bool open(Settings& settings, Callback* callback) = 0;
+
+	/**
+	 * Stops and closes the output stream
+	 */
+	virtual void close() = 0;
+
+	/**
+	 * Starts requesting data from the callback
+	 */
+	virtual void requestStart() = 0;
+
+	/**
+	 * Stops requesting data from the callback
+	 */
+	virtual void requestStop() = 0;
+
+	/**
+	 * @return True if the stream is open and started
+	 */
+	virtual bool isStarted() const = 0;
+
+	/**
+	 * @return Name of the backend, for logging
+	 */
+	virtual const char* getName() const = 0;
+};
@@ -0,0 +1,133 @@
+#include "FileAudioOutput.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+std::unique_ptr<AudioOutput> AudioOutput::create()
+{
+	const char* wavPath = getenv(FileAudioOutput::wavPathVariable);
+	return std::unique_ptr<AudioOutput>(new FileAudioOutput(wavPath != nullptr ? wavPath : ""));
+}
+
+FileAudioOutput::FileAudioOutput(std::string wavPath) :
+	mWavPath(std::move(wavPath)),
+	mRunning(false),
+	mStarted(false)
+{
+}
+
+FileAudioOutput::~FileAudioOutput()
+{
+	close();
+}
+
+bool FileAudioOutput::open(Settings& settings, Callback* callback)
+{
+	close();
+
+	mSettings = settings;
+	mCallback = callback;
+	mBurst.assign(static_cast<size_t>(settings.framesPerBurst) * settings.channels *
+					  (settings.floatSamples ? sizeof(float) : sizeof(int16_t)), 0);
+
+	if (!mWavPath.empty()) {
+		mWavFile = fopen(mWavPath.c_str(), "wb");
+		if (mWavFile == nullptr) {
+			return false;
+		}
+		mWavDataBytes = 0;
+		writeWavHeader();
+	}
+
+	mRunning = true;
+	mThread = std::thread(&FileAudioOutput::outputThread, this);
+	return true;
+}
+
+void FileAudioOutput::close()
+{
+	if (mThread.joinable()) {
+		mRunning = false;
+		mThread.join();
+	}
+	mStarted = false;
+
+	if (mWavFile != nullptr) {
+		writeWavHeader();
+		fclose(mWavFile);
+		mWavFile = nullptr;
+	}
+}
+
+void FileAudioOutput::requestStart()
+{
+	mStarted = true;
+}
+
+void FileAudioOutput::requestStop()
+{
+	mStarted = false;
+}
+
+bool FileAudioOutput::isStarted() const
+{
+	return mRunning && mStarted;
+}
+
+const char* FileAudioOutput::getName() const
+{
+	return mWavPath.empty() ? "null" : "WAV file";
+}
+
+void FileAudioOutput::outputThread()
+{
+	const std::chrono::duration<double> burstTime(static_cast<double>(mSettings.framesPerBurst) / mSettings.sampleRate);
+	auto nextBurst = std::chrono::steady_clock::now();
+
+	while (mRunning) {
+		nextBurst += std::chrono::duration_cast<std::chrono::steady_clock::duration>(burstTime);
+		std::this_thread::sleep_until(nextBurst);
+
+		if (!mStarted) {
+			nextBurst = std::chrono::steady_clock::now();
+			continue;
+		}
+
+		mCallback->onAudioReady(mBurst.data(), mSettings.framesPerBurst);
+
+		if (mWavFile != nullptr) {
+			mWavDataBytes += static_cast<uint32_t>(fwrite(mBurst.data(), 1, mBurst.size(), mWavFile));
+		}
+	}
+}
+
+void FileAudioOutput::writeWavHeader()
+{
+	const uint16_t format = mSettings.floatSamples ? 3 : 1;
+	const uint16_t channels = static_cast<uint16_t>(mSettings.channels);
+	const uint16_t bitsPerSample = mSettings.floatSamples ? 32 : 16;
+	const uint16_t blockAlign = channels * bitsPerSample / 8;
+	const uint32_t sampleRate = static_cast<uint32_t>(mSettings.sampleRate);
+	const uint32_t byteRate = sampleRate * blockAlign;
+	const uint32_t formatBytes = 16;
+	const uint32_t riffBytes = 36 + mWavDataBytes;
+
+	// WAV is little endian, as are all hosts this plugin runs on
+	unsigned char header[44];
+	memcpy(header + 0, "RIFF", 4);
+	memcpy(header + 4, &riffBytes, 4);
+	memcpy(header + 8, "WAVEfmt ", 8);
+	memcpy(header + 16, &formatBytes, 4);
+	memcpy(header + 20, &format, 2);
+	memcpy(header + 22, &channels, 2);
+	memcpy(header + 24, &sampleRate, 4);
+	memcpy(header + 28, &byteRate, 4);
+	memcpy(header + 32, &blockAlign, 2);
+	memcpy(header + 34, &bitsPerSample, 2);
+	memcpy(header + 36, "data", 4);
+	memcpy(header + 40, &mWavDataBytes, 4);
+
+	fseek(mWavFile, 0, SEEK_SET);
+	fwrite(header, 1, sizeof(header), mWavFile);
+	fseek(mWavFile, 0, SEEK_END);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "AudioOutput.h"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Output used by builds without Oboe. A thread requests one burst per burst period, like a
+ * real device would, and either discards the data or appends it to a WAV file. This allows
+ * the whole audio path to be profiled and latency tested on a desktop.
+ */
+class FileAudioOutput : public AudioOutput
+{
+public:
+
+	/**
+	 * @param wavPath WAV file to write, an empty path discards the audio
+	 */
+	explicit FileAudioOutput(std::string wavPath);
+
+	~FileAudioOutput() override;
+
+	bool open(Settings& settings, Callback* callback) override;
+
+	void close() override;
+
+	void requestStart() override;
+
+	void requestStop() override;
+
+	bool isStarted() const override;
+
+	const char* getName() const override;
+
+	// Environment variable holding the WAV path used by AudioOutput::create()
+	static constexpr const char* wavPathVariable = "AUDIO_ANDROID_WAV_PATH";
+
+private:
+
+	/**
+	 * Requests bursts from the callback until the output is closed
+	 */
+	void outputThread();
+
+	/**
+	 * Writes the WAV header, called again on close to fill in the sizes
+	 */
+	void writeWavHeader();
+
+	std::string mWavPath;
+	FILE* mWavFile = nullptr;
+	uint32_t mWavDataBytes = 0;
+
+	Settings mSettings = {};
+	Callback* mCallback = nullptr;
+	std::vector<unsigned char> mBurst;
+
+	std::thread mThread;
+	std::atomic<bool> mRunning;
+	std::atomic<bool> mStarted;
+};
@@ -0,0 +1,91 @@
+#include "OboeAudioOutput.h"
+
+std::unique_ptr<AudioOutput> AudioOutput::create()
+{
+	return std::unique_ptr<AudioOutput>(new OboeAudioOutput());
+}
+
+OboeAudioOutput::~OboeAudioOutput()
+{
+	close();
+}
+
+bool OboeAudioOutput::open(Settings& settings, Callback* callback)
+{
+	close();
+
+	mCallback = callback;
+
+	oboe::DefaultStreamValues::SampleRate = (int32_t) settings.sampleRate;
+	oboe::DefaultStreamValues::FramesPerBurst = (int32_t) settings.framesPerBurst;
+
+	oboe::AudioStreamBuilder builder;
+	// The builder set methods can be chained for convenience.
+	builder.setSharingMode(oboe::SharingMode::Exclusive);
+	builder.setPerformanceMode(oboe::PerformanceMode::LowLatency);
+	builder.setChannelCount(settings.channels);
+	builder.setSampleRate(settings.sampleRate);
+	//builder.setSampleRateConversionQuality(oboe::SampleRateConversionQuality::Fastest);
+
+	if (settings.forceSles) {
+		builder.setAudioApi(oboe::AudioApi::OpenSLES);
+	}
+
+	builder.setFormat(settings.floatSamples ? oboe::AudioFormat::Float : oboe::AudioFormat::I16);
+
+	builder.setCallback(this);
+	if (builder.openStream(mOutStream) != oboe::Result::OK) {
+		mOutStream = nullptr;
+		return false;
+	}
+
+	if (mOutStream->getAudioApi() == oboe::AudioApi::AAudio) {
+		settings.sampleRate = mOutStream->getSampleRate();
+		settings.framesPerBurst = mOutStream->getFramesPerBurst();
+	}
+
+	return true;
+}
+
+void OboeAudioOutput::close()
+{
+	if (mOutStream != nullptr) {
+		mOutStream->stop();
+		mOutStream->close();
+		mOutStream = nullptr;
+	}
+}
+
+void OboeAudioOutput::requestStart()
+{
+	if (mOutStream != nullptr) {
+		mOutStream->requestStart();
+	}
+}
+
+void OboeAudioOutput::requestStop()
+{
+	if (mOutStream != nullptr) {
+		mOutStream->requestStop();
+	}
+}
+
+bool OboeAudioOutput::isStarted() const
+{
+	return mOutStream != nullptr && mOutStream->getState() == oboe::StreamState::Started;
+}
+
+const char* OboeAudioOutput::getName() const
+{
+	if (mOutStream != nullptr && mOutStream->getAudioApi() == oboe::AudioApi::OpenSLES) {
+		return "Oboe (OpenSL ES)";
+	}
+	return "Oboe";
+}
+
+oboe::DataCallbackResult
+OboeAudioOutput::onAudioReady(oboe::AudioStream *oboeStream, void *audioData, int32_t numFrames)
+{
+	mCallback->onAudioReady(audioData, numFrames);
+	return oboe::DataCallbackResult::Continue;
+}
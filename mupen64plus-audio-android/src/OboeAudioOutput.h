@@ -0,0 +1,34 @@
+#pragma once
+
+#include "AudioOutput.h"
+#include <oboe/Oboe.h>
+
+/**
+ * Plays audio through Oboe, which picks AAudio or OpenSL ES
+ */
+class OboeAudioOutput : public AudioOutput, public oboe::AudioStreamCallback
+{
+public:
+	~OboeAudioOutput() override;
+
+	bool open(Settings& settings, Callback* callback) override;
+
+	void close() override;
+
+	void requestStart() override;
+
+	void requestStop() override;
+
+	bool isStarted() const override;
+
+	const char* getName() const override;
+
+	oboe::DataCallbackResult onAudioReady(oboe::AudioStream *oboeStream, void *audioData, int32_t numFrames) override;
+
+private:
+	// Oboe audio stream
+	std::shared_ptr<oboe::AudioStream> mOutStream;
+
+	// Where audio data comes from
+	Callback* mCallback = nullptr;
+};
@@ -0,0 +1,232 @@
+#include "Resampler.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RESAMPLER_NEON
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RESAMPLER_SSE
+#endif
+
+namespace {
+
+// Filters one output frame, _left and _right point at the first input frame under the filter
+inline void filterFrame(const float* _left, const float* _right, const float* _coefficients,
+						float& _outLeft, float& _outRight)
+{
+#if defined(RESAMPLER_NEON)
+	float32x4_t sumLeft = vdupq_n_f32(0.0f);
+	float32x4_t sumRight = vdupq_n_f32(0.0f);
+	for (int tap = 0; tap < Resampler::numTaps; tap += 4) {
+		const float32x4_t coefficients = vld1q_f32(_coefficients + tap);
+		sumLeft = vmlaq_f32(sumLeft, vld1q_f32(_left + tap), coefficients);
+		sumRight = vmlaq_f32(sumRight, vld1q_f32(_right + tap), coefficients);
+	}
+	// Reduce both accumulators at once, lanes end up as {left, right}
+	const float32x2_t pairs = vpadd_f32(vadd_f32(vget_low_f32(sumLeft), vget_high_f32(sumLeft)),
+										vadd_f32(vget_low_f32(sumRight), vget_high_f32(sumRight)));
+	_outLeft = vget_lane_f32(pairs, 0);
+	_outRight = vget_lane_f32(pairs, 1);
+#elif defined(RESAMPLER_SSE)
+	__m128 sumLeft = _mm_setzero_ps();
+	__m128 sumRight = _mm_setzero_ps();
+	for (int tap = 0; tap < Resampler::numTaps; tap += 4) {
+		const __m128 coefficients = _mm_loadu_ps(_coefficients + tap);
+		sumLeft = _mm_add_ps(sumLeft, _mm_mul_ps(_mm_loadu_ps(_left + tap), coefficients));
+		sumRight = _mm_add_ps(sumRight, _mm_mul_ps(_mm_loadu_ps(_right + tap), coefficients));
+	}
+	// Reduce both accumulators at once, lanes end up as {left, right, left, right}
+	const __m128 low = _mm_unpacklo_ps(sumLeft, sumRight);
+	const __m128 high = _mm_unpackhi_ps(sumLeft, sumRight);
+	const __m128 halves = _mm_add_ps(low, high);
+	const __m128 pairs = _mm_add_ps(halves, _mm_movehl_ps(halves, halves));
+	_outLeft = _mm_cvtss_f32(pairs);
+	_outRight = _mm_cvtss_f32(_mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1)));
+#else
+	float sumLeft = 0.0f;
+	float sumRight = 0.0f;
+	for (int tap = 0; tap < Resampler::numTaps; ++tap) {
+		sumLeft += _left[tap] * _coefficients[tap];
+		sumRight += _right[tap] * _coefficients[tap];
+	}
+	_outLeft = sumLeft;
+	_outRight = sumRight;
+#endif
+}
+
+inline float toFloat(int16_t _sample)
+{
+	return static_cast<float>(_sample);
+}
+
+inline float toFloat(float _sample)
+{
+	return _sample;
+}
+
+inline void fromFloat(float _value, int16_t& _sample)
+{
+	_value = std::min(std::max(_value, -32768.0f), 32767.0f);
+	_sample = static_cast<int16_t>(lrintf(_value));
+}
+
+inline void fromFloat(float _value, float& _sample)
+{
+	_sample = _value;
+}
+
+}
+
+Resampler::Resampler(int _maxInputFrames) :
+	mFilter((numPhases + 1) * numTaps, 0.0f),
+	mLeft(_maxInputFrames + halfTaps - 1, 0.0f),
+	mRight(_maxInputFrames + halfTaps - 1, 0.0f)
+{
+	clear();
+}
+
+void Resampler::setRates(int _inputRate, int _outputRate)
+{
+	if (_inputRate <= 0 || _outputRate <= 0 ||
+		(_inputRate == mInputRate && _outputRate == mOutputRate)) {
+		return;
+	}
+
+	mInputRate = _inputRate;
+	mOutputRate = _outputRate;
+	mNominalStep = (static_cast<uint64_t>(_inputRate) << 32) / static_cast<uint64_t>(_outputRate);
+	setRatioAdjustment(mAdjustment);
+
+	// Leave some room below Nyquist of whichever rate is lower so the short filter can roll off
+	const double ratio = std::min(1.0, static_cast<double>(_outputRate) / _inputRate);
+	buildFilter(0.45 * ratio);
+}
+
+void Resampler::setRatioAdjustment(double _adjustment)
+{
+	mAdjustment = _adjustment;
+	mStep = static_cast<uint64_t>(static_cast<double>(mNominalStep) * _adjustment);
+}
+
+void Resampler::buildFilter(double _cutoff)
+{
+	for (int phase = 0; phase <= numPhases; ++phase) {
+		float* coefficients = &mFilter[phase * numTaps];
+		const double fraction = static_cast<double>(phase) / numPhases;
+		double sum = 0.0;
+
+		for (int tap = 0; tap < numTaps; ++tap) {
+			// Distance from the output position to this input frame
+			const double distance = (tap - halfTaps + 1) - fraction;
+			const double x = 2.0 * _cutoff * distance;
+			const double sinc = x == 0.0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+			const double windowPosition = M_PI * distance / halfTaps;
+			const double window = 0.42 + 0.5 * std::cos(windowPosition) + 0.08 * std::cos(2.0 * windowPosition);
+			const double value = std::abs(distance) >= halfTaps ? 0.0 : sinc * window;
+
+			coefficients[tap] = static_cast<float>(value);
+			sum += value;
+		}
+
+		// Unity gain at DC for every phase
+		for (int tap = 0; tap < numTaps; ++tap) {
+			coefficients[tap] = static_cast<float>(coefficients[tap] / sum);
+		}
+	}
+}
+
+void Resampler::putSamples(const SampleType* _samples, int _frames)
+{
+	// This runs on the audio callback, so input is moved around within the storage allocated
+	// up front instead of growing it
+	const int capacity = static_cast<int>(mLeft.size());
+	const int history = halfTaps - 1;
+
+	// Never more than the capacity past the history, keep the newest frames
+	if (_frames > capacity - history) {
+		_samples += (_frames - (capacity - history)) * 2;
+		_frames = capacity - history;
+	}
+
+	// Drop consumed input, keeping the history the filter still needs. If the new input still
+	// doesn't fit, the consumer fell far behind, so unconsumed input is dropped too.
+	const int consumed = std::max(mReadIndex - history, 0);
+	const int overflow = std::max(0, mInputEnd - consumed + _frames - capacity);
+	const int discard = consumed + overflow;
+	if (discard > 0) {
+		std::copy(mLeft.begin() + discard, mLeft.begin() + mInputEnd, mLeft.begin());
+		std::copy(mRight.begin() + discard, mRight.begin() + mInputEnd, mRight.begin());
+		mInputEnd -= discard;
+		mReadIndex = std::max(mReadIndex - discard, history);
+		if (overflow > 0) {
+			mFraction = 0;
+		}
+	}
+
+	const int start = mInputEnd;
+	for (int frame = 0; frame < _frames; ++frame) {
+		mLeft[start + frame] = toFloat(_samples[frame * 2]);
+		mRight[start + frame] = toFloat(_samples[frame * 2 + 1]);
+	}
+	mInputEnd += _frames;
+}
+
+int Resampler::numSamples() const
+{
+	// The last input frame an output can be centered on still needs halfTaps frames after it
+	const int64_t centers = static_cast<int64_t>(mInputEnd) - halfTaps - mReadIndex;
+	if (centers <= 0) {
+		return 0;
+	}
+
+	const uint64_t span = (static_cast<uint64_t>(centers) << 32) - mFraction;
+	return static_cast<int>((span + mStep - 1) / mStep);
+}
+
+int Resampler::numInputFrames() const
+{
+	return std::max(0, mInputEnd - mReadIndex);
+}
+
+int Resampler::receiveSamples(SampleType* _output, int _frames)
+{
+	_frames = std::min(_frames, numSamples());
+
+	const float* left = mLeft.data();
+	const float* right = mRight.data();
+	uint64_t position = mFraction;
+	int readIndex = mReadIndex;
+
+	for (int frame = 0; frame < _frames; ++frame) {
+		// Round to the nearest phase, the extra filter row absorbs the carry
+		const int phase = static_cast<int>((position + (1ull << (31 - phaseBits))) >> (32 - phaseBits));
+		const int first = readIndex - halfTaps + 1;
+		float outLeft;
+		float outRight;
+
+		filterFrame(left + first, right + first, &mFilter[phase * numTaps], outLeft, outRight);
+		fromFloat(outLeft, _output[frame * 2]);
+		fromFloat(outRight, _output[frame * 2 + 1]);
+
+		position += mStep;
+		readIndex += static_cast<int>(position >> 32);
+		position &= 0xFFFFFFFFull;
+	}
+
+	mReadIndex = readIndex;
+	mFraction = static_cast<uint32_t>(position);
+
+	return _frames;
+}
+
+void Resampler::clear()
+{
+	// Start with silence as history so the first output is centered on the first input frame
+	std::fill(mLeft.begin(), mLeft.begin() + halfTaps - 1, 0.0f);
+	std::fill(mRight.begin(), mRight.begin() + halfTaps - 1, 0.0f);
+	mInputEnd = halfTaps - 1;
+	mReadIndex = halfTaps - 1;
+	mFraction = 0;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Stereo polyphase FIR resampler. Input and output are interleaved samples in the hardware
+ * format. Input is kept internally in planar float form so each output frame is two short
+ * dot products against one precomputed windowed sinc phase, done with NEON or SSE when
+ * available.
+ */
+class Resampler
+{
+public:
+
+#ifdef FP_ENABLED
+	typedef float SampleType;
+#else
+	typedef int16_t SampleType;
+#endif
+
+	/**
+	 * @param _maxInputFrames Input frames that can be buffered, storage for them is allocated
+	 * here so adding input never allocates
+	 */
+	explicit Resampler(int _maxInputFrames);
+
+	/**
+	 * Sets the conversion ratio, the filter bank is only rebuilt if the ratio changed
+	 * @param _inputRate Input sampling rate
+	 * @param _outputRate Output sampling rate
+	 */
+	void setRates(int _inputRate, int _outputRate);
+
+	/**
+	 * Scales how fast input is consumed without rebuilding the filter bank, used for small
+	 * continuous corrections
+	 * @param _adjustment Input frames consumed per output frame relative to the nominal rates
+	 */
+	void setRatioAdjustment(double _adjustment);
+
+	/**
+	 * Adds input samples. If the buffered input would exceed the capacity, the oldest input
+	 * is dropped.
+	 * @param _samples Interleaved stereo input
+	 * @param _frames Number of input frames
+	 */
+	void putSamples(const SampleType* _samples, int _frames);
+
+	/**
+	 * Produces resampled output
+	 * @param _output Where interleaved stereo output is written
+	 * @param _frames Maximum number of frames to write
+	 * @return Number of frames written
+	 */
+	int receiveSamples(SampleType* _output, int _frames);
+
+	/**
+	 * @return How many output frames can be produced from the buffered input
+	 */
+	int numSamples() const;
+
+	/**
+	 * @return How many input frames are buffered and not consumed yet
+	 */
+	int numInputFrames() const;
+
+	/**
+	 * Drops all buffered input
+	 */
+	void clear();
+
+	// Filter length in input frames, must be a multiple of 4
+	static const int numTaps = 16;
+
+	// Number of filter phases is 2^phaseBits
+	static const int phaseBits = 8;
+
+private:
+
+	/**
+	 * Computes a Blackman windowed sinc for every phase
+	 * @param _cutoff Cutoff frequency as a fraction of the input sampling rate
+	 */
+	void buildFilter(double _cutoff);
+
+	static const int numPhases = 1 << phaseBits;
+	static const int halfTaps = numTaps / 2;
+
+	// Filter coefficients, numPhases + 1 rows of numTaps values. The extra row is phase 0 of
+	// the next input frame so rounding to the nearest phase never needs a carry.
+	std::vector<float> mFilter;
+
+	// Planar input, the first halfTaps - 1 frames before mReadIndex are filter history.
+	// Sized once, mInputEnd frames are valid.
+	std::vector<float> mLeft;
+	std::vector<float> mRight;
+
+	// Number of valid frames in mLeft and mRight
+	int mInputEnd = 0;
+
+	// Input frame the next output is centered on
+	int mReadIndex = 0;
+
+	// Fractional position between mReadIndex and the next frame, 0.32 fixed point
+	uint32_t mFraction = 0;
+
+	// Input frames advanced per output frame, 32.32 fixed point
+	uint64_t mStep = 1ull << 32;
+
+	// mStep before the ratio adjustment is applied
+	uint64_t mNominalStep = 1ull << 32;
+
+	double mAdjustment = 1.0;
+
+	int mInputRate = 0;
+	int mOutputRate = 0;
+};
@@ -0,0 +1,71 @@
+#include "SampleRingBuffer.h"
+#include <algorithm>
+
+SampleRingBuffer::SampleRingBuffer(size_t _capacityFrames) :
+	m_mask(0),
+	m_writeIndex(0),
+	m_readIndex(0)
+{
+	size_t capacity = 1;
+	while (capacity < _capacityFrames)
+		capacity <<= 1;
+
+	m_buffer.resize(capacity * m_channels, 0);
+	m_mask = capacity - 1;
+}
+
+size_t SampleRingBuffer::write(const int16_t* _data, size_t _frames)
+{
+	// Indices only ever increase, their difference is the fill level even after they wrap
+	const size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+	const size_t readIndex = m_readIndex.load(std::memory_order_acquire);
+	const size_t freeFrames = getCapacity() - (writeIndex - readIndex);
+
+	_frames = std::min(_frames, freeFrames);
+
+	const size_t start = writeIndex & m_mask;
+	const size_t firstFrames = std::min(_frames, getCapacity() - start);
+
+	std::copy_n(_data, firstFrames * m_channels, &m_buffer[start * m_channels]);
+	std::copy_n(_data + firstFrames * m_channels, (_frames - firstFrames) * m_channels, m_buffer.data());
+
+	m_writeIndex.store(writeIndex + _frames, std::memory_order_release);
+
+	return _frames;
+}
+
+size_t SampleRingBuffer::acquireRead(ReadRegion& _region) const
+{
+	const size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+	const size_t frames = m_writeIndex.load(std::memory_order_acquire) - readIndex;
+
+	const size_t start = readIndex & m_mask;
+	const size_t firstFrames = std::min(frames, getCapacity() - start);
+
+	_region.data[0] = &m_buffer[start * m_channels];
+	_region.frames[0] = firstFrames;
+	_region.data[1] = m_buffer.data();
+	_region.frames[1] = frames - firstFrames;
+
+	return frames;
+}
+
+void SampleRingBuffer::releaseRead(size_t _frames)
+{
+	m_readIndex.store(m_readIndex.load(std::memory_order_relaxed) + _frames, std::memory_order_release);
+}
+
+void SampleRingBuffer::clear()
+{
+	m_readIndex.store(m_writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+size_t SampleRingBuffer::getReadableFrames() const
+{
+	return m_writeIndex.load(std::memory_order_acquire) - m_readIndex.load(std::memory_order_acquire);
+}
+
+size_t SampleRingBuffer::getCapacity() const
+{
+	return m_mask + 1;
+}
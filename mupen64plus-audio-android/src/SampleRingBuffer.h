@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed size ring of interleaved 16 bit stereo frames. This class is only thread safe for a
+// single producer and single consumer. Neither side ever blocks or allocates: the producer
+// drops what doesn't fit and the consumer reads the stored frames in place.
+class SampleRingBuffer
+{
+public:
+
+	// Frames that can be read without copying. The second region is only used when the
+	// readable data wraps around the end of the ring.
+	struct ReadRegion {
+		const int16_t* data[2];
+		size_t frames[2];
+	};
+
+	// Creates a ring that holds at least _capacityFrames frames, the capacity is rounded up
+	// to a power of two
+	explicit SampleRingBuffer(size_t _capacityFrames);
+
+	// Producer side: copies up to _frames frames into the ring and returns how many fit
+	size_t write(const int16_t* _data, size_t _frames);
+
+	// Consumer side: returns the number of readable frames and where they are stored. The
+	// frames stay valid until releaseRead() is called.
+	size_t acquireRead(ReadRegion& _region) const;
+
+	// Consumer side: marks frames returned by acquireRead() as consumed
+	void releaseRead(size_t _frames);
+
+	// Consumer side: discards all readable frames
+	void clear();
+
+	// Number of frames that can currently be read
+	size_t getReadableFrames() const;
+
+	size_t getCapacity() const;
+
+private:
+	static const size_t m_channels = 2;
+	static const size_t m_cacheLineSize = 64;
+
+	std::vector<int16_t> m_buffer;
+	size_t m_mask;
+
+	// Keep the indices on separate cache lines so the producer and consumer don't bounce them
+	alignas(m_cacheLineSize) std::atomic<size_t> m_writeIndex;
+	alignas(m_cacheLineSize) std::atomic<size_t> m_readIndex;
+};
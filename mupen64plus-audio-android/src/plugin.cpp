@@ -40,7 +40,6 @@
 #include "m64p_frontend.h"
 #include "plugin.h"
 #include "osal_dynamiclib.h"
-#include <jni.h>
 #include "AudioHandler.h"
 
 /* number of bytes per sample */
@@ -68,6 +67,7 @@ static unsigned int speed_factor = 100;
 static int samplingRateSelection = 0;
 static bool isUsingNetplay = false;
 static bool timeStretchEnabled = false;
+static bool dynamicRateControl = false;
 
 
 /* Definitions of pointers to Core config functions */
@@ -112,6 +112,10 @@ static void ReadConfig() {
     samplingRateSelection = ConfigGetParamInt(l_ConfigAudio, "SAMPLING_RATE");
     int samplingType = ConfigGetParamInt(l_ConfigAudio, "SAMPLING_TYPE");
     timeStretchEnabled = ConfigGetParamBool(l_ConfigAudio, "TIME_STRETCH_ENABLED") != 0;
+    dynamicRateControl = ConfigGetParamBool(l_ConfigAudio, "DYNAMIC_RATE_CONTROL") != 0;
+
+    // Dynamic rate control replaces time stretching
+    timeStretchEnabled = timeStretchEnabled && !dynamicRateControl;
     int forceSles = ConfigGetParamBool(l_ConfigAudio, "FORCE_SLES");
 
     AudioHandler::get().setSwapChannels(swapChannels);
@@ -120,6 +124,7 @@ static void ReadConfig() {
     AudioHandler::get().setSamplingRateSelection(samplingRateSelection);
     AudioHandler::get().setSamplingType(samplingType);
     AudioHandler::get().setTimeStretchEnabled(isUsingNetplay || timeStretchEnabled);
+    AudioHandler::get().setDynamicRateControl(dynamicRateControl);
     AudioHandler::get().setVolume(volume);
     AudioHandler::get().forceSles(forceSles);
 }
@@ -243,9 +248,11 @@ EXPORT m64p_error CALL PluginStartup(m64p_dynlib_handle CoreLibHandle, void *Con
     ConfigSetDefaultInt(l_ConfigAudio, "SAMPLING_RATE", 0,
                         "Sampling rate in hz, (0=game original");
     ConfigSetDefaultInt(l_ConfigAudio, "SAMPLING_TYPE", 0,
-                        "Sampling type when not time streteching, (0=trivial, 1=soundtouch");
+                        "Sampling type when not time streteching, (0=polyphase, 1=soundtouch");
     ConfigSetDefaultBool(l_ConfigAudio, "TIME_STRETCH_ENABLED", 1,
                          "Enable audio time stretching to prevent crackling");
+    ConfigSetDefaultBool(l_ConfigAudio, "DYNAMIC_RATE_CONTROL", 0,
+                         "Keep the audio buffer filled by adjusting the resampling ratio slightly instead of time stretching");
     ConfigSetDefaultBool(l_ConfigAudio, "FORCE_SLES", 0, "Force SLES audio (0=auto,1=force)");
 
     if (bSaveConfig && ConfigAPIVersion >= 0x020100)
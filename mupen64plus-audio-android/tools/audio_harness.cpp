@@ -0,0 +1,149 @@
+/**
+ * Desktop harness for the audio path. It plays a generated tone through AudioHandler and the
+ * null/WAV file output the way the plugin does with the core speed limiter on: one push of
+ * N64 audio per emulated frame, paced by the host clock. The emulated clock can be skewed
+ * against the output clock to check how each processing mode copes with drift.
+ *
+ * Build with -DAUDIO_ANDROID_USE_OBOE=OFF -DAUDIO_ANDROID_BUILD_HARNESS=ON, then run
+ *
+ *   audio-android-harness <mode> [drift_percent] [seconds] [target_ms] [pause]
+ *
+ * mode is one of
+ *   stretch     SoundTouch time stretching
+ *   polyphase   plain polyphase resampling
+ *   soundtouch  plain SoundTouch resampling
+ *   drc         polyphase resampling with dynamic rate control
+ *
+ * drift_percent makes the emulated clock run that much faster (or slower, when negative) than
+ * the output, the default is 0. The run lasts seconds (default 10) with a priming target of
+ * target_ms (default 30). pause pauses playback for 200ms halfway through.
+ *
+ * Everything AudioHandler logs is printed, including the once per second dynamic rate
+ * control reports and the callback statistics on close, which count underruns. Set
+ * AUDIO_ANDROID_WAV_PATH to also write the output to a WAV file.
+ */
+
+#include "AudioHandler.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Rate of the generated N64 audio
+const int inputFreq = 32000;
+
+// Output rate, what Android devices typically run at
+const int outputFreq = 48000;
+
+// Audio is pushed once per emulated frame
+const double framesPerSecond = 60.0;
+
+const double pi = 3.14159265358979323846;
+
+const char* const levelNames[] = {"", "Error", "Warning", "Info", "Status", "Verbose"};
+
+void debugCallback(void* context, int level, const char* message)
+{
+	const char* name = level >= 1 && level <= 5 ? levelNames[level] : "?";
+	printf("%s %s: %s\n", static_cast<const char*>(context), name, message);
+}
+
+void usage(const char* program)
+{
+	fprintf(stderr, "usage: %s <stretch|polyphase|soundtouch|drc> [drift_percent] [seconds] [target_ms] [pause]\n",
+			program);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	const char* mode = argv[1];
+	double driftPercent = argc > 2 ? atof(argv[2]) : 0.0;
+	double seconds = argc > 3 ? atof(argv[3]) : 10.0;
+	int targetMs = argc > 4 ? atoi(argv[4]) : 30;
+	bool pause = argc > 5 && strcmp(argv[5], "pause") == 0;
+
+	AudioHandler& handler = AudioHandler::get();
+	static char logContext[] = "Harness";
+	handler.setLoggingFunction(logContext, debugCallback);
+
+	if (strcmp(mode, "stretch") == 0) {
+		handler.setTimeStretchEnabled(true);
+	} else if (strcmp(mode, "polyphase") == 0) {
+		handler.setTimeStretchEnabled(false);
+		handler.setSamplingType(0);
+	} else if (strcmp(mode, "soundtouch") == 0) {
+		handler.setTimeStretchEnabled(false);
+		handler.setSamplingType(1);
+	} else if (strcmp(mode, "drc") == 0) {
+		handler.setTimeStretchEnabled(false);
+		handler.setDynamicRateControl(true);
+	} else {
+		usage(argv[0]);
+		return 1;
+	}
+
+	handler.setTargetPrimingBuffersMs(targetMs);
+	handler.setSamplingRateSelection(outputFreq);
+	handler.initializeAudio(inputFreq);
+
+	printf("Harness: %s, drift %+.3f%%, %.1fs, target %dms%s\n", mode, driftPercent, seconds, targetMs,
+		   pause ? ", paused halfway" : "");
+
+	// A push covers one emulated frame, which takes less real time when the emulated clock is fast
+	const std::chrono::duration<double> pushPeriod(1.0 / framesPerSecond / (1.0 + driftPercent / 100.0));
+	const double framesPerPush = inputFreq / framesPerSecond;
+	const int pushes = static_cast<int>(seconds / pushPeriod.count());
+
+	std::vector<int16_t> samples(static_cast<size_t>(framesPerPush + 1) * AudioHandler::numberOfChannels);
+	double pendingFrames = 0.0;
+	long long generatedFrames = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	auto nextPush = start;
+
+	for (int push = 0; push < pushes; ++push) {
+
+		if (pause && push == pushes / 2) {
+			handler.pausePlayback();
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			handler.resumePlayback();
+			nextPush = std::chrono::steady_clock::now();
+		}
+
+		pendingFrames += framesPerPush;
+		int frames = static_cast<int>(pendingFrames);
+		pendingFrames -= frames;
+
+		// 440Hz and 660Hz tones, in the interleaved stereo format AI DMA provides
+		for (int frame = 0; frame < frames; ++frame) {
+			double time = static_cast<double>(generatedFrames + frame) / inputFreq;
+			samples[frame * 2] = static_cast<int16_t>(8000.0 * sin(2.0 * pi * 440.0 * time));
+			samples[frame * 2 + 1] = static_cast<int16_t>(8000.0 * sin(2.0 * pi * 660.0 * time));
+		}
+		generatedFrames += frames;
+
+		handler.pushData(samples.data(), frames, std::chrono::steady_clock::now() - start);
+
+		nextPush += std::chrono::duration_cast<std::chrono::steady_clock::duration>(pushPeriod);
+		std::this_thread::sleep_until(nextPush);
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	printf("Harness: pushed %lld frames in %.2fs, %.1f frames per second\n", generatedFrames, elapsed.count(),
+		   generatedFrames / elapsed.count());
+
+	handler.closeAudio();
+	return 0;
+}
@@ -35,15 +35,21 @@ LOCAL_SRC_FILES :=                                              \
     $(SRCDIR)/api/vidext.c                                      \
     $(SRCDIR)/backends/plugins_compat/audio_plugin_compat.c     \
     $(SRCDIR)/backends/plugins_compat/input_plugin_compat.c     \
+    $(SRCDIR)/backends/async_disk_storage.c                     \
+    $(SRCDIR)/backends/async_file_storage.c                     \
     $(SRCDIR)/backends/clock_ctime_plus_delta.c                 \
     $(SRCDIR)/backends/file_storage.c                           \
+    $(SRCDIR)/backends/prefetch_video_capture.c                 \
+    $(SRCDIR)/backends/thread_task_runner.c                     \
     $(SRCDIR)/backends/dummy_video_capture.c                    \
+    $(SRCDIR)/backends/file_video_capture.c                     \
     $(SRCDIR)/backends/api/video_capture_backend.c              \
     $(SRCDIR)/main/cheat.c                                      \
     $(SRCDIR)/device/device.c                                   \
     $(SRCDIR)/main/eventloop.c                                  \
     $(SRCDIR)/main/main.c                                       \
     $(SRCDIR)/main/profile.c                                    \
+    $(SRCDIR)/main/qoi.c                                        \
     $(SRCDIR)/main/rom.c                                        \
     $(SRCDIR)/main/savestates.c                                 \
     $(SRCDIR)/main/sdl_key_converter.c                          \
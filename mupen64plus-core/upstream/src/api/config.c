@@ -42,6 +42,12 @@
 #define MUPEN64PLUS_CFG_NAME "mupen64plus.cfg"
 
 #define SECTION_MAGIC 0xDBDC0580
+#define PARAM_MAGIC   0xDBDC0581
+
+/* initial sizes of the hash tables, which are doubled when they hold as many entries as buckets */
+#define SECTION_TABLE_SIZE 32
+#define VAR_TABLE_SIZE     16
+#define PARAM_TABLE_SIZE   32
 
 struct external_config {
   char *file;
@@ -50,6 +56,7 @@ struct external_config {
 
 typedef struct _config_var {
   char                 *name;
+  unsigned int          hash;
   m64p_type             type;
   union {
     int integer;
@@ -57,26 +64,62 @@ typedef struct _config_var {
     char *string;
   } val;
   char                 *comment;
+  struct _config_param *param;      /* handle bound to this variable, only in the Active list */
+  struct _config_var   *hash_next;
   struct _config_var   *next;
   } config_var;
 
 typedef struct _config_section {
   unsigned int            magic;
   char                   *name;
+  unsigned int            hash;
   struct _config_var     *first_var;
+  struct _config_var     *last_var;
+  struct _config_var    **var_table;
+  unsigned int            var_table_size;
+  unsigned int            var_count;
+  struct _config_section *hash_next;
   struct _config_section *next;
   } config_section;
 
-typedef config_section *config_list;
+typedef struct {
+  config_section  *first;           /* sections in alphabetical order */
+  config_section **table;
+  unsigned int     table_size;
+  unsigned int     count;
+  } config_list;
+
+typedef struct _config_listener {
+  void                    (*callback)(void *, m64p_handle);
+  void                     *context;
+  struct _config_listener  *next;
+  } config_listener;
+
+/* Parameter handles are interned (section, parameter) names which live until ConfigShutdown.
+ * They follow the parameter through section deletion and reverts, var is NULL while the
+ * parameter doesn't exist in the Active list.
+ */
+typedef struct _config_param {
+  unsigned int          magic;
+  char                 *section_name;
+  char                 *name;
+  unsigned int          hash;
+  config_var           *var;
+  config_listener      *listeners;
+  struct _config_param *hash_next;
+  } config_param;
 
 /* local variables */
-static int         l_ConfigInit = 0;
-static char       *l_DataDirOverride = NULL;
-static char       *l_ConfigDirOverride = NULL;
-static char       *l_UserCacheDirOverride = NULL;
-static char       *l_UserDataDirOverride = NULL;
-static config_list l_ConfigListActive = NULL;
-static config_list l_ConfigListSaved = NULL;
+static int            l_ConfigInit = 0;
+static char          *l_DataDirOverride = NULL;
+static char          *l_ConfigDirOverride = NULL;
+static char          *l_UserCacheDirOverride = NULL;
+static char          *l_UserDataDirOverride = NULL;
+static config_list    l_ConfigListActive = { NULL, NULL, 0, 0 };
+static config_list    l_ConfigListSaved = { NULL, NULL, 0, 0 };
+static config_param **l_ParamTable = NULL;
+static unsigned int   l_ParamTableSize = 0;
+static unsigned int   l_ParamCount = 0;
 
 /* --------------- */
 /* local functions */
@@ -93,36 +136,109 @@ static int is_numeric(const char *string)
     return (rval == 1);
 }
 
-/* This function returns a pointer to the pointer of the requested section
- * (i.e. a pointer the next field of the previous element, or to the first node).
+/* FNV-1a hash of the name with ASCII letters folded to lower case, so that names which
+ * compare equal with osal_insensitive_strcmp() get the same hash.
+ */
+static unsigned int name_hash(const char *name)
+{
+    unsigned int hash = 2166136261u;
+    while (*name != 0)
+    {
+        unsigned char c = (unsigned char) *name++;
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash;
+}
+
+static unsigned int param_hash(unsigned int section_hash, unsigned int var_hash)
+{
+    return section_hash ^ (var_hash * 0x9E3779B1u);
+}
+
+static int list_grow_table(config_list *list)
+{
+    unsigned int new_size = (list->table_size == 0) ? SECTION_TABLE_SIZE : list->table_size * 2;
+    config_section **new_table;
+    config_section *curr_section;
+
+    new_table = (config_section **) calloc(new_size, sizeof(config_section *));
+    if (new_table == NULL)
+        return 0;
+
+    for (curr_section = list->first; curr_section != NULL; curr_section = curr_section->next)
+    {
+        unsigned int bucket = curr_section->hash & (new_size - 1);
+        curr_section->hash_next = new_table[bucket];
+        new_table[bucket] = curr_section;
+    }
+
+    free(list->table);
+    list->table = new_table;
+    list->table_size = new_size;
+    return 1;
+}
+
+/* This function inserts a section in the list at the position given by 'link', which
+ * must point to the next field of an element of the list or to its first node.
  *
- * If there's no section named 'ParamName', returns the pointer to the next
- * field of the last element in the list (such that derefencing it is NULL).
+ * Only fails if the hash table can't be allocated.
+ */
+static int list_insert_section(config_list *list, config_section **link, config_section *section)
+{
+    unsigned int bucket;
+
+    /* a table which couldn't grow is still usable, just more crowded */
+    if (list->count >= list->table_size && !list_grow_table(list) && list->table_size == 0)
+        return 0;
+
+    section->next = *link;
+    *link = section;
+
+    bucket = section->hash & (list->table_size - 1);
+    section->hash_next = list->table[bucket];
+    list->table[bucket] = section;
+    list->count++;
+    return 1;
+}
+
+static void list_unlink_section(config_list *list, config_section **link)
+{
+    config_section *section = *link;
+    config_section **bucket_link = &list->table[section->hash & (list->table_size - 1)];
+
+    while (*bucket_link != section)
+        bucket_link = &(*bucket_link)->hash_next;
+    *bucket_link = section->hash_next;
+
+    *link = section->next;
+    list->count--;
+}
+
+/* This function returns a pointer to the pointer of the given section
+ * (i.e. a pointer the next field of the previous element, or to the first node).
  *
  * Useful for operations that need to modify the links, e.g. deleting a section.
  */
-static config_section **find_section_link(config_list *list, const char *ParamName)
+static config_section **find_section_link(config_list *list, const config_section *section)
 {
     config_section **curr_sec_link;
-    for (curr_sec_link = list; *curr_sec_link != NULL; curr_sec_link = &(*curr_sec_link)->next)
-    {
-        if (osal_insensitive_strcmp(ParamName, (*curr_sec_link)->name) == 0)
-            break;
-    }
+    for (curr_sec_link = &list->first; *curr_sec_link != section; curr_sec_link = &(*curr_sec_link)->next)
+        ;
 
     return curr_sec_link;
 }
 
-/* This function is similar to the previous function, but instead it returns a
- * pointer to the pointer to the next section whose name is alphabetically
- * greater than or equal to 'ParamName'.
+/* This function returns a pointer to the pointer to the next section whose name
+ * is alphabetically greater than or equal to 'ParamName'.
  *
  * Useful for inserting a section in its alphabetical position.
  */
 static config_section **find_alpha_section_link(config_list *list, const char *ParamName)
 {
     config_section **curr_sec_link;
-    for (curr_sec_link = list; *curr_sec_link != NULL; curr_sec_link = &(*curr_sec_link)->next)
+    for (curr_sec_link = &list->first; *curr_sec_link != NULL; curr_sec_link = &(*curr_sec_link)->next)
     {
         if (osal_insensitive_strcmp((*curr_sec_link)->name, ParamName) >= 0)
             break;
@@ -131,9 +247,22 @@ static config_section **find_alpha_section_link(config_list *list, const char *P
     return curr_sec_link;
 }
 
-static config_section *find_section(config_list list, const char *ParamName)
+static config_section *find_section(const config_list *list, const char *ParamName)
 {
-    return *find_section_link(&list, ParamName);
+    config_section *curr_section;
+    unsigned int hash;
+
+    if (list->table_size == 0)
+        return NULL;
+
+    hash = name_hash(ParamName);
+    for (curr_section = list->table[hash & (list->table_size - 1)]; curr_section != NULL; curr_section = curr_section->hash_next)
+    {
+        if (curr_section->hash == hash && osal_insensitive_strcmp(ParamName, curr_section->name) == 0)
+            return curr_section;
+    }
+
+    return NULL;
 }
 
 static config_var *config_var_create(const char *ParamName, const char *ParamHelp)
@@ -155,6 +284,7 @@ static config_var *config_var_create(const char *ParamName, const char *ParamHel
         free(var);
         return NULL;
     }
+    var->hash = name_hash(ParamName);
 
     var->type = M64TYPE_INT;
     var->val.integer = 0;
@@ -176,13 +306,19 @@ static config_var *config_var_create(const char *ParamName, const char *ParamHel
     return var;
 }
 
-static config_var *find_section_var(config_section *section, const char *ParamName)
+static config_var *find_section_var(const config_section *section, const char *ParamName)
 {
-    /* walk through the linked list of variables in the section */
     config_var *curr_var;
-    for (curr_var = section->first_var; curr_var != NULL; curr_var = curr_var->next)
+    unsigned int hash;
+
+    if (section->var_table_size == 0)
+        return NULL;
+
+    /* walk through the hash chain of this name */
+    hash = name_hash(ParamName);
+    for (curr_var = section->var_table[hash & (section->var_table_size - 1)]; curr_var != NULL; curr_var = curr_var->hash_next)
     {
-        if (osal_insensitive_strcmp(ParamName, curr_var->name) == 0)
+        if (curr_var->hash == hash && osal_insensitive_strcmp(ParamName, curr_var->name) == 0)
             return curr_var;
     }
 
@@ -190,28 +326,283 @@ static config_var *find_section_var(config_section *section, const char *ParamNa
     return NULL;
 }
 
-static void append_var_to_section(config_section *section, config_var *var)
+static int section_grow_var_table(config_section *section)
 {
-    config_var *last_var;
+    unsigned int new_size = (section->var_table_size == 0) ? VAR_TABLE_SIZE : section->var_table_size * 2;
+    config_var **new_table;
+    config_var *curr_var;
 
-    if (section == NULL || var == NULL || section->magic != SECTION_MAGIC)
-        return;
+    new_table = (config_var **) calloc(new_size, sizeof(config_var *));
+    if (new_table == NULL)
+        return 0;
 
-    if (section->first_var == NULL)
+    for (curr_var = section->first_var; curr_var != NULL; curr_var = curr_var->next)
     {
+        unsigned int bucket = curr_var->hash & (new_size - 1);
+        curr_var->hash_next = new_table[bucket];
+        new_table[bucket] = curr_var;
+    }
+
+    free(section->var_table);
+    section->var_table = new_table;
+    section->var_table_size = new_size;
+    return 1;
+}
+
+/* Appends a variable to the section and indexes it. Only fails if the hash table can't be allocated. */
+static int section_add_var(config_section *section, config_var *var)
+{
+    unsigned int bucket;
+
+    if (section->var_count >= section->var_table_size && !section_grow_var_table(section) && section->var_table_size == 0)
+        return 0;
+
+    if (section->last_var == NULL)
         section->first_var = var;
-        return;
+    else
+        section->last_var->next = var;
+    section->last_var = var;
+
+    bucket = var->hash & (section->var_table_size - 1);
+    var->hash_next = section->var_table[bucket];
+    section->var_table[bucket] = var;
+    section->var_count++;
+    return 1;
+}
+
+static config_param *find_param(const char *SectionName, const char *ParamName, unsigned int hash)
+{
+    config_param *param;
+
+    if (l_ParamTableSize == 0)
+        return NULL;
+
+    for (param = l_ParamTable[hash & (l_ParamTableSize - 1)]; param != NULL; param = param->hash_next)
+    {
+        if (param->hash == hash && osal_insensitive_strcmp(ParamName, param->name) == 0 &&
+            osal_insensitive_strcmp(SectionName, param->section_name) == 0)
+            return param;
+    }
+
+    return NULL;
+}
+
+static int grow_param_table(void)
+{
+    unsigned int new_size = (l_ParamTableSize == 0) ? PARAM_TABLE_SIZE : l_ParamTableSize * 2;
+    config_param **new_table;
+    unsigned int i;
+
+    new_table = (config_param **) calloc(new_size, sizeof(config_param *));
+    if (new_table == NULL)
+        return 0;
+
+    for (i = 0; i < l_ParamTableSize; i++)
+    {
+        config_param *param = l_ParamTable[i];
+        while (param != NULL)
+        {
+            config_param *next_param = param->hash_next;
+            unsigned int bucket = param->hash & (new_size - 1);
+            param->hash_next = new_table[bucket];
+            new_table[bucket] = param;
+            param = next_param;
+        }
     }
 
-    last_var = section->first_var;
-    while (last_var->next != NULL)
-        last_var = last_var->next;
+    free(l_ParamTable);
+    l_ParamTable = new_table;
+    l_ParamTableSize = new_size;
+    return 1;
+}
+
+static config_param *config_param_create(const config_section *section, config_var *var)
+{
+    config_param *param;
+    unsigned int bucket;
+
+    if (l_ParamCount >= l_ParamTableSize && !grow_param_table() && l_ParamTableSize == 0)
+        return NULL;
 
-    last_var->next = var;
+    param = (config_param *) malloc(sizeof(config_param));
+    if (param == NULL)
+        return NULL;
+
+    param->magic = PARAM_MAGIC;
+    param->section_name = strdup(section->name);
+    param->name = strdup(var->name);
+    if (param->section_name == NULL || param->name == NULL)
+    {
+        free(param->section_name);
+        free(param->name);
+        free(param);
+        return NULL;
+    }
+    param->hash = param_hash(section->hash, var->hash);
+    param->var = var;
+    param->listeners = NULL;
+    var->param = param;
+
+    bucket = param->hash & (l_ParamTableSize - 1);
+    param->hash_next = l_ParamTable[bucket];
+    l_ParamTable[bucket] = param;
+    l_ParamCount++;
+    return param;
+}
+
+static void delete_params(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < l_ParamTableSize; i++)
+    {
+        config_param *param = l_ParamTable[i];
+        while (param != NULL)
+        {
+            config_param *next_param = param->hash_next;
+            config_listener *listener = param->listeners;
+            while (listener != NULL)
+            {
+                config_listener *next_listener = listener->next;
+                free(listener);
+                listener = next_listener;
+            }
+            free(param->section_name);
+            free(param->name);
+            free(param);
+            param = next_param;
+        }
+    }
+
+    free(l_ParamTable);
+    l_ParamTable = NULL;
+    l_ParamTableSize = 0;
+    l_ParamCount = 0;
+}
+
+static void notify_param(config_param *param)
+{
+    config_listener *listener = param->listeners;
+    while (listener != NULL)
+    {
+        config_listener *next_listener = listener->next;
+        (*listener->callback)(listener->context, (m64p_handle) param);
+        listener = next_listener;
+    }
+}
+
+/* Attaches the handle of this parameter, if one was given out, to a variable of an Active section */
+static config_param *bind_var_param(const config_section *section, config_var *var)
+{
+    config_param *param = find_param(section->name, var->name, param_hash(section->hash, var->hash));
+    if (param == NULL)
+        return NULL;
+
+    param->var = var;
+    var->param = param;
+    return param;
+}
+
+static int var_has_value(const config_var *var, m64p_type ParamType, const void *ParamValue)
+{
+    if (var->type != ParamType)
+        return 0;
+
+    switch (ParamType)
+    {
+        case M64TYPE_INT:
+            return var->val.integer == *((const int *) ParamValue);
+        case M64TYPE_FLOAT:
+            return var->val.number == *((const float *) ParamValue);
+        case M64TYPE_BOOL:
+            return var->val.integer == (*((const int *) ParamValue) != 0);
+        case M64TYPE_STRING:
+            return var->val.string != NULL && strcmp(var->val.string, (const char *) ParamValue) == 0;
+        default:
+            return 0;
+    }
+}
+
+static int vars_equal(const config_var *var1, const config_var *var2)
+{
+    if (var1 == NULL || var2 == NULL)
+        return var1 == var2;
+
+    if (var2->type == M64TYPE_STRING)
+        return var2->val.string != NULL && var_has_value(var1, var2->type, var2->val.string);
+
+    return var_has_value(var1, var2->type, &var2->val);
+}
+
+/* Adds a new variable to an Active section, notifying the parameter handle if there's one */
+static int append_var_to_section(config_section *section, config_var *var)
+{
+    config_param *param;
+
+    if (section == NULL || var == NULL || section->magic != SECTION_MAGIC)
+        return 0;
+
+    if (!section_add_var(section, var))
+        return 0;
+
+    param = bind_var_param(section, var);
+    if (param != NULL)
+        notify_param(param);
+
+    return 1;
+}
+
+/* Detaches the handles from the variables of an Active section which is going to be deleted */
+static void release_section_params(config_section *section)
+{
+    config_var *curr_var;
+
+    for (curr_var = section->first_var; curr_var != NULL; curr_var = curr_var->next)
+    {
+        config_param *param = curr_var->param;
+        if (param == NULL)
+            continue;
+
+        param->var = NULL;
+        curr_var->param = NULL;
+        notify_param(param);
+    }
+}
+
+/* Moves the handles from the variables of 'old_section' to the matching variables of 'section',
+ * notifying the parameters whose value changed. Both sections have the same name.
+ */
+static void rebind_section_params(config_section *section, config_section *old_section)
+{
+    config_var *curr_var;
+
+    if (l_ParamCount == 0)
+        return;
+
+    for (curr_var = section->first_var; curr_var != NULL; curr_var = curr_var->next)
+    {
+        config_var *old_var;
+        config_param *param = find_param(section->name, curr_var->name, param_hash(section->hash, curr_var->hash));
+        if (param == NULL)
+            continue;
+
+        old_var = param->var;
+        if (old_var != NULL)
+            old_var->param = NULL;
+        param->var = curr_var;
+        curr_var->param = param;
+        if (!vars_equal(old_var, curr_var))
+            notify_param(param);
+    }
+
+    /* parameters which don't exist anymore */
+    release_section_params(old_section);
 }
 
 static void delete_var(config_var *var)
 {
+    if (var->param != NULL && var->param->var == var)
+        var->param->var = NULL;
     if (var->type == M64TYPE_STRING)
         free(var->val.string);
     free(var->name);
@@ -234,13 +625,14 @@ static void delete_section(config_section *pSection)
         curr_var = next_var;
     }
 
+    free(pSection->var_table);
     free(pSection->name);
     free(pSection);
 }
 
 static void delete_list(config_list *pConfigList)
 {
-    config_section *curr_section = *pConfigList;
+    config_section *curr_section = pConfigList->first;
     while (curr_section != NULL)
     {
         config_section *next_section = curr_section->next;
@@ -250,7 +642,11 @@ static void delete_list(config_list *pConfigList)
         curr_section = next_section;
     }
 
-    *pConfigList = NULL;
+    free(pConfigList->table);
+    pConfigList->first = NULL;
+    pConfigList->table = NULL;
+    pConfigList->table_size = 0;
+    pConfigList->count = 0;
 }
 
 static config_section *config_section_create(const char *ParamName)
@@ -271,7 +667,13 @@ static config_section *config_section_create(const char *ParamName)
         free(sec);
         return NULL;
     }
+    sec->hash = name_hash(ParamName);
     sec->first_var = NULL;
+    sec->last_var = NULL;
+    sec->var_table = NULL;
+    sec->var_table_size = 0;
+    sec->var_count = 0;
+    sec->hash_next = NULL;
     sec->next = NULL;
     return sec;
 }
@@ -279,7 +681,7 @@ static config_section *config_section_create(const char *ParamName)
 static config_section * section_deepcopy(config_section *orig_section)
 {
     config_section *new_section;
-    config_var *orig_var, *last_new_var;
+    config_var *orig_var;
 
     /* Input validation */
     if (orig_section == NULL)
@@ -292,7 +694,6 @@ static config_section * section_deepcopy(config_section *orig_section)
 
     /* create and copy all section variables */
     orig_var = orig_section->first_var;
-    last_new_var = NULL;
     while (orig_var != NULL)
     {
         config_var *new_var = config_var_create(orig_var->name, orig_var->comment);
@@ -332,11 +733,12 @@ static config_section * section_deepcopy(config_section *orig_section)
         }
 
         /* add the new variable to the new section */
-        if (last_new_var == NULL)
-            new_section->first_var = new_var;
-        else
-            last_new_var->next = new_var;
-        last_new_var = new_var;
+        if (!section_add_var(new_section, new_var))
+        {
+            delete_section(new_section);
+            delete_var(new_var);
+            return NULL;
+        }
         /* advance variable pointer in original section variable list */
         orig_var = orig_var->next;
     }
@@ -344,10 +746,30 @@ static config_section * section_deepcopy(config_section *orig_section)
     return new_section;
 }
 
+/* Exchanges the names (which only differ by case) and the variables of two sections */
+static void swap_section_contents(config_section *section1, config_section *section2)
+{
+    config_section tmp = *section1;
+
+    section1->name = section2->name;
+    section1->first_var = section2->first_var;
+    section1->last_var = section2->last_var;
+    section1->var_table = section2->var_table;
+    section1->var_table_size = section2->var_table_size;
+    section1->var_count = section2->var_count;
+
+    section2->name = tmp.name;
+    section2->first_var = tmp.first_var;
+    section2->last_var = tmp.last_var;
+    section2->var_table = tmp.var_table;
+    section2->var_table_size = tmp.var_table_size;
+    section2->var_count = tmp.var_count;
+}
+
 static void copy_configlist_active_to_saved(void)
 {
-    config_section *curr_section = l_ConfigListActive;
-    config_section *last_section = NULL;
+    config_section *curr_section = l_ConfigListActive.first;
+    config_section **last_link = &l_ConfigListSaved.first;
 
     /* delete any pre-existing Saved config list */
     delete_list(&l_ConfigListSaved);
@@ -357,15 +779,96 @@ static void copy_configlist_active_to_saved(void)
     {
         config_section *new_section = section_deepcopy(curr_section);
         if (new_section == NULL) break;
-        if (last_section == NULL)
-            l_ConfigListSaved = new_section;
-        else
-            last_section->next = new_section;
-        last_section = new_section;
+        if (!list_insert_section(&l_ConfigListSaved, last_link, new_section))
+        {
+            delete_section(new_section);
+            break;
+        }
+        last_link = &new_section->next;
         curr_section = curr_section->next;
     }
 }
 
+/* these translate the actual variable type to the requested one */
+
+static int var_get_int(const config_var *var, const char *FuncName)
+{
+    switch(var->type)
+    {
+        case M64TYPE_INT:
+            return var->val.integer;
+        case M64TYPE_FLOAT:
+            return (int) var->val.number;
+        case M64TYPE_BOOL:
+            return (var->val.integer != 0);
+        case M64TYPE_STRING:
+            return atoi(var->val.string);
+        default:
+            DebugMessage(M64MSG_ERROR, "%s(): invalid internal parameter type for '%s'", FuncName, var->name);
+            return 0;
+    }
+}
+
+static float var_get_float(const config_var *var, const char *FuncName)
+{
+    switch(var->type)
+    {
+        case M64TYPE_INT:
+            return (float) var->val.integer;
+        case M64TYPE_FLOAT:
+            return var->val.number;
+        case M64TYPE_BOOL:
+            return (var->val.integer != 0) ? 1.0f : 0.0f;
+        case M64TYPE_STRING:
+            return (float) atof(var->val.string);
+        default:
+            DebugMessage(M64MSG_ERROR, "%s(): invalid internal parameter type for '%s'", FuncName, var->name);
+            return 0.0;
+    }
+}
+
+static int var_get_bool(const config_var *var, const char *FuncName)
+{
+    switch(var->type)
+    {
+        case M64TYPE_INT:
+            return (var->val.integer != 0);
+        case M64TYPE_FLOAT:
+            return (var->val.number != 0.0);
+        case M64TYPE_BOOL:
+            return var->val.integer;
+        case M64TYPE_STRING:
+            return (osal_insensitive_strcmp(var->val.string, "true") == 0);
+        default:
+            DebugMessage(M64MSG_ERROR, "%s(): invalid internal parameter type for '%s'", FuncName, var->name);
+            return 0;
+    }
+}
+
+static const char *var_get_string(const config_var *var, const char *FuncName)
+{
+    static char outstr[64];  /* warning: not thread safe */
+
+    switch(var->type)
+    {
+        case M64TYPE_INT:
+            snprintf(outstr, 63, "%i", var->val.integer);
+            outstr[63] = 0;
+            return outstr;
+        case M64TYPE_FLOAT:
+            snprintf(outstr, 63, "%f", var->val.number);
+            outstr[63] = 0;
+            return outstr;
+        case M64TYPE_BOOL:
+            return (var->val.integer ? "True" : "False");
+        case M64TYPE_STRING:
+            return var->val.string;
+        default:
+            DebugMessage(M64MSG_ERROR, "%s(): invalid internal parameter type for '%s'", FuncName, var->name);
+            return "";
+    }
+}
+
 static m64p_error write_configlist_file(void)
 {
     config_section *curr_section;
@@ -396,7 +899,7 @@ static m64p_error write_configlist_file(void)
     fprintf(fPtr, "# This file is automatically read and written by the Mupen64Plus Core library\n");
 
     /* write out all of the config parameters from the Saved list */
-    curr_section = l_ConfigListSaved;
+    curr_section = l_ConfigListSaved.first;
     while (curr_section != NULL)
     {
         config_var *curr_var = curr_section->first_var;
@@ -618,9 +1121,10 @@ m64p_error ConfigShutdown(void)
         l_UserCacheDirOverride = NULL;
     }
 
-    /* free all of the memory in the 2 lists */
+    /* free all of the memory in the 2 lists, then the parameter handles */
     delete_list(&l_ConfigListActive);
     delete_list(&l_ConfigListSaved);
+    delete_params();
 
     return M64ERR_SUCCESS;
 }
@@ -747,7 +1251,7 @@ EXPORT m64p_error CALL ConfigListSections(void *context, void (*SectionListCallb
         return M64ERR_INPUT_ASSERT;
 
     /* just walk through the section list, making a callback for each section name */
-    curr_section = l_ConfigListActive;
+    curr_section = l_ConfigListActive.first;
     while (curr_section != NULL)
     {
         (*SectionListCallback)(context, curr_section->name);
@@ -767,11 +1271,11 @@ EXPORT m64p_error CALL ConfigOpenSection(const char *SectionName, m64p_handle *C
     if (SectionName == NULL || ConfigSectionHandle == NULL)
         return M64ERR_INPUT_ASSERT;
 
-    /* walk through the section list, looking for a case-insensitive name match */
-    curr_section = find_alpha_section_link(&l_ConfigListActive, SectionName);
-    if (*curr_section != NULL && osal_insensitive_strcmp(SectionName, (*curr_section)->name) == 0)
+    /* look up the section index for a case-insensitive name match */
+    new_section = find_section(&l_ConfigListActive, SectionName);
+    if (new_section != NULL)
     {
-        *ConfigSectionHandle = *curr_section;
+        *ConfigSectionHandle = new_section;
         return M64ERR_SUCCESS;
     }
 
@@ -781,8 +1285,12 @@ EXPORT m64p_error CALL ConfigOpenSection(const char *SectionName, m64p_handle *C
         return M64ERR_NO_MEMORY;
 
     /* add section to list in alphabetical order */
-    new_section->next = *curr_section;
-    *curr_section = new_section;
+    curr_section = find_alpha_section_link(&l_ConfigListActive, SectionName);
+    if (!list_insert_section(&l_ConfigListActive, curr_section, new_section))
+    {
+        delete_section(new_section);
+        return M64ERR_NO_MEMORY;
+    }
 
     *ConfigSectionHandle = new_section;
     return M64ERR_SUCCESS;
@@ -828,31 +1336,23 @@ EXPORT int CALL ConfigHasUnsavedChanges(const char *SectionName)
     /* if SectionName is NULL or blank, then check all sections */
     if (SectionName == NULL || strlen(SectionName) < 1)
     {
-        int iNumActiveSections = 0, iNumSavedSections = 0;
         /* first, search through all sections in Active list.  Recursively call ourself and return 1 if changed */
-        curr_section = l_ConfigListActive;
+        curr_section = l_ConfigListActive.first;
         while (curr_section != NULL)
         {
             if (ConfigHasUnsavedChanges(curr_section->name))
                 return 1;
             curr_section = curr_section->next;
-            iNumActiveSections++;
         }
-        /* Next, count the number of Saved sections and see if the count matches */
-        curr_section = l_ConfigListSaved;
-        while (curr_section != NULL)
-        {
-            curr_section = curr_section->next;
-            iNumSavedSections++;
-        }
-        if (iNumActiveSections == iNumSavedSections)
+        /* Next, see if the number of Saved sections matches */
+        if (l_ConfigListActive.count == l_ConfigListSaved.count)
             return 0;  /* no changes */
         else
             return 1;
     }
 
     /* walk through the Active section list, looking for a case-insensitive name match with input string */
-    input_section = find_section(l_ConfigListActive, SectionName);
+    input_section = find_section(&l_ConfigListActive, SectionName);
     if (input_section == NULL)
     {
         DebugMessage(M64MSG_ERROR, "ConfigHasUnsavedChanges(): section name '%s' not found!", SectionName);
@@ -860,7 +1360,7 @@ EXPORT int CALL ConfigHasUnsavedChanges(const char *SectionName)
     }
 
     /* walk through the Saved section list, looking for a case-insensitive name match */
-    curr_section = find_section(l_ConfigListSaved, SectionName);
+    curr_section = find_section(&l_ConfigListSaved, SectionName);
     if (curr_section == NULL)
     {
         /* if this section isn't present in saved list, then it has been newly created */
@@ -928,26 +1428,23 @@ EXPORT int CALL ConfigHasUnsavedChanges(const char *SectionName)
 
 EXPORT m64p_error CALL ConfigDeleteSection(const char *SectionName)
 {
-    config_section **curr_section_link;
-    config_section *next_section;
+    config_section *section;
 
     if (!l_ConfigInit)
         return M64ERR_NOT_INIT;
-    if (l_ConfigListActive == NULL)
-        return M64ERR_INPUT_NOT_FOUND;
+    if (SectionName == NULL)
+        return M64ERR_INPUT_ASSERT;
 
     /* find the named section and pull it out of the list */
-    curr_section_link = find_section_link(&l_ConfigListActive, SectionName);
-    if (*curr_section_link == NULL)
+    section = find_section(&l_ConfigListActive, SectionName);
+    if (section == NULL)
         return M64ERR_INPUT_NOT_FOUND;
 
-    next_section = (*curr_section_link)->next;
+    list_unlink_section(&l_ConfigListActive, find_section_link(&l_ConfigListActive, section));
 
-    /* delete the named section */
-    delete_section(*curr_section_link);
-
-    /* fix the pointer to point to the next section after the deleted one */
-    *curr_section_link = next_section;
+    /* its parameters don't exist anymore, then delete the named section */
+    release_section_params(section);
+    delete_section(section);
 
     return M64ERR_SUCCESS;
 }
@@ -975,7 +1472,7 @@ EXPORT m64p_error CALL ConfigSaveSection(const char *SectionName)
         return M64ERR_INPUT_ASSERT;
 
     /* walk through the Active section list, looking for a case-insensitive name match */
-    curr_section = find_section(l_ConfigListActive, SectionName);
+    curr_section = find_section(&l_ConfigListActive, SectionName);
     if (curr_section == NULL)
         return M64ERR_INPUT_NOT_FOUND;
 
@@ -985,19 +1482,23 @@ EXPORT m64p_error CALL ConfigSaveSection(const char *SectionName)
         return M64ERR_NO_MEMORY;
 
     /* update config section that's in the Saved list with the new one */
-    insertion_point = find_alpha_section_link(&l_ConfigListSaved, SectionName);
-    if (*insertion_point != NULL && osal_insensitive_strcmp((*insertion_point)->name, SectionName) == 0)
+    curr_section = find_section(&l_ConfigListSaved, SectionName);
+    if (curr_section != NULL)
     {
         /* the section exists in the saved list and will be replaced */
-        new_section->next = (*insertion_point)->next;
-        delete_section(*insertion_point);
-        *insertion_point = new_section;
+        insertion_point = find_section_link(&l_ConfigListSaved, curr_section);
+        list_unlink_section(&l_ConfigListSaved, insertion_point);
+        delete_section(curr_section);
     }
     else
     {
         /* the section didn't exist in the saved list and has to be inserted */
-        new_section->next = *insertion_point;
-        *insertion_point = new_section;
+        insertion_point = find_alpha_section_link(&l_ConfigListSaved, SectionName);
+    }
+    if (!list_insert_section(&l_ConfigListSaved, insertion_point, new_section))
+    {
+        delete_section(new_section);
+        return M64ERR_NO_MEMORY;
     }
 
     /* write the saved config list out to a file */
@@ -1006,7 +1507,7 @@ EXPORT m64p_error CALL ConfigSaveSection(const char *SectionName)
 
 EXPORT m64p_error CALL ConfigRevertChanges(const char *SectionName)
 {
-    config_section **active_section_link, *active_section, *saved_section, *new_section;
+    config_section *active_section, *saved_section, *new_section;
 
     /* check input conditions */
     if (!l_ConfigInit)
@@ -1015,13 +1516,12 @@ EXPORT m64p_error CALL ConfigRevertChanges(const char *SectionName)
         return M64ERR_INPUT_ASSERT;
 
     /* walk through the Active section list, looking for a case-insensitive name match with input string */
-    active_section_link = find_section_link(&l_ConfigListActive, SectionName);
-    active_section = *active_section_link;
+    active_section = find_section(&l_ConfigListActive, SectionName);
     if (active_section == NULL)
         return M64ERR_INPUT_NOT_FOUND;
 
     /* walk through the Saved section list, looking for a case-insensitive name match */
-    saved_section = find_section(l_ConfigListSaved, SectionName);
+    saved_section = find_section(&l_ConfigListSaved, SectionName);
     if (saved_section == NULL)
     {
         /* if this section isn't present in saved list, then it has been newly created */
@@ -1033,12 +1533,12 @@ EXPORT m64p_error CALL ConfigRevertChanges(const char *SectionName)
     if (new_section == NULL)
         return M64ERR_NO_MEMORY;
 
-    /* replace active_section with saved_section in the linked list */
-    *active_section_link = new_section;
-    new_section->next = active_section->next;
+    /* take the contents of the copy, so that section handles given out stay valid */
+    swap_section_contents(active_section, new_section);
+    rebind_section_params(active_section, new_section);
 
-    /* release memory associated with active_section */
-    delete_section(active_section);
+    /* release memory associated with the previous variables */
+    delete_section(new_section);
 
     return M64ERR_SUCCESS;
 }
@@ -1052,6 +1552,7 @@ EXPORT m64p_error CALL ConfigSetParameter(m64p_handle ConfigSectionHandle, const
 {
     config_section *section;
     config_var *var;
+    int created = 0;
 
     /* check input conditions */
     if (!l_ConfigInit)
@@ -1063,14 +1564,18 @@ EXPORT m64p_error CALL ConfigSetParameter(m64p_handle ConfigSectionHandle, const
     if (section->magic != SECTION_MAGIC)
         return M64ERR_INPUT_INVALID;
 
-    /* if this parameter doesn't already exist, then create it and add it to the section */
+    /* nothing to do (nor to notify) if the parameter already has this value */
     var = find_section_var(section, ParamName);
+    if (var != NULL && var_has_value(var, ParamType, ParamValue))
+        return M64ERR_SUCCESS;
+
+    /* if this parameter doesn't already exist, then create it, it is added to the section once set */
     if (var == NULL)
     {
         var = config_var_create(ParamName, NULL);
         if (var == NULL)
             return M64ERR_NO_MEMORY;
-        append_var_to_section(section, var);
+        created = 1;
     }
 
     /* cleanup old values */
@@ -1099,13 +1604,28 @@ EXPORT m64p_error CALL ConfigSetParameter(m64p_handle ConfigSectionHandle, const
         case M64TYPE_STRING:
             var->val.string = strdup((char *)ParamValue);
             if (var->val.string == NULL)
+            {
+                if (created)
+                    delete_var(var);
                 return M64ERR_NO_MEMORY;
+            }
             break;
         default:
             /* this is logically impossible because of the ParamType check at the top of this function */
             break;
     }
 
+    if (created)
+    {
+        if (!append_var_to_section(section, var))
+        {
+            delete_var(var);
+            return M64ERR_NO_MEMORY;
+        }
+    }
+    else if (var->param != NULL)
+        notify_param(var->param);
+
     return M64ERR_SUCCESS;
 }
 
@@ -1270,7 +1790,11 @@ EXPORT m64p_error CALL ConfigSetDefaultInt(m64p_handle ConfigSectionHandle, cons
         return M64ERR_NO_MEMORY;
     var->type = M64TYPE_INT;
     var->val.integer = ParamValue;
-    append_var_to_section(section, var);
+    if (!append_var_to_section(section, var))
+    {
+        delete_var(var);
+        return M64ERR_NO_MEMORY;
+    }
 
     return M64ERR_SUCCESS;
 }
@@ -1305,7 +1829,11 @@ EXPORT m64p_error CALL ConfigSetDefaultFloat(m64p_handle ConfigSectionHandle, co
         return M64ERR_NO_MEMORY;
     var->type = M64TYPE_FLOAT;
     var->val.number = ParamValue;
-    append_var_to_section(section, var);
+    if (!append_var_to_section(section, var))
+    {
+        delete_var(var);
+        return M64ERR_NO_MEMORY;
+    }
 
     return M64ERR_SUCCESS;
 }
@@ -1340,7 +1868,11 @@ EXPORT m64p_error CALL ConfigSetDefaultBool(m64p_handle ConfigSectionHandle, con
         return M64ERR_NO_MEMORY;
     var->type = M64TYPE_BOOL;
     var->val.integer = ParamValue ? 1 : 0;
-    append_var_to_section(section, var);
+    if (!append_var_to_section(section, var))
+    {
+        delete_var(var);
+        return M64ERR_NO_MEMORY;
+    }
 
     return M64ERR_SUCCESS;
 }
@@ -1380,7 +1912,11 @@ EXPORT m64p_error CALL ConfigSetDefaultString(m64p_handle ConfigSectionHandle, c
         delete_var(var);
         return M64ERR_NO_MEMORY;
     }
-    append_var_to_section(section, var);
+    if (!append_var_to_section(section, var))
+    {
+        delete_var(var);
+        return M64ERR_NO_MEMORY;
+    }
 
     return M64ERR_SUCCESS;
 }
@@ -1412,21 +1948,7 @@ EXPORT int CALL ConfigGetParamInt(m64p_handle ConfigSectionHandle, const char *P
         return 0;
     }
 
-    /* translate the actual variable type to an int */
-    switch(var->type)
-    {
-        case M64TYPE_INT:
-            return var->val.integer;
-        case M64TYPE_FLOAT:
-            return (int) var->val.number;
-        case M64TYPE_BOOL:
-            return (var->val.integer != 0);
-        case M64TYPE_STRING:
-            return atoi(var->val.string);
-        default:
-            DebugMessage(M64MSG_ERROR, "ConfigGetParamInt(): invalid internal parameter type for '%s'", ParamName);
-            return 0;
-    }
+    return var_get_int(var, "ConfigGetParamInt");
 }
 
 EXPORT float CALL ConfigGetParamFloat(m64p_handle ConfigSectionHandle, const char *ParamName)
@@ -1456,21 +1978,7 @@ EXPORT float CALL ConfigGetParamFloat(m64p_handle ConfigSectionHandle, const cha
         return 0.0;
     }
 
-    /* translate the actual variable type to a float */
-    switch(var->type)
-    {
-        case M64TYPE_INT:
-            return (float) var->val.integer;
-        case M64TYPE_FLOAT:
-            return var->val.number;
-        case M64TYPE_BOOL:
-            return (var->val.integer != 0) ? 1.0f : 0.0f;
-        case M64TYPE_STRING:
-            return (float) atof(var->val.string);
-        default:
-            DebugMessage(M64MSG_ERROR, "ConfigGetParamFloat(): invalid internal parameter type for '%s'", ParamName);
-            return 0.0;
-    }
+    return var_get_float(var, "ConfigGetParamFloat");
 }
 
 EXPORT int CALL ConfigGetParamBool(m64p_handle ConfigSectionHandle, const char *ParamName)
@@ -1500,26 +2008,11 @@ EXPORT int CALL ConfigGetParamBool(m64p_handle ConfigSectionHandle, const char *
         return 0;
     }
 
-    /* translate the actual variable type to an int (0 or 1) */
-    switch(var->type)
-    {
-        case M64TYPE_INT:
-            return (var->val.integer != 0);
-        case M64TYPE_FLOAT:
-            return (var->val.number != 0.0);
-        case M64TYPE_BOOL:
-            return var->val.integer;
-        case M64TYPE_STRING:
-            return (osal_insensitive_strcmp(var->val.string, "true") == 0);
-        default:
-            DebugMessage(M64MSG_ERROR, "ConfigGetParamBool(): invalid internal parameter type for '%s'", ParamName);
-            return 0;
-    }
+    return var_get_bool(var, "ConfigGetParamBool");
 }
 
 EXPORT const char * CALL ConfigGetParamString(m64p_handle ConfigSectionHandle, const char *ParamName)
 {
-    static char outstr[64];  /* warning: not thread safe */
     config_section *section;
     config_var *var;
 
@@ -1545,25 +2038,146 @@ EXPORT const char * CALL ConfigGetParamString(m64p_handle ConfigSectionHandle, c
         return "";
     }
 
-    /* translate the actual variable type to a string */
-    switch(var->type)
+    return var_get_string(var, "ConfigGetParamString");
+}
+
+/* ------------------------------------------------------------ */
+/* Parameter handle functions, exported outside of the Core     */
+/* ------------------------------------------------------------ */
+
+EXPORT m64p_error CALL ConfigGetParamHandle(m64p_handle ConfigSectionHandle, const char *ParamName, m64p_handle *ParamHandle)
+{
+    config_section *section;
+    config_var *var;
+    config_param *param;
+
+    /* check input conditions */
+    if (!l_ConfigInit)
+        return M64ERR_NOT_INIT;
+    if (ConfigSectionHandle == NULL || ParamName == NULL || ParamHandle == NULL)
+        return M64ERR_INPUT_ASSERT;
+
+    section = (config_section *) ConfigSectionHandle;
+    if (section->magic != SECTION_MAGIC)
+        return M64ERR_INPUT_INVALID;
+
+    /* if this parameter doesn't already exist, return an error */
+    var = find_section_var(section, ParamName);
+    if (var == NULL)
+        return M64ERR_INPUT_NOT_FOUND;
+
+    param = var->param;
+    if (param == NULL)
     {
-        case M64TYPE_INT:
-            snprintf(outstr, 63, "%i", var->val.integer);
-            outstr[63] = 0;
-            return outstr;
-        case M64TYPE_FLOAT:
-            snprintf(outstr, 63, "%f", var->val.number);
-            outstr[63] = 0;
-            return outstr;
-        case M64TYPE_BOOL:
-            return (var->val.integer ? "True" : "False");
-        case M64TYPE_STRING:
-            return var->val.string;
-        default:
-            DebugMessage(M64MSG_ERROR, "ConfigGetParamString(): invalid internal parameter type for '%s'", ParamName);
-            return "";
+        param = config_param_create(section, var);
+        if (param == NULL)
+            return M64ERR_NO_MEMORY;
     }
+
+    *ParamHandle = param;
+    return M64ERR_SUCCESS;
+}
+
+static config_var *get_param_var(m64p_handle ParamHandle, const char *FuncName)
+{
+    config_param *param = (config_param *) ParamHandle;
+
+    /* check input conditions */
+    if (!l_ConfigInit || param == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "%s(): Input assertion!", FuncName);
+        return NULL;
+    }
+    if (param->magic != PARAM_MAGIC)
+    {
+        DebugMessage(M64MSG_ERROR, "%s(): ParamHandle invalid!", FuncName);
+        return NULL;
+    }
+
+    /* the parameter (or its section) may have been deleted since the handle was given */
+    if (param->var == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "%s(): Parameter '%s' not found!", FuncName, param->name);
+        return NULL;
+    }
+
+    return param->var;
+}
+
+EXPORT int CALL ConfigGetCachedParamInt(m64p_handle ParamHandle)
+{
+    config_var *var = get_param_var(ParamHandle, "ConfigGetCachedParamInt");
+    return (var != NULL) ? var_get_int(var, "ConfigGetCachedParamInt") : 0;
+}
+
+EXPORT float CALL ConfigGetCachedParamFloat(m64p_handle ParamHandle)
+{
+    config_var *var = get_param_var(ParamHandle, "ConfigGetCachedParamFloat");
+    return (var != NULL) ? var_get_float(var, "ConfigGetCachedParamFloat") : 0.0f;
+}
+
+EXPORT int CALL ConfigGetCachedParamBool(m64p_handle ParamHandle)
+{
+    config_var *var = get_param_var(ParamHandle, "ConfigGetCachedParamBool");
+    return (var != NULL) ? var_get_bool(var, "ConfigGetCachedParamBool") : 0;
+}
+
+EXPORT const char * CALL ConfigGetCachedParamString(m64p_handle ParamHandle)
+{
+    config_var *var = get_param_var(ParamHandle, "ConfigGetCachedParamString");
+    return (var != NULL) ? var_get_string(var, "ConfigGetCachedParamString") : "";
+}
+
+EXPORT m64p_error CALL ConfigRegisterParamCallback(m64p_handle ParamHandle, void *context, void (*ParamChangedCallback)(void *context, m64p_handle ParamHandle))
+{
+    config_param *param = (config_param *) ParamHandle;
+    config_listener *listener;
+
+    /* check input conditions */
+    if (!l_ConfigInit)
+        return M64ERR_NOT_INIT;
+    if (param == NULL || ParamChangedCallback == NULL)
+        return M64ERR_INPUT_ASSERT;
+    if (param->magic != PARAM_MAGIC)
+        return M64ERR_INPUT_INVALID;
+
+    listener = (config_listener *) malloc(sizeof(config_listener));
+    if (listener == NULL)
+        return M64ERR_NO_MEMORY;
+
+    listener->callback = ParamChangedCallback;
+    listener->context = context;
+    listener->next = param->listeners;
+    param->listeners = listener;
+
+    return M64ERR_SUCCESS;
+}
+
+EXPORT m64p_error CALL ConfigUnregisterParamCallback(m64p_handle ParamHandle, void *context, void (*ParamChangedCallback)(void *context, m64p_handle ParamHandle))
+{
+    config_param *param = (config_param *) ParamHandle;
+    config_listener **listener_link;
+
+    /* check input conditions */
+    if (!l_ConfigInit)
+        return M64ERR_NOT_INIT;
+    if (param == NULL || ParamChangedCallback == NULL)
+        return M64ERR_INPUT_ASSERT;
+    if (param->magic != PARAM_MAGIC)
+        return M64ERR_INPUT_INVALID;
+
+    for (listener_link = &param->listeners; *listener_link != NULL; listener_link = &(*listener_link)->next)
+    {
+        config_listener *listener = *listener_link;
+        if (listener->callback == ParamChangedCallback && listener->context == context)
+        {
+            *listener_link = listener->next;
+            free(listener);
+            return M64ERR_SUCCESS;
+        }
+    }
+
+    return M64ERR_INPUT_NOT_FOUND;
 }
 
 EXPORT m64p_error CALL ConfigOverrideUserPaths(const char *DataPath, const char *CachePath)
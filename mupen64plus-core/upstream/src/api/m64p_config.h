@@ -305,6 +305,51 @@ typedef m64p_error (*ptr_ConfigOverrideUserPaths)(const char*, const char*);
 EXPORT m64p_error CALL ConfigOverrideUserPaths(const char*, const char*);
 #endif
 
+/* ConfigGetParamHandle()
+ *
+ * This function gives a handle to an existing parameter of the given section,
+ * which may be kept and used with the ConfigGetCachedParam***() functions to
+ * read the parameter value without looking up its name again. The handle stays
+ * valid until the core configuration is shut down, even if the parameter or its
+ * section is deleted and created again.
+ */
+typedef m64p_error (*ptr_ConfigGetParamHandle)(m64p_handle, const char *, m64p_handle *);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT m64p_error CALL ConfigGetParamHandle(m64p_handle, const char *, m64p_handle *);
+#endif
+
+/* ConfigGetCachedParam***()
+ *
+ * These functions retrieve the value of the parameter given by a handle from
+ * ConfigGetParamHandle(), with the same conversions and error reporting as the
+ * ConfigGetParam***() functions.
+ */
+typedef int          (*ptr_ConfigGetCachedParamInt)(m64p_handle);
+typedef float        (*ptr_ConfigGetCachedParamFloat)(m64p_handle);
+typedef int          (*ptr_ConfigGetCachedParamBool)(m64p_handle);
+typedef const char * (*ptr_ConfigGetCachedParamString)(m64p_handle);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT int          CALL ConfigGetCachedParamInt(m64p_handle);
+EXPORT float        CALL ConfigGetCachedParamFloat(m64p_handle);
+EXPORT int          CALL ConfigGetCachedParamBool(m64p_handle);
+EXPORT const char * CALL ConfigGetCachedParamString(m64p_handle);
+#endif
+
+/* ConfigRegisterParamCallback()
+ * ConfigUnregisterParamCallback()
+ *
+ * These functions add or remove a function which is called, with the given
+ * context and the parameter handle, whenever the value of the parameter changes
+ * or when it is created or deleted. The callback is made from the thread which
+ * modified the configuration, and may not register or unregister callbacks.
+ */
+typedef m64p_error (*ptr_ConfigRegisterParamCallback)(m64p_handle, void *, void (*)(void *, m64p_handle));
+typedef m64p_error (*ptr_ConfigUnregisterParamCallback)(m64p_handle, void *, void (*)(void *, m64p_handle));
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT m64p_error CALL ConfigRegisterParamCallback(m64p_handle, void *, void (*)(void *, m64p_handle));
+EXPORT m64p_error CALL ConfigUnregisterParamCallback(m64p_handle, void *, void (*)(void *, m64p_handle));
+#endif
+
 #ifdef __cplusplus
 }
 #endif
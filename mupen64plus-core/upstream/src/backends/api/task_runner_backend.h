@@ -0,0 +1,55 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - task_runner_backend.h                                   *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_BACKENDS_API_TASK_RUNNER_BACKEND_H
+#define M64P_BACKENDS_API_TASK_RUNNER_BACKEND_H
+
+#include <stdint.h>
+
+#include "api/m64p_types.h"
+
+struct task_runner_backend_interface
+{
+    /* Initialize backend instance (*runner).
+     *
+     * Returns M64ERR_SUCCESS on success.
+     *
+     * You must call corresponding release method to release any allocated resources.
+     */
+    m64p_error (*init)(void** runner);
+
+    /* Release backend instance and any associated resources.
+     * Any task still in flight is waited for.
+     */
+    void (*release)(void* runner);
+
+    /* Start executing task(opaque) outside of the calling thread.
+     * Only one task can be in flight at a time.
+     */
+    void (*start)(void* runner, void (*task)(void*), void* opaque);
+
+    /* Block until the task started last has completed.
+     * Returns the time spent blocking in microseconds.
+     */
+    uint64_t (*wait)(void* runner);
+};
+
+#endif
@@ -25,6 +25,7 @@
 
 /* exported video capture backends */
 extern const struct video_capture_backend_interface g_idummy_video_capture_backend;
+extern const struct video_capture_backend_interface g_ifile_video_capture_backend;
 #if defined(M64P_OPENCV)
 extern const struct video_capture_backend_interface g_iopencv_video_capture_backend;
 #endif
@@ -35,6 +36,7 @@ const struct video_capture_backend_interface* g_video_capture_backend_interfaces
 #if defined(M64P_OPENCV)
     &g_iopencv_video_capture_backend,
 #endif
+    &g_ifile_video_capture_backend,
     &g_idummy_video_capture_backend,
     NULL /* sentinel - must be last element */
 };
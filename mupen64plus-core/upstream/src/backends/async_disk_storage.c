@@ -0,0 +1,431 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - async_disk_storage.c                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "async_disk_storage.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "backends/api/storage_backend.h"
+#include "backends/file_storage.h"
+#include "device/dd/disk.h"
+#include "main/util.h"
+#include "osal/files.h"
+#include "osal/thread_time.h"
+
+#if !defined(_MSC_VER)
+
+#include <pthread.h>
+
+/* Byte range of one LBA, relative to the saved storage */
+struct disk_extent
+{
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct disk_writer
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    const struct file_storage* fstorage;
+    uint64_t interval_us;
+
+    /* extents sorted by offset */
+    struct disk_extent* extents;
+    size_t count;
+
+    /* the following fields are guarded by lock */
+    uint8_t** pending;          /* saved content of each dirty extent, NULL if clean */
+    size_t* dirty;              /* indices of the dirty extents */
+    size_t dirty_count;
+    uint8_t* initial;           /* whole content, written before the dirty extents */
+    int create_file;            /* the file must be written whole on the next save */
+    uint64_t dirty_since_us;
+    int quit;
+    struct async_disk_storage_stats stats;
+
+    /* owned by the writer thread */
+    size_t* batch;
+    uint8_t** batch_data;
+};
+
+static int compare_extents(const void* a, const void* b)
+{
+    uint32_t offset_a = ((const struct disk_extent*)a)->offset;
+    uint32_t offset_b = ((const struct disk_extent*)b)->offset;
+    return (offset_a > offset_b) - (offset_a < offset_b);
+}
+
+/* Index of the last extent starting at or before offset, count if there is none */
+static size_t find_extent(const struct disk_writer* writer, size_t offset)
+{
+    size_t lo = 0;
+    size_t hi = writer->count;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (writer->extents[mid].offset <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return (lo == 0) ? writer->count : lo - 1;
+}
+
+/* Must be called with the writer lock held */
+static void snapshot_whole_storage(struct disk_writer* writer)
+{
+    size_t i;
+
+    free(writer->initial);
+    writer->initial = malloc(writer->fstorage->size);
+    if (writer->initial == NULL) {
+        DebugMessage(M64MSG_WARNING, "Failed to allocate DD disk save snapshot");
+        return;
+    }
+
+    memcpy(writer->initial, writer->fstorage->data, writer->fstorage->size);
+    writer->create_file = 0;
+
+    /* the snapshot supersedes every dirty extent, which could otherwise overwrite it with older content */
+    for (i = 0; i < writer->dirty_count; ++i) {
+        free(writer->pending[writer->dirty[i]]);
+        writer->pending[writer->dirty[i]] = NULL;
+    }
+    writer->dirty_count = 0;
+}
+
+/* Must be called with the writer lock held, which is released while writing */
+static void write_dirty_extents(struct disk_writer* writer)
+{
+    const char* filename = writer->fstorage->filename;
+    uint8_t* initial = writer->initial;
+    size_t count = writer->dirty_count;
+    uint64_t bytes_written = 0;
+    uint64_t write_start;
+    uint64_t write_time;
+    file_status_t err = file_ok;
+    size_t i;
+
+    for (i = 0; i < count; ++i) {
+        writer->batch[i] = writer->dirty[i];
+        writer->batch_data[i] = writer->pending[writer->dirty[i]];
+        writer->pending[writer->dirty[i]] = NULL;
+    }
+    writer->dirty_count = 0;
+    writer->initial = NULL;
+    pthread_mutex_unlock(&writer->lock);
+
+    write_start = osal_time_us();
+
+    if (initial != NULL) {
+        err = write_to_file_atomic(filename, initial, writer->fstorage->size);
+        if (err == file_ok)
+            bytes_written += writer->fstorage->size;
+        free(initial);
+    }
+
+    if (count > 0 && err == file_ok) {
+        FILE* f = osal_file_open(filename, "rb+");
+        if (f == NULL) {
+            err = file_open_error;
+        }
+        else {
+            for (i = 0; i < count; ++i) {
+                const struct disk_extent* extent = &writer->extents[writer->batch[i]];
+                if (fseek(f, extent->offset, SEEK_SET) != 0
+                 || fwrite(writer->batch_data[i], 1, extent->size, f) != extent->size) {
+                    err = file_write_error;
+                    break;
+                }
+                bytes_written += extent->size;
+            }
+            if (fclose(f) != 0)
+                err = file_write_error;
+        }
+    }
+
+    for (i = 0; i < count; ++i) {
+        free(writer->batch_data[i]);
+    }
+
+    write_time = osal_time_us() - write_start;
+
+    switch(err)
+    {
+    case file_open_error:
+        DebugMessage(M64MSG_WARNING, "couldn't open DD disk save file '%s' for writing", filename);
+        break;
+    case file_write_error:
+        DebugMessage(M64MSG_WARNING, "failed to write DD disk save file '%s'", filename);
+        break;
+    default:
+        break;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    /* the file is in an unknown state, rewrite it whole on the next save */
+    if (err != file_ok)
+        writer->create_file = 1;
+    ++writer->stats.flushes;
+    writer->stats.lbas_written += (err == file_ok) ? count : 0;
+    writer->stats.bytes_written += bytes_written;
+    writer->stats.write_us += write_time;
+}
+
+static void* disk_writer_loop(void* arg)
+{
+    struct disk_writer* writer = (struct disk_writer*)arg;
+
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        if (writer->dirty_count != 0 || writer->initial != NULL) {
+            uint64_t now = osal_time_us();
+            uint64_t due = writer->dirty_since_us + writer->interval_us;
+
+            if (due <= now || writer->quit) {
+                write_dirty_extents(writer);
+                continue;
+            }
+
+            osal_cond_timedwait_us(&writer->cond, &writer->lock, due - now);
+        }
+        else if (writer->quit) {
+            break;
+        }
+        else {
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    return NULL;
+}
+
+static void free_disk_writer(struct disk_writer* writer)
+{
+    size_t i;
+
+    if (writer->pending != NULL) {
+        for (i = 0; i < writer->count; ++i) {
+            free(writer->pending[i]);
+        }
+    }
+
+    free(writer->initial);
+    free(writer->extents);
+    free(writer->pending);
+    free(writer->dirty);
+    free(writer->batch);
+    free(writer->batch_data);
+    free(writer);
+}
+
+int open_async_disk_storage(struct async_disk_storage* storage, struct file_storage* fstorage,
+                            const struct dd_disk* disk, unsigned int interval_ms)
+{
+    const uint8_t* disk_data = disk->istorage->data(disk->storage);
+    size_t base = (size_t)(fstorage->data - disk_data);
+    size_t file_size = 0;
+    uint32_t lba;
+
+    struct disk_writer* w = calloc(1, sizeof(*w));
+    if (w == NULL)
+        return -1;
+
+    w->fstorage = fstorage;
+    w->interval_us = (uint64_t)interval_ms * 1000;
+    w->extents = malloc((SIZE_LBA) * sizeof(w->extents[0]));
+    w->pending = calloc((SIZE_LBA), sizeof(w->pending[0]));
+    w->dirty = malloc((SIZE_LBA) * sizeof(w->dirty[0]));
+    w->batch = malloc((SIZE_LBA) * sizeof(w->batch[0]));
+    w->batch_data = malloc((SIZE_LBA) * sizeof(w->batch_data[0]));
+    if (w->extents == NULL || w->pending == NULL || w->dirty == NULL
+     || w->batch == NULL || w->batch_data == NULL) {
+        free_disk_writer(w);
+        return -1;
+    }
+
+    /* keep the LBAs lying within the saved storage */
+    for (lba = 0; lba < (SIZE_LBA); ++lba) {
+        size_t offset = disk->lba_offset[lba];
+        size_t size = disk->lba_size[lba];
+
+        if (size == 0 || offset < base || offset + size > base + fstorage->size)
+            continue;
+
+        w->extents[w->count].offset = (uint32_t)(offset - base);
+        w->extents[w->count].size = (uint32_t)size;
+        ++w->count;
+    }
+    qsort(w->extents, w->count, sizeof(w->extents[0]), compare_extents);
+
+    w->create_file = (get_file_size(fstorage->filename, &file_size) != file_ok || file_size != fstorage->size);
+
+    if (pthread_mutex_init(&w->lock, NULL) != 0) {
+        free_disk_writer(w);
+        return -1;
+    }
+
+    if (pthread_cond_init(&w->cond, NULL) != 0) {
+        pthread_mutex_destroy(&w->lock);
+        free_disk_writer(w);
+        return -1;
+    }
+
+    if (pthread_create(&w->thread, NULL, disk_writer_loop, w) != 0) {
+        DebugMessage(M64MSG_ERROR, "Could not create DD disk writer thread");
+        pthread_cond_destroy(&w->cond);
+        pthread_mutex_destroy(&w->lock);
+        free_disk_writer(w);
+        return -1;
+    }
+
+    storage->fstorage = fstorage;
+    storage->writer = w;
+    return 0;
+}
+
+void close_async_disk_storage(struct async_disk_storage* storage, struct async_disk_storage_stats* stats)
+{
+    struct disk_writer* writer = storage->writer;
+
+    if (writer == NULL)
+        return;
+
+    /* the writer thread flushes unsaved changes before leaving */
+    pthread_mutex_lock(&writer->lock);
+    writer->quit = 1;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+
+    pthread_join(writer->thread, NULL);
+
+    if (stats != NULL)
+        *stats = writer->stats;
+
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->lock);
+    free_disk_writer(writer);
+    storage->writer = NULL;
+}
+
+static void async_disk_storage_save(void* storage, size_t start, size_t size)
+{
+    struct async_disk_storage* astorage = (struct async_disk_storage*)storage;
+    struct disk_writer* writer = astorage->writer;
+    const uint8_t* data = astorage->fstorage->data;
+    size_t end = start + size;
+    size_t i;
+    int was_clean;
+
+    pthread_mutex_lock(&writer->lock);
+
+    ++writer->stats.saves;
+    was_clean = (writer->dirty_count == 0 && writer->initial == NULL);
+
+    if (writer->create_file)
+        snapshot_whole_storage(writer);
+
+    for (i = find_extent(writer, start); start < end; ++i) {
+        const struct disk_extent* extent = &writer->extents[i];
+        size_t extent_end;
+
+        if (i >= writer->count || start < extent->offset || start >= extent->offset + extent->size) {
+            /* not within a known LBA, the whole content has to be rewritten */
+            snapshot_whole_storage(writer);
+            break;
+        }
+
+        extent_end = extent->offset + extent->size;
+
+        if (writer->pending[i] == NULL) {
+            writer->pending[i] = malloc(extent->size);
+            if (writer->pending[i] == NULL) {
+                snapshot_whole_storage(writer);
+                break;
+            }
+            memcpy(writer->pending[i], data + extent->offset, extent->size);
+            writer->dirty[writer->dirty_count++] = i;
+        }
+        else {
+            size_t chunk_end = (end < extent_end) ? end : extent_end;
+            memcpy(writer->pending[i] + (start - extent->offset), data + start, chunk_end - start);
+        }
+
+        start = extent_end;
+    }
+
+    if (was_clean && (writer->dirty_count != 0 || writer->initial != NULL)) {
+        writer->dirty_since_us = osal_time_us();
+        pthread_cond_broadcast(&writer->cond);
+    }
+
+    pthread_mutex_unlock(&writer->lock);
+}
+
+#else
+
+/* No writer thread available: callers are expected to fall back to g_ifile_storage */
+
+int open_async_disk_storage(struct async_disk_storage* storage, struct file_storage* fstorage,
+                            const struct dd_disk* disk, unsigned int interval_ms)
+{
+    return -1;
+}
+
+void close_async_disk_storage(struct async_disk_storage* storage, struct async_disk_storage_stats* stats)
+{
+}
+
+static void async_disk_storage_save(void* storage, size_t start, size_t size)
+{
+}
+
+#endif
+
+static uint8_t* async_disk_storage_data(const void* storage)
+{
+    const struct async_disk_storage* astorage = (const struct async_disk_storage*)storage;
+    return astorage->fstorage->data;
+}
+
+static size_t async_disk_storage_size(const void* storage)
+{
+    const struct async_disk_storage* astorage = (const struct async_disk_storage*)storage;
+    return astorage->fstorage->size;
+}
+
+
+const struct storage_backend_interface g_iasync_disk_storage =
+{
+    async_disk_storage_data,
+    async_disk_storage_size,
+    async_disk_storage_save
+};
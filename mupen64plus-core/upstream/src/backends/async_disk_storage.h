@@ -0,0 +1,66 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - async_disk_storage.h                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_BACKENDS_ASYNC_DISK_STORAGE_H
+#define M64P_BACKENDS_ASYNC_DISK_STORAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct dd_disk;
+struct file_storage;
+struct disk_writer;
+
+struct async_disk_storage_stats
+{
+    uint64_t saves;             /* save notifications received from the emulation thread */
+    uint64_t flushes;           /* batches of LBAs written */
+    uint64_t lbas_written;
+    uint64_t bytes_written;
+    uint64_t write_us;          /* time spent writing the file */
+};
+
+/* 64DD disk save whose changed LBAs are written behind by a dedicated thread.
+ * Saves copy the LBA they touch and mark it dirty, then at most interval_ms
+ * after the first unsaved change the dirty LBAs are written in place.
+ * If the save file doesn't exist yet, it is created with the whole content first.
+ */
+struct async_disk_storage
+{
+    struct file_storage* fstorage;
+    struct disk_writer* writer;
+};
+
+/* Wrap fstorage, whose data must lie within the storage of disk and which must
+ * outlive the async_disk_storage. The LBA table of disk must have been generated.
+ * Returns -1 on platforms without thread support.
+ */
+int open_async_disk_storage(struct async_disk_storage* storage, struct file_storage* fstorage,
+                            const struct dd_disk* disk, unsigned int interval_ms);
+
+/* Write any unsaved change right away and stop the writer thread.
+ * stats (if not NULL) receives the statistics of the storage lifetime.
+ */
+void close_async_disk_storage(struct async_disk_storage* storage, struct async_disk_storage_stats* stats);
+
+extern const struct storage_backend_interface g_iasync_disk_storage;
+
+#endif
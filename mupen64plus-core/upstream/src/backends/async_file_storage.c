@@ -0,0 +1,360 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - async_file_storage.c                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "async_file_storage.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "backends/api/storage_backend.h"
+#include "backends/file_storage.h"
+#include "main/util.h"
+#include "osal/thread_time.h"
+
+#if !defined(_MSC_VER)
+
+#include <pthread.h>
+
+struct storage_writer
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    struct async_file_storage* storages;
+    uint64_t interval_us;
+    int quit;
+
+    struct storage_writer_stats stats;
+};
+
+/* Must be called with the writer lock held, which is released while writing */
+static void write_storage(struct storage_writer* writer, struct async_file_storage* storage)
+{
+    struct file_storage* fstorage = storage->fstorage;
+    size_t start = storage->dirty_start;
+    size_t end = storage->dirty_end;
+    file_status_t err;
+    uint64_t write_start;
+    uint64_t write_time;
+
+    /* the snapshot already holds everything outside of the dirty range */
+    memcpy(storage->snapshot + start, storage->pending + start, end - start);
+    storage->dirty_start = storage->dirty_end = 0;
+    storage->writing = 1;
+    pthread_mutex_unlock(&writer->lock);
+
+    write_start = osal_time_us();
+    err = write_to_file_atomic(fstorage->filename, storage->snapshot, fstorage->size);
+    write_time = osal_time_us() - write_start;
+
+    switch(err)
+    {
+    case file_open_error:
+        DebugMessage(M64MSG_WARNING, "couldn't open storage file '%s' for writing", fstorage->filename);
+        break;
+    case file_write_error:
+        DebugMessage(M64MSG_WARNING, "failed to write storage file '%s'", fstorage->filename);
+        break;
+    default:
+        break;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    storage->writing = 0;
+
+    /* retry a failed write after the next interval, along with any newer changes */
+    if (err != file_ok) {
+        if (storage->dirty_start == storage->dirty_end) {
+            storage->dirty_start = start;
+            storage->dirty_end = end;
+            storage->dirty_since_us = osal_time_us();
+        }
+        else {
+            if (start < storage->dirty_start)
+                storage->dirty_start = start;
+            if (end > storage->dirty_end)
+                storage->dirty_end = end;
+        }
+    }
+
+    ++writer->stats.flushes;
+    writer->stats.bytes_written += (err == file_ok) ? fstorage->size : 0;
+    writer->stats.write_us += write_time;
+    pthread_cond_broadcast(&writer->cond);
+}
+
+static void* storage_writer_loop(void* arg)
+{
+    struct storage_writer* writer = (struct storage_writer*)arg;
+
+    pthread_mutex_lock(&writer->lock);
+    while (!writer->quit) {
+        struct async_file_storage* storage;
+        struct async_file_storage* due_storage = NULL;
+        uint64_t now = osal_time_us();
+        uint64_t next_due = UINT64_MAX;
+
+        for (storage = writer->storages; storage != NULL; storage = storage->next) {
+            uint64_t due;
+
+            if (storage->dirty_start == storage->dirty_end)
+                continue;
+
+            due = storage->dirty_since_us + writer->interval_us;
+            if (due <= now) {
+                due_storage = storage;
+                break;
+            }
+            if (due < next_due)
+                next_due = due;
+        }
+
+        if (due_storage != NULL) {
+            write_storage(writer, due_storage);
+        }
+        else if (next_due == UINT64_MAX) {
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+        else {
+            osal_cond_timedwait_us(&writer->cond, &writer->lock, next_due - now);
+        }
+    }
+    pthread_mutex_unlock(&writer->lock);
+
+    return NULL;
+}
+
+m64p_error init_storage_writer(struct storage_writer** writer, unsigned int interval_ms)
+{
+    struct storage_writer* w = calloc(1, sizeof(*w));
+    if (w == NULL)
+        return M64ERR_NO_MEMORY;
+
+    w->interval_us = (uint64_t)interval_ms * 1000;
+
+    if (pthread_mutex_init(&w->lock, NULL) != 0) {
+        free(w);
+        return M64ERR_SYSTEM_FAIL;
+    }
+
+    if (pthread_cond_init(&w->cond, NULL) != 0) {
+        pthread_mutex_destroy(&w->lock);
+        free(w);
+        return M64ERR_SYSTEM_FAIL;
+    }
+
+    if (pthread_create(&w->thread, NULL, storage_writer_loop, w) != 0) {
+        DebugMessage(M64MSG_ERROR, "Could not create storage writer thread");
+        pthread_cond_destroy(&w->cond);
+        pthread_mutex_destroy(&w->lock);
+        free(w);
+        return M64ERR_SYSTEM_FAIL;
+    }
+
+    *writer = w;
+    return M64ERR_SUCCESS;
+}
+
+void release_storage_writer(struct storage_writer* writer, struct storage_writer_stats* stats)
+{
+    if (writer == NULL)
+        return;
+
+    pthread_mutex_lock(&writer->lock);
+    writer->quit = 1;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+
+    pthread_join(writer->thread, NULL);
+
+    if (stats != NULL)
+        *stats = writer->stats;
+
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->lock);
+    free(writer);
+}
+
+int open_async_file_storage(struct async_file_storage* storage, struct file_storage* fstorage,
+                            struct storage_writer* writer)
+{
+    storage->fstorage = fstorage;
+    storage->writer = writer;
+    storage->dirty_start = storage->dirty_end = 0;
+    storage->dirty_since_us = 0;
+    storage->writing = 0;
+
+    storage->pending = malloc(fstorage->size);
+    storage->snapshot = malloc(fstorage->size);
+    if (storage->pending == NULL || storage->snapshot == NULL) {
+        free(storage->pending);
+        free(storage->snapshot);
+        storage->pending = storage->snapshot = NULL;
+        return -1;
+    }
+
+    memcpy(storage->pending, fstorage->data, fstorage->size);
+    memcpy(storage->snapshot, fstorage->data, fstorage->size);
+
+    pthread_mutex_lock(&writer->lock);
+    storage->next = writer->storages;
+    writer->storages = storage;
+    pthread_mutex_unlock(&writer->lock);
+
+    return 0;
+}
+
+void close_async_file_storage(struct async_file_storage* storage)
+{
+    struct storage_writer* writer = storage->writer;
+    struct async_file_storage** link;
+
+    if (storage->pending == NULL)
+        return;
+
+    pthread_mutex_lock(&writer->lock);
+    while (storage->writing)
+        pthread_cond_wait(&writer->cond, &writer->lock);
+
+    for (link = &writer->storages; *link != NULL; link = &(*link)->next) {
+        if (*link == storage) {
+            *link = storage->next;
+            break;
+        }
+    }
+
+    /* forced flush, the storage is not visible to the writer thread anymore */
+    if (storage->dirty_start != storage->dirty_end)
+        write_storage(writer, storage);
+    pthread_mutex_unlock(&writer->lock);
+
+    free(storage->pending);
+    free(storage->snapshot);
+    storage->pending = storage->snapshot = NULL;
+}
+
+static void async_file_storage_save(void* storage, size_t start, size_t size)
+{
+    struct async_file_storage* astorage = (struct async_file_storage*)storage;
+    struct storage_writer* writer = astorage->writer;
+    size_t end = start + size;
+
+    pthread_mutex_lock(&writer->lock);
+
+    memcpy(astorage->pending + start, astorage->fstorage->data + start, size);
+    ++writer->stats.saves;
+
+    if (astorage->dirty_start == astorage->dirty_end) {
+        astorage->dirty_start = start;
+        astorage->dirty_end = end;
+        astorage->dirty_since_us = osal_time_us();
+        pthread_cond_broadcast(&writer->cond);
+    }
+    else {
+        if (start < astorage->dirty_start)
+            astorage->dirty_start = start;
+        if (end > astorage->dirty_end)
+            astorage->dirty_end = end;
+    }
+
+    pthread_mutex_unlock(&writer->lock);
+}
+
+#else
+
+/* No writer thread available: callers are expected to fall back to g_ifile_storage */
+
+m64p_error init_storage_writer(struct storage_writer** writer, unsigned int interval_ms)
+{
+    return M64ERR_UNSUPPORTED;
+}
+
+void release_storage_writer(struct storage_writer* writer, struct storage_writer_stats* stats)
+{
+}
+
+int open_async_file_storage(struct async_file_storage* storage, struct file_storage* fstorage,
+                            struct storage_writer* writer)
+{
+    return -1;
+}
+
+void close_async_file_storage(struct async_file_storage* storage)
+{
+}
+
+static void async_file_storage_save(void* storage, size_t start, size_t size)
+{
+}
+
+#endif
+
+static uint8_t* async_file_storage_data(const void* storage)
+{
+    const struct async_file_storage* astorage = (const struct async_file_storage*)storage;
+    return astorage->fstorage->data;
+}
+
+static size_t async_file_storage_size(const void* storage)
+{
+    const struct async_file_storage* astorage = (const struct async_file_storage*)storage;
+    return astorage->fstorage->size;
+}
+
+static uint8_t* async_subfile_storage_data(const void* storage)
+{
+    const struct file_storage* fstorage = (const struct file_storage*)storage;
+    return fstorage->data;
+}
+
+static size_t async_subfile_storage_size(const void* storage)
+{
+    const struct file_storage* fstorage = (const struct file_storage*)storage;
+    return fstorage->size;
+}
+
+static void async_subfile_storage_save(void* storage, size_t start, size_t size)
+{
+    struct file_storage* fstorage = (struct file_storage*)storage;
+    struct async_file_storage* parent = (struct async_file_storage*)fstorage->filename;
+
+    /* start is relative to the sub storage */
+    async_file_storage_save(parent, (size_t)(fstorage->data - parent->fstorage->data) + start, size);
+}
+
+
+const struct storage_backend_interface g_iasync_file_storage =
+{
+    async_file_storage_data,
+    async_file_storage_size,
+    async_file_storage_save
+};
+
+const struct storage_backend_interface g_iasync_subfile_storage =
+{
+    async_subfile_storage_data,
+    async_subfile_storage_size,
+    async_subfile_storage_save
+};
@@ -0,0 +1,83 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - async_file_storage.h                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_BACKENDS_ASYNC_FILE_STORAGE_H
+#define M64P_BACKENDS_ASYNC_FILE_STORAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "api/m64p_types.h"
+
+struct file_storage;
+struct storage_writer;
+
+struct storage_writer_stats
+{
+    uint64_t saves;             /* save notifications received from the emulation thread */
+    uint64_t flushes;           /* files written */
+    uint64_t bytes_written;
+    uint64_t write_us;          /* time spent writing files */
+};
+
+/* Save memory whose changes are written behind by a storage_writer thread.
+ * Saves only copy the updated bytes and mark them dirty. Dirty ranges are coalesced
+ * and the whole file is rewritten (then renamed over the previous one) at most
+ * interval_ms after the first unsaved change.
+ */
+struct async_file_storage
+{
+    struct file_storage* fstorage;
+    struct storage_writer* writer;
+    struct async_file_storage* next;
+
+    /* the following fields are guarded by the writer lock */
+    uint8_t* pending;           /* saved content */
+    uint8_t* snapshot;          /* content being written, owned by the writer while writing is set */
+    size_t dirty_start;         /* dirty range of pending, empty if dirty_start == dirty_end */
+    size_t dirty_end;
+    uint64_t dirty_since_us;
+    int writing;
+};
+
+/* Start the writer thread.
+ * Returns M64ERR_UNSUPPORTED on platforms without thread support.
+ */
+m64p_error init_storage_writer(struct storage_writer** writer, unsigned int interval_ms);
+
+/* Stop the writer thread. All async_file_storage must have been closed before.
+ * stats (if not NULL) receives the statistics of the writer lifetime.
+ */
+void release_storage_writer(struct storage_writer* writer, struct storage_writer_stats* stats);
+
+/* Wrap fstorage, which must outlive the async_file_storage. */
+int open_async_file_storage(struct async_file_storage* storage, struct file_storage* fstorage,
+                            struct storage_writer* writer);
+
+/* Write any unsaved change right away and detach storage from its writer. */
+void close_async_file_storage(struct async_file_storage* storage);
+
+extern const struct storage_backend_interface g_iasync_file_storage;
+
+/* Sub storage whose filename field points to the parent async_file_storage */
+extern const struct storage_backend_interface g_iasync_subfile_storage;
+
+#endif
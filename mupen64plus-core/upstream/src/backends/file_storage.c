@@ -21,6 +21,7 @@
 
 #include "file_storage.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "api/callbacks.h"
@@ -29,6 +30,7 @@
 #include "device/dd/dd_controller.h"
 #include "main/util.h"
 #include "main/netplay.h"
+#include "osal/files.h"
 
 int open_file_storage(struct file_storage* fstorage, size_t size, const char* filename)
 {
@@ -36,6 +38,7 @@ int open_file_storage(struct file_storage* fstorage, size_t size, const char* fi
     fstorage->filename = filename;
     fstorage->size = size;
     fstorage->first_access = 1;
+    fstorage->mapped_size = 0;
 
     /* allocate memory for holding data */
     fstorage->data = malloc(fstorage->size);
@@ -60,6 +63,7 @@ int open_rom_file_storage(struct file_storage* fstorage, const char* filename)
     fstorage->size = 0;
     fstorage->filename = NULL;
     fstorage->first_access = 1;
+    fstorage->mapped_size = 0;
 
     file_status_t err = load_file(filename, (void**)&fstorage->data, &fstorage->size);
 
@@ -71,9 +75,33 @@ int open_rom_file_storage(struct file_storage* fstorage, const char* filename)
     return err;
 }
 
+int open_mapped_rom_file_storage(struct file_storage* fstorage, const char* filename)
+{
+    size_t size = 0;
+    uint8_t* data = osal_file_map(filename, &size);
+
+    if (data == NULL) {
+        return open_rom_file_storage(fstorage, filename);
+    }
+
+    /* ! take ownsership of filename ! */
+    fstorage->data = data;
+    fstorage->size = size;
+    fstorage->filename = filename;
+    fstorage->first_access = 1;
+    fstorage->mapped_size = size;
+
+    return file_ok;
+}
+
 void close_file_storage(struct file_storage* fstorage)
 {
-    free((void*)fstorage->data);
+    if (fstorage->mapped_size != 0) {
+        osal_file_unmap(fstorage->data, fstorage->mapped_size);
+    }
+    else {
+        free((void*)fstorage->data);
+    }
     free((void*)fstorage->filename);
 }
 
@@ -31,11 +31,15 @@ struct file_storage
     size_t size;
     const char* filename;
     int first_access;
+    size_t mapped_size;     /* size of the file mapping holding data, 0 if data was allocated */
 };
 
 
 int open_file_storage(struct file_storage* storage, size_t size, const char* filename);
 int open_rom_file_storage(struct file_storage* storage, const char* filename);
+/* Same as open_rom_file_storage, but maps the file copy-on-write when possible
+ * so that only the parts actually accessed are read. */
+int open_mapped_rom_file_storage(struct file_storage* storage, const char* filename);
 void close_file_storage(struct file_storage* storage);
 
 extern const struct storage_backend_interface g_ifile_storage;
@@ -0,0 +1,262 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - file_video_capture.c                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "backends/api/video_capture_backend.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define M64P_CORE_PROTOTYPES 1
+#include "api/callbacks.h"
+#include "api/m64p_config.h"
+#include "api/m64p_types.h"
+#include "main/util.h"
+#include "osal/preproc.h"
+
+/* larger images are rejected before their size is computed */
+#define MAX_PPM_DIMENSION 16384
+
+/* File video capture backend
+ *
+ * Replays the images of a binary PPM (P6) file, which can hold several
+ * concatenated images. Images are scaled to the requested resolution and
+ * returned in order, looping back to the first one after the last.
+ * Useful to get deterministic camera input.
+ */
+struct file_video_capture
+{
+    char* path;
+
+    /* BGR frame size (no stride) */
+    size_t size;
+
+    uint8_t* frames;
+    size_t count;
+    size_t next;
+};
+
+static const uint8_t* skip_ppm_space(const uint8_t* p, const uint8_t* end)
+{
+    while (p < end) {
+        if (*p == '#') {
+            while (p < end && *p != '\n') { ++p; }
+        }
+        else if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+            ++p;
+        }
+        else {
+            break;
+        }
+    }
+
+    return p;
+}
+
+static const uint8_t* parse_ppm_uint(const uint8_t* p, const uint8_t* end, unsigned int* value)
+{
+    unsigned int v = 0;
+
+    p = skip_ppm_space(p, end);
+    if (p == end || *p < '0' || *p > '9') {
+        return NULL;
+    }
+
+    while (p < end && *p >= '0' && *p <= '9' && v < 65536) {
+        v = 10 * v + (*p++ - '0');
+    }
+
+    *value = v;
+    return p;
+}
+
+/* Parse the image at *p and append it, scaled to width x height, to frames.
+ * Returns 0 on success.
+ */
+static int load_ppm_image(struct file_video_capture* fcap, const uint8_t** p, const uint8_t* end,
+                          unsigned int width, unsigned int height)
+{
+    unsigned int w, h, maxval, x, y;
+    const uint8_t* data = *p;
+    uint8_t* frames;
+    uint8_t* frame;
+
+    if (end - data < 2 || data[0] != 'P' || data[1] != '6') {
+        return -1;
+    }
+
+    data += 2;
+    if ((data = parse_ppm_uint(data, end, &w)) == NULL
+     || (data = parse_ppm_uint(data, end, &h)) == NULL
+     || (data = parse_ppm_uint(data, end, &maxval)) == NULL
+     || data == end
+     || w == 0 || h == 0 || w > MAX_PPM_DIMENSION || h > MAX_PPM_DIMENSION
+     || maxval == 0 || maxval > 255) {
+        return -1;
+    }
+
+    /* a single whitespace separates header and pixels */
+    ++data;
+    if ((size_t)(end - data) < (size_t)3 * w * h) {
+        return -1;
+    }
+
+    frames = realloc(fcap->frames, (fcap->count + 1) * fcap->size);
+    if (frames == NULL) {
+        return -1;
+    }
+    fcap->frames = frames;
+    frame = frames + fcap->count * fcap->size;
+
+    /* nearest neighbor scaling, RGB to BGR */
+    for (y = 0; y < height; ++y) {
+        const uint8_t* src_row = data + (size_t)3 * w * (((size_t)y * h) / height);
+        for (x = 0; x < width; ++x) {
+            const uint8_t* src = src_row + 3 * (((size_t)x * w) / width);
+            frame[0] = (uint8_t)((src[2] * 255) / maxval);
+            frame[1] = (uint8_t)((src[1] * 255) / maxval);
+            frame[2] = (uint8_t)((src[0] * 255) / maxval);
+            frame += 3;
+        }
+    }
+
+    ++fcap->count;
+    *p = skip_ppm_space(data + (size_t)3 * w * h, end);
+    return 0;
+}
+
+static m64p_error file_init(void** vcap, const char* section)
+{
+    /* default parameters */
+    const char* path = "";
+    struct file_video_capture* fcap;
+
+    if (section && strlen(section) > 0) {
+        m64p_handle config = NULL;
+
+        ConfigOpenSection(section, &config);
+
+        /* set default parameters */
+        ConfigSetDefaultString(config, "path", path, "Binary PPM (P6) file holding the images to replay, in order.");
+
+        /* get parameters */
+        path = ConfigGetParamString(config, "path");
+    }
+
+    fcap = calloc(1, sizeof(*fcap));
+    if (fcap == NULL) {
+        *vcap = NULL;
+        return M64ERR_NO_MEMORY;
+    }
+
+    fcap->path = strdup((path != NULL) ? path : "");
+    if (fcap->path == NULL) {
+        free(fcap);
+        *vcap = NULL;
+        return M64ERR_NO_MEMORY;
+    }
+
+    *vcap = fcap;
+    return M64ERR_SUCCESS;
+}
+
+static void file_release(void* vcap)
+{
+    struct file_video_capture* fcap = (struct file_video_capture*)vcap;
+    if (fcap == NULL) {
+        return;
+    }
+
+    free(fcap->frames);
+    free(fcap->path);
+    free(fcap);
+}
+
+static m64p_error file_open(void* vcap, unsigned int width, unsigned int height)
+{
+    struct file_video_capture* fcap = (struct file_video_capture*)vcap;
+    void* buffer = NULL;
+    size_t size = 0;
+    const uint8_t* p;
+    const uint8_t* end;
+
+    if (load_file(fcap->path, &buffer, &size) != file_ok) {
+        DebugMessage(M64MSG_ERROR, "Failed to open video file %s", fcap->path);
+        return M64ERR_FILES;
+    }
+
+    fcap->size = (size_t)3 * width * height;
+    fcap->count = 0;
+    fcap->next = 0;
+
+    p = (const uint8_t*)buffer;
+    end = p + size;
+    while (p < end) {
+        if (load_ppm_image(fcap, &p, end, width, height) != 0) {
+            DebugMessage(M64MSG_WARNING, "Invalid image %u in video file %s", (unsigned int)fcap->count, fcap->path);
+            break;
+        }
+    }
+
+    free(buffer);
+
+    if (fcap->count == 0) {
+        DebugMessage(M64MSG_ERROR, "No image found in video file %s", fcap->path);
+        return M64ERR_INPUT_INVALID;
+    }
+
+    DebugMessage(M64MSG_INFO, "Video file successfully opened: %s (%u images)", fcap->path, (unsigned int)fcap->count);
+
+    return M64ERR_SUCCESS;
+}
+
+static void file_close(void* vcap)
+{
+    struct file_video_capture* fcap = (struct file_video_capture*)vcap;
+
+    free(fcap->frames);
+    fcap->frames = NULL;
+    fcap->count = 0;
+}
+
+static m64p_error file_grab_image(void* vcap, void* data)
+{
+    struct file_video_capture* fcap = (struct file_video_capture*)vcap;
+
+    if (fcap->count == 0) {
+        return M64ERR_INVALID_STATE;
+    }
+
+    memcpy(data, fcap->frames + fcap->next * fcap->size, fcap->size);
+    fcap->next = (fcap->next + 1) % fcap->count;
+
+    return M64ERR_SUCCESS;
+}
+
+const struct video_capture_backend_interface g_ifile_video_capture_backend =
+{
+    "file",
+    file_init,
+    file_release,
+    file_open,
+    file_close,
+    file_grab_image
+};
@@ -0,0 +1,294 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - prefetch_video_capture.c                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "prefetch_video_capture.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "backends/api/video_capture_backend.h"
+#include "osal/thread_time.h"
+
+#if !defined(_MSC_VER)
+
+#include <pthread.h>
+
+struct prefetch_video_capture
+{
+    void* vcap;
+    const struct video_capture_backend_interface* ivcap;
+    uint64_t refresh_us;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int started;                /* the capture thread was started, or couldn't be */
+    int running;
+
+    /* BGR frame size (no stride) */
+    size_t size;
+    /* the back frame is owned by the capture thread while it grabs */
+    uint8_t* back;
+
+    /* the following fields are guarded by the lock */
+    uint8_t* front;             /* last grabbed frame */
+    m64p_error front_err;
+    uint64_t grabbed_us;
+    int ready;                  /* front holds a frame which can be read */
+    int consumed;               /* front was read, the next frame can be grabbed */
+    int quit;
+
+    struct prefetch_video_capture_stats stats;
+};
+
+static void* prefetch_loop(void* arg)
+{
+    struct prefetch_video_capture* pcap = (struct prefetch_video_capture*)arg;
+
+    pthread_mutex_lock(&pcap->lock);
+    while (!pcap->quit) {
+        uint8_t* frame;
+        m64p_error err;
+        uint64_t grab_start;
+        uint64_t grab_time;
+
+        /* keep an unread frame until it is too old */
+        if (pcap->ready && !pcap->consumed) {
+            uint64_t now = osal_time_us();
+            uint64_t due = pcap->grabbed_us + pcap->refresh_us;
+
+            if (pcap->refresh_us == 0) {
+                pthread_cond_wait(&pcap->cond, &pcap->lock);
+                continue;
+            }
+            if (due > now) {
+                osal_cond_timedwait_us(&pcap->cond, &pcap->lock, due - now);
+                continue;
+            }
+        }
+
+        pthread_mutex_unlock(&pcap->lock);
+
+        grab_start = osal_time_us();
+        err = pcap->ivcap->grab_image(pcap->vcap, pcap->back);
+        grab_time = osal_time_us() - grab_start;
+
+        pthread_mutex_lock(&pcap->lock);
+        frame = pcap->front;
+        pcap->front = pcap->back;
+        pcap->back = frame;
+        pcap->front_err = err;
+        pcap->grabbed_us = grab_start + grab_time;
+        pcap->ready = 1;
+        pcap->consumed = 0;
+        ++pcap->stats.grabs;
+        pcap->stats.grab_us += grab_time;
+        pthread_cond_broadcast(&pcap->cond);
+    }
+    pthread_mutex_unlock(&pcap->lock);
+
+    return NULL;
+}
+
+m64p_error init_prefetch_video_capture(struct prefetch_video_capture** pcap,
+                                       void* vcap, const struct video_capture_backend_interface* ivcap,
+                                       unsigned int refresh_ms)
+{
+    struct prefetch_video_capture* p = calloc(1, sizeof(*p));
+    if (p == NULL)
+        return M64ERR_NO_MEMORY;
+
+    p->vcap = vcap;
+    p->ivcap = ivcap;
+    p->refresh_us = (uint64_t)refresh_ms * 1000;
+
+    if (pthread_mutex_init(&p->lock, NULL) != 0) {
+        free(p);
+        return M64ERR_SYSTEM_FAIL;
+    }
+
+    if (pthread_cond_init(&p->cond, NULL) != 0) {
+        pthread_mutex_destroy(&p->lock);
+        free(p);
+        return M64ERR_SYSTEM_FAIL;
+    }
+
+    *pcap = p;
+    return M64ERR_SUCCESS;
+}
+
+void release_prefetch_video_capture(struct prefetch_video_capture* pcap, struct prefetch_video_capture_stats* stats)
+{
+    if (pcap == NULL)
+        return;
+
+    if (stats != NULL)
+        *stats = pcap->stats;
+
+    pthread_cond_destroy(&pcap->cond);
+    pthread_mutex_destroy(&pcap->lock);
+    free(pcap);
+}
+
+static m64p_error prefetch_open(void* vcap, unsigned int width, unsigned int height)
+{
+    struct prefetch_video_capture* pcap = (struct prefetch_video_capture*)vcap;
+    m64p_error err;
+
+    err = pcap->ivcap->open(pcap->vcap, width, height);
+    if (err != M64ERR_SUCCESS)
+        return err;
+
+    pcap->size = 3 * width * height;
+    pcap->started = pcap->ready = pcap->consumed = pcap->quit = 0;
+
+    return M64ERR_SUCCESS;
+}
+
+/* Games which never read the camera don't pay for a thread and frames */
+static void start_prefetch(struct prefetch_video_capture* pcap)
+{
+    pcap->started = 1;
+    pcap->front = malloc(pcap->size);
+    pcap->back = malloc(pcap->size);
+
+    if (pcap->front == NULL || pcap->back == NULL) {
+        DebugMessage(M64MSG_WARNING, "Couldn't allocate prefetched video frames, grabbing synchronously");
+    }
+    else if (pthread_create(&pcap->thread, NULL, prefetch_loop, pcap) != 0) {
+        DebugMessage(M64MSG_WARNING, "Couldn't create video prefetch thread, grabbing synchronously");
+    }
+    else {
+        pcap->running = 1;
+    }
+}
+
+static void prefetch_close(void* vcap)
+{
+    struct prefetch_video_capture* pcap = (struct prefetch_video_capture*)vcap;
+
+    if (pcap->running) {
+        pthread_mutex_lock(&pcap->lock);
+        pcap->quit = 1;
+        pthread_cond_broadcast(&pcap->cond);
+        pthread_mutex_unlock(&pcap->lock);
+
+        pthread_join(pcap->thread, NULL);
+        pcap->running = 0;
+    }
+
+    free(pcap->front);
+    free(pcap->back);
+    pcap->front = pcap->back = NULL;
+
+    pcap->ivcap->close(pcap->vcap);
+}
+
+static m64p_error prefetch_grab_image(void* vcap, void* data)
+{
+    struct prefetch_video_capture* pcap = (struct prefetch_video_capture*)vcap;
+    m64p_error err;
+
+    if (!pcap->started)
+        start_prefetch(pcap);
+
+    if (!pcap->running)
+        return pcap->ivcap->grab_image(pcap->vcap, data);
+
+    pthread_mutex_lock(&pcap->lock);
+
+    if (!pcap->ready) {
+        uint64_t wait_start = osal_time_us();
+        while (!pcap->ready)
+            pthread_cond_wait(&pcap->cond, &pcap->lock);
+        ++pcap->stats.waits;
+        pcap->stats.wait_us += osal_time_us() - wait_start;
+    }
+
+    memcpy(data, pcap->front, pcap->size);
+    err = pcap->front_err;
+
+    /* ask for the next frame. Unless frames are refreshed,
+     * each frame is read once to keep the sequence of frames. */
+    pcap->consumed = 1;
+    if (pcap->refresh_us == 0)
+        pcap->ready = 0;
+    ++pcap->stats.reads;
+    pthread_cond_broadcast(&pcap->cond);
+
+    pthread_mutex_unlock(&pcap->lock);
+
+    return err;
+}
+
+#else
+
+/* No capture thread available: callers are expected to use the wrapped backend directly */
+
+m64p_error init_prefetch_video_capture(struct prefetch_video_capture** pcap,
+                                       void* vcap, const struct video_capture_backend_interface* ivcap,
+                                       unsigned int refresh_ms)
+{
+    return M64ERR_UNSUPPORTED;
+}
+
+void release_prefetch_video_capture(struct prefetch_video_capture* pcap, struct prefetch_video_capture_stats* stats)
+{
+}
+
+static m64p_error prefetch_open(void* vcap, unsigned int width, unsigned int height)
+{
+    return M64ERR_UNSUPPORTED;
+}
+
+static void prefetch_close(void* vcap)
+{
+}
+
+static m64p_error prefetch_grab_image(void* vcap, void* data)
+{
+    return M64ERR_UNSUPPORTED;
+}
+
+#endif
+
+static m64p_error prefetch_init(void** vcap, const char* section)
+{
+    return M64ERR_UNSUPPORTED;
+}
+
+static void prefetch_release(void* vcap)
+{
+    release_prefetch_video_capture((struct prefetch_video_capture*)vcap, NULL);
+}
+
+const struct video_capture_backend_interface g_iprefetch_video_capture =
+{
+    "prefetch",
+    prefetch_init,
+    prefetch_release,
+    prefetch_open,
+    prefetch_close,
+    prefetch_grab_image
+};
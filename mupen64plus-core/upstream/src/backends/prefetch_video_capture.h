@@ -0,0 +1,69 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - prefetch_video_capture.h                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_BACKENDS_PREFETCH_VIDEO_CAPTURE_H
+#define M64P_BACKENDS_PREFETCH_VIDEO_CAPTURE_H
+
+#include <stdint.h>
+
+#include "api/m64p_types.h"
+
+struct prefetch_video_capture;
+struct video_capture_backend_interface;
+
+struct prefetch_video_capture_stats
+{
+    uint64_t grabs;             /* frames grabbed by the capture thread */
+    uint64_t grab_us;           /* time spent grabbing frames */
+    uint64_t reads;             /* frames handed to the emulation thread */
+    uint64_t waits;             /* reads which had to wait for a frame */
+    uint64_t wait_us;           /* time the emulation thread spent waiting */
+};
+
+/* Video capture which grabs frames of another video capture backend on a separate thread.
+ * The capture thread is only started when the first frame is requested. Afterwards the
+ * next frame is grabbed as soon as the previous one was read, so reads return the frame
+ * grabbed ahead without waiting for the device.
+ *
+ * With refresh_ms > 0, a frame which is still unread after refresh_ms is replaced by a
+ * newer one and reads return the latest frame, which may have been read before.
+ * With refresh_ms = 0, every frame is read exactly once, so the sequence of frames
+ * is the same as with synchronous grabs.
+ *
+ * Use g_iprefetch_video_capture to open, close and grab frames.
+ */
+
+/* Wrap (vcap, ivcap), which must outlive the prefetch_video_capture.
+ * Returns M64ERR_UNSUPPORTED on platforms without thread support.
+ */
+m64p_error init_prefetch_video_capture(struct prefetch_video_capture** pcap,
+                                       void* vcap, const struct video_capture_backend_interface* ivcap,
+                                       unsigned int refresh_ms);
+
+/* Release a closed prefetch_video_capture, but not the wrapped backend.
+ * stats (if not NULL) receives the statistics of the prefetch_video_capture lifetime.
+ */
+void release_prefetch_video_capture(struct prefetch_video_capture* pcap, struct prefetch_video_capture_stats* stats);
+
+/* Its init method is unsupported, use init_prefetch_video_capture instead */
+extern const struct video_capture_backend_interface g_iprefetch_video_capture;
+
+#endif
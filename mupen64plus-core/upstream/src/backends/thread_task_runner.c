@@ -0,0 +1,180 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - thread_task_runner.c                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "thread_task_runner.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "osal/thread_time.h"
+
+#if !defined(_MSC_VER)
+
+#include <pthread.h>
+
+struct thread_task_runner
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    void (*task)(void*);
+    void* opaque;
+    int busy;
+    int quit;
+};
+
+static void* thread_task_runner_loop(void* arg)
+{
+    struct thread_task_runner* runner = (struct thread_task_runner*)arg;
+
+    pthread_mutex_lock(&runner->lock);
+    for (;;) {
+        while (!runner->busy && !runner->quit)
+            pthread_cond_wait(&runner->cond, &runner->lock);
+
+        if (!runner->busy)
+            break;
+
+        pthread_mutex_unlock(&runner->lock);
+        runner->task(runner->opaque);
+        pthread_mutex_lock(&runner->lock);
+
+        runner->busy = 0;
+        pthread_cond_broadcast(&runner->cond);
+    }
+    pthread_mutex_unlock(&runner->lock);
+
+    return NULL;
+}
+
+static m64p_error thread_task_runner_init(void** runner)
+{
+    struct thread_task_runner* r = calloc(1, sizeof(*r));
+    if (r == NULL)
+        return M64ERR_NO_MEMORY;
+
+    if (pthread_mutex_init(&r->lock, NULL) != 0) {
+        free(r);
+        return M64ERR_SYSTEM_FAIL;
+    }
+
+    if (pthread_cond_init(&r->cond, NULL) != 0) {
+        pthread_mutex_destroy(&r->lock);
+        free(r);
+        return M64ERR_SYSTEM_FAIL;
+    }
+
+    if (pthread_create(&r->thread, NULL, thread_task_runner_loop, r) != 0) {
+        DebugMessage(M64MSG_ERROR, "Could not create task runner thread");
+        pthread_cond_destroy(&r->cond);
+        pthread_mutex_destroy(&r->lock);
+        free(r);
+        return M64ERR_SYSTEM_FAIL;
+    }
+
+    *runner = r;
+    return M64ERR_SUCCESS;
+}
+
+static void thread_task_runner_release(void* runner)
+{
+    struct thread_task_runner* r = (struct thread_task_runner*)runner;
+    if (r == NULL)
+        return;
+
+    pthread_mutex_lock(&r->lock);
+    r->quit = 1;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+
+    pthread_join(r->thread, NULL);
+    pthread_cond_destroy(&r->cond);
+    pthread_mutex_destroy(&r->lock);
+    free(r);
+}
+
+static void thread_task_runner_start(void* runner, void (*task)(void*), void* opaque)
+{
+    struct thread_task_runner* r = (struct thread_task_runner*)runner;
+
+    pthread_mutex_lock(&r->lock);
+    while (r->busy)
+        pthread_cond_wait(&r->cond, &r->lock);
+
+    r->task = task;
+    r->opaque = opaque;
+    r->busy = 1;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+}
+
+static uint64_t thread_task_runner_wait(void* runner)
+{
+    struct thread_task_runner* r = (struct thread_task_runner*)runner;
+    uint64_t stall = 0;
+
+    pthread_mutex_lock(&r->lock);
+    if (r->busy) {
+        uint64_t start = osal_time_us();
+        while (r->busy)
+            pthread_cond_wait(&r->cond, &r->lock);
+        stall = osal_time_us() - start;
+    }
+    pthread_mutex_unlock(&r->lock);
+
+    return stall;
+}
+
+#else
+
+/* No worker thread available: tasks are run synchronously by start */
+
+static m64p_error thread_task_runner_init(void** runner)
+{
+    return M64ERR_UNSUPPORTED;
+}
+
+static void thread_task_runner_release(void* runner)
+{
+}
+
+static void thread_task_runner_start(void* runner, void (*task)(void*), void* opaque)
+{
+    task(opaque);
+}
+
+static uint64_t thread_task_runner_wait(void* runner)
+{
+    return 0;
+}
+
+#endif
+
+const struct task_runner_backend_interface g_ithread_task_runner =
+{
+    thread_task_runner_init,
+    thread_task_runner_release,
+    thread_task_runner_start,
+    thread_task_runner_wait
+};
@@ -399,10 +399,59 @@ uint8_t* get_sector_base(const struct dd_disk* disk,
     }
 }
 
-uint8_t* scan_and_expand_disk_format(uint8_t* data, size_t size,
+void GenerateLBAExtentTable(struct dd_disk* disk)
+{
+    const uint8_t* data = disk->istorage->data(disk->storage);
+    const struct dd_sys_data* sys_data = (void*)(data + disk->offset_sys);
+    uint8_t disk_type = sys_data->type & 0x0F;
+    uint16_t rom_lba_end = big16(sys_data->rom_lba_end);
+    uint16_t ram_lba_start = big16(sys_data->ram_lba_start);
+    uint16_t ram_lba_end = big16(sys_data->ram_lba_end);
+
+    /* SDK and D64 store LBAs in order, D64 without system area and unused LBAs */
+    uint32_t offset = (disk->format == DISK_FORMAT_D64)
+        ? D64_OFFSET_DATA
+        : LBAToByteA(disk_type, 0, SYSTEM_LBAS);
+
+    for (uint32_t lba = 0; lba < SIZE_LBA; lba++)
+    {
+        disk->lba_offset[lba] = 0;
+        disk->lba_size[lba] = 0;
+
+        //System area is never written
+        if (lba < SYSTEM_LBAS)
+            continue;
+
+        uint32_t size = LBAToByteA(disk_type, lba, 1);
+
+        if (disk->format == DISK_FORMAT_MAME)
+        {
+            //MAME stores blocks by physical location, defect tracks included
+            uint16_t phys = LBAToPhys(sys_data, lba);
+            const uint8_t* base = get_sector_base_mame(disk, (phys >> 12) & 1, phys & 0xFFF, (phys >> 13) & 1, 0);
+            if (base == NULL)
+                continue;
+            offset = (uint32_t)(base - data);
+        }
+        else if (disk->format == DISK_FORMAT_D64)
+        {
+            if (lba > (uint32_t)(rom_lba_end + SYSTEM_LBAS)
+             && !(ram_lba_start != 0xFFFF && (lba - SYSTEM_LBAS) >= ram_lba_start && (lba - SYSTEM_LBAS) <= ram_lba_end))
+                continue;
+        }
+
+        disk->lba_offset[lba] = offset;
+        disk->lba_size[lba] = size;
+        offset += size;
+    }
+}
+
+uint8_t* scan_and_expand_disk_format(uint8_t* data, size_t* psize,
     unsigned int* format, unsigned int* development,
     size_t* offset_sys, size_t* offset_id, size_t* offset_ram, size_t* size_ram)
 {
+    size_t size = *psize;
+
     /* Search for good System Data */
     const unsigned int blocks[8] = { 0, 1, 2, 3, 8, 9, 10, 11 };
     int isValidDisk = -1;
@@ -569,8 +618,6 @@ uint8_t* scan_and_expand_disk_format(uint8_t* data, size_t size,
                 sys_data_->ram_lba_end = 0xFFFF;
             }
 
-            /* FIXME: you're not supposed to know that data was malloc'ed */
-            free(data);
             data = buffer;
             size = full_d64_size;
         }
@@ -615,6 +662,7 @@ uint8_t* scan_and_expand_disk_format(uint8_t* data, size_t size,
         }
     }
 
+    *psize = size;
     return data;
 }
 
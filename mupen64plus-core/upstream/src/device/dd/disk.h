@@ -147,6 +147,9 @@ struct dd_disk
     const struct storage_backend_interface* isave_storage;
 
     uint16_t lba_phys_table[0x10DC];
+    /* Byte range of each LBA in storage, lba_size is 0 for LBAs outside of it */
+    uint32_t lba_offset[0x10DC];
+    uint32_t lba_size[0x10DC];
     uint8_t format;
     uint8_t development;
     uint8_t region;
@@ -162,6 +165,7 @@ extern const struct storage_backend_interface g_istorage_disk_ram_only;
 
 /* Disk Helper routines */
 void GenerateLBAToPhysTable(struct dd_disk* disk);
+void GenerateLBAExtentTable(struct dd_disk* disk);
 uint32_t LBAToVZone(const struct dd_sys_data* sys_data, uint32_t lba);
 uint32_t LBAToVZoneA(uint8_t type, uint32_t lba);
 uint32_t LBAToByte(const struct dd_sys_data* sys_data, uint32_t lba, uint32_t nlbas);
@@ -174,7 +178,9 @@ unsigned int get_zone_from_head_track(unsigned int head, unsigned int track);
 uint8_t* get_sector_base(const struct dd_disk* disk,
     unsigned int head, unsigned int track, unsigned int block, unsigned int sector);
 
-uint8_t* scan_and_expand_disk_format(uint8_t* data, size_t size,
+/* Returns data, or a new buffer holding the expanded disk (size is updated).
+ * In the latter case data is left untouched and still owned by the caller. */
+uint8_t* scan_and_expand_disk_format(uint8_t* data, size_t* size,
     unsigned int* format, unsigned int* development,
     size_t* offset_sys, size_t* offset_id, size_t* offset_ram, size_t* size_ram);
 
@@ -89,6 +89,10 @@ void init_device(struct device* dev,
     uint32_t start_address,
     int forceAlignmentOfPiDma,
     int tlbHack,
+    /* rsp */
+    void* rsp_task_runner, const struct task_runner_backend_interface* irsp_task_runner,
+    unsigned int rsp_threaded_gfx, unsigned int rsp_threaded_audio,
+    unsigned int rsp_gfx_task_latency, unsigned int rsp_audio_task_latency,
     /* ai */
     void* aout, const struct audio_out_backend_interface* iaout, float dma_modifier,
     /* si */
@@ -126,7 +130,8 @@ void init_device(struct device* dev,
         { &dev->pif,       hw2_int_handler             }, /* HW2 */
         { dev,             nmi_int_handler             }, /* NMI */
         { dev,             reset_hard_handler          }, /* reset_hard */
-        { &dev->sp,        rsp_end_of_dma_event        }
+        { &dev->sp,        rsp_end_of_dma_event        }, /* RSP DMA */
+        { &dev->sp,        rsp_task_deadline_event     }  /* RSP task */
     };
 
 #define R(x) read_ ## x
@@ -183,9 +188,11 @@ void init_device(struct device* dev,
     init_r4300(&dev->r4300, &dev->mem, &dev->mi, &dev->rdram, interrupt_handlers,
             emumode, count_per_op, count_per_op_denom_pot, no_compiled_jump, randomize_interrupt, tlbHack, start_address);
     init_rdp(&dev->dp, &dev->sp, &dev->mi, &dev->mem, &dev->rdram, &dev->r4300);
-    init_rsp(&dev->sp, mem_base_u32(base, MM_RSP_MEM), &dev->mi, &dev->dp, &dev->ri);
+    init_rsp(&dev->sp, mem_base_u32(base, MM_RSP_MEM), &dev->mi, &dev->dp, &dev->ri,
+            rsp_task_runner, irsp_task_runner, rsp_threaded_gfx, rsp_threaded_audio,
+            rsp_gfx_task_latency, rsp_audio_task_latency);
     init_ai(&dev->ai, &dev->mi, &dev->ri, &dev->vi, aout, iaout, dma_modifier);
-    init_mi(&dev->mi, &dev->r4300);
+    init_mi(&dev->mi, &dev->r4300, &dev->sp);
     init_pi(&dev->pi,
             get_pi_dma_handler,
             &dev->cart, &dev->dd,
@@ -50,6 +50,7 @@
 struct audio_out_backend_interface;
 struct clock_backend_interface;
 struct storage_backend_interface;
+struct task_runner_backend_interface;
 struct joybus_device_interface;
 
 enum { GAME_CONTROLLERS_COUNT = 4 };
@@ -127,6 +128,10 @@ void init_device(struct device* dev,
     uint32_t start_address,
     int forceAlignmentOfPiDma,
     int tlbHack,
+    /* rsp */
+    void* rsp_task_runner, const struct task_runner_backend_interface* irsp_task_runner,
+    unsigned int rsp_threaded_gfx, unsigned int rsp_threaded_audio,
+    unsigned int rsp_gfx_task_latency, unsigned int rsp_audio_task_latency,
     /* ai */
     void* aout, const struct audio_out_backend_interface* iaout, float dma_modifier,
     /* si */
@@ -39,6 +39,14 @@ void cv_imshow(const char* name, unsigned int width, unsigned int height, int ch
 #include <assert.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define POCKET_CAM_SSE2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(M64P_BIG_ENDIAN)
+#include <arm_neon.h>
+#define POCKET_CAM_NEON
+#endif
+
 
 enum gbcart_extra_devices
 {
@@ -602,6 +610,7 @@ static int write_gb_cart_mmm01(struct gb_cart* gb_cart, uint16_t address, const
 
 
 /* TODO: extract each mbc into its own module, store in gb_cart a union of them */
+#if !defined(POCKET_CAM_SSE2) && !defined(POCKET_CAM_NEON)
 static uint8_t apply_dithering_matrix(const uint8_t* d, uint8_t value, unsigned int x, unsigned int y)
 {
     d += ((y & 3) * 4 + (x & 3)) * 3;
@@ -611,6 +620,158 @@ static uint8_t apply_dithering_matrix(const uint8_t* d, uint8_t value, unsigned
     else if (value < d[2]) return 0x80; /* light gray */
     return 0xc0; /* white */
 }
+#endif
+
+/* convert to gray using (2R+5G+1B)/8 formula */
+static void convert_bgr_to_gray(uint8_t* gray, const uint8_t* bgr, size_t count)
+{
+    size_t i = 0;
+
+#if defined(POCKET_CAM_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= count; i += 16, bgr += 48) {
+        /* deinterleave 16 BGR pixels with 4 rounds of byte unpacking */
+        __m128i t00 = _mm_loadu_si128((const __m128i*)(bgr + 0));
+        __m128i t01 = _mm_loadu_si128((const __m128i*)(bgr + 16));
+        __m128i t02 = _mm_loadu_si128((const __m128i*)(bgr + 32));
+
+        __m128i t10 = _mm_unpacklo_epi8(t00, _mm_unpackhi_epi64(t01, t01));
+        __m128i t11 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t00, t00), t02);
+        __m128i t12 = _mm_unpacklo_epi8(t01, _mm_unpackhi_epi64(t02, t02));
+
+        __m128i t20 = _mm_unpacklo_epi8(t10, _mm_unpackhi_epi64(t11, t11));
+        __m128i t21 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t10, t10), t12);
+        __m128i t22 = _mm_unpacklo_epi8(t11, _mm_unpackhi_epi64(t12, t12));
+
+        __m128i t30 = _mm_unpacklo_epi8(t20, _mm_unpackhi_epi64(t21, t21));
+        __m128i t31 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t20, t20), t22);
+        __m128i t32 = _mm_unpacklo_epi8(t21, _mm_unpackhi_epi64(t22, t22));
+
+        __m128i b = _mm_unpacklo_epi8(t30, _mm_unpackhi_epi64(t31, t31));
+        __m128i g = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t30, t30), t32);
+        __m128i r = _mm_unpacklo_epi8(t31, _mm_unpackhi_epi64(t32, t32));
+
+        /* 1*B + 5*G + 2*R <= 8*255 fits in 16 bits */
+        __m128i blo = _mm_unpacklo_epi8(b, zero), bhi = _mm_unpackhi_epi8(b, zero);
+        __m128i glo = _mm_unpacklo_epi8(g, zero), ghi = _mm_unpackhi_epi8(g, zero);
+        __m128i rlo = _mm_unpacklo_epi8(r, zero), rhi = _mm_unpackhi_epi8(r, zero);
+        __m128i lo = _mm_add_epi16(_mm_add_epi16(blo, _mm_add_epi16(glo, _mm_slli_epi16(glo, 2))), _mm_slli_epi16(rlo, 1));
+        __m128i hi = _mm_add_epi16(_mm_add_epi16(bhi, _mm_add_epi16(ghi, _mm_slli_epi16(ghi, 2))), _mm_slli_epi16(rhi, 1));
+
+        _mm_storeu_si128((__m128i*)(gray + i), _mm_packus_epi16(_mm_srli_epi16(lo, 3), _mm_srli_epi16(hi, 3)));
+    }
+#elif defined(POCKET_CAM_NEON)
+    for (; i + 16 <= count; i += 16, bgr += 48) {
+        uint8x16x3_t px = vld3q_u8(bgr);
+
+        uint16x8_t lo = vmlal_u8(vmovl_u8(vget_low_u8(px.val[0])), vget_low_u8(px.val[1]), vdup_n_u8(5));
+        uint16x8_t hi = vmlal_u8(vmovl_u8(vget_high_u8(px.val[0])), vget_high_u8(px.val[1]), vdup_n_u8(5));
+        lo = vmlal_u8(lo, vget_low_u8(px.val[2]), vdup_n_u8(2));
+        hi = vmlal_u8(hi, vget_high_u8(px.val[2]), vdup_n_u8(2));
+
+        vst1q_u8(gray + i, vcombine_u8(vshrn_n_u16(lo, 3), vshrn_n_u16(hi, 3)));
+    }
+#endif
+
+    for (; i < count; ++i, bgr += 3) {
+        gray[i] = (1*bgr[0] + 5*bgr[1] + 2*bgr[2]) / 8;
+    }
+}
+
+/* Dither img with the 4x4 matrix d and encode it as 2bpp GB tiles.
+ * img is replaced by the dithered shades.
+ */
+static void encode_dithered_tiles(uint8_t tiles[16][16][16],
+    uint8_t img[M64282FP_SENSOR_H][M64282FP_SENSOR_W], const uint8_t* d)
+{
+    unsigned int x, y;
+
+    memset(tiles, 0, 16*16*16);
+
+#if defined(POCKET_CAM_SSE2) || defined(POCKET_CAM_NEON)
+    /* each row of the matrix repeated over 16 pixels, one vector per threshold */
+    uint8_t thresholds[4][3][16];
+    static const uint8_t bit_weights[16] = {
+        0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+        0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01
+    };
+
+    for (y = 0; y < 4; ++y) {
+        for (x = 0; x < 16; ++x) {
+            thresholds[y][0][x] = d[(y * 4 + (x & 3)) * 3 + 0];
+            thresholds[y][1][x] = d[(y * 4 + (x & 3)) * 3 + 1];
+            thresholds[y][2][x] = d[(y * 4 + (x & 3)) * 3 + 2];
+        }
+    }
+
+    for (y = 0; y < M64282FP_SENSOR_H; ++y) {
+        for (x = 0; x < M64282FP_SENSOR_W; x += 16) {
+            /* value >= threshold for each of the 3 thresholds, the matrix is
+             * applied in order so a failed compare masks the following ones */
+#if defined(POCKET_CAM_SSE2)
+            const __m128i weights = _mm_loadu_si128((const __m128i*)bit_weights);
+            __m128i v = _mm_loadu_si128((const __m128i*)&img[y][x]);
+            __m128i t0 = _mm_loadu_si128((const __m128i*)thresholds[y & 3][0]);
+            __m128i t1 = _mm_loadu_si128((const __m128i*)thresholds[y & 3][1]);
+            __m128i t2 = _mm_loadu_si128((const __m128i*)thresholds[y & 3][2]);
+            __m128i a = _mm_cmpeq_epi8(_mm_max_epu8(v, t0), v);
+            __m128i ab = _mm_and_si128(a, _mm_cmpeq_epi8(_mm_max_epu8(v, t1), v));
+            __m128i abc = _mm_and_si128(ab, _mm_cmpeq_epi8(_mm_max_epu8(v, t2), v));
+
+            /* shade = 0xc0 - 0x40 * level, bit 6 in the low plane and bit 7 in the high plane */
+            __m128i lo = _mm_or_si128(_mm_andnot_si128(a, _mm_set1_epi8(-1)), _mm_andnot_si128(abc, ab));
+            __m128i hi = _mm_andnot_si128(ab, _mm_set1_epi8(-1));
+
+            /* bits are disjoint so summing each group of 8 weights packs them */
+            __m128i lo_bits = _mm_sad_epu8(_mm_and_si128(lo, weights), _mm_setzero_si128());
+            __m128i hi_bits = _mm_sad_epu8(_mm_and_si128(hi, weights), _mm_setzero_si128());
+
+            _mm_storeu_si128((__m128i*)&img[y][x], _mm_or_si128(
+                _mm_and_si128(lo, _mm_set1_epi8(0x40)), _mm_and_si128(hi, _mm_set1_epi8((char)0x80))));
+
+            tiles[y >> 3][(x >> 3) + 0][((y & 7) << 1) + 0] = (uint8_t)_mm_cvtsi128_si32(lo_bits);
+            tiles[y >> 3][(x >> 3) + 0][((y & 7) << 1) + 1] = (uint8_t)_mm_cvtsi128_si32(hi_bits);
+            tiles[y >> 3][(x >> 3) + 1][((y & 7) << 1) + 0] = (uint8_t)_mm_extract_epi16(lo_bits, 4);
+            tiles[y >> 3][(x >> 3) + 1][((y & 7) << 1) + 1] = (uint8_t)_mm_extract_epi16(hi_bits, 4);
+#else
+            const uint8x16_t weights = vld1q_u8(bit_weights);
+            uint8x16_t v = vld1q_u8(&img[y][x]);
+            uint8x16_t a = vcgeq_u8(v, vld1q_u8(thresholds[y & 3][0]));
+            uint8x16_t ab = vandq_u8(a, vcgeq_u8(v, vld1q_u8(thresholds[y & 3][1])));
+            uint8x16_t abc = vandq_u8(ab, vcgeq_u8(v, vld1q_u8(thresholds[y & 3][2])));
+
+            /* shade = 0xc0 - 0x40 * level, bit 6 in the low plane and bit 7 in the high plane */
+            uint8x16_t lo = vorrq_u8(vmvnq_u8(a), vbicq_u8(ab, abc));
+            uint8x16_t hi = vmvnq_u8(ab);
+
+            /* bits are disjoint so summing each group of 8 weights packs them */
+            uint64x2_t lo_bits = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vandq_u8(lo, weights))));
+            uint64x2_t hi_bits = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vandq_u8(hi, weights))));
+
+            vst1q_u8(&img[y][x], vorrq_u8(vandq_u8(lo, vdupq_n_u8(0x40)), vandq_u8(hi, vdupq_n_u8(0x80))));
+
+            tiles[y >> 3][(x >> 3) + 0][((y & 7) << 1) + 0] = (uint8_t)vgetq_lane_u64(lo_bits, 0);
+            tiles[y >> 3][(x >> 3) + 0][((y & 7) << 1) + 1] = (uint8_t)vgetq_lane_u64(hi_bits, 0);
+            tiles[y >> 3][(x >> 3) + 1][((y & 7) << 1) + 0] = (uint8_t)vgetq_lane_u64(lo_bits, 1);
+            tiles[y >> 3][(x >> 3) + 1][((y & 7) << 1) + 1] = (uint8_t)vgetq_lane_u64(hi_bits, 1);
+#endif
+        }
+    }
+#else
+    for (y = 0; y < M64282FP_SENSOR_H; ++y) {
+        for (x = 0; x < M64282FP_SENSOR_W; ++x) {
+            /* apply dithering matrix */
+            uint8_t c = UINT8_C(0xc0) - apply_dithering_matrix(d, img[y][x], x, y);
+            img[y][x] = c;
+            /* encode as tiles */
+            uint8_t* tile_base = &tiles[y >> 3][x >> 3][(y & 7) << 1];
+            if (c & 0x40) { tile_base[0] |= (1U << (7 - (7 & x))); }
+            if (c & 0x80) { tile_base[1] |= (1U << (7 - (7 & x))); }
+        }
+    }
+#endif
+}
 
 static void grab_pocket_cam_image(struct pocket_cam* cam)
 {
@@ -625,7 +786,6 @@ static void grab_pocket_cam_image(struct pocket_cam* cam)
     uint8_t tiles[16][16][16];
     uint8_t bgr[M64282FP_SENSOR_H][M64282FP_SENSOR_W][3];
     uint8_t img[M64282FP_SENSOR_H][M64282FP_SENSOR_W];
-    unsigned int x, y;
 
     /* setup sensor regs */
     unsigned int pm_mode = (cam->regs[0] >> 1) & 0x3;
@@ -673,16 +833,7 @@ static void grab_pocket_cam_image(struct pocket_cam* cam)
 
     cv_imshow("bgr image", M64282FP_SENSOR_W, M64282FP_SENSOR_H, 3, bgr);
 
-    /* convert to gray using (2R+5G+1B)/8 formula */
-    const uint8_t* bgr_ptr = &bgr[0][0][0];
-    uint8_t* gray_ptr = &img[0][0];
-    for (y = 0; y < M64282FP_SENSOR_H; ++y) {
-        for (x = 0; x < M64282FP_SENSOR_W; ++x) {
-            gray_ptr[0] = (1*bgr_ptr[0] + 5*bgr_ptr[1] + 2*bgr_ptr[2]) / 8;
-            bgr_ptr += 3;
-            gray_ptr += 1;
-        }
-    }
+    convert_bgr_to_gray(&img[0][0], &bgr[0][0][0], M64282FP_SENSOR_W*M64282FP_SENSOR_H);
 
     /* apply m64282fp processings */
     cv_imshow("gray image", M64282FP_SENSOR_W, M64282FP_SENSOR_H, 1, img);
@@ -690,18 +841,7 @@ static void grab_pocket_cam_image(struct pocket_cam* cam)
     cv_imshow("m64282fp", M64282FP_SENSOR_W, M64282FP_SENSOR_H, 1, img);
 
     /* convert to dithered GB tile format */
-    memset(tiles, 0, sizeof(tiles));
-    for (y = 0; y < M64282FP_SENSOR_H; ++y) {
-        for (x = 0; x < M64282FP_SENSOR_W; ++x) {
-            /* apply dithering matrix */
-            uint8_t c = UINT8_C(0xc0) - apply_dithering_matrix(&cam->regs[6], img[y][x], x, y);
-            img[y][x] = c;
-            /* encode as tiles */
-            uint8_t* tile_base = &tiles[y >> 3][x >> 3][(y & 7) << 1];
-            if (c & 0x40) { tile_base[0] |= (1U << (7 - (7 & x))); }
-            if (c & 0x80) { tile_base[1] |= (1U << (7 - (7 & x))); }
-        }
-    }
+    encode_dithered_tiles(tiles, img, &cam->regs[6]);
 
     cv_imshow("dithered", M64282FP_SENSOR_W, M64282FP_SENSOR_H, 1, img);
 
@@ -195,6 +195,8 @@ void TLB_refill_exception(struct r4300_core* r4300, uint32_t address, int w)
     uint32_t* cp0_regs = r4300_cp0_regs(&r4300->cp0);
     int usual_handler = 0, i;
 
+    ++r4300->cp0.tlb.stats.refills;
+
     if (r4300->emumode != EMUMODE_DYNAREC && w != 2) {
         cp0_update_count(r4300);
     }
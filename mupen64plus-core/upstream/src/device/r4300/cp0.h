@@ -166,7 +166,7 @@ struct interrupt_handler
     void (*callback)(void*);
 };
 
-enum { CP0_INTERRUPT_HANDLERS_COUNT = 13 };
+enum { CP0_INTERRUPT_HANDLERS_COUNT = 14 };
 
 enum {
     INTR_UNSAFE_R4300 = 0x01,
@@ -1918,6 +1918,7 @@ static void TLBWI_new(int pcaddr, int count)
     {
       invalidate_block(i);
       state->memory_map[i]=(uintptr_t)-1;
+      ++r4300->cp0.tlb.stats.invalidated_blocks;
     }
   }
   for (i=old_start_odd>>12; i<=old_end_odd>>12; i++)
@@ -1926,6 +1927,7 @@ static void TLBWI_new(int pcaddr, int count)
     {
       invalidate_block(i);
       state->memory_map[i]=(uintptr_t)-1;
+      ++r4300->cp0.tlb.stats.invalidated_blocks;
     }
   }
   cached_interp_TLBWI();
@@ -1997,6 +1999,7 @@ static void TLBWR_new(int pcaddr, int count)
     {
       invalidate_block(i);
       state->memory_map[i]=(uintptr_t)-1;
+      ++r4300->cp0.tlb.stats.invalidated_blocks;
     }
   }
   for (i=old_start_odd>>12; i<=old_end_odd>>12; i++)
@@ -2005,6 +2008,7 @@ static void TLBWR_new(int pcaddr, int count)
     {
       invalidate_block(i);
       state->memory_map[i]=(uintptr_t)-1;
+      ++r4300->cp0.tlb.stats.invalidated_blocks;
     }
   }
   cached_interp_TLBWR();
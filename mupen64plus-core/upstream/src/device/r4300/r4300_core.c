@@ -283,9 +283,31 @@ uint32_t *fast_mem_access(struct r4300_core* r4300, uint32_t address)
      * Removing error checking saves some time, but the emulator may crash. */
 
     if ((address & UINT32_C(0xc0000000)) != UINT32_C(0x80000000)) {
+        struct tlb* tlb = &r4300->cp0.tlb;
+        uint32_t vpage = address >> 12;
+        struct tlb_host_entry* e = &tlb->host_cache[vpage & (TLB_HOST_CACHE_SIZE - 1)];
+        uint32_t* mem;
+
+        if (e->vpage == vpage) {
+            ++tlb->stats.host_cache_hits;
+            return e->host + ((address & UINT32_C(0xffc)) >> 2);
+        }
+        ++tlb->stats.host_cache_misses;
+
         address = virtual_to_physical_address(r4300, address, 2);
         if (address == 0) // TLB exception
             return NULL;
+
+        address &= UINT32_C(0x1ffffffc);
+        mem = mem_base_u32(r4300->mem->base, address);
+
+        /* mem base regions are page aligned, so the whole page can be cached */
+        if (mem != NULL) {
+            e->vpage = vpage;
+            e->host = mem - ((address & UINT32_C(0xffc)) >> 2);
+        }
+
+        return mem;
     }
 
     address &= UINT32_C(0x1ffffffc);
@@ -42,6 +42,38 @@ void poweron_tlb(struct tlb* tlb)
     memset(tlb->entries, 0, 32 * sizeof(tlb->entries[0]));
     memset(tlb->LUT_r, 0, 0x100000 * sizeof(tlb->LUT_r[0]));
     memset(tlb->LUT_w, 0, 0x100000 * sizeof(tlb->LUT_w[0]));
+    memset(&tlb->stats, 0, sizeof(tlb->stats));
+    tlb_flush_host_cache(tlb);
+}
+
+void tlb_flush_host_cache(struct tlb* tlb)
+{
+    size_t i;
+
+    for (i = 0; i < TLB_HOST_CACHE_SIZE; ++i) {
+        tlb->host_cache[i].vpage = TLB_HOST_CACHE_INVALID;
+        tlb->host_cache[i].host = NULL;
+    }
+}
+
+/* Drop cached translations of the virtual pages in [start, end] */
+static void invalidate_host_cache(struct tlb* tlb, uint32_t start, uint32_t end)
+{
+    uint32_t page;
+    uint32_t first = start >> 12;
+    uint32_t last = end >> 12;
+
+    if (last - first >= TLB_HOST_CACHE_SIZE) {
+        tlb_flush_host_cache(tlb);
+        return;
+    }
+
+    for (page = first; page <= last; ++page) {
+        struct tlb_host_entry* e = &tlb->host_cache[page & (TLB_HOST_CACHE_SIZE - 1)];
+        if (e->vpage == page) {
+            e->vpage = TLB_HOST_CACHE_INVALID;
+        }
+    }
 }
 
 void tlb_unmap(struct tlb* tlb, size_t entry)
@@ -54,6 +86,7 @@ void tlb_unmap(struct tlb* tlb, size_t entry)
 
     if (e->v_even)
     {
+        invalidate_host_cache(tlb, e->start_even, e->end_even);
         for (i=e->start_even; i<e->end_even; i += 0x1000)
             tlb->LUT_r[i>>12] = 0;
         if (e->d_even)
@@ -63,6 +96,7 @@ void tlb_unmap(struct tlb* tlb, size_t entry)
 
     if (e->v_odd)
     {
+        invalidate_host_cache(tlb, e->start_odd, e->end_odd);
         for (i=e->start_odd; i<e->end_odd; i += 0x1000)
             tlb->LUT_r[i>>12] = 0;
         if (e->d_odd)
@@ -85,6 +119,7 @@ void tlb_map(struct tlb* tlb, size_t entry)
             !(e->start_even >= 0x80000000 && e->end_even < 0xC0000000) &&
             e->phys_even < 0x20000000)
         {
+            invalidate_host_cache(tlb, e->start_even, e->end_even);
             for (i=e->start_even;i<e->end_even;i+=0x1000)
                 tlb->LUT_r[i>>12] = UINT32_C(0x80000000) | (e->phys_even + (i - e->start_even) + 0xFFF);
             if (e->d_even)
@@ -99,6 +134,7 @@ void tlb_map(struct tlb* tlb, size_t entry)
             !(e->start_odd >= 0x80000000 && e->end_odd < 0xC0000000) &&
             e->phys_odd < 0x20000000)
         {
+            invalidate_host_cache(tlb, e->start_odd, e->end_odd);
             for (i=e->start_odd;i<e->end_odd;i+=0x1000)
                 tlb->LUT_r[i>>12] = UINT32_C(0x80000000) | (e->phys_odd + (i - e->start_odd) + 0xFFF);
             if (e->d_odd)
@@ -52,11 +52,35 @@ struct tlb_entry
    unsigned int phys_odd;
 };
 
+/* Direct mapped cache of read translations going straight from a virtual page
+ * to the host address of its physical page. It sits in front of LUT_r on the
+ * instruction fetch path and is kept coherent by tlb_map/tlb_unmap. */
+#define TLB_HOST_CACHE_SIZE 256
+#define TLB_HOST_CACHE_INVALID UINT32_C(0xffffffff)
+
+struct tlb_host_entry
+{
+    uint32_t vpage;
+    uint32_t* host;
+};
+
+struct tlb_stats
+{
+    uint64_t writes;                /* TLBWI/TLBWR executed */
+    uint64_t refills;               /* TLB refill exceptions raised */
+    uint64_t invalidated_blocks;    /* cached or recompiled code pages invalidated by TLB writes */
+    uint64_t host_cache_hits;       /* fetches translated by the host cache */
+    uint64_t host_cache_misses;     /* fetches which had to go through LUT_r */
+};
+
 struct tlb
 {
     struct tlb_entry entries[32];
     uint32_t LUT_r[0x100000];
     uint32_t LUT_w[0x100000];
+
+    struct tlb_host_entry host_cache[TLB_HOST_CACHE_SIZE];
+    struct tlb_stats stats;
 };
 
 void init_tlb(int ignoreTlbExceptions);
@@ -66,6 +90,8 @@ void poweron_tlb(struct tlb* tlb);
 void tlb_unmap(struct tlb* tlb, size_t entry);
 void tlb_map(struct tlb* tlb, size_t entry);
 
+void tlb_flush_host_cache(struct tlb* tlb);
+
 uint32_t virtual_to_physical_address(struct r4300_core* r4300, uint32_t address, int w);
 
 #endif /* M64P_DEVICE_R4300_TLB_H */
@@ -28,6 +28,7 @@
 #include "device/r4300/r4300_core.h"
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/ri/ri_controller.h"
+#include "device/rcp/rsp/rsp_core.h"
 #include "device/rcp/vi/vi_controller.h"
 #include "device/rdram/rdram.h"
 
@@ -176,6 +177,8 @@ void read_ai_regs(void* opaque, uint32_t address, uint32_t* value)
         {
             unsigned int diff = ai->fifo[0].length - ai->last_read;
             unsigned char *p = (unsigned char*)&ai->ri->rdram->dram[ai->fifo[0].address/4];
+            /* samples may still be produced by an in-flight audio task */
+            rsp_wait_task(ai->mi->sp);
             ai->iaout->push_samples(ai->aout, p + diff, ai->last_read - *value);
             ai->last_read = *value;
         }
@@ -227,6 +230,7 @@ void ai_end_of_dma_event(void* opaque)
     {
         unsigned int diff = ai->fifo[0].length - ai->last_read;
         unsigned char *p = (unsigned char*)&ai->ri->rdram->dram[ai->fifo[0].address/4];
+        rsp_wait_task(ai->mi->sp);
         ai->iaout->push_samples(ai->aout, p + diff, ai->last_read);
         ai->last_read = 0;
     }
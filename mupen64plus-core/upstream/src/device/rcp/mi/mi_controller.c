@@ -26,6 +26,7 @@
 #include "device/r4300/cp0.h"
 #include "device/r4300/interrupt.h"
 #include "device/r4300/r4300_core.h"
+#include "device/rcp/rsp/rsp_core.h"
 
 static int update_mi_init_mode(uint32_t* mi_init_mode, uint32_t w)
 {
@@ -66,9 +67,10 @@ static void update_mi_intr_mask(uint32_t* mi_intr_mask, uint32_t w)
 }
 
 
-void init_mi(struct mi_controller* mi, struct r4300_core* r4300)
+void init_mi(struct mi_controller* mi, struct r4300_core* r4300, struct rsp_core* sp)
 {
     mi->r4300 = r4300;
+    mi->sp = sp;
 }
 
 void poweron_mi(struct mi_controller* mi)
@@ -83,6 +85,8 @@ void read_mi_regs(void* opaque, uint32_t address, uint32_t* value)
     struct mi_controller* mi = (struct mi_controller*)opaque;
     uint32_t reg = mi_reg(address);
 
+    rsp_wait_task(mi->sp);
+
     *value = mi->regs[reg];
 }
 
@@ -93,6 +97,8 @@ void write_mi_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask
 
     int* cp0_cycle_count = r4300_cp0_cycle_count(&mi->r4300->cp0);
 
+    rsp_wait_task(mi->sp);
+
     switch(reg)
     {
     case MI_INIT_MODE_REG:
@@ -117,6 +123,8 @@ void write_mi_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask
  */
 void raise_rcp_interrupt(struct mi_controller* mi, uint32_t mi_intr)
 {
+    rsp_wait_task(mi->sp);
+
     mi->regs[MI_INTR_REG] |= mi_intr;
 
     if (mi->regs[MI_INTR_REG] & mi->regs[MI_INTR_MASK_REG])
@@ -126,12 +134,16 @@ void raise_rcp_interrupt(struct mi_controller* mi, uint32_t mi_intr)
 /* interrupt execution is scheduled (if not masked) */
 void signal_rcp_interrupt(struct mi_controller* mi, uint32_t mi_intr)
 {
+    rsp_wait_task(mi->sp);
+
     mi->regs[MI_INTR_REG] |= mi_intr;
     r4300_check_interrupt(mi->r4300, CP0_CAUSE_IP2, mi->regs[MI_INTR_REG] & mi->regs[MI_INTR_MASK_REG]);
 }
 
 void clear_rcp_interrupt(struct mi_controller* mi, uint32_t mi_intr)
 {
+    rsp_wait_task(mi->sp);
+
     mi->regs[MI_INTR_REG] &= ~mi_intr;
     r4300_check_interrupt(mi->r4300, CP0_CAUSE_IP2, mi->regs[MI_INTR_REG] & mi->regs[MI_INTR_MASK_REG]);
 }
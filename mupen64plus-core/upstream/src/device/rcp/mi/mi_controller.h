@@ -27,6 +27,7 @@
 #include "osal/preproc.h"
 
 struct r4300_core;
+struct rsp_core;
 
 enum mi_registers
 {
@@ -53,6 +54,7 @@ struct mi_controller
     uint32_t regs[MI_REGS_COUNT];
 
     struct r4300_core* r4300;
+    struct rsp_core* sp;
 };
 
 static osal_inline uint32_t mi_reg(uint32_t address)
@@ -60,7 +62,7 @@ static osal_inline uint32_t mi_reg(uint32_t address)
     return (address & 0xffff) >> 2;
 }
 
-void init_mi(struct mi_controller* mi, struct r4300_core* r4300);
+void init_mi(struct mi_controller* mi, struct r4300_core* r4300, struct rsp_core* sp);
 void poweron_mi(struct mi_controller* mi);
 
 void read_mi_regs(void* opaque, uint32_t address, uint32_t* value);
@@ -25,6 +25,7 @@
 #include "api/callbacks.h"
 #include "device/memory/memory.h"
 #include "device/r4300/r4300_core.h"
+#include "device/rcp/rsp/rsp_core.h"
 #include "device/rdram/rdram.h"
 #include "osal/preproc.h"
 #include "plugin/plugin.h"
@@ -38,6 +39,9 @@ static osal_inline size_t fb_buffer_size(const FrameBufferInfo* fb_info)
 
 void pre_framebuffer_read(struct fb* fb, uint32_t address)
 {
+    /* framebuffers may still be rendered by an in-flight graphics task */
+    rsp_wait_task(fb->sp);
+
     if (!fb->infos[0].addr) {
         return;
     }
@@ -65,6 +69,8 @@ void pre_framebuffer_read(struct fb* fb, uint32_t address)
 
 void post_framebuffer_write(struct fb* fb, uint32_t address, uint32_t length)
 {
+    rsp_wait_task(fb->sp);
+
     if (!fb->infos[0].addr) {
         return;
     }
@@ -101,11 +107,13 @@ void post_framebuffer_write(struct fb* fb, uint32_t address, uint32_t length)
 void init_fb(struct fb* fb,
              struct memory* mem,
              struct rdram* rdram,
-             struct r4300_core* r4300)
+             struct r4300_core* r4300,
+             struct rsp_core* sp)
 {
     fb->mem = mem;
     fb->rdram = rdram;
     fb->r4300 = r4300;
+    fb->sp = sp;
 }
 
 void poweron_fb(struct fb* fb)
@@ -29,6 +29,7 @@
 struct memory;
 struct rdram;
 struct r4300_core;
+struct rsp_core;
 
 enum { FB_INFOS_COUNT = 6 };
 enum { FB_DIRTY_PAGES_COUNT = 0x800 };
@@ -38,6 +39,7 @@ struct fb
     struct memory* mem;
     struct rdram* rdram;
     struct r4300_core* r4300;
+    struct rsp_core* sp;
 
     unsigned char dirty_page[FB_DIRTY_PAGES_COUNT];
     FrameBufferInfo infos[FB_INFOS_COUNT];
@@ -47,7 +49,8 @@ struct fb
 void init_fb(struct fb* fb,
              struct memory* mem,
              struct rdram* rdram,
-             struct r4300_core* r4300);
+             struct r4300_core* r4300,
+             struct rsp_core* sp);
 
 void poweron_fb(struct fb* fb);
 
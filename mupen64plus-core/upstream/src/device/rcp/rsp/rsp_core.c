@@ -24,6 +24,7 @@
 #include <string.h>
 
 #include "device/memory/memory.h"
+#include "device/r4300/interrupt.h"
 #include "device/r4300/r4300_core.h"
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/rdp/rdp_core.h"
@@ -35,6 +36,7 @@
 #endif
 #include "plugin/plugin.h"
 #include "api/callbacks.h"
+#include "backends/api/task_runner_backend.h"
 
 static void do_sp_dma(struct rsp_core* sp, const struct sp_dma* dma)
 {
@@ -206,16 +208,34 @@ void init_rsp(struct rsp_core* sp,
               uint32_t* sp_mem,
               struct mi_controller* mi,
               struct rdp_core* dp,
-              struct ri_controller* ri)
+              struct ri_controller* ri,
+              void* task_runner,
+              const struct task_runner_backend_interface* itask_runner,
+              unsigned int threaded_gfx,
+              unsigned int threaded_audio,
+              unsigned int gfx_task_latency,
+              unsigned int audio_task_latency)
 {
     sp->mem = sp_mem;
     sp->mi = mi;
     sp->dp = dp;
     sp->ri = ri;
+
+    sp->task_runner = task_runner;
+    sp->itask_runner = itask_runner;
+    sp->threaded_gfx = (itask_runner != NULL) && threaded_gfx;
+    sp->threaded_audio = (itask_runner != NULL) && threaded_audio;
+    sp->gfx_task_latency = gfx_task_latency;
+    sp->audio_task_latency = audio_task_latency;
+    sp->task_pending = RSP_TASK_NONE;
+    memset(&sp->gfx_task_stats, 0, sizeof(sp->gfx_task_stats));
+    memset(&sp->audio_task_stats, 0, sizeof(sp->audio_task_stats));
 }
 
 void poweron_rsp(struct rsp_core* sp)
 {
+    rsp_wait_task(sp);
+
     memset(sp->mem, 0, SP_MEM_SIZE);
     memset(sp->regs, 0, SP_REGS_COUNT*sizeof(uint32_t));
     memset(sp->regs2, 0, SP_REGS2_COUNT*sizeof(uint32_t));
@@ -232,6 +252,8 @@ void read_rsp_mem(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t addr = rsp_mem_address(address);
 
+    rsp_wait_task(sp);
+
     *value = sp->mem[addr];
 }
 
@@ -240,6 +262,8 @@ void write_rsp_mem(void* opaque, uint32_t address, uint32_t value, uint32_t mask
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t addr = rsp_mem_address(address);
 
+    rsp_wait_task(sp);
+
     masked_write(&sp->mem[addr], value, mask);
 }
 
@@ -249,6 +273,8 @@ void read_rsp_regs(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg(address);
 
+    rsp_wait_task(sp);
+
     *value = sp->regs[reg];
 
     if (reg == SP_SEMAPHORE_REG)
@@ -262,6 +288,8 @@ void write_rsp_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mas
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg(address);
 
+    rsp_wait_task(sp);
+
     switch(reg)
     {
     case SP_STATUS_REG:
@@ -293,6 +321,8 @@ void read_rsp_regs2(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg2(address);
 
+    rsp_wait_task(sp);
+
     *value = sp->regs2[reg];
 }
 
@@ -301,17 +331,147 @@ void write_rsp_regs2(void* opaque, uint32_t address, uint32_t value, uint32_t ma
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg2(address);
 
+    rsp_wait_task(sp);
+
     masked_write(&sp->regs2[reg], value, mask);
 }
 
+static uint32_t get_cp0_count(struct r4300_core* r4300)
+{
+    cp0_update_count(r4300);
+    return r4300_cp0_regs(&r4300->cp0)[CP0_COUNT_REG];
+}
+
+static void run_task(void* opaque)
+{
+    rsp.doRspCycles(0xffffffff);
+}
+
+static void end_gfx_task(struct rsp_core* sp, uint32_t save_pc, uint32_t sp_delay_time)
+{
+    sp->regs2[SP_PC_REG] |= save_pc;
+    new_frame();
+
+    if (sp->mi->regs[MI_INTR_REG] & MI_INTR_DP)
+    {
+        sp->mi->regs[MI_INTR_REG] &= ~MI_INTR_DP;
+        if (sp->dp->dpc_regs[DPC_STATUS_REG] & DPC_STATUS_FREEZE) {
+            sp->dp->do_on_unfreeze |= DELAY_DP_INT;
+        } else {
+            cp0_update_count(sp->mi->r4300);
+            add_interrupt_event(&sp->mi->r4300->cp0, DP_INT, sp_delay_time + 3000);
+        }
+    }
+
+    protect_framebuffers(&sp->dp->fb);
+}
+
+static void end_sp_task(struct rsp_core* sp, uint32_t sp_delay_time)
+{
+    sp->rsp_task_locked = 0;
+    sp->mi->r4300->cp0.interrupt_unsafe_state &= ~INTR_UNSAFE_RSP;
+    if ((sp->regs[SP_STATUS_REG] & (SP_STATUS_HALT | SP_STATUS_BROKE)) == 0)
+    {
+        sp->rsp_task_locked = 1;
+        sp->mi->r4300->cp0.interrupt_unsafe_state |= INTR_UNSAFE_RSP;
+        sp->mi->regs[MI_INTR_REG] |= MI_INTR_SP;
+    }
+    if (sp->mi->regs[MI_INTR_REG] & MI_INTR_SP)
+    {
+        cp0_update_count(sp->mi->r4300);
+        add_interrupt_event(&sp->mi->r4300->cp0, SP_INT, sp_delay_time);
+        sp->mi->regs[MI_INTR_REG] &= ~MI_INTR_SP;
+    }
+
+    sp->regs[SP_STATUS_REG] &=
+        ~(SP_STATUS_TASKDONE | SP_STATUS_BROKE | SP_STATUS_HALT);
+}
+
+/* Hand the task over to the task runner. The r4300 keeps running until it touches
+ * state owned by the task or reaches the task deadline, see rsp_wait_task.
+ * Graphics tasks keep framebuffers protected meanwhile so that r4300 accesses to them
+ * also wait. Audio tasks are waited for when the AI reads samples from RDRAM.
+ */
+static void start_task(struct rsp_core* sp, unsigned int type, uint32_t save_pc, uint32_t latency)
+{
+    struct rsp_task_stats* stats = (type == RSP_TASK_GFX) ? &sp->gfx_task_stats : &sp->audio_task_stats;
+
+    sp->regs2[SP_PC_REG] &= 0xfff;
+
+    sp->task_save_pc = save_pc;
+    sp->task_start_count = get_cp0_count(sp->mi->r4300);
+    sp->task_delay_time = latency;
+    sp->task_pending = type;
+    ++stats->tasks;
+
+    /* no savestates or resets while the task is in flight */
+    sp->mi->r4300->cp0.interrupt_unsafe_state |= INTR_UNSAFE_RSP;
+    add_interrupt_event(&sp->mi->r4300->cp0, RSP_TSK_EVT, latency);
+
+    sp->itask_runner->start(sp->task_runner, run_task, sp);
+}
+
+static void wait_task(struct rsp_core* sp, int forced)
+{
+    unsigned int type = sp->task_pending;
+    struct rsp_task_stats* stats;
+    uint32_t elapsed;
+    uint32_t sp_delay_time;
+
+    if (type == RSP_TASK_NONE)
+        return;
+
+    stats = (type == RSP_TASK_GFX) ? &sp->gfx_task_stats : &sp->audio_task_stats;
+
+    sp->task_pending = RSP_TASK_NONE;
+    stats->stall_us += sp->itask_runner->wait(sp->task_runner);
+    stats->forced_syncs += forced;
+
+    remove_event(&sp->mi->r4300->cp0.q, RSP_TSK_EVT);
+
+    /* interrupts are scheduled relative to the start of the task, so that
+     * emulated timings do not depend on when the task actually completed */
+    elapsed = get_cp0_count(sp->mi->r4300) - sp->task_start_count;
+    stats->overlap_cycles += elapsed;
+    sp_delay_time = (elapsed < sp->task_delay_time) ? sp->task_delay_time - elapsed : 0;
+
+    if (type == RSP_TASK_GFX)
+    {
+        unprotect_framebuffers(&sp->dp->fb);
+        end_gfx_task(sp, sp->task_save_pc, sp_delay_time);
+    }
+    else
+    {
+        sp->regs2[SP_PC_REG] |= sp->task_save_pc;
+    }
+
+    end_sp_task(sp, sp_delay_time);
+}
+
+void rsp_wait_task(struct rsp_core* sp)
+{
+    wait_task(sp, 1);
+}
+
 void do_SP_Task(struct rsp_core* sp)
 {
-    uint32_t save_pc = sp->regs2[SP_PC_REG] & ~0xfff;
+    uint32_t save_pc;
 
     uint32_t sp_delay_time;
 
+    /* tasks never overlap */
+    rsp_wait_task(sp);
+
+    save_pc = sp->regs2[SP_PC_REG] & ~0xfff;
+
     if (sp->mem[0xfc0/4] == 1)
     {
+        if (sp->threaded_gfx)
+        {
+            start_task(sp, RSP_TASK_GFX, save_pc, sp->gfx_task_latency);
+            return;
+        }
+
         unprotect_framebuffers(&sp->dp->fb);
 
         //gfx.processDList();
@@ -323,25 +483,18 @@ void do_SP_Task(struct rsp_core* sp)
 #if defined(PROFILE)
         timed_section_end(TIMED_SECTION_GFX);
 #endif
-        sp->regs2[SP_PC_REG] |= save_pc;
-        new_frame();
-
-        if (sp->mi->regs[MI_INTR_REG] & MI_INTR_DP)
-        {
-            sp->mi->regs[MI_INTR_REG] &= ~MI_INTR_DP;
-            if (sp->dp->dpc_regs[DPC_STATUS_REG] & DPC_STATUS_FREEZE) {
-                sp->dp->do_on_unfreeze |= DELAY_DP_INT;
-            } else {
-                cp0_update_count(sp->mi->r4300);
-                add_interrupt_event(&sp->mi->r4300->cp0, DP_INT, 4000);
-            }
-        }
         sp_delay_time = 1000;
 
-        protect_framebuffers(&sp->dp->fb);
+        end_gfx_task(sp, save_pc, sp_delay_time);
     }
     else if (sp->mem[0xfc0/4] == 2)
     {
+        if (sp->threaded_audio)
+        {
+            start_task(sp, RSP_TASK_AUDIO, save_pc, sp->audio_task_latency);
+            return;
+        }
+
         //audio.processAList();
         sp->regs2[SP_PC_REG] &= 0xfff;
 #if defined(PROFILE)
@@ -364,29 +517,15 @@ void do_SP_Task(struct rsp_core* sp)
         sp_delay_time = 0;
     }
 
-    sp->rsp_task_locked = 0;
-    sp->mi->r4300->cp0.interrupt_unsafe_state &= ~INTR_UNSAFE_RSP;
-    if ((sp->regs[SP_STATUS_REG] & (SP_STATUS_HALT | SP_STATUS_BROKE)) == 0)
-    {
-        sp->rsp_task_locked = 1;
-        sp->mi->r4300->cp0.interrupt_unsafe_state |= INTR_UNSAFE_RSP;
-        sp->mi->regs[MI_INTR_REG] |= MI_INTR_SP;
-    }
-    if (sp->mi->regs[MI_INTR_REG] & MI_INTR_SP)
-    {
-        cp0_update_count(sp->mi->r4300);
-        add_interrupt_event(&sp->mi->r4300->cp0, SP_INT, sp_delay_time);
-        sp->mi->regs[MI_INTR_REG] &= ~MI_INTR_SP;
-    }
-
-    sp->regs[SP_STATUS_REG] &=
-        ~(SP_STATUS_TASKDONE | SP_STATUS_BROKE | SP_STATUS_HALT);
+    end_sp_task(sp, sp_delay_time);
 }
 
 void rsp_interrupt_event(void* opaque)
 {
     struct rsp_core* sp = (struct rsp_core*)opaque;
 
+    rsp_wait_task(sp);
+
     if (!sp->rsp_task_locked)
     {
         sp->regs[SP_STATUS_REG] |=
@@ -402,5 +541,12 @@ void rsp_interrupt_event(void* opaque)
 void rsp_end_of_dma_event(void* opaque)
 {
     struct rsp_core* sp = (struct rsp_core*)opaque;
+    rsp_wait_task(sp);
     fifo_pop(sp);
 }
+
+void rsp_task_deadline_event(void* opaque)
+{
+    struct rsp_core* sp = (struct rsp_core*)opaque;
+    wait_task(sp, 0);
+}
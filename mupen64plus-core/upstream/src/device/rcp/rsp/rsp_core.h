@@ -29,6 +29,7 @@
 struct mi_controller;
 struct rdp_core;
 struct ri_controller;
+struct task_runner_backend_interface;
 
 enum { SP_MEM_SIZE = 0x2000 };
 
@@ -91,6 +92,21 @@ struct sp_dma
     uint32_t dramaddr;
 };
 
+enum rsp_task_type
+{
+    RSP_TASK_NONE  = 0,
+    RSP_TASK_GFX   = 1,
+    RSP_TASK_AUDIO = 2
+};
+
+struct rsp_task_stats
+{
+    uint64_t tasks;             /* tasks run on the task runner */
+    uint64_t overlap_cycles;    /* count cycles run by the r4300 while a task was in flight */
+    uint64_t stall_us;          /* time spent waiting for in-flight tasks to complete */
+    uint64_t forced_syncs;      /* waits forced before the task deadline was reached */
+};
+
 struct rsp_core
 {
     uint32_t* mem;
@@ -102,6 +118,20 @@ struct rsp_core
     struct rdp_core* dp;
     struct ri_controller* ri;
     struct sp_dma fifo[SP_DMA_FIFO_SIZE];
+
+    /* threaded graphics and audio tasks (disabled if itask_runner is NULL) */
+    void* task_runner;
+    const struct task_runner_backend_interface* itask_runner;
+    unsigned int threaded_gfx;
+    unsigned int threaded_audio;
+    unsigned int gfx_task_latency;
+    unsigned int audio_task_latency;
+    unsigned int task_pending;      /* rsp_task_type of the in-flight task */
+    uint32_t task_save_pc;
+    uint32_t task_start_count;
+    uint32_t task_delay_time;
+    struct rsp_task_stats gfx_task_stats;
+    struct rsp_task_stats audio_task_stats;
 };
 
 static osal_inline uint32_t rsp_mem_address(uint32_t address)
@@ -123,7 +153,13 @@ void init_rsp(struct rsp_core* sp,
               uint32_t* sp_mem,
               struct mi_controller* mi,
               struct rdp_core* dp,
-              struct ri_controller* ri);
+              struct ri_controller* ri,
+              void* task_runner,
+              const struct task_runner_backend_interface* itask_runner,
+              unsigned int threaded_gfx,
+              unsigned int threaded_audio,
+              unsigned int gfx_task_latency,
+              unsigned int audio_task_latency);
 
 void poweron_rsp(struct rsp_core* sp);
 
@@ -138,7 +174,14 @@ void write_rsp_regs2(void* opaque, uint32_t address, uint32_t value, uint32_t ma
 
 void do_SP_Task(struct rsp_core* sp);
 
+/* Wait for the in-flight task (if any) and complete it.
+ * Must be called before touching any state owned by the task.
+ * The wait is counted as a forced sync since the task deadline was not reached yet.
+ */
+void rsp_wait_task(struct rsp_core* sp);
+
 void rsp_interrupt_event(void* opaque);
 void rsp_end_of_dma_event(void* opaque);
+void rsp_task_deadline_event(void* opaque);
 
 #endif
@@ -27,6 +27,8 @@
 #include "device/memory/memory.h"
 #include "device/r4300/r4300_core.h"
 #include "device/rcp/mi/mi_controller.h"
+#include "device/rcp/rdp/rdp_core.h"
+#include "device/rcp/rsp/rsp_core.h"
 #include "main/main.h"
 #include "plugin/plugin.h"
 
@@ -117,6 +119,9 @@ void write_vi_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask
     struct vi_controller* vi = (struct vi_controller*)opaque;
     uint32_t reg = vi_reg(address);
 
+    /* the graphics task may read VI registers */
+    rsp_wait_task(vi->dp->sp);
+
     switch(reg)
     {
     case VI_STATUS_REG:
@@ -173,6 +178,10 @@ void write_vi_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mask
 void vi_vertical_interrupt_event(void* opaque)
 {
     struct vi_controller* vi = (struct vi_controller*)opaque;
+
+    /* updateScreen must not run concurrently with a graphics task */
+    rsp_wait_task(vi->dp->sp);
+
     if (vi->dp->do_on_unfreeze & DELAY_DP_INT)
         vi->dp->do_on_unfreeze |= DELAY_UPDATESCREEN;
     else
@@ -49,29 +49,68 @@
 typedef struct cheat_code {
     uint32_t address;
     uint32_t value;
-    uint32_t old_value;
     struct list_head list;
 } cheat_code_t;
 
 typedef struct cheat {
     char *name;
+    uint32_t id;    /* changes whenever the codes are replaced */
     int enabled;
-    int was_enabled;
     struct list_head cheat_codes;
     struct list_head list;
 } cheat_t;
 
-/* private functions */
-static uint16_t read_address_16bit(struct r4300_core* r4300, uint32_t address)
+/* Cheats are compiled into a flat program of pre-decoded operations whenever
+ * they change. The program is applied by the emulation thread without locking.
+ */
+enum cheat_op_kind
 {
-    return *(uint16_t*)(((unsigned char*)r4300->rdram->dram + ((address & 0xFFFFFF)^S16)));
-}
+    CHEAT_OP_NOP,
+    CHEAT_OP_WRITE8,
+    CHEAT_OP_WRITE16,
+    CHEAT_OP_EQUAL8,
+    CHEAT_OP_EQUAL16,
+    CHEAT_OP_NOT_EQUAL8,
+    CHEAT_OP_NOT_EQUAL16,
+    CHEAT_OP_EE
+};
+
+enum cheat_op_flags
+{
+    CHEAT_OP_TEST      = 0x1,   /* conditional code, skips the next non-test code if false */
+    CHEAT_OP_GS_BUTTON = 0x2,   /* only active while the GS button is pressed */
+    CHEAT_OP_BOOT      = 0x4    /* only written once at boot time */
+};
 
-static uint8_t read_address_8bit(struct r4300_core* r4300, uint32_t address)
+struct cheat_op
 {
-    return *(uint8_t*)(((unsigned char*)r4300->rdram->dram + ((address & 0xFFFFFF)^S8)));
-}
+    uint8_t* host;          /* RDRAM location, resolved by the emulation thread */
+    uint32_t offset;        /* RDRAM byte offset with the host byte order swizzle applied */
+    uint32_t address;       /* code address, used to invalidate cached code */
+    uint32_t old_value;     /* value before the first write, restored when disabled */
+    uint16_t value;
+    uint8_t kind;
+    uint8_t flags;
+};
+
+struct cheat_entry
+{
+    uint32_t id;
+    int enabled;
+    int was_enabled;
+    size_t first_op;
+    size_t op_count;
+};
+
+struct cheat_program
+{
+    struct cheat_entry* cheats;
+    size_t cheat_count;
+    struct cheat_op* ops;
+    size_t op_count;
+};
 
+/* private functions */
 static void update_address_16bit(struct r4300_core* r4300, uint32_t address, uint16_t new_value)
 {
     *(uint16_t*)(((unsigned char*)r4300->rdram->dram + ((address & 0xFFFFFF)^S16))) = new_value;
@@ -80,31 +119,16 @@ static void update_address_16bit(struct r4300_core* r4300, uint32_t address, uin
     invalidate_r4300_cached_code(r4300, address, 2);
 }
 
-static void update_address_8bit(struct r4300_core* r4300, uint32_t address, uint8_t new_value)
-{
-    *(uint8_t*)(((unsigned char*)r4300->rdram->dram + ((address & 0xFFFFFF)^S8))) = new_value;
-    invalidate_r4300_cached_code(r4300, address, 1);
-}
-
-static int address_equal_to_8bit(struct r4300_core* r4300, uint32_t address, uint8_t value)
-{
-    uint8_t value_read;
-    value_read = *(uint8_t*)(((unsigned char*)r4300->rdram->dram + ((address & 0xFFFFFF)^S8)));
-    return value_read == value;
-}
-
-static int address_equal_to_16bit(struct r4300_core* r4300, uint32_t address, uint16_t value)
+static void decode_cheat_code(struct cheat_op* op, uint32_t address, uint32_t value)
 {
-    uint16_t value_read;
-    value_read = *(unsigned short *)(((unsigned char*)r4300->rdram->dram + ((address & 0xFFFFFF)^S16)));
-    return value_read == value;
-}
+    op->host = NULL;
+    op->offset = 0;
+    op->address = address;
+    op->old_value = CHEAT_CODE_MAGIC_VALUE;
+    op->value = (uint16_t)value;
+    op->kind = CHEAT_OP_NOP;
+    op->flags = 0;
 
-/* individual application - returns 0 if we are supposed to skip the next cheat
- * (only really used on conditional codes)
- */
-static int execute_cheat(struct r4300_core* r4300, uint32_t address, uint32_t value, uint32_t* old_value)
-{
     switch (address & 0xFF000000)
     {
     case 0x80000000:
@@ -112,45 +136,330 @@ static int execute_cheat(struct r4300_core* r4300, uint32_t address, uint32_t va
     case 0xA0000000:
     case 0xA8000000:
     case 0xF0000000:
-        /* if pointer to old value is valid and uninitialized, write current value to it */
-        if (old_value && (*old_value == CHEAT_CODE_MAGIC_VALUE)) {
-            *old_value = read_address_8bit(r4300, address);
-        }
-        update_address_8bit(r4300, address, (uint8_t)value);
-        return 1;
+        op->kind = CHEAT_OP_WRITE8;
+        break;
     case 0x81000000:
     case 0x89000000:
     case 0xA1000000:
     case 0xA9000000:
     case 0xF1000000:
-        /* if pointer to old value is valid and uninitialized, write current value to it */
-        if (old_value && (*old_value == CHEAT_CODE_MAGIC_VALUE)) {
-            *old_value = read_address_16bit(r4300, address);
-        }
-        update_address_16bit(r4300, address, (uint16_t)value);
-        return 1;
+        op->kind = CHEAT_OP_WRITE16;
+        break;
     case 0xD0000000:
     case 0xD8000000:
-        return address_equal_to_8bit(r4300, address, (uint8_t)value);
+        op->kind = CHEAT_OP_EQUAL8;
+        break;
     case 0xD1000000:
     case 0xD9000000:
-        return address_equal_to_16bit(r4300, address, (uint16_t)value);
+        op->kind = CHEAT_OP_EQUAL16;
+        break;
     case 0xD2000000:
     case 0xDB000000:
-        return !(address_equal_to_8bit(r4300, address, (uint8_t)value));
+        op->kind = CHEAT_OP_NOT_EQUAL8;
+        break;
     case 0xD3000000:
     case 0xDA000000:
-        return !(address_equal_to_16bit(r4300, address, (uint16_t)value));
+        op->kind = CHEAT_OP_NOT_EQUAL16;
+        break;
     case 0xEE000000:
-        /* most likely, this doesnt do anything. */
-        execute_cheat(r4300, 0xF1000318, 0x0040, NULL);
-        execute_cheat(r4300, 0xF100031A, 0x0000, NULL);
-        return 1;
+        op->kind = CHEAT_OP_EE;
+        break;
+    default:
+        break;
+    }
+
+    switch (op->kind)
+    {
+    case CHEAT_OP_WRITE8:
+    case CHEAT_OP_EQUAL8:
+    case CHEAT_OP_NOT_EQUAL8:
+        op->offset = (address & 0xFFFFFF)^S8;
+        break;
+    case CHEAT_OP_WRITE16:
+    case CHEAT_OP_EQUAL16:
+    case CHEAT_OP_NOT_EQUAL16:
+        op->offset = (address & 0xFFFFFF)^S16;
+        break;
+    default:
+        break;
+    }
+
+    switch (address & 0xFF000000)
+    {
+    case 0x88000000:
+    case 0x89000000:
+    case 0xA8000000:
+    case 0xA9000000:
+    case 0xD8000000:
+    case 0xD9000000:
+    case 0xDA000000:
+    case 0xDB000000:
+        op->flags |= CHEAT_OP_GS_BUTTON;
+        break;
+    default:
+        break;
+    }
+
+    if ((address & 0xF0000000) == 0xD0000000)
+        op->flags |= CHEAT_OP_TEST;
+    if ((address & 0xF0000000) == 0xF0000000)
+        op->flags |= CHEAT_OP_BOOT;
+}
+
+/* Atomically replaces the published program, returns the previous one */
+static struct cheat_program* exchange_pending_program(struct cheat_ctx* ctx, struct cheat_program* program)
+{
+#if SDL_VERSION_ATLEAST(2,0,2)
+    return (struct cheat_program*)SDL_AtomicSetPtr(&ctx->pending_program, program);
+#else
+    return (struct cheat_program*)__atomic_exchange_n(&ctx->pending_program, program, __ATOMIC_ACQ_REL);
+#endif
+}
+
+static void free_cheat_program(struct cheat_program* program)
+{
+    if (program == NULL)
+        return;
+
+    free(program->cheats);
+    free(program->ops);
+    free(program);
+}
+
+/* Must be called with the cheat mutex held */
+static struct cheat_program* compile_cheats(struct cheat_ctx* ctx)
+{
+    struct cheat_program* program;
+    cheat_t *cheat;
+    cheat_code_t *code;
+    size_t cheat_count = 0;
+    size_t op_count = 0;
+
+    list_for_each_entry_t(cheat, &ctx->active_cheats, cheat_t, list) {
+        ++cheat_count;
+        list_for_each_entry_t(code, &cheat->cheat_codes, cheat_code_t, list) {
+            ++op_count;
+        }
+    }
+
+    program = calloc(1, sizeof(*program));
+    if (program == NULL)
+        return NULL;
+
+    program->cheats = malloc((cheat_count + 1) * sizeof(*program->cheats));
+    program->ops = malloc((op_count + 1) * sizeof(*program->ops));
+    if (program->cheats == NULL || program->ops == NULL) {
+        free_cheat_program(program);
+        return NULL;
+    }
+
+    list_for_each_entry_t(cheat, &ctx->active_cheats, cheat_t, list) {
+        struct cheat_entry* entry = &program->cheats[program->cheat_count++];
+
+        entry->id = cheat->id;
+        entry->enabled = cheat->enabled;
+        entry->was_enabled = 0;
+        entry->first_op = program->op_count;
+
+        list_for_each_entry_t(code, &cheat->cheat_codes, cheat_code_t, list) {
+            decode_cheat_code(&program->ops[program->op_count++], code->address, code->value);
+        }
+
+        entry->op_count = program->op_count - entry->first_op;
+    }
+
+    return program;
+}
+
+/* Must be called with the cheat mutex held */
+static void publish_cheats(struct cheat_ctx* ctx)
+{
+    struct cheat_program* program = compile_cheats(ctx);
+    struct cheat_program* stale;
+
+    if (program == NULL) {
+        DebugMessage(M64MSG_ERROR, "Failed to compile cheats");
+        return;
+    }
+
+    /* a program the emulation thread did not pick up yet is ours to free */
+    stale = exchange_pending_program(ctx, program);
+    free_cheat_program(stale);
+}
+
+/* Called by the emulation thread before applying a newly published program */
+static void adopt_cheat_program(struct cheat_ctx* ctx, struct cheat_program* program, struct r4300_core* r4300)
+{
+    struct cheat_program* previous = ctx->program;
+    uint8_t* dram = (uint8_t*)r4300->rdram->dram;
+    size_t dram_size = r4300->rdram->dram_size;
+    size_t i, j;
+
+    for (j = 0; j < program->op_count; ++j) {
+        struct cheat_op* op = &program->ops[j];
+        size_t size;
+
+        switch (op->kind)
+        {
+        case CHEAT_OP_WRITE8:
+        case CHEAT_OP_EQUAL8:
+        case CHEAT_OP_NOT_EQUAL8:
+            size = 1;
+            break;
+        case CHEAT_OP_WRITE16:
+        case CHEAT_OP_EQUAL16:
+        case CHEAT_OP_NOT_EQUAL16:
+            size = 2;
+            break;
+        default:
+            continue;
+        }
+
+        /* codes outside of RDRAM have no effect */
+        if (op->offset + size > dram_size)
+            op->kind = CHEAT_OP_NOP;
+        else
+            op->host = dram + op->offset;
+    }
+
+    /* cheats keep their position until all are deleted, so state of cheats
+     * whose codes were not replaced can be carried over by index */
+    if (previous != NULL) {
+        for (i = 0; i < program->cheat_count && i < previous->cheat_count; ++i) {
+            struct cheat_entry* cheat = &program->cheats[i];
+            const struct cheat_entry* prev = &previous->cheats[i];
+
+            if (cheat->id != prev->id)
+                continue;
+
+            cheat->was_enabled = prev->was_enabled;
+            for (j = 0; j < cheat->op_count; ++j) {
+                program->ops[cheat->first_op + j].old_value = previous->ops[prev->first_op + j].old_value;
+            }
+        }
+    }
+
+    ctx->program = program;
+    free_cheat_program(previous);
+}
+
+/* returns 0 if we are supposed to skip the next cheat */
+static int test_cheat_op(const struct cheat_op* op)
+{
+    switch (op->kind)
+    {
+    case CHEAT_OP_EQUAL8:
+        return *op->host == (uint8_t)op->value;
+    case CHEAT_OP_EQUAL16:
+        return *(uint16_t*)op->host == op->value;
+    case CHEAT_OP_NOT_EQUAL8:
+        return *op->host != (uint8_t)op->value;
+    case CHEAT_OP_NOT_EQUAL16:
+        return *(uint16_t*)op->host != op->value;
     default:
         return 1;
     }
 }
 
+/* Memory is only written, and cached code invalidated, if the value changes */
+static void write_cheat_op(struct r4300_core* r4300, struct cheat_op* op, uint16_t value, int save_old_value)
+{
+    switch (op->kind)
+    {
+    case CHEAT_OP_WRITE8:
+        if (save_old_value && op->old_value == CHEAT_CODE_MAGIC_VALUE) {
+            op->old_value = *op->host;
+        }
+        if (*op->host != (uint8_t)value) {
+            *op->host = (uint8_t)value;
+            invalidate_r4300_cached_code(r4300, op->address, 1);
+        }
+        break;
+    case CHEAT_OP_WRITE16:
+        if (save_old_value && op->old_value == CHEAT_CODE_MAGIC_VALUE) {
+            op->old_value = *(uint16_t*)op->host;
+        }
+        if (*(uint16_t*)op->host != value) {
+            *(uint16_t*)op->host = value;
+            /* mask out bit 24 which is used by GS codes to specify 8/16 bits */
+            invalidate_r4300_cached_code(r4300, op->address & 0xfeffffff, 2);
+        }
+        break;
+    case CHEAT_OP_EE:
+        /* most likely, this doesnt do anything. */
+        update_address_16bit(r4300, 0xF1000318, 0x0040);
+        update_address_16bit(r4300, 0xF100031A, 0x0000);
+        break;
+    default:
+        break;
+    }
+}
+
+static void apply_boot_cheat(struct r4300_core* r4300, struct cheat_op* ops, size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i) {
+        /* code should only be written once at boot time */
+        if (ops[i].flags & CHEAT_OP_BOOT) {
+            write_cheat_op(r4300, &ops[i], ops[i].value, 1);
+        }
+    }
+}
+
+static void apply_vi_cheat(struct r4300_core* r4300, struct cheat_op* ops, size_t count, int gs_active)
+{
+    /* a cheat starts without failed preconditions */
+    int cond_failed = 0;
+    size_t i;
+
+    for (i = 0; i < count; ++i) {
+        struct cheat_op* op = &ops[i];
+
+        /* conditional cheat codes */
+        if (op->flags & CHEAT_OP_TEST) {
+            /* if code needs GS button pressed and it's not,
+             * or if condition false, skip next code non-test code */
+            if (((op->flags & CHEAT_OP_GS_BUTTON) && !gs_active) || !test_cheat_op(op)) {
+                cond_failed = 1;
+            }
+            continue;
+        }
+
+        /* preconditions were false for this non-test code
+         * reset the condition state and skip the cheat
+         */
+        if (cond_failed) {
+            cond_failed = 0;
+            continue;
+        }
+
+        /* GS button triggers cheat code */
+        if (op->flags & CHEAT_OP_GS_BUTTON) {
+            if (gs_active) {
+                write_cheat_op(r4300, op, op->value, 0);
+            }
+        }
+        /* normal cheat code, excluding boot-time cheat codes */
+        else if (!(op->flags & CHEAT_OP_BOOT)) {
+            write_cheat_op(r4300, op, op->value, 1);
+        }
+    }
+}
+
+static void restore_cheat(struct r4300_core* r4300, struct cheat_op* ops, size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; ++i) {
+        /* set memory back to old value and clear saved copy of old value */
+        if (ops[i].old_value != CHEAT_CODE_MAGIC_VALUE) {
+            write_cheat_op(r4300, &ops[i], (uint16_t)ops[i].old_value, 0);
+            ops[i].old_value = CHEAT_CODE_MAGIC_VALUE;
+        }
+    }
+}
+
 static cheat_t *find_or_create_cheat(struct cheat_ctx* ctx, const char *name)
 {
     cheat_t *cheat;
@@ -173,15 +482,15 @@ static cheat_t *find_or_create_cheat(struct cheat_ctx* ctx, const char *name)
             free(code);
         }
 
+        cheat->id = ctx->next_cheat_id++;
         cheat->enabled = 0;
-        cheat->was_enabled = 0;
     }
     else
     {
         cheat = malloc(sizeof(*cheat));
         cheat->name = strdup(name);
+        cheat->id = ctx->next_cheat_id++;
         cheat->enabled = 0;
-        cheat->was_enabled = 0;
         INIT_LIST_HEAD(&cheat->cheat_codes);
         list_add_tail(&cheat->list, &ctx->active_cheats);
     }
@@ -195,6 +504,9 @@ void cheat_init(struct cheat_ctx* ctx)
 {
     ctx->mutex = SDL_CreateMutex();
     INIT_LIST_HEAD(&ctx->active_cheats);
+    ctx->next_cheat_id = 0;
+    ctx->pending_program = NULL;
+    ctx->program = NULL;
 }
 
 void cheat_uninit(struct cheat_ctx* ctx)
@@ -203,89 +515,44 @@ void cheat_uninit(struct cheat_ctx* ctx)
         SDL_DestroyMutex(ctx->mutex);
     }
     ctx->mutex = NULL;
+
+    free_cheat_program(exchange_pending_program(ctx, NULL));
+    free_cheat_program(ctx->program);
+    ctx->program = NULL;
 }
 
 void cheat_apply_cheats(struct cheat_ctx* ctx, struct r4300_core* r4300, int entry)
 {
-    cheat_t *cheat;
-    cheat_code_t *code;
-    int cond_failed;
+    struct cheat_program* program;
+    int gs_active;
+    size_t i;
+
+    /* pick up cheats changed since the last application */
+    program = exchange_pending_program(ctx, NULL);
+    if (program != NULL) {
+        adopt_cheat_program(ctx, program, r4300);
+    }
 
-    if (list_empty(&ctx->active_cheats))
+    program = ctx->program;
+    if (program == NULL || program->cheat_count == 0)
         return;
 
-    if (ctx->mutex == NULL || SDL_LockMutex(ctx->mutex) != 0)
-    {
-        DebugMessage(M64MSG_ERROR, "Internal error: failed to lock mutex in cheat_apply_cheats()");
-        return;
-    }
+    gs_active = event_gameshark_active();
+
+    for (i = 0; i < program->cheat_count; ++i) {
+        struct cheat_entry* cheat = &program->cheats[i];
+        struct cheat_op* ops = &program->ops[cheat->first_op];
 
-    list_for_each_entry_t(cheat, &ctx->active_cheats, cheat_t, list) {
         if (cheat->enabled)
         {
             cheat->was_enabled = 1;
             switch(entry)
             {
             case ENTRY_BOOT:
-                list_for_each_entry_t(code, &cheat->cheat_codes, cheat_code_t, list) {
-                    /* code should only be written once at boot time */
-                    if ((code->address & 0xF0000000) == 0xF0000000) {
-                        execute_cheat(r4300, code->address, code->value, &code->old_value);
-                    }
-                }
+                apply_boot_cheat(r4300, ops, cheat->op_count);
                 break;
             case ENTRY_VI:
-                /* a cheat starts without failed preconditions */
-                cond_failed = 0;
-
-                list_for_each_entry_t(code, &cheat->cheat_codes, cheat_code_t, list) {
-                    /* conditional cheat codes */
-                    if ((code->address & 0xF0000000) == 0xD0000000)
-                    {
-                        /* if code needs GS button pressed and it's not, skip it */
-                        if (((code->address & 0xFF000000) == 0xD8000000 ||
-                                    (code->address & 0xFF000000) == 0xD9000000 ||
-                                    (code->address & 0xFF000000) == 0xDA000000 ||
-                                    (code->address & 0xFF000000) == 0xDB000000) &&
-                                !event_gameshark_active()) {
-                            /* if condition false, skip next code non-test code */
-                            cond_failed = 1;
-                        }
-
-                        /* if condition false, skip next code non-test code */
-                        if (!execute_cheat(r4300, code->address, code->value, NULL)) {
-                            cond_failed = 1;
-                        }
-                    }
-                    else {
-                        /* preconditions were false for this non-test code
-                         * reset the condition state and skip the cheat
-                         */
-                        if (cond_failed) {
-                            cond_failed = 0;
-                            continue;
-                        }
-
-                        switch (code->address & 0xFF000000) {
-                        /* GS button triggers cheat code */
-                        case 0x88000000:
-                        case 0x89000000:
-                        case 0xA8000000:
-                        case 0xA9000000:
-                            if (event_gameshark_active()) {
-                                execute_cheat(r4300, code->address, code->value, NULL);
-                            }
-                            break;
-                            /* normal cheat code */
-                        default:
-                            /* exclude boot-time cheat codes */
-                            if ((code->address & 0xF0000000) != 0xF0000000) {
-                                execute_cheat(r4300, code->address, code->value, &code->old_value);
-                            }
-                            break;
-                        }
-                    }
-                }
+                apply_vi_cheat(r4300, ops, cheat->op_count, gs_active);
                 break;
             default:
                 break;
@@ -298,22 +565,13 @@ void cheat_apply_cheats(struct cheat_ctx* ctx, struct r4300_core* r4300, int ent
             switch(entry)
             {
             case ENTRY_VI:
-                list_for_each_entry_t(code, &cheat->cheat_codes, cheat_code_t, list) {
-                    /* set memory back to old value and clear saved copy of old value */
-                    if(code->old_value != CHEAT_CODE_MAGIC_VALUE)
-                    {
-                        execute_cheat(r4300, code->address, code->old_value, NULL);
-                        code->old_value = CHEAT_CODE_MAGIC_VALUE;
-                    }
-                }
+                restore_cheat(r4300, ops, cheat->op_count);
                 break;
             default:
                 break;
             }
         }
     }
-
-    SDL_UnlockMutex(ctx->mutex);
 }
 
 
@@ -342,6 +600,8 @@ void cheat_delete_all(struct cheat_ctx* ctx)
         free(cheat);
     }
 
+    publish_cheats(ctx);
+
     SDL_UnlockMutex(ctx->mutex);
 }
 
@@ -361,7 +621,10 @@ int cheat_set_enabled(struct cheat_ctx* ctx, const char* name, int enabled)
     list_for_each_entry_t(cheat, &ctx->active_cheats, cheat_t, list) {
         if (strcmp(name, cheat->name) == 0)
         {
-            cheat->enabled = enabled;
+            if (cheat->enabled != enabled) {
+                cheat->enabled = enabled;
+                publish_cheats(ctx);
+            }
             SDL_UnlockMutex(ctx->mutex);
             return 1;
         }
@@ -409,7 +672,6 @@ int cheat_add_new(struct cheat_ctx* ctx, const char* name, m64p_cheat_code* code
                 cheat_code_t *code = malloc(sizeof(*code));
                 code->address = cur_addr;
                 code->value = cur_value;
-                code->old_value = CHEAT_CODE_MAGIC_VALUE;
                 list_add_tail(&code->list, &cheat->cheat_codes);
                 cur_addr += incr_addr;
                 cur_value += incr_value;
@@ -421,11 +683,12 @@ int cheat_add_new(struct cheat_ctx* ctx, const char* name, m64p_cheat_code* code
             cheat_code_t *code = malloc(sizeof(*code));
             code->address = code_list[i].address;
             code->value = code_list[i].value;
-            code->old_value = CHEAT_CODE_MAGIC_VALUE;
             list_add_tail(&code->list, &cheat->cheat_codes);
         }
     }
 
+    publish_cheats(ctx);
+
     SDL_UnlockMutex(ctx->mutex);
     return 1;
 }
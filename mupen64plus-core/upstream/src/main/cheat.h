@@ -32,12 +32,19 @@
 #define ENTRY_VI 1
 
 struct SDL_mutex;
+struct cheat_program;
 struct r4300_core;
 
 struct cheat_ctx
 {
     struct SDL_mutex* mutex;
     struct list_head active_cheats;
+    uint32_t next_cheat_id;
+
+    /* compiled cheats published under mutex, taken over by cheat_apply_cheats */
+    void* pending_program;
+    /* compiled cheats being applied, only accessed by the emulation thread */
+    struct cheat_program* program;
 };
 
 void cheat_apply_cheats(struct cheat_ctx* ctx, struct r4300_core* r4300, int entry);
@@ -140,6 +140,7 @@ static const int NumJoyCommands = sizeof(JoyCmdName) / sizeof(const char *);
 
 static int JoyCmdActive[16][2];  /* if extra joystick commands are added above, make sure there is enough room in this array */
                                  /* [i][0] is Command Active, [i][1] is Hotkey Active */
+static m64p_handle JoyCmdParam[16]; /* matched against every joystick event, so looked up once */
 #endif /* NO_KEYBINDINGS */
 
 static int GamesharkActive = 0;
@@ -159,7 +160,7 @@ static int GamesharkActive = 0;
  */
 static int MatchJoyCommand(const SDL_Event *event, eJoyCommand cmd)
 {
-    const char *multi_event_str = ConfigGetParamString(l_CoreEventsConfig, JoyCmdName[cmd]);
+    const char *multi_event_str = ConfigGetCachedParamString(JoyCmdParam[cmd]);
     const int orig_cmd_value = (JoyCmdActive[cmd][1] << 1) | JoyCmdActive[cmd][0];
     int dev_number, input_number, input_value;
     char axis_direction;
@@ -599,6 +600,9 @@ int event_set_core_defaults(void)
     ConfigSetDefaultString(l_CoreEventsConfig, JoyCmdName[joyForward], "",    "Joystick event string for fast-forward");
     ConfigSetDefaultString(l_CoreEventsConfig, JoyCmdName[joyAdvance], "",    "Joystick event string for advancing by one frame when paused");
     ConfigSetDefaultString(l_CoreEventsConfig, JoyCmdName[joyGameshark], "",  "Joystick event string for pressing the game shark button");
+
+    for (int cmd = 0; cmd < NumJoyCommands; cmd++)
+        ConfigGetParamHandle(l_CoreEventsConfig, JoyCmdName[cmd], &JoyCmdParam[cmd]);
 #endif /* NO_KEYBINDINGS */
     return 1;
 }
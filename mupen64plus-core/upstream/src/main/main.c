@@ -50,10 +50,15 @@
 #include "backends/api/joybus.h"
 #include "backends/api/rumble_backend.h"
 #include "backends/api/storage_backend.h"
+#include "backends/api/task_runner_backend.h"
 #include "backends/api/video_capture_backend.h"
 #include "backends/plugins_compat/plugins_compat.h"
+#include "backends/async_disk_storage.h"
+#include "backends/async_file_storage.h"
 #include "backends/clock_ctime_plus_delta.h"
 #include "backends/file_storage.h"
+#include "backends/prefetch_video_capture.h"
+#include "backends/thread_task_runner.h"
 #include "cheat.h"
 #include "device/device.h"
 #include "device/dd/disk.h"
@@ -123,6 +128,7 @@ static int   l_TakeScreenshot = 0;       // Tell OSD Rendering callback to take
 static int   l_SpeedFactor = 100;        // percentage of nominal game speed at which emulator is running
 static int   l_FrameAdvance = 0;         // variable to check if we pause on next frame
 static int   l_MainSpeedLimit = 1;       // insert delay during vi_interrupt to keep speed at real-time
+static m64p_handle l_OnScreenDisplay = NULL; // read on every rendered frame and OSD message
 
 static osd_message_t *l_msgVol = NULL;
 static osd_message_t *l_msgFF = NULL;
@@ -267,6 +273,26 @@ static m64p_error init_video_capture_backend(const struct video_capture_backend_
     return err;
 }
 
+/* Stop grabbing GB cam frames ahead. The prefetch_video_capture must be closed. */
+static void release_gbcam_prefetch(struct prefetch_video_capture* pcap)
+{
+    struct prefetch_video_capture_stats stats;
+
+    if (pcap == NULL)
+        return;
+
+    release_prefetch_video_capture(pcap, &stats);
+
+    if (stats.reads > 0) {
+        DebugMessage(M64MSG_INFO, "GB camera prefetch: %llu frames grabbed in %llu us, %llu frames read, %llu reads waited %llu us",
+            (unsigned long long)stats.grabs,
+            (unsigned long long)stats.grab_us,
+            (unsigned long long)stats.reads,
+            (unsigned long long)stats.waits,
+            (unsigned long long)stats.wait_us);
+    }
+}
+
 /*********************************************************************************************************
 * helper functions
 */
@@ -294,7 +320,7 @@ void main_message(m64p_msg_level level, unsigned int corner, const char *format,
     va_end(ap);
 
     /* send message to on-screen-display if enabled */
-    if (ConfigGetParamBool(g_CoreConfig, "OnScreenDisplay"))
+    if (ConfigGetCachedParamBool(l_OnScreenDisplay))
         osd_new_message((enum osd_corner) corner, "%s", buffer);
     /* send message to front-end */
     DebugMessage(level, "%s", buffer);
@@ -353,6 +379,10 @@ int main_set_core_defaults(void)
     ConfigSetDefaultInt(g_CoreConfig, "CurrentStateSlot", 0, "Save state slot (0-9) to use when saving/loading the emulator state");
     ConfigSetDefaultBool(g_CoreConfig, "EnableDebugger", 0, "Activate the R4300 debugger when ROM execution begins, if core was built with Debugger support");
     ConfigSetDefaultString(g_CoreConfig, "ScreenshotPath", "", "Path to directory where screenshots are saved. If this is blank, the default value of ${UserDataPath}/screenshot will be used");
+    ConfigSetDefaultInt(g_CoreConfig, "ScreenshotCompression", -1, "PNG compression level of screenshots and frame dumps, from 0 (fastest) to 9 (smallest), -1 for the libpng default");
+    ConfigSetDefaultInt(g_CoreConfig, "ScreenshotQueueSize", 4, "Number of captured frames which can wait to be written by a background thread, captures wait when it is full (0: write on the emulation thread)");
+    ConfigSetDefaultBool(g_CoreConfig, "DumpFrames", 0, "Save every rendered frame to the screenshot directory");
+    ConfigSetDefaultInt(g_CoreConfig, "FrameDumpFormat", 1, "Image format of dumped frames (0: PNG, 1: QOI, faster to write)");
     ConfigSetDefaultString(g_CoreConfig, "SaveStatePath", "", "Path to directory where emulator save states (snapshots) are saved. If this is blank, the default value of ${UserDataPath}/save will be used");
     ConfigSetDefaultString(g_CoreConfig, "SaveSRAMPath", "", "Path to directory where SRAM/EEPROM data (in-game saves) are stored. If this is blank, the default value of ${UserDataPath}/save will be used");
     ConfigSetDefaultString(g_CoreConfig, "SharedDataPath", "", "Path to a directory to search when looking for shared data files");
@@ -361,8 +391,15 @@ int main_set_core_defaults(void)
     ConfigSetDefaultInt(g_CoreConfig, "CountPerScanlineOverride", 0, "Count per scanline override, 0 for game default");
     ConfigSetDefaultBool(g_CoreConfig, "RandomizeInterrupt", 1, "Randomize PI/SI Interrupt Timing");
     ConfigSetDefaultInt(g_CoreConfig, "SiDmaDuration", -1, "Duration of SI DMA (-1: use per game settings)");
+    ConfigSetDefaultBool(g_CoreConfig, "ThreadedRsp", 0, "Run graphics tasks on a separate thread while the R4300 keeps running. Requires RSP and video plugins which can be called from another thread");
+    ConfigSetDefaultInt(g_CoreConfig, "ThreadedRspLatency", 100000, "Count cycles after which a threaded graphics task is reported complete to the game");
+    ConfigSetDefaultBool(g_CoreConfig, "ThreadedRspAudio", 0, "Run audio tasks on a separate thread while the R4300 keeps running. Requires an RSP plugin which can be called from another thread");
+    ConfigSetDefaultInt(g_CoreConfig, "ThreadedRspAudioLatency", 4000, "Count cycles after which a threaded audio task is reported complete to the game (4000 matches the delay of a synchronous audio task)");
     ConfigSetDefaultString(g_CoreConfig, "GbCameraVideoCaptureBackend1", DEFAULT_VIDEO_CAPTURE_BACKEND, "Gameboy Camera Video Capture backend");
+    ConfigSetDefaultBool(g_CoreConfig, "GbCameraPrefetch", 1, "Grab Gameboy Camera frames ahead of time on a separate thread");
+    ConfigSetDefaultInt(g_CoreConfig, "GbCameraRefreshInterval", 0, "Milliseconds after which an unread prefetched Gameboy Camera frame is replaced by a newer one (0: every frame is read once, which keeps captures reproducible)");
     ConfigSetDefaultInt(g_CoreConfig, "SaveDiskFormat", 1, "Disk Save Format (0: Full Disk Copy (*.ndr/*.d6r), 1: RAM Area Only (*.ram))");
+    ConfigSetDefaultInt(g_CoreConfig, "SaveFlushInterval", 0, "Milliseconds after which changed EEPROM, SRAM, FlashRAM, mempak and 64DD disk data is written to disk by a background thread (0: write synchronously on every change)");
 
     /* handle upgrades */
     if (bUpgrade)
@@ -375,6 +412,9 @@ int main_set_core_defaults(void)
         }
     }
 
+    /* the handle follows the parameter even if the section is deleted and created again */
+    ConfigGetParamHandle(g_CoreConfig, "OnScreenDisplay", &l_OnScreenDisplay);
+
     /* set config parameters for keyboard and joystick commands */
     return event_set_core_defaults();
 }
@@ -816,7 +856,7 @@ m64p_error main_reset(int do_hard_reset)
 
 static void video_plugin_render_callback(int bScreenRedrawn)
 {
-    int bOSD = ConfigGetParamBool(g_CoreConfig, "OnScreenDisplay");
+    int bOSD = ConfigGetCachedParamBool(l_OnScreenDisplay);
 
     // if the flag is set to take a screenshot, then grab it now
     if (l_TakeScreenshot != 0)
@@ -830,6 +870,12 @@ static void video_plugin_render_callback(int bScreenRedrawn)
         }
     }
 
+    // same for frame dumps, which are written in the background
+    if (!bOSD || bScreenRedrawn)
+    {
+        DumpFrame(l_CurrentFrame);
+    }
+
     // if the OSD is enabled, then draw it now
     if (bOSD)
     {
@@ -1057,6 +1103,30 @@ static void open_sra_file(struct file_storage* fstorage)
     }
 }
 
+/* Stop writing save files behind. Any unsaved change is written right away. */
+static void release_save_writer(struct storage_writer* writer, struct async_file_storage* storages, size_t count)
+{
+    struct storage_writer_stats stats;
+    size_t i;
+
+    if (writer == NULL)
+        return;
+
+    for (i = 0; i < count; ++i) {
+        close_async_file_storage(&storages[i]);
+    }
+
+    release_storage_writer(writer, &stats);
+
+    if (stats.saves > 0) {
+        DebugMessage(M64MSG_INFO, "Save writer: %llu saves, %llu flushes, %llu bytes written, %llu us writing",
+            (unsigned long long)stats.saves,
+            (unsigned long long)stats.flushes,
+            (unsigned long long)stats.bytes_written,
+            (unsigned long long)stats.write_us);
+    }
+}
+
 static void open_eep_file(struct file_storage* fstorage)
 {
     /* Note: EEP files are all EEPROM_MAX_SIZE bytes long,
@@ -1188,13 +1258,17 @@ static int load_dd_disk(struct dd_disk* dd_disk, const struct storage_backend_in
     }
 
     /* Try loading *.{nd,d6}r file first (if SaveDiskFormat == 0) */
+    int save_file_mapped = 0;
     if (save_format == 0)
     {
-        if (open_rom_file_storage(fstorage, save_filename) != file_ok) {
+        if (open_mapped_rom_file_storage(fstorage, save_filename) == file_ok) {
+            save_file_mapped = (fstorage->mapped_size != 0);
+        }
+        else {
             DebugMessage(M64MSG_WARNING, "Failed to load DD Disk save: %s.", save_filename);
 
             /* Try loading regular disk file */
-            if (open_rom_file_storage(fstorage, dd_disk_filename) != file_ok) {
+            if (open_mapped_rom_file_storage(fstorage, dd_disk_filename) != file_ok) {
                 DebugMessage(M64MSG_ERROR, "Failed to load DD Disk: %s.", dd_disk_filename);
                 goto free_fstorage;
             }
@@ -1203,7 +1277,7 @@ static int load_dd_disk(struct dd_disk* dd_disk, const struct storage_backend_in
     else
     {
         /* Try loading regular disk file */
-        if (open_rom_file_storage(fstorage, dd_disk_filename) != file_ok) {
+        if (open_mapped_rom_file_storage(fstorage, dd_disk_filename) != file_ok) {
             DebugMessage(M64MSG_ERROR, "Failed to load DD Disk: %s.", dd_disk_filename);
             goto free_fstorage;
         }
@@ -1223,13 +1297,24 @@ static int load_dd_disk(struct dd_disk* dd_disk, const struct storage_backend_in
     size_t offset_id = 0;
     size_t offset_ram = 0;
     size_t size_ram = 0;
-    uint8_t* new_data = scan_and_expand_disk_format(fstorage->data, fstorage->size, &format, &development, &offset_sys, &offset_id, &offset_ram, &size_ram);
+    size_t disk_size = fstorage->size;
+    uint8_t* new_data = scan_and_expand_disk_format(fstorage->data, &disk_size, &format, &development, &offset_sys, &offset_id, &offset_ram, &size_ram);
     if (new_data == NULL) {
         DebugMessage(M64MSG_ERROR, "Wrong disk format");
         goto wrong_disk_format;
     }
-    else {
+    else if (new_data != fstorage->data) {
+        /* expanded disk replaces the loaded file content */
+        if (fstorage->mapped_size != 0) {
+            osal_file_unmap(fstorage->data, fstorage->mapped_size);
+            fstorage->mapped_size = 0;
+        }
+        else {
+            free(fstorage->data);
+        }
         fstorage->data = new_data;
+        fstorage->size = disk_size;
+        save_file_mapped = 0;
     }
 
     /* Load RAM save data (if SaveDiskFormat == 1) */
@@ -1248,7 +1333,10 @@ static int load_dd_disk(struct dd_disk* dd_disk, const struct storage_backend_in
         fstorage_save->filename = save_filename;
         fstorage_save->data = fstorage->data;
         fstorage_save->size = fstorage->size;
-        fstorage_save->first_access = 1;
+        /* Rewriting the whole save file would truncate it under its own mapping,
+         * and it already holds the content anyway */
+        fstorage_save->first_access = !save_file_mapped;
+        fstorage_save->mapped_size = 0;
         break;
     case 1: /* RAM only */
         *dd_idisk = &g_istorage_disk_ram_only;
@@ -1256,6 +1344,7 @@ static int load_dd_disk(struct dd_disk* dd_disk, const struct storage_backend_in
         fstorage_save->data = &fstorage->data[offset_ram];
         fstorage_save->size = size_ram;
         fstorage_save->first_access = 1;
+        fstorage_save->mapped_size = 0;
         break;
     default: /* read only */
         *dd_idisk = &g_istorage_disk_read_only;
@@ -1275,8 +1364,24 @@ static int load_dd_disk(struct dd_disk* dd_disk, const struct storage_backend_in
     dd_disk->offset_id = offset_id;
     dd_disk->offset_ram = offset_ram;
 
-    /* Generate LBA conversion table */
+    /* Generate LBA conversion tables */
     GenerateLBAToPhysTable(dd_disk);
+    GenerateLBAExtentTable(dd_disk);
+
+    /* write changed LBAs behind on a separate thread,
+     * netplay requires all clients to save synchronously */
+    int save_flush_interval = ConfigGetParamInt(g_CoreConfig, "SaveFlushInterval");
+    if (fstorage_save != NULL && save_flush_interval > 0 && !netplay_is_init()) {
+        struct async_disk_storage* astorage = malloc(sizeof(*astorage));
+        if (astorage != NULL && open_async_disk_storage(astorage, fstorage_save, dd_disk, save_flush_interval) == 0) {
+            dd_disk->save_storage = astorage;
+            dd_disk->isave_storage = &g_iasync_disk_storage;
+        }
+        else {
+            DebugMessage(M64MSG_WARNING, "Couldn't start DD disk writer, writing disk saves synchronously");
+            free(astorage);
+        }
+    }
 
     DebugMessage(M64MSG_INFO, "DD Disk: %s - %zu - %s",
             dd_disk_filename,
@@ -1320,6 +1425,27 @@ no_disk:
 
 static void close_dd_disk(struct dd_disk* disk)
 {
+    if (disk->isave_storage == &g_iasync_disk_storage) {
+        struct async_disk_storage* astorage = (struct async_disk_storage*)disk->save_storage;
+        struct async_disk_storage_stats stats;
+
+        /* unsaved changes are written before the disk content is freed */
+        close_async_disk_storage(astorage, &stats);
+
+        if (stats.saves > 0) {
+            DebugMessage(M64MSG_INFO, "DD disk writer: %llu saves, %llu flushes, %llu LBAs written, %llu bytes written, %llu us writing",
+                (unsigned long long)stats.saves,
+                (unsigned long long)stats.flushes,
+                (unsigned long long)stats.lbas_written,
+                (unsigned long long)stats.bytes_written,
+                (unsigned long long)stats.write_us);
+        }
+
+        disk->save_storage = astorage->fstorage;
+        disk->isave_storage = &g_ifile_storage;
+        free(astorage);
+    }
+
     if (disk->save_storage != NULL) {
         /* no need to close save_storage as it is a child of disk->storage */
         free(disk->save_storage);
@@ -1487,11 +1613,27 @@ m64p_error main_run(void)
     int32_t si_dma_duration;
     int32_t no_compiled_jump;
     int32_t randomize_interrupt;
+    void* rsp_task_runner = NULL;
+    const struct task_runner_backend_interface* irsp_task_runner = NULL;
+    uint32_t rsp_threaded_gfx;
+    uint32_t rsp_threaded_audio;
+    uint32_t rsp_gfx_task_latency;
+    uint32_t rsp_audio_task_latency;
     struct file_storage eep;
     struct file_storage fla;
     struct file_storage sra;
+    int32_t save_flush_interval;
+    struct storage_writer* save_writer = NULL;
+    struct async_file_storage async_saves[4]; /* eep, fla, sra, mpk */
+    void* eep_storage = &eep;
+    void* fla_storage = &fla;
+    void* sra_storage = &sra;
+    void* mpk_storage;
+    const struct storage_backend_interface* isave_storage = &g_ifile_storage;
+    const struct storage_backend_interface* isave_substorage = &g_isubfile_storage;
     size_t dd_rom_size;
     struct dd_disk dd_disk;
+    struct screenshot_encoder_stats screenshot_stats;
 
     int control_ids[GAME_CONTROLLERS_COUNT];
     struct controller_input_compat cin_compats[GAME_CONTROLLERS_COUNT];
@@ -1501,6 +1643,10 @@ m64p_error main_run(void)
 
     void* gbcam_backend;
     const struct video_capture_backend_interface* igbcam_backend;
+    struct prefetch_video_capture* gbcam_prefetch = NULL;
+    int32_t gbcam_refresh_interval;
+    void* gbcam_capture;
+    const struct video_capture_backend_interface* igbcam_capture;
 
     /* XXX: select type of flashram from db */
     uint32_t flashram_type = MX29L1100_ID;
@@ -1533,6 +1679,10 @@ m64p_error main_run(void)
     force_alignment_pi_dma = ConfigGetParamInt(g_CoreConfig, "ForceAlignmentOfPiDma");
     count_per_scanline_override = ConfigGetParamInt(g_CoreConfig, "CountPerScanlineOverride");
     tlb_hack = ConfigGetParamInt(g_CoreConfig, "TlbHack");
+    rsp_threaded_gfx = ConfigGetParamBool(g_CoreConfig, "ThreadedRsp");
+    rsp_threaded_audio = ConfigGetParamBool(g_CoreConfig, "ThreadedRspAudio");
+    rsp_gfx_task_latency = ConfigGetParamInt(g_CoreConfig, "ThreadedRspLatency");
+    rsp_audio_task_latency = ConfigGetParamInt(g_CoreConfig, "ThreadedRspAudioLatency");
 
     if (ROM_SETTINGS.disableextramem)
         disable_extra_mem = ROM_SETTINGS.disableextramem;
@@ -1612,8 +1762,19 @@ m64p_error main_run(void)
     init_video_capture_backend(&igbcam_backend, &gbcam_backend,
         g_CoreConfig, "GbCameraVideoCaptureBackend1");
 
+    /* grab GB cam frames ahead on a separate thread */
+    gbcam_capture = gbcam_backend;
+    igbcam_capture = igbcam_backend;
+    gbcam_refresh_interval = ConfigGetParamInt(g_CoreConfig, "GbCameraRefreshInterval");
+    if (ConfigGetParamBool(g_CoreConfig, "GbCameraPrefetch")
+     && init_prefetch_video_capture(&gbcam_prefetch, gbcam_backend, igbcam_backend,
+            (gbcam_refresh_interval > 0) ? (unsigned int)gbcam_refresh_interval : 0) == M64ERR_SUCCESS) {
+        gbcam_capture = gbcam_prefetch;
+        igbcam_capture = &g_iprefetch_video_capture;
+    }
+
     /* open GB cam video device */
-    igbcam_backend->open(gbcam_backend, M64282FP_SENSOR_W, M64282FP_SENSOR_H);
+    igbcam_capture->open(gbcam_capture, M64282FP_SENSOR_W, M64282FP_SENSOR_H);
 
     /* open storage files, provide default content if not present */
     open_mpk_file(&mpk);
@@ -1621,6 +1782,31 @@ m64p_error main_run(void)
     open_fla_file(&fla);
     open_sra_file(&sra);
 
+    /* write save files behind on a separate thread,
+     * netplay requires all clients to save synchronously */
+    save_flush_interval = ConfigGetParamInt(g_CoreConfig, "SaveFlushInterval");
+    memset(async_saves, 0, sizeof(async_saves));
+    mpk_storage = &mpk;
+    if (save_flush_interval > 0 && !netplay_is_init()) {
+        if (init_storage_writer(&save_writer, save_flush_interval) == M64ERR_SUCCESS
+         && open_async_file_storage(&async_saves[0], &eep, save_writer) == 0
+         && open_async_file_storage(&async_saves[1], &fla, save_writer) == 0
+         && open_async_file_storage(&async_saves[2], &sra, save_writer) == 0
+         && open_async_file_storage(&async_saves[3], &mpk, save_writer) == 0) {
+            eep_storage = &async_saves[0];
+            fla_storage = &async_saves[1];
+            sra_storage = &async_saves[2];
+            mpk_storage = &async_saves[3];
+            isave_storage = &g_iasync_file_storage;
+            isave_substorage = &g_iasync_subfile_storage;
+            DebugMessage(M64MSG_INFO, "Writing save files every %d ms on a separate thread", save_flush_interval);
+        } else {
+            DebugMessage(M64MSG_WARNING, "Couldn't start save writer, writing save files synchronously");
+            release_save_writer(save_writer, async_saves, 4);
+            save_writer = NULL;
+        }
+    }
+
     /* Load 64DD IPL ROM and Disk */
     const struct clock_backend_interface* dd_rtc_iclock = NULL;
     const struct storage_backend_interface* dd_idisk = NULL;
@@ -1701,8 +1887,8 @@ m64p_error main_run(void)
 
             l_gb_carts_data[i].control_id = (int)i;
 
-            l_gb_carts_data[i].gbcam_backend = gbcam_backend;
-            l_gb_carts_data[i].igbcam_backend = igbcam_backend;
+            l_gb_carts_data[i].gbcam_backend = gbcam_capture;
+            l_gb_carts_data[i].igbcam_backend = igbcam_capture;
 
             l_paks_idx[i] = 0;
 
@@ -1726,9 +1912,9 @@ m64p_error main_run(void)
                 else if (l_ipaks[k] == &g_imempak) {
                     mpk_storages[i].data = mpk.data + i * MEMPAK_SIZE;
                     mpk_storages[i].size = MEMPAK_SIZE;
-                    mpk_storages[i].filename = (void*)&mpk; /* OK for isubfile_storage */
+                    mpk_storages[i].filename = mpk_storage; /* OK for isubfile_storage */
 
-                    init_mempak(&g_dev.mempaks[i], &mpk_storages[i], &g_isubfile_storage);
+                    init_mempak(&g_dev.mempaks[i], &mpk_storages[i], isave_substorage);
                     l_paks[i][k] = &g_dev.mempaks[i];
 
                     if (Controls[i].Plugin == PLUGIN_MEMPAK) {
@@ -1799,6 +1985,19 @@ m64p_error main_run(void)
         ijoybus_devices[i] = &g_ijoybus_device_cart;
     }
 
+    /* netplay requires all clients to run tasks the same way, so keep them synchronous */
+    if ((rsp_threaded_gfx || rsp_threaded_audio) && !netplay_is_init()) {
+        if (g_ithread_task_runner.init(&rsp_task_runner) == M64ERR_SUCCESS) {
+            irsp_task_runner = &g_ithread_task_runner;
+            DebugMessage(M64MSG_INFO, "Running%s%s%s tasks on a separate thread",
+                rsp_threaded_gfx ? " graphics" : "",
+                (rsp_threaded_gfx && rsp_threaded_audio) ? " and" : "",
+                rsp_threaded_audio ? " audio" : "");
+        } else {
+            DebugMessage(M64MSG_WARNING, "Couldn't start RSP task thread, running all tasks synchronously");
+        }
+    }
+
     init_device(&g_dev,
                 g_mem_base,
                 emumode,
@@ -1809,6 +2008,8 @@ m64p_error main_run(void)
                 g_start_address,
                 force_alignment_pi_dma,
                 tlb_hack,
+                rsp_task_runner, irsp_task_runner, rsp_threaded_gfx, rsp_threaded_audio,
+                rsp_gfx_task_latency, rsp_audio_task_latency,
                 &g_dev.ai, &g_iaudio_out_backend_plugin_compat, ((float)ROM_SETTINGS.aidmamodifier / 100.0),
                 si_dma_duration,
                 rdram_size,
@@ -1819,10 +2020,10 @@ m64p_error main_run(void)
                 NULL, &g_iclock_ctime_plus_delta,
                 g_rom_size,
                 eeprom_type,
-                &eep, &g_ifile_storage,
+                eep_storage, isave_storage,
                 flashram_type,
-                &fla, &g_ifile_storage,
-                &sra, &g_ifile_storage,
+                fla_storage, isave_storage,
+                sra_storage, isave_storage,
                 NULL, dd_rtc_iclock,
                 dd_rom_size,
                 &dd_disk, dd_idisk);
@@ -1879,6 +2080,46 @@ m64p_error main_run(void)
     else
         DebugMessage(M64MSG_STATUS, "Exit requested");
 
+    /* the r4300 may have stopped while a task was in flight */
+    rsp_wait_task(&g_dev.sp);
+    if (g_dev.sp.gfx_task_stats.tasks > 0) {
+        DebugMessage(M64MSG_INFO, "Threaded RSP: %llu graphics tasks, %llu count cycles overlapped, %llu forced syncs, %llu us stalled",
+            (unsigned long long)g_dev.sp.gfx_task_stats.tasks,
+            (unsigned long long)g_dev.sp.gfx_task_stats.overlap_cycles,
+            (unsigned long long)g_dev.sp.gfx_task_stats.forced_syncs,
+            (unsigned long long)g_dev.sp.gfx_task_stats.stall_us);
+    }
+    if (g_dev.sp.audio_task_stats.tasks > 0) {
+        DebugMessage(M64MSG_INFO, "Threaded RSP: %llu audio tasks, %llu count cycles overlapped, %llu forced syncs, %llu us stalled",
+            (unsigned long long)g_dev.sp.audio_task_stats.tasks,
+            (unsigned long long)g_dev.sp.audio_task_stats.overlap_cycles,
+            (unsigned long long)g_dev.sp.audio_task_stats.forced_syncs,
+            (unsigned long long)g_dev.sp.audio_task_stats.stall_us);
+    }
+    ScreenshotStop(&screenshot_stats);
+    if (screenshot_stats.frames > 0) {
+        DebugMessage(M64MSG_INFO, "Screenshots: %llu frames, %llu bytes written in %llu us, %llu captures waited %llu us for the encoder (%u queued at most)",
+            (unsigned long long)screenshot_stats.frames,
+            (unsigned long long)screenshot_stats.bytes_written,
+            (unsigned long long)screenshot_stats.encode_us,
+            (unsigned long long)screenshot_stats.waits,
+            (unsigned long long)screenshot_stats.wait_us,
+            screenshot_stats.max_queued);
+    }
+    if (g_dev.r4300.cp0.tlb.stats.writes > 0) {
+        const struct tlb_stats* tlb_stats = &g_dev.r4300.cp0.tlb.stats;
+        int frames = (l_CurrentFrame > 0) ? l_CurrentFrame : 1;
+        DebugMessage(M64MSG_INFO, "TLB: %llu writes, %llu refills, %llu blocks invalidated (%.1f / %.1f / %.1f per frame), host cache %llu hits / %llu misses",
+            (unsigned long long)tlb_stats->writes,
+            (unsigned long long)tlb_stats->refills,
+            (unsigned long long)tlb_stats->invalidated_blocks,
+            (double)tlb_stats->writes / frames,
+            (double)tlb_stats->refills / frames,
+            (double)tlb_stats->invalidated_blocks / frames,
+            (unsigned long long)tlb_stats->host_cache_hits,
+            (unsigned long long)tlb_stats->host_cache_misses);
+    }
+
     /* now begin to shut down */
 #ifdef WITH_LIRC
     lircStop();
@@ -1896,9 +2137,11 @@ m64p_error main_run(void)
         }
     }
 
-    igbcam_backend->close(gbcam_backend);
+    igbcam_capture->close(gbcam_capture);
+    release_gbcam_prefetch(gbcam_prefetch);
     igbcam_backend->release(gbcam_backend);
 
+    release_save_writer(save_writer, async_saves, 4);
     close_file_storage(&sra);
     close_file_storage(&fla);
     close_file_storage(&eep);
@@ -1915,6 +2158,9 @@ m64p_error main_run(void)
     audio.romClosed();
     gfx.romClosed();
 
+    if (irsp_task_runner != NULL)
+        irsp_task_runner->release(rsp_task_runner);
+
     // clean up
     g_EmulatorRunning = 0;
     StateChanged(M64CORE_EMU_STATE, M64EMU_STOPPED);
@@ -1926,6 +2172,9 @@ on_input_open_failure:
 on_audio_open_failure:
     gfx.romClosed();
 on_gfx_open_failure:
+    if (irsp_task_runner != NULL)
+        irsp_task_runner->release(rsp_task_runner);
+
     /* release gb_carts */
     for(i = 0; i < GAME_CONTROLLERS_COUNT; ++i) {
         if (!Controls[i].RawData  && (Controls[i].Type == CONT_TYPE_STANDARD) && g_dev.gb_carts[i].read_gb_cart != NULL) {
@@ -1934,10 +2183,12 @@ on_gfx_open_failure:
         }
     }
 
-    igbcam_backend->close(gbcam_backend);
+    igbcam_capture->close(gbcam_capture);
+    release_gbcam_prefetch(gbcam_prefetch);
     igbcam_backend->release(gbcam_backend);
 
     /* release storage files */
+    release_save_writer(save_writer, async_saves, 4);
     close_file_storage(&sra);
     close_file_storage(&fla);
     close_file_storage(&eep);
@@ -0,0 +1,115 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - qoi.c                                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <string.h>
+
+#include "qoi.h"
+
+size_t qoi_encode_rgb(unsigned char *out, const unsigned char *buf, int width, int height, int pitch)
+{
+    /* RGBA, as a decoder's index starts with transparent black */
+    unsigned char index[64][4];
+    unsigned char prev[3] = { 0, 0, 0 };
+    size_t pos = 0;
+    int run = 0;
+    int x, y;
+
+    memset(index, 0, sizeof(index));
+
+    memcpy(out, "qoif", 4);
+    out[4] = (unsigned char) (width >> 24);
+    out[5] = (unsigned char) (width >> 16);
+    out[6] = (unsigned char) (width >> 8);
+    out[7] = (unsigned char) width;
+    out[8] = (unsigned char) (height >> 24);
+    out[9] = (unsigned char) (height >> 16);
+    out[10] = (unsigned char) (height >> 8);
+    out[11] = (unsigned char) height;
+    out[12] = 3;    // RGB
+    out[13] = 0;    // sRGB with linear alpha
+    pos = 14;
+
+    for (y = height - 1; y >= 0; y--)
+    {
+        const unsigned char *px = buf + y * pitch;
+        for (x = 0; x < width; x++, px += 3)
+        {
+            if (px[0] == prev[0] && px[1] == prev[1] && px[2] == prev[2])
+            {
+                if (++run == 62)
+                {
+                    out[pos++] = (unsigned char) (0xc0 | (run - 1));    // QOI_OP_RUN
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0)
+            {
+                out[pos++] = (unsigned char) (0xc0 | (run - 1));
+                run = 0;
+            }
+
+            // alpha is always 255
+            int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11) & 63;
+            if (index[hash][0] == px[0] && index[hash][1] == px[1] && index[hash][2] == px[2] && index[hash][3] == 255)
+            {
+                out[pos++] = (unsigned char) hash;                        // QOI_OP_INDEX
+            }
+            else
+            {
+                signed char vr = (signed char) (px[0] - prev[0]);
+                signed char vg = (signed char) (px[1] - prev[1]);
+                signed char vb = (signed char) (px[2] - prev[2]);
+                signed char vg_r = (signed char) (vr - vg);
+                signed char vg_b = (signed char) (vb - vg);
+
+                memcpy(index[hash], px, 3);
+                index[hash][3] = 255;
+                if (vr >= -2 && vr <= 1 && vg >= -2 && vg <= 1 && vb >= -2 && vb <= 1)
+                {
+                    out[pos++] = (unsigned char) (0x40 | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));  // QOI_OP_DIFF
+                }
+                else if (vg_r >= -8 && vg_r <= 7 && vg >= -32 && vg <= 31 && vg_b >= -8 && vg_b <= 7)
+                {
+                    out[pos++] = (unsigned char) (0x80 | (vg + 32));   // QOI_OP_LUMA
+                    out[pos++] = (unsigned char) (((vg_r + 8) << 4) | (vg_b + 8));
+                }
+                else
+                {
+                    out[pos++] = 0xfe;                                     // QOI_OP_RGB
+                    out[pos++] = px[0];
+                    out[pos++] = px[1];
+                    out[pos++] = px[2];
+                }
+            }
+            memcpy(prev, px, 3);
+        }
+    }
+
+    if (run > 0)
+        out[pos++] = (unsigned char) (0xc0 | (run - 1));
+
+    // end marker
+    memset(out + pos, 0, 7);
+    out[pos + 7] = 1;
+    return pos + 8;
+}
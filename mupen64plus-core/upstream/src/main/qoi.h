@@ -0,0 +1,36 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - qoi.h                                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_QOI_H
+#define M64P_MAIN_QOI_H
+
+#include <stddef.h>
+
+/* Worst case size of an encoded image: one QOI_OP_RGB per pixel, the header and the end marker */
+#define QOI_MAX_SIZE(width, height) ((size_t) (width) * (height) * 4 + 14 + 8)
+
+/* Encodes a bottom-up RGB buffer to the QOI format (https://qoiformat.org), which is several
+ * times faster to write than PNG for a somewhat larger file. out must hold QOI_MAX_SIZE bytes.
+ * Returns the encoded size.
+ */
+size_t qoi_encode_rgb(unsigned char *out, const unsigned char *buf, int width, int height, int pitch);
+
+#endif
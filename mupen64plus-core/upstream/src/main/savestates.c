@@ -437,6 +437,7 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
 
     COPYARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
     COPYARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    tlb_flush_host_cache(&dev->r4300.cp0.tlb);
 
     *r4300_llbit(&dev->r4300) = GETDATA(curr, uint32_t);
     COPYARRAY(r4300_regs(&dev->r4300), curr, int64_t, 32);
@@ -1183,6 +1184,7 @@ static int savestates_load_pj64(struct device* dev,
     // tlb
     memset(dev->r4300.cp0.tlb.LUT_r, 0, 0x400000);
     memset(dev->r4300.cp0.tlb.LUT_w, 0, 0x400000);
+    tlb_flush_host_cache(&dev->r4300.cp0.tlb);
     for (i=0; i < 32; i++)
     {
         unsigned int MyPageMask, MyEntryHi, MyEntryLo0, MyEntryLo1;
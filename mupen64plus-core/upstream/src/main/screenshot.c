@@ -23,10 +23,15 @@
 #include <ctype.h>
 #include <png.h>
 #include <setjmp.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(_MSC_VER)
+#include <pthread.h>
+#endif
+
 
 #define M64P_CORE_PROTOTYPES 1
 #include "api/callbacks.h"
@@ -37,13 +42,64 @@
 #include "main/util.h"
 #include "osal/files.h"
 #include "osal/preproc.h"
+#include "osal/thread_time.h"
 #include "osd/osd.h"
 #include "plugin/plugin.h"
+#include "qoi.h"
+#include "screenshot.h"
+
+#define FRAME_DUMP_FORMAT_PNG 0
+#define FRAME_DUMP_FORMAT_QOI 1
+
+/* A captured frame waiting to be encoded. Rows are stored bottom-up, as given by readScreen. */
+struct screenshot_job
+{
+    char *filename;
+    unsigned char *pixels;
+    size_t capacity;
+    int width;
+    int height;
+    int format;
+    int level;
+};
+
+#if !defined(_MSC_VER)
+
+/* Captured frames are encoded and written by a background thread. The emulation thread
+ * fills the free slot following the queued ones, and waits if all slots are queued.
+ */
+struct screenshot_encoder
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    /* the following fields are guarded by lock */
+    struct screenshot_job *jobs;
+    unsigned int size;
+    unsigned int head;          /* next job to encode */
+    unsigned int count;         /* queued jobs, including the one being encoded */
+    int quit;
+    struct screenshot_encoder_stats stats;
+};
+
+#else
+
+/* No encoder thread available: screenshots are written on the emulation thread */
+struct screenshot_encoder;
+
+#endif
 
 /*********************************************************************************************************
 * PNG support functions for writing screenshot files
 */
 
+struct png_output
+{
+    FILE *file;
+    size_t bytes;
+};
+
 static void mupen_png_error(png_structp png_write, const char *message)
 {
     DebugMessage(M64MSG_ERROR, "PNG Error: %s", message);
@@ -56,24 +112,27 @@ static void mupen_png_warn(png_structp png_write, const char *message)
 
 static void user_write_data(png_structp png_write, png_bytep data, png_size_t length)
 {
-    FILE *fPtr = (FILE *) png_get_io_ptr(png_write);
-    if (fwrite(data, 1, length, fPtr) != length)
+    struct png_output *output = (struct png_output *) png_get_io_ptr(png_write);
+    if (fwrite(data, 1, length, output->file) != length)
         DebugMessage(M64MSG_ERROR, "Failed to write %zi bytes to screenshot file.", length);
+    output->bytes += length;
 }
 
 static void user_flush_data(png_structp png_write)
 {
-    FILE *fPtr = (FILE *) png_get_io_ptr(png_write);
-    fflush(fPtr);
+    struct png_output *output = (struct png_output *) png_get_io_ptr(png_write);
+    fflush(output->file);
 }
 
 /*********************************************************************************************************
 * Other Local (static) functions
 */
 
-static int SaveRGBBufferToFile(const char *filename, const unsigned char *buf, int width, int height, int pitch)
+/* level is the zlib compression level, or -1 for the libpng default */
+static int SaveRGBBufferToFile(const char *filename, const unsigned char *buf, int width, int height, int pitch, int level, size_t *bytes)
 {
     int i;
+    struct png_output output;
 
     // allocate PNG structures
     png_structp png_write = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, mupen_png_error, mupen_png_warn);
@@ -103,8 +162,12 @@ static int SaveRGBBufferToFile(const char *filename, const unsigned char *buf, i
         DebugMessage(M64MSG_ERROR, "Error opening '%s' to save screenshot.", filename);
         return 4;
     }
+    output.file = savefile;
+    output.bytes = 0;
     // set function pointers in the PNG library, for write callbacks
-    png_set_write_fn(png_write, (png_voidp) savefile, user_write_data, user_flush_data);
+    png_set_write_fn(png_write, (png_voidp) &output, user_write_data, user_flush_data);
+    if (level >= 0)
+        png_set_compression_level(png_write, level);
     // set the info
     png_set_IHDR(png_write, png_info, width, height, 8, PNG_COLOR_TYPE_RGB,
                  PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
@@ -124,16 +187,59 @@ static int SaveRGBBufferToFile(const char *filename, const unsigned char *buf, i
     png_destroy_write_struct(&png_write, &png_info);
     // close file
     fclose(savefile);
+    *bytes = output.bytes;
     // all done
     return 0;
 }
 
+static int SaveRGBBufferToQOIFile(const char *filename, const unsigned char *buf, int width, int height, int pitch, size_t *bytes)
+{
+    unsigned char *encoded = (unsigned char *) malloc(QOI_MAX_SIZE(width, height));
+    if (encoded == NULL)
+        return 1;
+
+    size_t size = qoi_encode_rgb(encoded, buf, width, height, pitch);
+
+    FILE *savefile = osal_file_open(filename, "wb");
+    if (savefile == NULL)
+    {
+        DebugMessage(M64MSG_ERROR, "Error opening '%s' to save screenshot.", filename);
+        free(encoded);
+        return 4;
+    }
+    if (fwrite(encoded, 1, size, savefile) != size)
+        DebugMessage(M64MSG_ERROR, "Failed to write %zi bytes to screenshot file.", size);
+    fclose(savefile);
+    free(encoded);
+
+    *bytes = size;
+    return 0;
+}
+
+static size_t EncodeJob(const struct screenshot_job *job)
+{
+    size_t bytes = 0;
+
+    if (job->format == FRAME_DUMP_FORMAT_QOI)
+        SaveRGBBufferToQOIFile(job->filename, job->pixels, job->width, job->height, job->width * 3, &bytes);
+    else
+        SaveRGBBufferToFile(job->filename, job->pixels, job->width, job->height, job->width * 3, job->level, &bytes);
+
+    return bytes;
+}
+
 static int CurrentShotIndex;
+static char *DumpBasePath;
+static struct screenshot_encoder *Encoder;
+static m64p_handle DumpFramesParam;
+static m64p_handle FrameDumpFormatParam;
+static m64p_handle CompressionParam;
 
-static char *GetNextScreenshotPath(void)
+/* Returns the path of the screenshot directory followed by the ROM name and suffix */
+static char *GetScreenshotPath(const char *suffix)
 {
     char *ScreenshotPath;
-    char ScreenshotFileName[60 + 8 + 1];
+    char ScreenshotFileName[60 + 16 + 1];
     char *pch;
 
     // if there are any characters in the ROM header name with the highest bit set,
@@ -163,7 +269,7 @@ static char *GetNextScreenshotPath(void)
         }
     }
 
-    strcat(ScreenshotFileName, "-###.png");
+    strcat(ScreenshotFileName, suffix);
     
     // add the base path to the screenshot file name
     const char *SshotDir = ConfigGetParamString(g_CoreConfig, "ScreenshotPath");
@@ -184,6 +290,15 @@ static char *GetNextScreenshotPath(void)
             return NULL;
     }
 
+    return ScreenshotPath;
+}
+
+static char *GetNextScreenshotPath(void)
+{
+    char *ScreenshotPath = GetScreenshotPath("-###.png");
+    if (ScreenshotPath == NULL)
+        return NULL;
+
     // patch the number part of the name (the '###' part) until we find a free spot
     char *NumberPtr = ScreenshotPath + strlen(ScreenshotPath) - 7;
     for (; CurrentShotIndex < 1000; CurrentShotIndex++)
@@ -206,46 +321,301 @@ static char *GetNextScreenshotPath(void)
     return ScreenshotPath;
 }
 
-/*********************************************************************************************************
-* Global screenshot functions
-*/
+#if !defined(_MSC_VER)
 
-void ScreenshotRomOpen(void)
+static void *EncoderThread(void *data)
 {
-    CurrentShotIndex = 0;
+    struct screenshot_encoder *encoder = (struct screenshot_encoder *) data;
+
+    pthread_mutex_lock(&encoder->lock);
+    for (;;)
+    {
+        if (encoder->count == 0)
+        {
+            if (encoder->quit)
+                break;
+            pthread_cond_wait(&encoder->cond, &encoder->lock);
+            continue;
+        }
+
+        // the emulation thread doesn't touch queued jobs
+        struct screenshot_job *job = &encoder->jobs[encoder->head];
+        pthread_mutex_unlock(&encoder->lock);
+
+        uint64_t encode_start = osal_time_us();
+        size_t bytes = EncodeJob(job);
+        uint64_t encode_time = osal_time_us() - encode_start;
+        free(job->filename);
+        job->filename = NULL;
+
+        pthread_mutex_lock(&encoder->lock);
+        encoder->head = (encoder->head + 1) % encoder->size;
+        encoder->count--;
+        encoder->stats.frames++;
+        encoder->stats.bytes_written += bytes;
+        encoder->stats.encode_us += encode_time;
+        pthread_cond_broadcast(&encoder->cond);
+    }
+    pthread_mutex_unlock(&encoder->lock);
+
+    return NULL;
 }
 
-void TakeScreenshot(int iFrameNumber)
+static void FreeEncoder(struct screenshot_encoder *encoder)
 {
-    char *filename;
+    unsigned int i;
 
-    // look for an unused screenshot filename
-    filename = GetNextScreenshotPath();
-    if (filename == NULL)
-        return;
+    for (i = 0; i < encoder->size; i++)
+    {
+        free(encoder->jobs[i].filename);
+        free(encoder->jobs[i].pixels);
+    }
+    free(encoder->jobs);
+    free(encoder);
+}
+
+/* Returns NULL if screenshots are to be written on the emulation thread */
+static struct screenshot_encoder *GetEncoder(void)
+{
+    struct screenshot_encoder *encoder;
+    int size;
+
+    if (Encoder != NULL)
+        return Encoder;
+
+    size = ConfigGetParamInt(g_CoreConfig, "ScreenshotQueueSize");
+    if (size <= 0)
+        return NULL;
+
+    encoder = (struct screenshot_encoder *) calloc(1, sizeof(*encoder));
+    if (encoder == NULL)
+        return NULL;
+
+    encoder->size = (unsigned int) size;
+    encoder->jobs = (struct screenshot_job *) calloc(encoder->size, sizeof(struct screenshot_job));
+    if (encoder->jobs == NULL)
+    {
+        free(encoder);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&encoder->lock, NULL) != 0)
+    {
+        FreeEncoder(encoder);
+        return NULL;
+    }
+
+    if (pthread_cond_init(&encoder->cond, NULL) != 0)
+    {
+        pthread_mutex_destroy(&encoder->lock);
+        FreeEncoder(encoder);
+        return NULL;
+    }
+
+    if (pthread_create(&encoder->thread, NULL, EncoderThread, encoder) != 0)
+    {
+        DebugMessage(M64MSG_WARNING, "Could not create screenshot encoder thread, screenshots will be written synchronously");
+        pthread_cond_destroy(&encoder->cond);
+        pthread_mutex_destroy(&encoder->lock);
+        FreeEncoder(encoder);
+        return NULL;
+    }
+
+    Encoder = encoder;
+    return encoder;
+}
+
+/* Returns the slot for the next capture, waiting for the encoder if all of them are queued.
+ * Captures are delayed rather than dropped.
+ */
+static struct screenshot_job *BeginCapture(struct screenshot_encoder *encoder)
+{
+    struct screenshot_job *job;
+
+    pthread_mutex_lock(&encoder->lock);
+    if (encoder->count == encoder->size)
+    {
+        uint64_t wait_start = osal_time_us();
+        while (encoder->count == encoder->size)
+            pthread_cond_wait(&encoder->cond, &encoder->lock);
+        encoder->stats.waits++;
+        encoder->stats.wait_us += osal_time_us() - wait_start;
+    }
+    job = &encoder->jobs[(encoder->head + encoder->count) % encoder->size];
+    pthread_mutex_unlock(&encoder->lock);
+
+    return job;
+}
+
+static void QueueCapture(struct screenshot_encoder *encoder)
+{
+    pthread_mutex_lock(&encoder->lock);
+    encoder->count++;
+    if (encoder->count > encoder->stats.max_queued)
+        encoder->stats.max_queued = encoder->count;
+    pthread_cond_broadcast(&encoder->cond);
+    pthread_mutex_unlock(&encoder->lock);
+}
+
+static void StopEncoder(struct screenshot_encoder *encoder, struct screenshot_encoder_stats *stats)
+{
+    // the thread writes all queued frames before leaving
+    pthread_mutex_lock(&encoder->lock);
+    encoder->quit = 1;
+    pthread_cond_broadcast(&encoder->cond);
+    pthread_mutex_unlock(&encoder->lock);
+
+    pthread_join(encoder->thread, NULL);
+
+    *stats = encoder->stats;
+    pthread_cond_destroy(&encoder->cond);
+    pthread_mutex_destroy(&encoder->lock);
+    FreeEncoder(encoder);
+}
+
+#else
+
+static struct screenshot_encoder *GetEncoder(void)
+{
+    return NULL;
+}
+
+static struct screenshot_job *BeginCapture(struct screenshot_encoder *encoder)
+{
+    return NULL;
+}
+
+static void QueueCapture(struct screenshot_encoder *encoder)
+{
+}
+
+static void StopEncoder(struct screenshot_encoder *encoder, struct screenshot_encoder_stats *stats)
+{
+}
+
+#endif
+
+/* Reads the current frame and writes it, or queues it when the encoder thread is running.
+ * Takes ownership of filename.
+ */
+static void CaptureFrame(char *filename, int format)
+{
+    struct screenshot_encoder *encoder = GetEncoder();
+    struct screenshot_job local_job;
+    struct screenshot_job *job;
 
     // get the width and height
     int width = 640;
     int height = 480;
     gfx.readScreen(NULL, &width, &height, 0);
+    size_t size = (size_t) width * height * 3;
 
-    // allocate memory for the image
-    unsigned char *pucFrame = (unsigned char *) malloc(width * height * 3);
-    if (pucFrame == NULL)
+    if (encoder != NULL)
+    {
+        job = BeginCapture(encoder);
+    }
+    else
+    {
+        memset(&local_job, 0, sizeof(local_job));
+        job = &local_job;
+    }
+
+    // allocate memory for the image, queue slots keep theirs
+    if (job->capacity < size)
+    {
+        free(job->pixels);
+        job->pixels = (unsigned char *) malloc(size);
+        job->capacity = (job->pixels != NULL) ? size : 0;
+    }
+    if (job->pixels == NULL)
     {
         free(filename);
         return;
     }
 
     // grab the back image from OpenGL by calling the video plugin
-    gfx.readScreen(pucFrame, &width, &height, 0);
+    gfx.readScreen(job->pixels, &width, &height, 0);
 
-    // write the image to a PNG
-    SaveRGBBufferToFile(filename, pucFrame, width, height, width * 3);
+    job->filename = filename;
+    job->width = width;
+    job->height = height;
+    job->format = format;
+    job->level = (CompressionParam != NULL) ? ConfigGetCachedParamInt(CompressionParam) : -1;
+
+    if (encoder != NULL)
+    {
+        QueueCapture(encoder);
+        return;
+    }
+
+    // write the image to a file
+    EncodeJob(job);
     // free the memory
-    free(pucFrame);
-    free(filename);
+    free(job->pixels);
+    free(job->filename);
+}
+
+/*********************************************************************************************************
+* Global screenshot functions
+*/
+
+void ScreenshotRomOpen(void)
+{
+    CurrentShotIndex = 0;
+
+    ConfigGetParamHandle(g_CoreConfig, "DumpFrames", &DumpFramesParam);
+    ConfigGetParamHandle(g_CoreConfig, "FrameDumpFormat", &FrameDumpFormatParam);
+    ConfigGetParamHandle(g_CoreConfig, "ScreenshotCompression", &CompressionParam);
+}
+
+void ScreenshotStop(struct screenshot_encoder_stats *stats)
+{
+    struct screenshot_encoder *encoder = Encoder;
+
+    memset(stats, 0, sizeof(*stats));
+
+    free(DumpBasePath);
+    DumpBasePath = NULL;
+
+    if (encoder == NULL)
+        return;
+
+    StopEncoder(encoder, stats);
+    Encoder = NULL;
+}
+
+void TakeScreenshot(int iFrameNumber)
+{
+    char *filename;
+
+    // look for an unused screenshot filename
+    filename = GetNextScreenshotPath();
+    if (filename == NULL)
+        return;
+
+    CaptureFrame(filename, FRAME_DUMP_FORMAT_PNG);
+
     // print message -- this allows developers to capture frames and use them in the regression test
     main_message(M64MSG_INFO, OSD_BOTTOM_LEFT, "Captured screenshot for frame %i.", iFrameNumber);
 }
 
+void DumpFrame(int iFrameNumber)
+{
+    if (DumpFramesParam == NULL || !ConfigGetCachedParamBool(DumpFramesParam))
+        return;
+
+    if (DumpBasePath == NULL)
+    {
+        DumpBasePath = GetScreenshotPath("-dump");
+        if (DumpBasePath == NULL)
+            return;
+        DebugMessage(M64MSG_INFO, "Dumping frames to '%s-*'", DumpBasePath);
+    }
+
+    int format = ConfigGetCachedParamInt(FrameDumpFormatParam);
+    char *filename = formatstr("%s-%06i.%s", DumpBasePath, iFrameNumber, (format == FRAME_DUMP_FORMAT_QOI) ? "qoi" : "png");
+    if (filename == NULL)
+        return;
+
+    CaptureFrame(filename, format);
+}
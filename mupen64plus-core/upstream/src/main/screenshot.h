@@ -22,7 +22,27 @@
 #ifndef M64P_MAIN_SCREENSHOT_H
 #define M64P_MAIN_SCREENSHOT_H
 
+#include <stdint.h>
+
+struct screenshot_encoder_stats
+{
+    uint64_t frames;            /* screenshots and dumped frames written */
+    uint64_t bytes_written;
+    uint64_t encode_us;         /* time spent encoding and writing files */
+    uint64_t waits;             /* captures which waited for a free queue slot */
+    uint64_t wait_us;           /* time the emulation thread spent waiting */
+    unsigned int max_queued;
+};
+
 void ScreenshotRomOpen(void);
 void TakeScreenshot(int iFrameNumber);
 
+/* Saves the current frame if the DumpFrames parameter is set */
+void DumpFrame(int iFrameNumber);
+
+/* Writes the frames still queued and stops the encoder thread.
+ * stats receives the statistics since the encoder was started.
+ */
+void ScreenshotStop(struct screenshot_encoder_stats *stats);
+
 #endif
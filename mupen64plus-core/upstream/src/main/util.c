@@ -115,6 +115,52 @@ file_status_t write_chunk_to_file(const char *filename, const void *data, size_t
     return file_ok;
 }
 
+file_status_t write_to_file_atomic(const char *filename, const void *data, size_t size)
+{
+    file_status_t err = file_ok;
+    char *tmpname;
+    FILE *f;
+
+    tmpname = formatstr("%s.tmp", filename);
+    if (tmpname == NULL)
+    {
+        return file_open_error;
+    }
+
+    f = osal_file_open(tmpname, "wb");
+    if (f == NULL)
+    {
+        free(tmpname);
+        return file_open_error;
+    }
+
+    if (fwrite(data, 1, size, f) != size)
+    {
+        err = file_write_error;
+    }
+
+    /* the new content must be on disk before it replaces the previous one,
+     * otherwise a crash right after the rename could leave an empty file */
+    if (err == file_ok && osal_file_sync(f) != 0)
+    {
+        err = file_write_error;
+    }
+
+    if (fclose(f) != 0)
+    {
+        err = file_write_error;
+    }
+
+    /* only replace the previous content once the new one is complete */
+    if (err == file_ok && osal_file_replace(tmpname, filename) != 0)
+    {
+        err = file_write_error;
+    }
+
+    free(tmpname);
+    return err;
+}
+
 
 file_status_t load_file(const char* filename, void** buffer, size_t* size)
 {
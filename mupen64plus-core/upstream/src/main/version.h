@@ -28,7 +28,7 @@
 #define MUPEN_CORE_VERSION 0x020509
 
 #define FRONTEND_API_VERSION 0x020104
-#define CONFIG_API_VERSION   0x020302
+#define CONFIG_API_VERSION   0x020303
 #define DEBUG_API_VERSION    0x020001
 #define VIDEXT_API_VERSION   0x030200
 #define NETPLAY_API_VERSION  0x010001
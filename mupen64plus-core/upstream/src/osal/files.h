@@ -26,6 +26,7 @@
 #if !defined (OSAL_FILES_H)
 #define OSAL_FILES_H
 
+#include <stddef.h>
 #include <zlib.h>
 
 /* some file-related preprocessor definitions */
@@ -64,5 +65,20 @@ extern const char * osal_get_user_cachepath(void);
 extern FILE * osal_file_open (const char *filename, const char *mode);
 extern gzFile osal_gzopen(const char *filename, const char *mode);
 
+/* Flushes f and waits until its content has reached the storage device.
+ * Returns 0 on success. */
+extern int osal_file_sync(FILE *f);
+
+/* Renames source to destination, replacing destination if it exists.
+ * The rename itself is made durable where the platform allows it.
+ * Returns 0 on success. */
+extern int osal_file_replace(const char *source, const char *destination);
+
+/* Maps a whole file copy-on-write: pages are read from the file when first
+ * accessed and changes made to them never reach the file.
+ * Returns NULL if the file can't be mapped, in which case it should be read instead. */
+extern void * osal_file_map(const char *filename, size_t *size);
+extern void osal_file_unmap(void *data, size_t size);
+
 #endif /* OSAL_FILES_H */
 
@@ -29,6 +29,8 @@
 #include <sysdir.h>
 #include <pwd.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -232,3 +234,73 @@ gzFile osal_gzopen(const char *filename, const char *mode)
 {
     return gzopen(filename, mode);
 }
+
+int osal_file_sync(FILE *f)
+{
+    if (fflush(f) != 0)
+        return -1;
+
+    return fsync(fileno(f));
+}
+
+/* the new directory entry of a renamed file only survives a crash once its directory is synced */
+static void sync_parent_directory(const char *path)
+{
+    char dirpath[PATH_MAX];
+    const char *slash = strrchr(path, '/');
+    size_t len = (slash == NULL) ? 0 : (slash == path) ? 1 : (size_t)(slash - path);
+    int fd;
+
+    if (len == 0) {
+        strcpy(dirpath, ".");
+    } else if (len < sizeof(dirpath)) {
+        memcpy(dirpath, path, len);
+        dirpath[len] = '\0';
+    } else {
+        return;
+    }
+
+    fd = open(dirpath, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+int osal_file_replace(const char *source, const char *destination)
+{
+    if (rename(source, destination) != 0)
+        return -1;
+
+    sync_parent_directory(destination);
+    return 0;
+}
+
+void * osal_file_map(const char *filename, size_t *size)
+{
+    struct stat st;
+    void *data;
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+        return NULL;
+
+    *size = (size_t)st.st_size;
+    return data;
+}
+
+void osal_file_unmap(void *data, size_t size)
+{
+    munmap(data, size);
+}
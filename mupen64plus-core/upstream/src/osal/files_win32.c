@@ -24,7 +24,9 @@
  */
 
 #include <direct.h>
+#include <io.h>
 #include <shlobj.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -220,3 +222,56 @@ gzFile osal_gzopen(const char *filename, const char *mode)
     MultiByteToWideChar(CP_UTF8, 0, filename, -1, wstr_filename, PATH_MAX);
     return gzopen_w(wstr_filename, mode);
 }
+
+int osal_file_sync(FILE *f)
+{
+    if (fflush(f) != 0)
+        return -1;
+
+    return _commit(_fileno(f));
+}
+
+int osal_file_replace(const char *source, const char *destination)
+{
+    wchar_t wstr_source[PATH_MAX];
+    wchar_t wstr_destination[PATH_MAX];
+    MultiByteToWideChar(CP_UTF8, 0, source, -1, wstr_source, PATH_MAX);
+    MultiByteToWideChar(CP_UTF8, 0, destination, -1, wstr_destination, PATH_MAX);
+    return MoveFileExW(wstr_source, wstr_destination, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1;
+}
+
+void * osal_file_map(const char *filename, size_t *size)
+{
+    wchar_t wstr_filename[PATH_MAX];
+    LARGE_INTEGER file_size;
+    HANDLE file;
+    HANDLE mapping;
+    void *data = NULL;
+
+    MultiByteToWideChar(CP_UTF8, 0, filename, -1, wstr_filename, PATH_MAX);
+    file = CreateFileW(wstr_filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0 || (ULONGLONG)file_size.QuadPart > (SIZE_MAX >> 1)) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    /* the view keeps the mapping alive once both handles are closed */
+    mapping = CreateFileMappingW(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (mapping != NULL) {
+        data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+
+    if (data != NULL)
+        *size = (size_t)file_size.QuadPart;
+    return data;
+}
+
+void osal_file_unmap(void *data, size_t size)
+{
+    UnmapViewOfFile(data);
+}
@@ -0,0 +1,58 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-core - osal/thread_time.h                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef OSAL_THREAD_TIME_H
+#define OSAL_THREAD_TIME_H
+
+#if !defined(_MSC_VER)
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "osal/preproc.h"
+
+/* Microseconds on the monotonic clock, for measuring durations and deadlines */
+static osal_inline uint64_t osal_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* Waits on cond for at most timeout_us microseconds, lock must be held.
+ * Condition variables wait on the realtime clock, hence the conversion.
+ */
+static osal_inline int osal_cond_timedwait_us(pthread_cond_t* cond, pthread_mutex_t* lock, uint64_t timeout_us)
+{
+    struct timespec ts;
+    uint64_t deadline;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    deadline = (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000 + timeout_us;
+    ts.tv_sec = (time_t)(deadline / 1000000);
+    ts.tv_nsec = (long)(deadline % 1000000) * 1000;
+    return pthread_cond_timedwait(cond, lock, &ts);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,343 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - cheat_test.c                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Applies generated cheat sessions and checks that RDRAM ends up with the
+ * content recorded from the list-walking cheat engine, before cheats were
+ * compiled into a flat program.
+ *
+ * Each session adds up to 8 cheats of random code types (writes,
+ * conditionals, repeaters and GS button codes) and applies them at boot
+ * and for 100 VIs.  In between, cheats get enabled, disabled or replaced,
+ * the GS button toggles and the game writes to the patched memory.
+ * A frontend thread then changes the cheats while they are applied, as
+ * the core API allows.
+ *
+ * The recorded hash was generated with this test linked against the
+ * main/cheat.c which walked the cheat lists, from before the commit that
+ * compiled cheats into a flat program.  Since that engine is gone, an
+ * intended change of output is checked against it by building the test
+ * with that file in place of the current one, e.g.
+ *   gcc -I../../src ../../tools/cheat_test.c old_cheat.c <SDL flags> -lpthread
+ * and running it with record, which prints the recorded_hash line.
+ *
+ * Usage: cheat_test [bench [codes]|record]
+ *   bench also prints the time to apply the given number of codes
+ *   (default 5000) on each VI.
+ *   record prints the hash of this build as the recorded_hash line.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if !defined(_MSC_VER)
+#include <pthread.h>
+#endif
+
+#include "api/m64p_types.h"
+#include "device/r4300/r4300_core.h"
+#include "device/rdram/rdram.h"
+#include "main/cheat.h"
+
+#define DRAM_SIZE 0x400000
+#define SESSIONS 200
+#define VIS_PER_SESSION 100
+
+/* RDRAM hash after all sessions, as the list-walking engine left it */
+static const uint64_t recorded_hash = 0x3FB4ACB42832AF74ull;
+
+static struct rdram rdram;
+static struct r4300_core r4300;
+static int gameshark_active;
+static unsigned long invalidations;
+static int changed_after_delete;
+
+/* normally provided by main/eventloop.c, the r4300 core and api/callbacks.c */
+int event_gameshark_active(void)
+{
+    return gameshark_active;
+}
+
+void invalidate_r4300_cached_code(struct r4300_core* r4300, uint32_t address, size_t size)
+{
+    ++invalidations;
+}
+
+void DebugMessage(int level, const char *message, ...)
+{
+    va_list args;
+
+    va_start(args, message);
+    vprintf(message, args);
+    va_end(args);
+    putchar('\n');
+}
+
+static uint32_t seed = 1;
+
+static uint32_t random_u32(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) ^ (seed << 13);
+}
+
+static const uint8_t code_types[] = {
+    0x80, 0x81, 0x88, 0x89, 0xa0, 0xa1, 0xa8, 0xa9, 0xf0, 0xf1,
+    0xd0, 0xd1, 0xd2, 0xd3, 0xd8, 0xd9, 0xda, 0xdb, 0xee, 0x50, 0x12
+};
+
+/* random codes of every type on a small area, so that they overlap */
+static void random_codes(m64p_cheat_code* codes, int count)
+{
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        uint32_t type = code_types[random_u32() % sizeof(code_types)];
+        uint32_t address = random_u32() % 0x1000;
+
+        if (type == 0x50) {
+            /* repeater */
+            codes[i].address = 0x50000000 | ((random_u32() % 8) << 8) | (random_u32() % 4);
+            codes[i].value = random_u32() % 3;
+        } else {
+            codes[i].address = (type << 24) | address;
+            codes[i].value = random_u32() & 0xffff;
+        }
+    }
+}
+
+/* the kind of codes a large cheat list is made of: writes behind a
+ * condition which holds */
+static void typical_codes(m64p_cheat_code* codes, int count)
+{
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        uint32_t type = ((i & 3) == 0) ? 0xd0 : (i & 1) ? 0x81 : 0x80;
+
+        codes[i].address = (type << 24) | (random_u32() % 0x3ffff0);
+        codes[i].value = (type == 0xd0) ? 0 : (random_u32() & 0xffff);
+    }
+}
+
+static void add_random_cheat(struct cheat_ctx* ctx, int index)
+{
+    m64p_cheat_code codes[12];
+    int count = 1 + random_u32() % 12;
+    char name[24];
+
+    random_codes(codes, count);
+    sprintf(name, "cheat %d", index);
+    cheat_add_new(ctx, name, codes, count);
+}
+
+static uint64_t hash_dram(uint64_t hash)
+{
+    size_t i;
+
+    for (i = 0; i < DRAM_SIZE / 4; ++i)
+        hash = (hash ^ rdram.dram[i]) * 0x00000100000001B3ull;
+    return hash;
+}
+
+static uint64_t run_sessions(void)
+{
+    struct cheat_ctx ctx;
+    uint64_t hash = 0xCBF29CE484222325ull;
+    uint64_t before_delete;
+    int session, vi, i;
+
+    for (session = 0; session < SESSIONS; ++session) {
+        int cheat_count = 1 + random_u32() % 8;
+
+        for (i = 0; i < DRAM_SIZE / 4; ++i)
+            rdram.dram[i] = (random_u32() % 4 == 0) ? random_u32() : 0;
+
+        cheat_init(&ctx);
+        for (i = 0; i < cheat_count; ++i)
+            add_random_cheat(&ctx, i);
+
+        for (vi = 0; vi < VIS_PER_SESSION; ++vi) {
+            gameshark_active = (random_u32() % 3 == 0);
+
+            if (random_u32() % 5 == 0) {
+                int enabled = random_u32() % 2;
+                char name[24];
+
+                sprintf(name, "cheat %d", (int)(random_u32() % (cheat_count + 1)));
+                cheat_set_enabled(&ctx, name, enabled);
+            }
+            if (random_u32() % 20 == 0)
+                add_random_cheat(&ctx, random_u32() % (cheat_count + 2));
+            if (random_u32() % 15 == 0) {
+                /* the game overwrites patched memory */
+                for (i = 0; i < 50; ++i)
+                    rdram.dram[random_u32() % 0x1000 / 4] = random_u32();
+            }
+
+            cheat_apply_cheats(&ctx, &r4300, (vi == 0) ? ENTRY_BOOT : ENTRY_VI);
+        }
+
+        /* deleting the cheats publishes an empty program, which leaves memory as it is */
+        before_delete = hash_dram(hash);
+        cheat_delete_all(&ctx);
+        cheat_apply_cheats(&ctx, &r4300, ENTRY_VI);
+        cheat_uninit(&ctx);
+
+        hash = hash_dram(hash);
+        if (hash != before_delete)
+            ++changed_after_delete;
+    }
+
+    return hash;
+}
+
+#if !defined(_MSC_VER)
+static struct cheat_ctx shared_ctx;
+static volatile int frontend_done;
+
+static void* frontend_thread(void* arg)
+{
+    m64p_cheat_code codes[4] = {
+        { 0x80000010, 1 }, { 0x81000020, 2 }, { 0xd0000010, 1 }, { 0x80000030, 3 }
+    };
+    int i;
+
+    for (i = 0; i < 20000; ++i) {
+        char name[24];
+
+        sprintf(name, "cheat %d", i % 7);
+        if (i % 3)
+            cheat_add_new(&shared_ctx, name, codes, 4);
+        else
+            cheat_set_enabled(&shared_ctx, name, i & 1);
+        if (i % 5000 == 4999)
+            cheat_delete_all(&shared_ctx);
+    }
+
+    frontend_done = 1;
+    return NULL;
+}
+
+static void run_concurrent_changes(void)
+{
+    pthread_t thread;
+    unsigned long applies = 0;
+
+    cheat_init(&shared_ctx);
+    pthread_create(&thread, NULL, frontend_thread, NULL);
+    while (!frontend_done) {
+        cheat_apply_cheats(&shared_ctx, &r4300, ENTRY_VI);
+        ++applies;
+    }
+    pthread_join(thread, NULL);
+
+    cheat_delete_all(&shared_ctx);
+    cheat_apply_cheats(&shared_ctx, &r4300, ENTRY_VI);
+    cheat_uninit(&shared_ctx);
+
+    printf("%lu VIs applied while a frontend thread changed cheats\n", applies);
+}
+#endif
+
+static void bench(int code_count)
+{
+    enum { VIS = 2000 };
+    struct cheat_ctx ctx;
+    struct timespec start, end;
+    m64p_cheat_code* codes = malloc(sizeof(*codes) * code_count);
+    int i;
+
+    if (codes == NULL)
+        return;
+
+    typical_codes(codes, code_count);
+    cheat_init(&ctx);
+    for (i = 0; i < code_count; i += 10) {
+        char name[24];
+
+        sprintf(name, "cheat %d", i);
+        cheat_add_new(&ctx, name, codes + i, (code_count - i < 10) ? code_count - i : 10);
+    }
+
+    /* the first VI takes the new cheats over */
+    cheat_apply_cheats(&ctx, &r4300, ENTRY_VI);
+    invalidations = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < VIS; ++i)
+        cheat_apply_cheats(&ctx, &r4300, ENTRY_VI);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    printf("%d codes: %.1f us per VI, %lu invalidations per VI\n", code_count,
+           ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / 1e3 / VIS,
+           invalidations / VIS);
+
+    cheat_delete_all(&ctx);
+    cheat_apply_cheats(&ctx, &r4300, ENTRY_VI);
+    cheat_uninit(&ctx);
+    free(codes);
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t hash;
+    int failed = 0;
+
+    rdram.dram = calloc(1, DRAM_SIZE);
+    rdram.dram_size = DRAM_SIZE;
+    if (rdram.dram == NULL) {
+        puts("out of memory");
+        return 1;
+    }
+    r4300.rdram = &rdram;
+
+    hash = run_sessions();
+    if (argc > 1 && strcmp(argv[1], "record") == 0) {
+        printf("static const uint64_t recorded_hash = 0x%016llXull;\n", (unsigned long long)hash);
+        free(rdram.dram);
+        return 0;
+    }
+
+    if (changed_after_delete != 0) {
+        printf("%d sessions changed RDRAM once their cheats were deleted\n", changed_after_delete);
+        failed = 1;
+    }
+    if (hash != recorded_hash) {
+        printf("RDRAM hash %016llX, recorded %016llX\n",
+               (unsigned long long)hash, (unsigned long long)recorded_hash);
+        failed = 1;
+    } else {
+        printf("%d cheat sessions match\n", SESSIONS);
+    }
+
+#if !defined(_MSC_VER)
+    run_concurrent_changes();
+#endif
+
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+        bench((argc > 2) ? atoi(argv[2]) : 5000);
+
+    free(rdram.dram);
+    return failed;
+}
@@ -0,0 +1,317 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - config_test.c                                           *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Checks parameter handles and change callbacks of the core configuration
+ * with as many sections as a frontend and all its plugins create.
+ *
+ * Handles are taken for every parameter of 500 sections of 40 parameters,
+ * then parameters are changed, saved, reverted, deleted with their section
+ * and created again.  Each handle must read the same value as a lookup by
+ * name, and each callback must be made exactly when its parameter changes.
+ * The saved file is finally read back by a new configuration.  Nothing is
+ * recorded: every value is checked against the lookup by name and against
+ * the values the test itself set, so there is nothing to regenerate.
+ *
+ * Usage: config_test [scratch directory] [bench]
+ *   bench also prints the time of a section lookup, a parameter lookup by
+ *   name and a parameter read through its handle.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define M64P_CORE_PROTOTYPES 1
+#include "api/config.h"
+#include "api/m64p_config.h"
+#include "api/m64p_types.h"
+
+#define SECTIONS 500
+#define PARAMS 40
+
+/* The configuration reports through the core message callback, not needed here */
+void DebugMessage(int level, const char *message, ...)
+{
+    (void)level;
+    (void)message;
+}
+
+static const char* scratch_dir = ".";
+static char section_names[SECTIONS][24];
+static char param_names[PARAMS][24];
+static m64p_handle sections[SECTIONS];
+static m64p_handle params[SECTIONS][PARAMS];
+static int expected[SECTIONS][PARAMS];
+static int saved[SECTIONS][PARAMS];
+static int notified[SECTIONS][PARAMS];
+static int errors = 0;
+
+static uint32_t seed = 2463534242u;
+
+static uint32_t random_u32(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/* the context is the notification counter of the parameter */
+static void param_changed(void *context, m64p_handle param)
+{
+    int index = (int)((int *)context - &notified[0][0]);
+
+    if (param != params[index / PARAMS][index % PARAMS]) {
+        printf("callback of %s/%s made with another handle\n",
+               section_names[index / PARAMS], param_names[index % PARAMS]);
+        ++errors;
+    }
+    ++*(int *)context;
+}
+
+static void set_value(int s, int p, int value)
+{
+    ConfigSetParameter(sections[s], param_names[p], M64TYPE_INT, &value);
+    expected[s][p] = value;
+}
+
+/* compares handles with lookups by name, and callbacks with the expected changes */
+static void check(const char *step, const int changed[SECTIONS][PARAMS])
+{
+    int step_errors = 0;
+    int s, p;
+
+    for (s = 0; s < SECTIONS; ++s) {
+        for (p = 0; p < PARAMS; ++p) {
+            int cached = ConfigGetCachedParamInt(params[s][p]);
+            int by_name = ConfigGetParamInt(sections[s], param_names[p]);
+
+            if (cached != expected[s][p] || by_name != expected[s][p]) {
+                if (step_errors++ < 10)
+                    printf("%s: %s/%s reads %d through its handle and %d by name, expected %d\n",
+                           step, section_names[s], param_names[p], cached, by_name, expected[s][p]);
+            }
+            if (notified[s][p] != (changed != NULL ? changed[s][p] : 0)) {
+                if (step_errors++ < 10)
+                    printf("%s: %s/%s notified %d times\n", step, section_names[s], param_names[p],
+                           notified[s][p]);
+            }
+        }
+    }
+
+    memset(notified, 0, sizeof(notified));
+    errors += step_errors;
+}
+
+static void run_checks(void)
+{
+    static int changed[SECTIONS][PARAMS];
+    m64p_handle handle;
+    int s, p;
+
+    for (s = 0; s < SECTIONS; ++s) {
+        ConfigOpenSection(section_names[s], &sections[s]);
+        for (p = 0; p < PARAMS; ++p) {
+            expected[s][p] = s * PARAMS + p;
+            ConfigSetDefaultInt(sections[s], param_names[p], expected[s][p], "config_test parameter");
+        }
+    }
+
+    for (s = 0; s < SECTIONS; ++s) {
+        for (p = 0; p < PARAMS; ++p) {
+            if (ConfigGetParamHandle(sections[s], param_names[p], &params[s][p]) != M64ERR_SUCCESS) {
+                printf("no handle for %s/%s\n", section_names[s], param_names[p]);
+                ++errors;
+                return;
+            }
+            ConfigRegisterParamCallback(params[s][p], &notified[s][p], param_changed);
+        }
+    }
+
+    /* names are case insensitive, and unknown parameters have no handle */
+    ConfigGetParamHandle(sections[7], "PARAMETER3", &handle);
+    if (handle != params[7][3]) {
+        puts("handle lookup is case sensitive");
+        ++errors;
+    }
+    if (ConfigGetParamHandle(sections[7], "Missing", &handle) != M64ERR_INPUT_NOT_FOUND) {
+        puts("handle given for a missing parameter");
+        ++errors;
+    }
+    check("defaults", NULL);
+
+    /* setting a parameter to its value is not a change */
+    memset(changed, 0, sizeof(changed));
+    for (s = 0; s < SECTIONS; ++s) {
+        for (p = 0; p < PARAMS; ++p) {
+            if (random_u32() % 3 == 0) {
+                set_value(s, p, (int)(random_u32() % 100000));
+                changed[s][p] = 1;
+            } else if (random_u32() % 2 == 0) {
+                set_value(s, p, expected[s][p]);
+            }
+        }
+    }
+    check("set", changed);
+
+    ConfigSaveFile();
+    memcpy(saved, expected, sizeof(saved));
+
+    /* a revert only notifies the parameters which differ from the saved ones */
+    memset(changed, 0, sizeof(changed));
+    for (s = 0; s < SECTIONS; ++s) {
+        for (p = 0; p < PARAMS; p += 4)
+            set_value(s, p, expected[s][p] + 1);
+    }
+    for (s = 0; s < SECTIONS; ++s) {
+        if (s % 5 == 0) {
+            ConfigRevertChanges(section_names[s]);
+            memcpy(expected[s], saved[s], sizeof(expected[s]));
+        }
+        for (p = 0; p < PARAMS; p += 4)
+            changed[s][p] = (s % 5 == 0) ? 2 : 1;
+    }
+    check("revert", changed);
+
+    /* handles follow their parameter through the deletion of the section */
+    memset(changed, 0, sizeof(changed));
+    for (s = 0; s < SECTIONS; s += 7) {
+        ConfigDeleteSection(section_names[s]);
+        for (p = 0; p < PARAMS; ++p) {
+            if (ConfigGetCachedParamInt(params[s][p]) != 0) {
+                printf("deleted %s/%s still has a value\n", section_names[s], param_names[p]);
+                ++errors;
+            }
+        }
+
+        ConfigOpenSection(section_names[s], &sections[s]);
+        for (p = 0; p < PARAMS; ++p) {
+            expected[s][p] = -(s * PARAMS + p);
+            ConfigSetDefaultInt(sections[s], param_names[p], expected[s][p], "config_test parameter");
+            changed[s][p] = 2;
+        }
+    }
+    check("delete", changed);
+
+    /* no callbacks once they are unregistered */
+    for (s = 0; s < SECTIONS; ++s) {
+        for (p = 0; p < PARAMS; ++p)
+            ConfigUnregisterParamCallback(params[s][p], &notified[s][p], param_changed);
+    }
+    for (s = 0; s < SECTIONS; ++s)
+        set_value(s, s % PARAMS, expected[s][s % PARAMS] + 1);
+    check("unregister", NULL);
+
+    /* a new configuration reads what was saved */
+    ConfigShutdown();
+    if (ConfigInit(scratch_dir, scratch_dir) != M64ERR_SUCCESS) {
+        puts("configuration can't be read back");
+        ++errors;
+        return;
+    }
+    for (s = 0; s < SECTIONS; ++s) {
+        ConfigOpenSection(section_names[s], &sections[s]);
+        for (p = 0; p < PARAMS; ++p) {
+            if (ConfigGetParamHandle(sections[s], param_names[p], &params[s][p]) != M64ERR_SUCCESS) {
+                printf("%s/%s not read back\n", section_names[s], param_names[p]);
+                ++errors;
+                return;
+            }
+        }
+    }
+    memcpy(expected, saved, sizeof(expected));
+    check("read back", NULL);
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+static void bench(void)
+{
+    enum { LOOKUPS = 2000000 };
+    struct timespec start, end;
+    m64p_handle handle;
+    long sum = 0;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < LOOKUPS; ++i) {
+        ConfigOpenSection(section_names[random_u32() % SECTIONS], &handle);
+        sum += (handle != NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("ConfigOpenSection: %.1f ns\n", elapsed_ns(&start, &end) / LOOKUPS);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < LOOKUPS; ++i)
+        sum += ConfigGetParamInt(sections[random_u32() % SECTIONS], param_names[random_u32() % PARAMS]);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("ConfigGetParamInt: %.1f ns\n", elapsed_ns(&start, &end) / LOOKUPS);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < LOOKUPS; ++i)
+        sum += ConfigGetCachedParamInt(params[random_u32() % SECTIONS][random_u32() % PARAMS]);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("ConfigGetCachedParamInt: %.1f ns\n", elapsed_ns(&start, &end) / LOOKUPS);
+
+    /* keeps the loops from being optimized out */
+    if (sum == 0)
+        puts("");
+}
+
+int main(int argc, char* argv[])
+{
+    char path[4096];
+    int do_bench = 0;
+    int s, p;
+
+    for (s = 1; s < argc; ++s) {
+        if (strcmp(argv[s], "bench") == 0)
+            do_bench = 1;
+        else
+            scratch_dir = argv[s];
+    }
+
+    for (s = 0; s < SECTIONS; ++s)
+        sprintf(section_names[s], "Test-Section-%d", s);
+    for (p = 0; p < PARAMS; ++p)
+        sprintf(param_names[p], "Parameter%d", p);
+
+    snprintf(path, sizeof(path), "%s/mupen64plus.cfg", scratch_dir);
+    remove(path);
+    if (ConfigInit(scratch_dir, scratch_dir) != M64ERR_SUCCESS) {
+        puts("configuration can't be initialized");
+        return 1;
+    }
+
+    run_checks();
+    if (do_bench && errors == 0)
+        bench();
+
+    ConfigShutdown();
+    remove(path);
+    printf("%s\n", errors ? "FAILED" : "All parameter handles and callbacks match");
+    return errors != 0;
+}
@@ -0,0 +1,320 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - dd_disk_test.c                                          *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Checks the LBA extent table of 64DD disks against get_sector_base().
+ *
+ * Synthetic SDK, MAME and D64 images are built for the 7 disk types (D64 both
+ * with the RAM area right after the ROM area and with a gap between them).
+ * For every LBA, each sector of the extent must be where get_sector_base()
+ * finds it, extents must lie in the image and must not overlap.
+ * A few layouts are then saved through the async disk storage and the
+ * resulting file compared with the image.
+ *
+ * Usage: dd_disk_test [scratch directory]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/m64p_types.h"
+#include "backends/api/storage_backend.h"
+#include "backends/async_disk_storage.h"
+#include "backends/file_storage.h"
+#include "device/dd/disk.h"
+#include "main/util.h"
+
+/* The disk code reports through the core message callback, not needed here */
+void DebugMessage(int level, const char *message, ...)
+{
+    (void)level;
+    (void)message;
+}
+
+/* First RAM LBA of each disk type, type 6 has no RAM area */
+static const uint16_t ram_start_lba[7] = { 0x5A2, 0x7C6, 0x9EA, 0xC0E, 0xE32, 0x1010, 0x10DC };
+
+static const char* scratch_dir = ".";
+
+static void put_sys_data(uint8_t* p, int type)
+{
+    struct dd_sys_data* sys = (struct dd_sys_data*)p;
+
+    memset(p, 0, SECTORSIZE_SYS);
+    sys->region = big32(DD_REGION_JP);
+    sys->type = type;
+    sys->format = 0x10;
+    sys->ipl_load_blk = big16(0x20);
+    sys->ipl_load_addr = big32(0x80000400);
+}
+
+static int check_extents(const struct dd_disk* disk, const char* name)
+{
+    uint8_t* data = disk->istorage->data(disk->storage);
+    size_t size = disk->istorage->size(disk->storage);
+    const struct dd_sys_data* sys = (const struct dd_sys_data*)(data + disk->offset_sys);
+    uint8_t* covered = calloc(size, 1);
+    size_t bytes = 0;
+    int lbas = 0;
+    int errors = 0;
+    uint32_t lba;
+
+    for (lba = SYSTEM_LBAS; lba < SIZE_LBA; ++lba) {
+        uint16_t phys = (disk->format == DISK_FORMAT_MAME) ? LBAToPhys(sys, lba) : disk->lba_phys_table[lba];
+        unsigned int head = (phys >> 12) & 1;
+        unsigned int track = phys & 0xfff;
+        unsigned int block = (phys >> 13) & 1;
+        uint32_t lba_size = disk->lba_size[lba];
+        uint32_t sector_size = lba_size / SECTORS_PER_BLOCK;
+        unsigned int sector;
+        uint32_t i;
+
+        for (sector = 0; sector < SECTORS_PER_BLOCK; ++sector) {
+            const uint8_t* base = get_sector_base(disk, head, track, block, sector);
+            const uint8_t* expected = (lba_size == 0) ? NULL : data + disk->lba_offset[lba] + sector * sector_size;
+
+            if (base != expected && errors++ < 5) {
+                printf("%s: LBA %u sector %u at %ld, extent says %ld\n", name, lba, sector,
+                       base ? (long)(base - data) : -1L, expected ? (long)(expected - data) : -1L);
+            }
+        }
+
+        if (lba_size == 0)
+            continue;
+
+        ++lbas;
+        bytes += lba_size;
+        if (disk->lba_offset[lba] + lba_size > size) {
+            ++errors;
+            printf("%s: LBA %u extends past the image\n", name, lba);
+            continue;
+        }
+        for (i = 0; i < lba_size; ++i) {
+            if (covered[disk->lba_offset[lba] + i]++) {
+                ++errors;
+                printf("%s: LBA %u overlaps another LBA\n", name, lba);
+                break;
+            }
+        }
+    }
+
+    free(covered);
+    printf("%-12s %4d LBAs, %9zu of %9zu bytes, %d errors\n", name, lbas, bytes, size, errors);
+    return errors;
+}
+
+static uint8_t* make_ndd_image(size_t size, int type)
+{
+    uint8_t* data = calloc(size, 1);
+    size_t i;
+    int j;
+
+    for (j = 0; j < SECTORS_PER_BLOCK; ++j)
+        put_sys_data(data + j * SECTORSIZE_SYS, type);
+    /* Disk ID block */
+    memset(data + 14 * BLOCKSIZE(0), 0x5a, SECTORS_PER_BLOCK * SECTORSIZE_SYS);
+    for (i = 15 * BLOCKSIZE(0); i < size; ++i)
+        data[i] = (uint8_t)((i * 2654435761u) >> 24);
+
+    return data;
+}
+
+static uint8_t* make_d64_image(int type, int rom_lba_end, size_t* size)
+{
+    int has_ram = (type < 6);
+    int ram_lba_start = ram_start_lba[type] - SYSTEM_LBAS;
+    int ram_lba_end = ram_lba_start + 40;
+    size_t rom_size = LBAToByteA(type, SYSTEM_LBAS, rom_lba_end + 1);
+    size_t ram_size = has_ram ? LBAToByteA(type, SYSTEM_LBAS + ram_lba_start, ram_lba_end + 1 - ram_lba_start) : 0;
+    struct dd_sys_data* sys;
+    uint8_t* data;
+
+    *size = D64_OFFSET_DATA + rom_size + ram_size;
+    data = calloc(*size, 1);
+    put_sys_data(data, type);
+
+    sys = (struct dd_sys_data*)data;
+    sys->rom_lba_end = big16(rom_lba_end);
+    sys->ram_lba_start = has_ram ? big16(ram_lba_start) : 0xFFFF;
+    sys->ram_lba_end = has_ram ? big16(ram_lba_end) : 0xFFFF;
+
+    return data;
+}
+
+/* Takes ownership of data, the expanded image ends up in fstorage */
+static int load_disk(struct dd_disk* disk, struct file_storage* fstorage, uint8_t* data, size_t size,
+                     size_t* offset_ram, size_t* size_ram)
+{
+    unsigned int format, development;
+    size_t offset_sys, offset_id;
+    uint8_t* image = scan_and_expand_disk_format(data, &size, &format, &development,
+                                                 &offset_sys, &offset_id, offset_ram, size_ram);
+
+    if (image == NULL) {
+        printf("Unrecognized disk image\n");
+        free(data);
+        return -1;
+    }
+    if (image != data)
+        free(data);
+
+    memset(fstorage, 0, sizeof(*fstorage));
+    fstorage->data = image;
+    fstorage->size = size;
+
+    memset(disk, 0, sizeof(*disk));
+    disk->storage = fstorage;
+    disk->istorage = &g_ifile_storage_ro;
+    disk->format = format;
+    disk->development = development;
+    disk->offset_sys = offset_sys;
+    disk->offset_id = offset_id;
+    disk->offset_ram = *offset_ram;
+    GenerateLBAToPhysTable(disk);
+    GenerateLBAExtentTable(disk);
+
+    return 0;
+}
+
+/* Scribble over random sectors of [offset, offset + size) of the disk, saving each
+ * through the async disk storage, then compare the written file with the image.
+ */
+static int check_save(const struct dd_disk* disk, struct file_storage* fstorage, size_t offset, size_t size,
+                      const char* name, int create_first, unsigned int interval_ms)
+{
+    struct file_storage save;
+    struct async_disk_storage storage;
+    struct async_disk_storage_stats stats;
+    char path[1024];
+    void* file_data;
+    size_t file_size;
+    int saves = 0;
+    int same;
+    int i;
+
+    snprintf(path, sizeof(path), "%s/%s", scratch_dir, name);
+    memset(&save, 0, sizeof(save));
+    save.data = fstorage->data + offset;
+    save.size = size;
+    save.filename = path;
+
+    remove(path);
+    if (create_first)
+        write_to_file(path, save.data, size);
+
+    if (open_async_disk_storage(&storage, &save, disk, interval_ms) != 0) {
+        printf("%s: can't open async disk storage\n", name);
+        return 1;
+    }
+
+    srand(7);
+    for (i = 0; i < 3000; ++i) {
+        uint32_t lba = SYSTEM_LBAS + rand() % (SIZE_LBA - SYSTEM_LBAS);
+        uint32_t sector_size = disk->lba_size[lba] / SECTORS_PER_BLOCK;
+        uint8_t* sector;
+        uint32_t j;
+
+        if (disk->lba_size[lba] == 0 || disk->lba_offset[lba] < offset
+         || disk->lba_offset[lba] + disk->lba_size[lba] > offset + size)
+            continue;
+
+        sector = fstorage->data + disk->lba_offset[lba] + (rand() % SECTORS_PER_BLOCK) * sector_size;
+        for (j = 0; j < sector_size; ++j)
+            sector[j] = (uint8_t)rand();
+        g_iasync_disk_storage.save(&storage, (size_t)(sector - save.data), sector_size);
+        ++saves;
+
+        /* spans the gaps between LBAs, if any, which falls back to a whole snapshot */
+        if (i % 1000 == 999) {
+            g_iasync_disk_storage.save(&storage, 0, size);
+            ++saves;
+        }
+    }
+    close_async_disk_storage(&storage, &stats);
+
+    if (load_file(path, &file_data, &file_size) != file_ok) {
+        printf("%s: save file missing\n", name);
+        return 1;
+    }
+    same = (file_size == size && memcmp(file_data, save.data, size) == 0);
+    printf("  %-10s %d saves, %llu flushes, %llu LBAs written: %s\n", name, saves,
+           (unsigned long long)stats.flushes, (unsigned long long)stats.lbas_written,
+           same ? "identical" : "DIFFERENT");
+
+    free(file_data);
+    remove(path);
+    return !same;
+}
+
+int main(int argc, char* argv[])
+{
+    struct dd_disk disk;
+    struct file_storage fstorage;
+    size_t offset_ram, size_ram;
+    char name[32];
+    int errors = 0;
+    int type, gap;
+
+    if (argc > 1)
+        scratch_dir = argv[1];
+
+    for (type = 0; type < 7; ++type) {
+        snprintf(name, sizeof(name), "SDK type %d", type);
+        if (load_disk(&disk, &fstorage, make_ndd_image(SDK_FORMAT_DUMP_SIZE, type), SDK_FORMAT_DUMP_SIZE,
+                      &offset_ram, &size_ram) != 0)
+            return 1;
+        errors += check_extents(&disk, name);
+        if (type == 0) {
+            errors += check_save(&disk, &fstorage, 0, fstorage.size, "sdk.ndr", 0, 2);
+            errors += check_save(&disk, &fstorage, offset_ram, size_ram, "sdk.ram", 1, 50);
+        }
+        free(fstorage.data);
+
+        snprintf(name, sizeof(name), "MAME type %d", type);
+        if (load_disk(&disk, &fstorage, make_ndd_image(MAME_FORMAT_DUMP_SIZE, type), MAME_FORMAT_DUMP_SIZE,
+                      &offset_ram, &size_ram) != 0)
+            return 1;
+        errors += check_extents(&disk, name);
+        if (type == 0)
+            errors += check_save(&disk, &fstorage, 0, fstorage.size, "mame.ndr", 1, 2);
+        free(fstorage.data);
+
+        for (gap = 0; gap < 2; ++gap) {
+            int rom_lba_end = (type == 6) ? 0x500 : ram_start_lba[type] - SYSTEM_LBAS - 1 - (gap ? 200 : 0);
+            size_t size;
+            uint8_t* data = make_d64_image(type, rom_lba_end, &size);
+
+            snprintf(name, sizeof(name), "D64 type %d%s", type, gap ? " gap" : "");
+            if (load_disk(&disk, &fstorage, data, size, &offset_ram, &size_ram) != 0)
+                return 1;
+            errors += check_extents(&disk, name);
+            if (type == 1 && gap) {
+                errors += check_save(&disk, &fstorage, 0, fstorage.size, "d64.d6r", 0, 2);
+                errors += check_save(&disk, &fstorage, offset_ram, size_ram, "d64.ram", 0, 1000);
+            }
+            free(fstorage.data);
+        }
+    }
+
+    printf("%s\n", errors ? "FAILED" : "All disk layouts match");
+    return errors != 0;
+}
@@ -0,0 +1,188 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - qoi_test.c                                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Encodes generated frames with the screenshot QOI encoder and decodes them
+ * with a decoder following the reference implementation (qoi.h from
+ * https://qoiformat.org), which must give back every pixel.
+ *
+ * Frames cover black and non-black first pixels, long runs, small and
+ * large colour steps and few-colour images which make the encoder reuse
+ * its colour index, at sizes from 1x1 up.
+ *
+ * Usage: qoi_test
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main/qoi.h"
+
+static uint32_t seed = 2463534242u;
+
+static uint32_t random_u32(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/* decodes to a top-down RGB buffer, returns 0 on malformed data */
+static int decode(const unsigned char *data, size_t size, unsigned char *rgb, int width, int height)
+{
+    unsigned char index[64][4];
+    unsigned char px[4] = { 0, 0, 0, 255 };
+    size_t p = 14;
+    int run = 0;
+    int i;
+
+    memset(index, 0, sizeof(index));
+
+    if (size < 22 || memcmp(data, "qoif", 4) != 0 || data[12] != 3)
+        return 0;
+    if ((int) (((uint32_t) data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7]) != width ||
+        (int) (((uint32_t) data[8] << 24) | (data[9] << 16) | (data[10] << 8) | data[11]) != height)
+        return 0;
+
+    for (i = 0; i < width * height; ++i) {
+        if (run > 0) {
+            --run;
+        } else {
+            int b1;
+
+            if (p >= size - 8)
+                return 0;
+            b1 = data[p++];
+            if (b1 == 0xfe) {
+                px[0] = data[p++];
+                px[1] = data[p++];
+                px[2] = data[p++];
+            } else if (b1 == 0xff) {
+                memcpy(px, data + p, 4);
+                p += 4;
+            } else if ((b1 & 0xc0) == 0x00) {
+                memcpy(px, index[b1], 4);
+            } else if ((b1 & 0xc0) == 0x40) {
+                px[0] += ((b1 >> 4) & 3) - 2;
+                px[1] += ((b1 >> 2) & 3) - 2;
+                px[2] += (b1 & 3) - 2;
+            } else if ((b1 & 0xc0) == 0x80) {
+                int b2 = data[p++];
+                int vg = (b1 & 0x3f) - 32;
+                px[0] += vg - 8 + ((b2 >> 4) & 0x0f);
+                px[1] += vg;
+                px[2] += vg - 8 + (b2 & 0x0f);
+            } else {
+                run = b1 & 0x3f;
+            }
+            memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+        }
+        if (px[3] != 255)
+            return 0;
+        memcpy(rgb + i * 3, px, 3);
+    }
+
+    return p == size - 8 && memcmp(data + p, "\0\0\0\0\0\0\0\1", 8) == 0;
+}
+
+/* encodes the top-down frame as the bottom-up buffer readScreen gives */
+static int round_trip(const char *name, const unsigned char *frame, int width, int height)
+{
+    int pitch = width * 3;
+    unsigned char *bottom_up = malloc((size_t) pitch * height);
+    unsigned char *encoded = malloc(QOI_MAX_SIZE(width, height));
+    unsigned char *decoded = malloc((size_t) pitch * height);
+    size_t size;
+    int y, ok;
+
+    for (y = 0; y < height; ++y)
+        memcpy(bottom_up + (height - 1 - y) * pitch, frame + y * pitch, pitch);
+
+    size = qoi_encode_rgb(encoded, bottom_up, width, height, pitch);
+    ok = size <= QOI_MAX_SIZE(width, height) &&
+         decode(encoded, size, decoded, width, height) &&
+         memcmp(decoded, frame, (size_t) pitch * height) == 0;
+    if (!ok)
+        printf("%s: %dx%d frame does not decode back\n", name, width, height);
+
+    free(bottom_up);
+    free(encoded);
+    free(decoded);
+    return ok;
+}
+
+int main(void)
+{
+    static const unsigned char black_after_colour[] = {
+        200, 10, 10,  0, 0, 0,  50, 60, 70,  1, 2, 3,  50, 60, 70
+    };
+    static const unsigned char black_first[] = {
+        0, 0, 0,  200, 10, 10,  0, 0, 0,  200, 10, 10,  0, 0, 0
+    };
+    static const int sizes[][2] = { { 1, 1 }, { 7, 3 }, { 64, 64 }, { 320, 240 }, { 640, 480 } };
+    unsigned char *frame = malloc(640 * 480 * 3);
+    int failed = 0;
+    size_t s;
+    int i;
+
+    failed |= !round_trip("black after a colour", black_after_colour, 5, 1);
+    failed |= !round_trip("black first", black_first, 5, 1);
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        int width = sizes[s][0];
+        int height = sizes[s][1];
+        int n = width * height * 3;
+        unsigned char palette[8][3];
+
+        /* few colours, black included, in runs of random length */
+        for (i = 0; i < 8; ++i) {
+            palette[i][0] = (i == 0) ? 0 : (unsigned char) random_u32();
+            palette[i][1] = (i == 0) ? 0 : (unsigned char) random_u32();
+            palette[i][2] = (i == 0) ? 0 : (unsigned char) random_u32();
+        }
+        for (i = 0; i < n; i += 3) {
+            if (i == 0 || random_u32() % 4 == 0)
+                memcpy(frame + i, palette[random_u32() % 8], 3);
+            else
+                memcpy(frame + i, frame + i - 3, 3);
+        }
+        failed |= !round_trip("palette", frame, width, height);
+
+        /* small and medium steps from the previous pixel */
+        for (i = 0; i < n; ++i) {
+            int step = (random_u32() % 2) ? (int) (random_u32() % 4) - 2 : (int) (random_u32() % 48) - 24;
+            frame[i] = (unsigned char) ((i < 3 ? 128 : frame[i - 3]) + step);
+        }
+        failed |= !round_trip("gradient", frame, width, height);
+
+        /* noise, with black and runs longer than 62 pixels */
+        for (i = 0; i < n; ++i)
+            frame[i] = (unsigned char) random_u32();
+        memset(frame + n / 3, 0, n / 3);
+        failed |= !round_trip("noise", frame, width, height);
+    }
+
+    free(frame);
+    printf("%s\n", failed ? "FAILED" : "All QOI frames decode back");
+    return failed;
+}
@@ -28,6 +28,7 @@ LOCAL_SRC_FILES := \
     $(SRCDIR)/vu/logical.c \
     $(SRCDIR)/vu/multiply.c \
     $(SRCDIR)/vu/select.c \
+    $(SRCDIR)/vu/sse41.c \
     $(SRCDIR)/vu/vu.c
 
 LOCAL_CFLAGS := $(MY_LOCAL_CFLAGS)
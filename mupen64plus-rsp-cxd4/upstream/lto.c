@@ -34,6 +34,7 @@
 #include "vu/select.c"
 #include "vu/logical.c"
 #include "vu/divide.c"
+#include "vu/sse41.c"
 #if 0
 #include "vu/pack.c"
 #endif
@@ -12,7 +12,8 @@ OBJ_LIST="\
     $obj/vu/add.o \
     $obj/vu/select.o \
     $obj/vu/logical.o \
-    $obj/vu/divide.o"
+    $obj/vu/divide.o \
+    $obj/vu/sse41.o"
 
 FLAGS_ANSI="-fPIC -DPLUGIN_API_VERSION=0x0101 -mstackrealign -Wall -pedantic"
 
@@ -55,6 +56,7 @@ cc -S -O3 $C_FLAGS -o $obj/vu/add.s      $src/vu/add.c
 cc -S -O3 $C_FLAGS -o $obj/vu/select.s   $src/vu/select.c
 cc -S -O3 $C_FLAGS -o $obj/vu/logical.s  $src/vu/logical.c
 cc -S -O2 $C_FLAGS -o $obj/vu/divide.s   $src/vu/divide.c
+cc -S -O3 $C_FLAGS -o $obj/vu/sse41.s    $src/vu/sse41.c
 
 echo Assembling compiled sources...
 as -o $obj/module.o $obj/module.s
@@ -65,6 +67,7 @@ as -o $obj/vu/add.o      $obj/vu/add.s
 as -o $obj/vu/select.o   $obj/vu/select.s
 as -o $obj/vu/logical.o  $obj/vu/logical.s
 as -o $obj/vu/divide.o   $obj/vu/divide.s
+as -o $obj/vu/sse41.o    $obj/vu/sse41.s
 
 echo Linking assembled object files...
 ld --shared -o $obj/rspdebug.so -lc $OBJ_LIST
@@ -25,7 +25,8 @@ set OBJ_LIST=^
 %obj%\vu\add.o ^
 %obj%\vu\select.o ^
 %obj%\vu\logical.o ^
-%obj%\vu\divide.o
+%obj%\vu\divide.o ^
+%obj%\vu\sse41.o
 
 set FLAGS_ANSI=-Wall -pedantic^
  -DPLUGIN_API_VERSION=0x0101^
@@ -56,6 +57,7 @@ gcc -O3 -S %C_FLAGS% -o %obj%\vu\add.asm      %rsp%\vu\add.c
 gcc -O3 -S %C_FLAGS% -o %obj%\vu\select.asm   %rsp%\vu\select.c
 gcc -O3 -S %C_FLAGS% -o %obj%\vu\logical.asm  %rsp%\vu\logical.c
 gcc -O2 -S %C_FLAGS% -o %obj%\vu\divide.asm   %rsp%\vu\divide.c
+gcc -O3 -S %C_FLAGS% -o %obj%\vu\sse41.asm    %rsp%\vu\sse41.c
 @ECHO OFF
 ECHO.
 
@@ -68,6 +70,7 @@ as -o %obj%\vu\add.o            %obj%\vu\add.asm
 as -o %obj%\vu\select.o         %obj%\vu\select.asm
 as -o %obj%\vu\logical.o        %obj%\vu\logical.asm
 as -o %obj%\vu\divide.o         %obj%\vu\divide.asm
+as -o %obj%\vu\sse41.o          %obj%\vu\sse41.asm
 ECHO.
 
 ECHO Linking assembled object files...
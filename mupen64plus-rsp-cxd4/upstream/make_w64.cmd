@@ -29,7 +29,8 @@ set OBJ_LIST=^
 %obj%\vu\add.o ^
 %obj%\vu\select.o ^
 %obj%\vu\logical.o ^
-%obj%\vu\divide.o
+%obj%\vu\divide.o ^
+%obj%\vu\sse41.o
 
 set FLAGS_ANSI=-Wall -pedantic^
  -DPLUGIN_API_VERSION=0x0101^
@@ -60,6 +61,7 @@ gcc -S -O3 %C_FLAGS% -o %obj%\vu\add.asm      %rsp%\vu\add.c
 gcc -S -O3 %C_FLAGS% -o %obj%\vu\select.asm   %rsp%\vu\select.c
 gcc -S -O3 %C_FLAGS% -o %obj%\vu\logical.asm  %rsp%\vu\logical.c
 gcc -S -O2 %C_FLAGS% -o %obj%\vu\divide.asm   %rsp%\vu\divide.c
+gcc -S -O3 %C_FLAGS% -o %obj%\vu\sse41.asm    %rsp%\vu\sse41.c
 @ECHO OFF
 ECHO.
 
@@ -72,6 +74,7 @@ as -o %obj%\vu\add.o            %obj%\vu\add.asm
 as -o %obj%\vu\select.o         %obj%\vu\select.asm
 as -o %obj%\vu\logical.o        %obj%\vu\logical.asm
 as -o %obj%\vu\divide.o         %obj%\vu\divide.asm
+as -o %obj%\vu\sse41.o          %obj%\vu\sse41.asm
 ECHO.
 
 ECHO Linking assembled object files...
@@ -30,6 +30,7 @@
 
 #include "module.h"
 #include "su.h"
+#include "vu/sse41.h"
 
 #include <signal.h>
 #include <setjmp.h>
@@ -520,6 +521,7 @@ EXPORT void CALL InitiateRSP(RSP_INFO Rsp_Info, pu32 CycleCount)
     if (CycleCount != NULL) /* cycle-accuracy not doable with today's hosts */
         *CycleCount = 0;
     update_conf(CFG_FILE);
+    select_VU_backend();
 
     RSP_INFO_NAME = Rsp_Info;
     DRAM = GET_RSP_INFO(RDRAM);
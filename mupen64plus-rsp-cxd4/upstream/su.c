@@ -210,6 +210,165 @@ MT_CMD_START       ,MT_CMD_END         ,MT_READ_ONLY       ,MT_CMD_STATUS,
 MT_CMD_CLOCK       ,MT_READ_ONLY       ,MT_READ_ONLY       ,MT_READ_ONLY
 };
 
+/*
+ * decoded IMEM
+ *
+ * Rather than switching on the primary op-code and then again on the
+ * SPECIAL, REGIMM, COP0 or COP2 sub-op-code for every instruction, each IMEM
+ * word is decoded once into a flat operation index, so that the interpreter
+ * reaches any handler through a single jump table and never has to read IMEM
+ * itself while running.
+ *
+ * Within a task, IMEM can only change through SP DMA, which decodes the words
+ * it writes again.  The host CPU may write IMEM directly between tasks, so it
+ * is compared against the decoded copy once before each task starts.
+ */
+enum {
+    SU_SLL = 0, /* so that the zero-filled table already decodes a NOP */
+    SU_SRL,
+    SU_SRA,
+    SU_SLLV,
+    SU_SRLV,
+    SU_SRAV,
+    SU_JR,
+    SU_JALR,
+    SU_BREAK,
+    SU_ADDU,
+    SU_SUBU,
+    SU_AND,
+    SU_OR,
+    SU_XOR,
+    SU_NOR,
+    SU_SLT,
+    SU_SLTU,
+
+    SU_BLTZ,
+    SU_BGEZ,
+    SU_BLTZAL,
+    SU_BGEZAL,
+    SU_REGIMM_RES,
+
+    SU_J,
+    SU_JAL,
+    SU_BEQ,
+    SU_BNE,
+    SU_BLEZ,
+    SU_BGTZ,
+    SU_ADDIU,
+    SU_SLTI,
+    SU_SLTIU,
+    SU_ANDI,
+    SU_ORI,
+    SU_XORI,
+    SU_LUI,
+
+    SU_MFC0,
+    SU_MTC0,
+
+    SU_MFC2,
+    SU_CFC2,
+    SU_MTC2,
+    SU_CTC2,
+    SU_VECTOR,
+
+    SU_LB,
+    SU_LH,
+    SU_LW,
+    SU_LBU,
+    SU_LHU,
+    SU_SB,
+    SU_SH,
+    SU_SW,
+    SU_LWC2,
+    SU_SWC2,
+
+    SU_RES
+};
+
+static struct {
+    u32 word;
+    u32 op;
+} decoded_IMEM[4096 / 4];
+
+static const u8 decode_SPECIAL[64] = {
+    SU_SLL   ,SU_RES   ,SU_SRL   ,SU_SRA   ,SU_SLLV  ,SU_RES   ,SU_SRLV  ,SU_SRAV  ,
+    SU_JR    ,SU_JALR  ,SU_RES   ,SU_RES   ,SU_RES   ,SU_BREAK ,SU_RES   ,SU_RES   ,
+    SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,
+    SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,
+    SU_ADDU  ,SU_ADDU  ,SU_SUBU  ,SU_SUBU  ,SU_AND   ,SU_OR    ,SU_XOR   ,SU_NOR   ,
+    SU_RES   ,SU_RES   ,SU_SLT   ,SU_SLTU  ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,
+    SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,
+    SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,
+};
+
+static const u8 decode_primary[64] = {
+    SU_RES   ,SU_RES   ,SU_J     ,SU_JAL   ,SU_BEQ   ,SU_BNE   ,SU_BLEZ  ,SU_BGTZ  ,
+    SU_ADDIU ,SU_ADDIU ,SU_SLTI  ,SU_SLTIU ,SU_ANDI  ,SU_ORI   ,SU_XORI  ,SU_LUI   ,
+    SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,
+    SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,
+    SU_LB    ,SU_LH    ,SU_RES   ,SU_LW    ,SU_LBU   ,SU_LHU   ,SU_RES   ,SU_RES   ,
+    SU_SB    ,SU_SH    ,SU_RES   ,SU_SW    ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,
+    SU_RES   ,SU_RES   ,SU_LWC2  ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,
+    SU_RES   ,SU_RES   ,SU_SWC2  ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,SU_RES   ,
+};
+
+NOINLINE static unsigned int decode_SU(u32 inst)
+{
+    const unsigned int rs = (inst >> 21) % (1 << 5);
+    const unsigned int rt = (inst >> 16) % (1 << 5);
+
+    switch (inst >> 26) {
+    case 000: /* SPECIAL */
+        return decode_SPECIAL[inst % 64];
+    case 001: /* REGIMM */
+        switch (rt) {
+        case 000:
+            return SU_BLTZ;
+        case 001:
+            return SU_BGEZ;
+        case 020:
+            return SU_BLTZAL;
+        case 021:
+            return SU_BGEZAL;
+        }
+        return SU_REGIMM_RES; /* still taken as a branch */
+    case 020: /* COP0 */
+        switch (rs) {
+        case 000:
+            return SU_MFC0;
+        case 004:
+            return SU_MTC0;
+        }
+        return SU_RES;
+    case 022: /* COP2 */
+        if (rs >= 020)
+            return SU_VECTOR;
+        switch (rs) {
+        case 000:
+            return SU_MFC2;
+        case 002:
+            return SU_CFC2;
+        case 004:
+            return SU_MTC2;
+        case 006:
+            return SU_CTC2;
+        }
+        return SU_RES;
+    }
+    return decode_primary[inst >> 26];
+}
+
+static void decode_IMEM(unsigned int offset)
+{
+    const unsigned int slot = FIT_IMEM(offset) / 4;
+    const u32 word = *(pi32)(IMEM + FIT_IMEM(offset));
+
+    if (decoded_IMEM[slot].word == word)
+        return;
+    decoded_IMEM[slot].word = word;
+    decoded_IMEM[slot].op = decode_SU(word);
+}
+
 void SP_DMA_READ(void)
 {
     unsigned int offC, offD; /* SP cache and dynamic DMA pointers */
@@ -235,11 +394,14 @@ void SP_DMA_READ(void)
             offC = (count*length + *CR[0x0] + i) & 0x00001FF8ul;
             offD = (count*skip + *CR[0x1] + i) & 0x00FFFFF8ul;
             i += 0x008;
-            if (offD > su_max_address) {
+            if (offD > su_max_address)
                 memset(DMEM + offC, 0x00, 8);
-                continue;
+            else
+                memcpy(DMEM + offC, DRAM + offD, 8);
+            if (offC & 0x1000) {
+                decode_IMEM(offC + 0);
+                decode_IMEM(offC + 4);
             }
-            memcpy(DMEM + offC, DRAM + offD, 8);
         } while (i < length);
     } while (count);
 
@@ -1663,132 +1825,6 @@ mwc2_func SWC2[2 * 8*2] = {
 };
 
 
-PROFILE_MODE int SPECIAL(u32 inst, u32 PC)
-{
-    unsigned int rd, rs, rt;
-
-    rd = IW_RD(inst);
-    rt = (inst >> 16) % (1 << 5);
-
-    switch (inst % 64) {
-    case 000: /* SLL */
-        SR[rd] = SR[rt] << MASK_SA(inst >> 6);
-        SR[zero] = 0x00000000;
-        break;
-    case 002: /* SRL */
-        SR[rd] = (u32)(SR[rt]) >> MASK_SA(inst >> 6);
-        SR[zero] = 0x00000000;
-        break;
-    case 003: /* SRA */
-        SR[rd] = (s32)(SR[rt]) >> MASK_SA(inst >> 6);
-        SR[zero] = 0x00000000;
-        break;
-    case 004: /* SLLV */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rt] << MASK_SA(SR[rs]);
-        SR[zero] = 0x00000000;
-        break;
-    case 006: /* SRLV */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = (u32)(SR[rt]) >> MASK_SA(SR[rs]);
-        SR[zero] = 0x00000000;
-        break;
-    case 007: /* SRAV */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = (s32)(SR[rt]) >> MASK_SA(SR[rs]);
-        SR[zero] = 0x00000000;
-        break;
-    case 011: /* JALR */
-        SR[rd] = FIT_IMEM(PC + LINK_OFF);
-        SR[zero] = 0x00000000;
-     /* Fall through. */
-    case 010: /* JR */
-        rs = SPECIAL_DECODE_RS(inst);
-        set_PC(SR[rs]);
-        return 1;
-    case 015: /* BREAK */
-        *CR[0x4] |= SP_STATUS_BROKE | SP_STATUS_HALT;
-        if (*CR[0x4] & SP_STATUS_INTR_BREAK) {
-            GET_RCP_REG(MI_INTR_REG) |= 0x00000001;
-            GET_RSP_INFO(CheckInterrupts)();
-        }
-        return -1;
-    case 040: /* ADD */
-    case 041: /* ADDU */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rs] + SR[rt];
-        SR[zero] = 0x00000000; /* needed for Rareware micro-codes */
-        break;
-    case 042: /* SUB */
-    case 043: /* SUBU */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rs] - SR[rt];
-        SR[zero] = 0x00000000;
-        break;
-    case 044: /* AND */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rs] & SR[rt];
-        SR[zero] = 0x00000000; /* needed for Rareware micro-codes */
-        break;
-    case 045: /* OR */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rs] | SR[rt];
-        SR[zero] = 0x00000000;
-        break;
-    case 046: /* XOR */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rs] ^ SR[rt];
-        SR[zero] = 0x00000000;
-        break;
-    case 047: /* NOR */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = ~(SR[rs] | SR[rt]);
-        SR[zero] = 0x00000000;
-        break;
-    case 052: /* SLT */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = ((s32)(SR[rs]) < (s32)(SR[rt]));
-        SR[zero] = 0x00000000;
-        break;
-    case 053: /* SLTU */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = ((u32)(SR[rs]) < (u32)(SR[rt]));
-        SR[zero] = 0x00000000;
-        break;
-    default:
-        res_S();
-    }
-    return 0;
-}
-
-PROFILE_MODE int REGIMM(u32 inst, u32 PC)
-{
-    const unsigned int base = (inst >> 21) % (1 << 5);
-    const unsigned int rt   = (inst >> 16) % (1 << 5);
-
-    switch (rt) {
-    case 020: /* BLTZAL */
-        SR[ra] = FIT_IMEM(PC + LINK_OFF);
-     /* Fall through. */
-    case 000: /* BLTZ */
-        if (!((s32)SR[base] < 0))
-            return 0;
-        set_PC(PC + 4*inst + SLOT_OFF);
-        break;
-    case 021: /* BGEZAL */
-        SR[ra] = FIT_IMEM(PC + LINK_OFF);
-     /* Fall through. */
-    case 001: /* BGEZ */
-        if (!((s32)SR[base] >= 0))
-            return 0;
-        set_PC(PC + 4*inst + SLOT_OFF);
-        break;
-    default:
-        res_S();
-    }
-    return 1;
-}
-
 PROFILE_MODE void MWC2_load(u32 inst)
 {
     s16 offset;
@@ -1822,24 +1858,6 @@ PROFILE_MODE void MWC2_store(u32 inst)
     SWC2[IW_RD(inst)](vt, element, offset, base);
 }
 
-PROFILE_MODE void COP0(u32 inst)
-{
-    const unsigned int rd = IW_RD(inst);
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-    const unsigned int rt = (inst >> 16) % (1 << 5);
-
-    switch (rs) {
-    case 000:
-        SP_CP0_MF(rt, rd);
-        break;
-    case 004:
-        SP_CP0_MT[rd % NUMBER_OF_CP0_REGISTERS](rt);
-        break;
-    default:
-        res_S();
-    }
-}
-
 PROFILE_MODE void COP2(u32 inst)
 {
     const unsigned int op = (inst >> 21) % (1 << 5); /* inst.R.rs */
@@ -1956,10 +1974,16 @@ PROFILE_MODE void COP2(u32 inst)
 NOINLINE void run_task(void)
 {
     register u32 PC;
+    register unsigned int op;
+    unsigned int rd, rs, rt;
+
+    for (op = 0; op < 4096; op += 4)
+        decode_IMEM(op); /* in case the host CPU wrote to IMEM */
 
     PC = FIT_IMEM(GET_RCP_REG(SP_PC_REG));
     for (;;) {
-        inst_word = *(pi32)(IMEM + FIT_IMEM(PC));
+        inst_word = decoded_IMEM[FIT_IMEM(PC) / 4].word;
+        op = decoded_IMEM[FIT_IMEM(PC) / 4].op;
 #ifdef EMULATE_STATIC_PC
         PC = (PC + 0x004);
 EX:
@@ -1973,99 +1997,208 @@ EX:
             goto RSP_halted_CPU_exit_point; /* Only BREAK and COP0 set this. */
         SR[zero] = 0x00000000; /* already handled on per-instruction basis */
 #endif
-        switch (inst_word >> 26) {
-        case 000: /* SPECIAL */
-            switch (SPECIAL(inst_word, PC)) {
-            case -1: /* BREAK */
-                goto RSP_halted_CPU_exit_point;
-            case +1: /* JR and JALR */
-                JUMP;
+        rd = IW_RD(inst_word);
+        rt = (inst_word >> 16) % (1 << 5);
+        switch (op) {
+        case SU_SLL:
+            SR[rd] = SR[rt] << MASK_SA(inst_word >> 6);
+            SR[zero] = 0x00000000;
+            break;
+        case SU_SRL:
+            SR[rd] = (u32)(SR[rt]) >> MASK_SA(inst_word >> 6);
+            SR[zero] = 0x00000000;
+            break;
+        case SU_SRA:
+            SR[rd] = (s32)(SR[rt]) >> MASK_SA(inst_word >> 6);
+            SR[zero] = 0x00000000;
+            break;
+        case SU_SLLV:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            SR[rd] = SR[rt] << MASK_SA(SR[rs]);
+            SR[zero] = 0x00000000;
+            break;
+        case SU_SRLV:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            SR[rd] = (u32)(SR[rt]) >> MASK_SA(SR[rs]);
+            SR[zero] = 0x00000000;
+            break;
+        case SU_SRAV:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            SR[rd] = (s32)(SR[rt]) >> MASK_SA(SR[rs]);
+            SR[zero] = 0x00000000;
+            break;
+        case SU_JALR:
+            SR[rd] = FIT_IMEM(PC + LINK_OFF);
+            SR[zero] = 0x00000000;
+         /* Fall through. */
+        case SU_JR:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            set_PC(SR[rs]);
+            JUMP;
+        case SU_BREAK:
+            *CR[0x4] |= SP_STATUS_BROKE | SP_STATUS_HALT;
+            if (*CR[0x4] & SP_STATUS_INTR_BREAK) {
+                GET_RCP_REG(MI_INTR_REG) |= 0x00000001;
+                GET_RSP_INFO(CheckInterrupts)();
             }
+            goto RSP_halted_CPU_exit_point;
+        case SU_ADDU:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            SR[rd] = SR[rs] + SR[rt];
+            SR[zero] = 0x00000000; /* needed for Rareware micro-codes */
             break;
-        case 001: /* REGIMM */
-            if (REGIMM(inst_word, PC) != 0)
-                JUMP;
+        case SU_SUBU:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            SR[rd] = SR[rs] - SR[rt];
+            SR[zero] = 0x00000000;
             break;
-        case 002:
+        case SU_AND:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            SR[rd] = SR[rs] & SR[rt];
+            SR[zero] = 0x00000000; /* needed for Rareware micro-codes */
+            break;
+        case SU_OR:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            SR[rd] = SR[rs] | SR[rt];
+            SR[zero] = 0x00000000;
+            break;
+        case SU_XOR:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            SR[rd] = SR[rs] ^ SR[rt];
+            SR[zero] = 0x00000000;
+            break;
+        case SU_NOR:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            SR[rd] = ~(SR[rs] | SR[rt]);
+            SR[zero] = 0x00000000;
+            break;
+        case SU_SLT:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            SR[rd] = ((s32)(SR[rs]) < (s32)(SR[rt]));
+            SR[zero] = 0x00000000;
+            break;
+        case SU_SLTU:
+            rs = SPECIAL_DECODE_RS(inst_word);
+            SR[rd] = ((u32)(SR[rs]) < (u32)(SR[rt]));
+            SR[zero] = 0x00000000;
+            break;
+        case SU_BLTZAL:
+            SR[ra] = FIT_IMEM(PC + LINK_OFF);
+         /* Fall through. */
+        case SU_BLTZ:
+            rs = (inst_word >> 21) % (1 << 5);
+            if (!((s32)SR[rs] < 0))
+                break;
+            set_PC(PC + 4*inst_word + SLOT_OFF);
+            JUMP;
+        case SU_BGEZAL:
+            SR[ra] = FIT_IMEM(PC + LINK_OFF);
+         /* Fall through. */
+        case SU_BGEZ:
+            rs = (inst_word >> 21) % (1 << 5);
+            if (!((s32)SR[rs] >= 0))
+                break;
+            set_PC(PC + 4*inst_word + SLOT_OFF);
+            JUMP;
+        case SU_REGIMM_RES:
+            res_S();
+            JUMP;
+        case SU_J:
             J(inst_word);
             JUMP;
-        case 003:
+        case SU_JAL:
             JAL(inst_word, PC);
             JUMP;
-        case 004:
+        case SU_BEQ:
             if (BEQ(inst_word, PC) != 0)
                 JUMP;
             break;
-        case 005:
+        case SU_BNE:
             if (BNE(inst_word, PC) != 0)
                 JUMP;
             break;
-        case 006:
+        case SU_BLEZ:
             if (BLEZ(inst_word, PC) != 0)
                 JUMP;
             break;
-        case 007:
+        case SU_BGTZ:
             if (BGTZ(inst_word, PC) != 0)
                 JUMP;
             break;
-        case 010: /* ADDI:  Traps don't exist on the RCP. */
-        case 011:
+        case SU_ADDIU: /* also ADDI:  Traps don't exist on the RCP. */
             ADDIU(inst_word);
             break;
-        case 012:
+        case SU_SLTI:
             SLTI(inst_word);
             break;
-        case 013:
+        case SU_SLTIU:
             SLTIU(inst_word);
             break;
-        case 014:
+        case SU_ANDI:
             ANDI(inst_word);
             break;
-        case 015:
+        case SU_ORI:
             ORI(inst_word);
             break;
-        case 016:
+        case SU_XORI:
             XORI(inst_word);
             break;
-        case 017:
+        case SU_LUI:
             LUI(inst_word);
             break;
-        case 020:
-            COP0(inst_word);
+        case SU_MFC0:
+            SP_CP0_MF(rt, rd);
+            if (GET_RCP_REG(SP_STATUS_REG) & SP_STATUS_HALT)
+                goto RSP_halted_CPU_exit_point;
+            break;
+        case SU_MTC0:
+            SP_CP0_MT[rd % NUMBER_OF_CP0_REGISTERS](rt);
             if (GET_RCP_REG(SP_STATUS_REG) & SP_STATUS_HALT)
                 goto RSP_halted_CPU_exit_point;
             break;
-        case 022:
+        case SU_MFC2:
+            MFC2(rt, rd, (inst_word >> 7) % (1 << 4));
+            break;
+        case SU_CFC2:
+            CFC2(rt, rd);
+            break;
+        case SU_MTC2:
+            MTC2(rt, rd, (inst_word >> 7) % (1 << 4));
+            break;
+        case SU_CTC2:
+            CTC2(rt, rd);
+            break;
+        case SU_VECTOR:
             COP2(inst_word);
             break;
-        case 040:
+        case SU_LB:
             LB(inst_word);
             break;
-        case 041:
+        case SU_LH:
             LH(inst_word);
             break;
-        case 043:
+        case SU_LW:
             LW(inst_word);
             break;
-        case 044:
+        case SU_LBU:
             LBU(inst_word);
             break;
-        case 045:
+        case SU_LHU:
             LHU(inst_word);
             break;
-        case 050:
+        case SU_SB:
             SB(inst_word);
             break;
-        case 051:
+        case SU_SH:
             SH(inst_word);
             break;
-        case 053:
+        case SU_SW:
             SW(inst_word);
             break;
-        case 062: /* LWC2 */
+        case SU_LWC2:
             MWC2_load(inst_word);
             break;
-        case 072: /* SWC2 */
+        case SU_SWC2:
             MWC2_store(inst_word);
             break;
         default:
@@ -2085,7 +2218,8 @@ EX:
 #else
         continue;
 set_branch_delay:
-        inst_word = *(pi32)(IMEM + FIT_IMEM(PC));
+        inst_word = decoded_IMEM[FIT_IMEM(PC) / 4].word;
+        op = decoded_IMEM[FIT_IMEM(PC) / 4].op;
         PC = FIT_IMEM(temp_PC);
         goto EX;
 #endif
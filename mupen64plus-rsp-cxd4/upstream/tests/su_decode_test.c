@@ -0,0 +1,446 @@
+/******************************************************************************\
+* Project:  Scalar Unit Decoded IMEM Test                                      *
+* Authors:  Mupen64plus development team                                       *
+* Release:  2026.10.19                                                         *
+* License:  CC0 Public Domain Dedication                                       *
+*                                                                              *
+* To the extent possible under law, the author(s) have dedicated all copyright *
+* and related and neighboring rights to this software to the public domain     *
+* worldwide. This software is distributed without any warranty.                *
+*                                                                              *
+* You should have received a copy of the CC0 Public Domain Dedication along    *
+* with this software.                                                          *
+* If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.             *
+\******************************************************************************/
+
+/*
+ * Runs micro-code through the interpreter and checks the decoded IMEM path
+ * against the interpreter that decoded every instruction as it ran it.
+ *
+ * The built-in IMEM images are generated from fixed seeds:  random scalar and
+ * vector code with branches in delay slots and reserved op-codes, a task that
+ * loads an overlay by SP DMA and jumps into it, and IMEM rewritten by the host
+ * between tasks.  The SR, VR and DMEM state after each image must hash to the
+ * values recorded with the interpreter before IMEM was decoded ahead of time,
+ * and after every task the decoded copy of IMEM must match IMEM itself.
+ *
+ * Recorded images can be given as IMEM and DMEM file pairs, the state hash of
+ * each is printed so that two builds of the plugin can be compared.
+ *
+ * Defining SU_DECODE_TEST_REFERENCE builds the test without the decoded IMEM
+ * checks, against the lto.c found on the include path.  Pointed at a tree
+ * from before IMEM was decoded ahead of time, e.g.
+ *     make su_decode_reference REFERENCE=/path/to/old/cxd4
+ * it reproduces the recorded hashes and gives the bench figures to compare
+ * with.
+ *
+ * Usage:  su_decode_test [imem.bin dmem.bin]...
+ *         su_decode_test bench
+ *   bench also prints how many RSP instructions per second the built-in
+ *   scalar-only and scalar/vector programs run at.
+ */
+
+#ifdef SU_DECODE_TEST_REFERENCE
+#include "lto.c"
+#else
+/* the decoder and its table are private to su.c */
+#include "../lto.c"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+static m64p_error stub_CoreDoCommand(m64p_command command, int length, void* data)
+{
+    memset(data, 0, length);
+    return M64ERR_SUCCESS;
+}
+static int stub_ConfigGetParamBool(m64p_handle section, const char* name)
+{
+    return 0;
+}
+static void stub_CheckInterrupts(void)
+{
+}
+
+static unsigned int RCP_registers[32];
+
+#ifndef _WIN32
+/* Running stale code usually never reaches the BREAK. */
+static void time_out(int signal_number)
+{
+    static const char text[] = "timed out, stale code is probably running\nFAILED\n";
+
+    if (write(STDOUT_FILENO, text, sizeof(text) - 1) < 0)
+        { /* branch */ }
+    _exit(1);
+}
+#endif
+
+static u32 seed;
+static u32 random_word(void)
+{ /* xorshift32 */
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed <<  5;
+    return (seed);
+}
+static unsigned int random_GPR(void)
+{ /* never $0, nor $30 which holds the loop counter, nor $31 */
+    return (random_word() % 29 + 1);
+}
+
+/*
+ * Random instruction which can't halt the task or jump out of the program.
+ * Memory accesses and vector loads and stores stay within DMEM.
+ */
+static u32 random_instruction(int scalar_only)
+{
+    static const u8 SPECIAL_functions[] = {
+        000, 002, 003, 004, 006, 007, 041, 043, 044, 045, 046, 047, 052, 053,
+        001, 030, /* reserved */
+    };
+    static const u8 immediate_ops[] = { 011, 012, 013, 014, 015, 016, 017 };
+    static const u8 memory_ops[] = { 040, 041, 043, 044, 045, 050, 051, 053 };
+    static const u8 vector_functions[] = {
+        0x00, 0x01, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0C, 0x0D, 0x0E, 0x0F,
+        0x10, 0x11, 0x13, 0x14, 0x15, 0x1D, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25,
+        0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x30, 0x31, 0x32, 0x33,
+        0x34, 0x35, 0x36, 0x37,
+    };
+    static const u8 COP2_moves[] = { 000, 002, 004, 006 };
+    const u32 rs = random_GPR(), rt = random_GPR(), rd = random_GPR();
+    unsigned int move;
+
+    switch (random_word() % (scalar_only ? 6 : 10)) {
+    case 0:
+    case 1:
+    case 2:
+        return (rs << 21) | (rt << 16) | (rd << 11)
+             | ((random_word() % 32) << 6)
+             | SPECIAL_functions[random_word() % sizeof(SPECIAL_functions)];
+    case 3:
+    case 4:
+        return (immediate_ops[random_word() % sizeof(immediate_ops)] << 26)
+             | (rs << 21) | (rt << 16) | (random_word() & 0xFFFF);
+    case 5:
+        return (memory_ops[random_word() % sizeof(memory_ops)] << 26)
+             | (rt << 16) | (random_word() % 0xF00 & ~3u);
+    case 6:
+        move = COP2_moves[random_word() % sizeof(COP2_moves)];
+        return (022u << 26) | (move << 21) | (rt << 16)
+             | ((move & 2 ? random_word() % 3 : random_word() % 32) << 11)
+             | ((random_word() % 16) << 7);
+    case 7: /* LWC2 and SWC2 */
+        return ((random_word() & 1 ? 062u : 072u) << 26)
+             | ((random_word() % 32) << 16) | ((random_word() % 12) << 11)
+             | ((random_word() % 16) << 7) | (random_word() % 64);
+    default:
+        return (022u << 26) | ((0x10 | random_word() % 16) << 21)
+             | ((random_word() % 32) << 16) | ((random_word() % 32) << 11)
+             | ((random_word() % 32) << 6)
+             | vector_functions[random_word() % sizeof(vector_functions)];
+    }
+}
+
+/*
+ * A loop of random code run `loops` times, then BREAK.  Short forward
+ * branches, REGIMM ones included, land within the loop body.  Reserved
+ * REGIMM op-codes are left out, they branch to whatever target came last.
+ */
+static void make_program(u32 program_seed, unsigned int body, unsigned int loops, int scalar_only)
+{
+    u32* program = (u32 *)IMEM;
+    unsigned int i = 0, start;
+
+    seed = program_seed;
+    memset(IMEM, 0, 4096);
+    program[i++] = (015u << 26) | (30 << 16) | loops; /* ORI $30, $0, loops */
+    start = i;
+    while (i < start + body) {
+        const unsigned int left = start + body - i;
+        const u32 offset = 1 + random_word() % 3;
+        const u32 op = 004 + random_word() % 4;
+
+        if (left > 5 && random_word() % 12 == 0) {
+            if (op >= 006) /* BLEZ, BGTZ */
+                program[i++] = (op << 26) | (random_GPR() << 21) | offset;
+            else if (random_word() % 4 == 0) /* BLTZ, BGEZ, BLTZAL, BGEZAL */
+                program[i++] = (001u << 26) | (random_GPR() << 21)
+                             | ((random_word() % 2 ? 020u : 0) + random_word() % 2) << 16
+                             | offset;
+            else /* BEQ, BNE */
+                program[i++] = (op << 26) | (random_GPR() << 21) | (random_GPR() << 16) | offset;
+        }
+        program[i++] = random_instruction(scalar_only);
+    }
+    program[i++] = (011u << 26) | (30 << 21) | (30 << 16) | 0xFFFF; /* ADDIU $30, $30, -1 */
+    program[i] = (005u << 26) | (30 << 21) | ((start - i - 1) & 0xFFFF); /* BNE $30, $0, start */
+    i++;
+    program[i++] = 0x00000000; /* NOP */
+    program[i++] = 0x0000000D; /* BREAK */
+}
+
+/*
+ * The first task runs the code at IMEM 0x100, then loads an overlay from
+ * RDRAM over it by SP DMA and runs the overlay.
+ */
+static void make_overlay_program(void)
+{
+    u32* program = (u32 *)IMEM;
+    u32* overlay = (u32 *)(DRAM + 0x1000);
+
+    memset(IMEM, 0, 4096);
+    program[0x40] = (015u << 26) | (1 << 16) | 0x5555; /* ORI $1, $0, 0x5555 */
+    program[0x41] = 0x0000000D; /* BREAK */
+    overlay[0] = (015u << 26) | (1 << 16) | 0x1234; /* ORI $1, $0, 0x1234 */
+    overlay[1] = 0x0000000D; /* BREAK */
+
+    program[0] = (015u << 26) | (2 << 16) | 0x1100; /* ORI $2, $0, 0x1100 */
+    program[1] = (020u << 26) | (004 << 21) | (2 << 16) | (0 << 11); /* MTC0 $2, SP_MEM_ADDR */
+    program[2] = (015u << 26) | (3 << 16) | 0x1000; /* ORI $3, $0, 0x1000 */
+    program[3] = (020u << 26) | (004 << 21) | (3 << 16) | (1 << 11); /* MTC0 $3, SP_DRAM_ADDR */
+    program[4] = (015u << 26) | (4 << 16) | 7; /* ORI $4, $0, 7 */
+    program[5] = (020u << 26) | (004 << 21) | (4 << 16) | (2 << 11); /* MTC0 $4, SP_RD_LEN */
+    program[6] = (002u << 26) | 0x40; /* J 0x100 */
+    program[7] = 0x00000000;
+}
+
+static void run(void)
+{
+    RCP_registers[5] = 0x00000000; /* SP_STATUS */
+    RCP_registers[8] = 0x00000000; /* SP_PC */
+    DoRspCycles(1);
+}
+
+static int check_decoded_IMEM(const char* image)
+{
+#ifndef SU_DECODE_TEST_REFERENCE
+    register unsigned int slot;
+
+    for (slot = 0; slot < 4096 / 4; slot++) {
+        const u32 word = *(pi32)(IMEM + 4*slot);
+
+        if (decoded_IMEM[slot].word != word || decoded_IMEM[slot].op != decode_SU(word)) {
+            printf("%s: IMEM 0x%03X is %08X but decoded from %08X\n",
+                image, 4*slot, word, decoded_IMEM[slot].word);
+            return 1;
+        }
+    }
+#endif
+    return 0;
+}
+
+static u64 hash_state(u64 hash)
+{
+    const u8* state[3];
+    size_t length[3];
+    register size_t i, j;
+
+    state[0] = (const u8 *)SR;
+    length[0] = 32 * sizeof(SR[0]);
+    state[1] = (const u8 *)VR;
+    length[1] = sizeof(VR);
+    state[2] = (const u8 *)DMEM;
+    length[2] = 4096;
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < length[i]; j++)
+            hash = (hash ^ state[i][j]) * 0x00000100000001B3ull;
+    return (hash);
+}
+
+static void reset_state(unsigned int task)
+{
+    register unsigned int i;
+
+    memset(SR, 0, 32 * sizeof(SR[0]));
+    memset(VR, 0, sizeof(VR));
+    for (i = 0; i < 0xF00; i++)
+        DMEM[i] = (u8)(7*i + task);
+    memset(DMEM + 0xF00, 0, 0x100);
+}
+
+/* state hashes of the built-in images, as the per-instruction decoder left them */
+static const u64 recorded_hash[] = {
+    0x846D6F7E792B5470ull,
+    0x5E689C9DFB8970FDull,
+    0x3AD8B42EC642886Cull,
+    0x8414733C9FE8396Cull,
+    0x75FBACE99C04BE5Aull,
+    0x966CB6B84C60F072ull,
+    0xB842561E9F433CE1ull,
+    0x38E2FB5B3AD77DAEull,
+    0xF1EF45FCF81BFA17ull,
+    0x7E474B93721D585Dull,
+};
+
+static int run_builtin_images(void)
+{
+    const int image_count = 8;
+    u64 hash;
+    char name[32];
+    int image, task, failed = 0;
+
+    for (image = 0; image <= image_count + 1; image++) {
+        hash = 0xCBF29CE484222325ull;
+        if (image < image_count) {
+            sprintf(name, "image %d", image);
+            make_program(1 + image, 600, 500, image % 2);
+            for (task = 0; task < 4; task++) {
+                reset_state(task);
+                run();
+                failed |= check_decoded_IMEM(name);
+                hash = hash_state(hash);
+
+                /* the host rewrites a word of the loop body between tasks */
+                *(pi32)(IMEM + 4*(8 + task)) = random_instruction(image % 2);
+            }
+        } else if (image == image_count) {
+            strcpy(name, "DMA overlay");
+            reset_state(0);
+            make_overlay_program();
+            run();
+            failed |= check_decoded_IMEM(name);
+            if (SR[1] != 0x1234) {
+                printf("%s: $1 is %04X, the overlay didn't run\n", name, SR[1]);
+                failed = 1;
+            }
+            hash = hash_state(hash);
+        } else {
+            strcpy(name, "host write");
+            reset_state(0);
+            make_overlay_program();
+            run();
+            *(pi32)(IMEM + 0x100) = (015u << 26) | (1 << 16) | 0x4321; /* ORI $1, $0, 0x4321 */
+            *(pi32)(IMEM + 0x000) = (002u << 26) | 0x40; /* J 0x100 */
+            run();
+            failed |= check_decoded_IMEM(name);
+            if (SR[1] != 0x4321) {
+                printf("%s: $1 is %04X, stale code ran\n", name, SR[1]);
+                failed = 1;
+            }
+            hash = hash_state(hash);
+        }
+
+        if (image < (int)(sizeof(recorded_hash) / sizeof(recorded_hash[0]))
+         && hash != recorded_hash[image]) {
+            printf("%s: state hash %016llX, recorded %016llX\n",
+                name, (unsigned long long)hash, (unsigned long long)recorded_hash[image]);
+            failed = 1;
+        } else {
+            printf("%s: state hash %016llX\n", name, (unsigned long long)hash);
+        }
+    }
+    return (failed);
+}
+
+/*
+ * Each task runs the loop body, ADDIU, BNE and its delay slot `loops` times,
+ * minus the few instructions skipped by taken forward branches.
+ */
+static void bench(void)
+{
+    const unsigned int body = 600, loops = 500, tasks = 20;
+    int scalar_only;
+    unsigned int task;
+
+    for (scalar_only = 1; scalar_only >= 0; scalar_only--) {
+        const double instructions = (double)(body + 3) * loops * tasks;
+        clock_t start;
+        double seconds;
+
+        make_program(1 + !scalar_only, body, loops, scalar_only);
+        start = clock();
+        for (task = 0; task < tasks; task++) {
+            reset_state(task);
+            run();
+        }
+        seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        printf("%s: %.1f M instructions per second\n",
+            scalar_only ? "scalar-only" : "scalar/vector", instructions / seconds * 1e-6);
+    }
+}
+
+static int load_image(const char* path, u8* destination)
+{
+    FILE* stream = fopen(path, "rb");
+    size_t length;
+
+    if (stream == NULL) {
+        printf("can't open %s\n", path);
+        return 1;
+    }
+    memset(destination, 0, 4096);
+    length = fread(destination, 1, 4096, stream);
+    fclose(stream);
+    return (length == 0);
+}
+
+int main(int argc, char** argv)
+{
+    RSP_INFO info;
+    int failed = 0;
+    int i;
+
+    ConfigGetParamBool = stub_ConfigGetParamBool;
+    CoreDoCommand = stub_CoreDoCommand;
+
+    memset(&info, 0, sizeof(info));
+    info.RDRAM = calloc(16 << 20, 1); /* InitiateRSP probes 16 MiB */
+    info.DMEM = calloc(8192, 1);
+    info.IMEM = info.DMEM + 4096;
+    info.MI_INTR_REG = &RCP_registers[0];
+    info.SP_MEM_ADDR_REG = &RCP_registers[1];
+    info.SP_DRAM_ADDR_REG = &RCP_registers[2];
+    info.SP_RD_LEN_REG = &RCP_registers[3];
+    info.SP_WR_LEN_REG = &RCP_registers[4];
+    info.SP_STATUS_REG = &RCP_registers[5];
+    info.SP_DMA_FULL_REG = &RCP_registers[6];
+    info.SP_DMA_BUSY_REG = &RCP_registers[7];
+    info.SP_PC_REG = &RCP_registers[8];
+    info.SP_SEMAPHORE_REG = &RCP_registers[9];
+    info.DPC_START_REG = &RCP_registers[10];
+    info.DPC_END_REG = &RCP_registers[11];
+    info.DPC_CURRENT_REG = &RCP_registers[12];
+    info.DPC_STATUS_REG = &RCP_registers[13];
+    info.DPC_CLOCK_REG = &RCP_registers[14];
+    info.DPC_BUFBUSY_REG = &RCP_registers[15];
+    info.DPC_PIPEBUSY_REG = &RCP_registers[16];
+    info.DPC_TMEM_REG = &RCP_registers[17];
+    info.CheckInterrupts = stub_CheckInterrupts;
+    InitiateRSP(info, NULL);
+#ifndef _WIN32
+    signal(SIGALRM, time_out);
+    alarm(60);
+#endif
+
+    if (argc == 2 && strcmp(argv[1], "bench") == 0) {
+        failed = run_builtin_images();
+#ifndef _WIN32
+        alarm(0);
+#endif
+        bench();
+        argc = 1;
+    } else if (argc < 2) {
+        failed = run_builtin_images();
+    }
+    for (i = 1; i + 1 < argc; i += 2) {
+        memset(SR, 0, 32 * sizeof(SR[0]));
+        memset(VR, 0, sizeof(VR));
+        if (load_image(argv[i], IMEM) || load_image(argv[i + 1], DMEM)) {
+            failed = 1;
+            continue;
+        }
+        run();
+        failed |= check_decoded_IMEM(argv[i]);
+        printf("%s: state hash %016llX\n",
+            argv[i], (unsigned long long)hash_state(0xCBF29CE484222325ull));
+    }
+
+    puts(failed ? "FAILED" : "OK");
+    return (failed);
+}
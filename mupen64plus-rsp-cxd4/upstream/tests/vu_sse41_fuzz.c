@@ -0,0 +1,227 @@
+/******************************************************************************\
+* Project:  Vector Unit SSE4.1 Backend Differential Fuzzer                     *
+* Authors:  Mupen64plus development team                                       *
+* Release:  2026.10.19                                                         *
+* License:  CC0 Public Domain Dedication                                       *
+*                                                                              *
+* To the extent possible under law, the author(s) have dedicated all copyright *
+* and related and neighboring rights to this software to the public domain     *
+* worldwide. This software is distributed without any warranty.                *
+*                                                                              *
+* You should have received a copy of the CC0 Public Domain Dedication along    *
+* with this software.                                                          *
+* If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.             *
+\******************************************************************************/
+
+/*
+ * Runs every SSE4.1 vector operation and the SSE2 one it replaces on the same
+ * random operands, accumulators and flags, and compares the results.
+ *
+ * Usage:  vu_sse41_fuzz [iterations per operation] [bench]
+ *   bench also prints the time of each operation with both backends, over
+ *   the same operands and starting from the same accumulators and flags.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../vu/vu.h"
+#include "../vu/multiply.h"
+#include "../vu/select.h"
+#include "../vu/sse41.h"
+
+/* normally provided by module.c and su.c */
+u32 inst_word;
+void message(const char* body)
+{
+    fputs(body, stderr);
+}
+
+#ifdef VU_HAVE_SSE41
+
+typedef v16 (*vector_op)(v16 vs, v16 vt);
+
+static const struct {
+    const char* name;
+    vector_op sse2;
+    vector_op sse41;
+} ops[] = {
+    { "VMACU", VMACU, macu_v_sse41 },
+    { "VLT",   VLT,   lt_v_sse41 },
+    { "VEQ",   VEQ,   eq_v_sse41 },
+    { "VNE",   VNE,   ne_v_sse41 },
+    { "VGE",   VGE,   ge_v_sse41 },
+    { "VCL",   VCL,   cl_v_sse41 },
+    { "VCH",   VCH,   ch_v_sse41 },
+    { "VCR",   VCR,   cr_v_sse41 },
+    { "VMRG",  VMRG,  mrg_v_sse41 },
+};
+
+/* everything a vector operation reads or writes besides its operands */
+typedef struct {
+    i16 acc[3][N];
+    i16 ne[N];
+    i16 co[N];
+    i16 clip[N];
+    i16 comp[N];
+    i16 vce[N];
+    i16 result[N];
+} vu_state;
+
+static u32 seed = 1234567;
+
+/*
+ * Random element, biased towards the values where signed and unsigned
+ * saturation and the clip tests change behavior.
+ */
+static i16 random_element(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    switch ((seed >> 8) & 7) {
+    case 0:  return 0;
+    case 1:  return (i16)0x8000;
+    case 2:  return 0x7FFF;
+    case 3:  return -1;
+    default: return (i16)(seed >> 12);
+    }
+}
+
+static void load_state(const vu_state* state)
+{
+    memcpy(VACC, state->acc, sizeof(VACC));
+    memcpy(cf_ne, state->ne, sizeof(cf_ne));
+    memcpy(cf_co, state->co, sizeof(cf_co));
+    memcpy(cf_clip, state->clip, sizeof(cf_clip));
+    memcpy(cf_comp, state->comp, sizeof(cf_comp));
+    memcpy(cf_vce, state->vce, sizeof(cf_vce));
+}
+
+static void save_state(vu_state* state, v16 result)
+{
+    memcpy(state->acc, VACC, sizeof(VACC));
+    memcpy(state->ne, cf_ne, sizeof(cf_ne));
+    memcpy(state->co, cf_co, sizeof(cf_co));
+    memcpy(state->clip, cf_clip, sizeof(cf_clip));
+    memcpy(state->comp, cf_comp, sizeof(cf_comp));
+    memcpy(state->vce, cf_vce, sizeof(cf_vce));
+    *(v16 *)state->result = result;
+}
+
+enum { BENCH_OPERANDS = 1024, BENCH_ROUNDS = 20000 };
+
+static ALIGNED i16 bench_vs[BENCH_OPERANDS][N];
+static ALIGNED i16 bench_vt[BENCH_OPERANDS][N];
+static ALIGNED i16 bench_result[N];
+
+/*
+ * Nanoseconds per call of op, which keeps its accumulators and flags from
+ * one call to the next, as a microcode running a run of them would.
+ */
+static double bench_op(vector_op op, const vu_state* input)
+{
+    clock_t start;
+    long round;
+    register int k;
+
+    load_state(input);
+    start = clock();
+    for (round = 0; round < BENCH_ROUNDS; round++)
+        for (k = 0; k < BENCH_OPERANDS; k++)
+            *(v16 *)bench_result = op(*(v16 *)bench_vs[k], *(v16 *)bench_vt[k]);
+    return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9
+         / ((double)BENCH_ROUNDS * BENCH_OPERANDS);
+}
+
+static void bench(void)
+{
+    vu_state input;
+    size_t op;
+    register int k, j;
+
+    memset(&input, 0, sizeof(input));
+    for (k = 0; k < BENCH_OPERANDS; k++)
+        for (j = 0; j < N; j++) {
+            bench_vs[k][j] = random_element();
+            bench_vt[k][j] = random_element();
+        }
+    for (j = 0; j < N; j++) {
+        input.acc[LO][j] = random_element();
+        input.acc[MD][j] = random_element();
+        input.acc[HI][j] = random_element();
+        input.ne[j] = random_element() & 1;
+        input.co[j] = random_element() & 1;
+        input.vce[j] = random_element() & 1;
+    }
+
+    for (op = 0; op < sizeof(ops) / sizeof(ops[0]); op++) {
+        double sse2 = bench_op(ops[op].sse2, &input);
+        double sse41 = bench_op(ops[op].sse41, &input);
+
+        printf("%s: %.2f ns SSE2, %.2f ns SSE4.1, %.2fx\n", ops[op].name,
+               sse2, sse41, sse2 / sse41);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ALIGNED i16 vs[N], vt[N];
+    vu_state input, sse2_output, sse41_output;
+    int do_bench = (argc > 1 && strcmp(argv[argc - 1], "bench") == 0);
+    long iterations = (argc > 1 + do_bench) ? atol(argv[1]) : 1000000;
+    long i;
+    size_t op;
+    int failed = 0;
+    register int k;
+
+    if (!select_VU_backend()) {
+        puts("SSE4.1 is not supported by this CPU, skipped.");
+        return 0;
+    }
+
+    for (op = 0; op < sizeof(ops) / sizeof(ops[0]); op++) {
+        for (i = 0; i < iterations; i++) {
+            memset(&input, 0, sizeof(input));
+            for (k = 0; k < N; k++) {
+                vs[k] = random_element();
+                vt[k] = random_element();
+                input.acc[LO][k] = random_element();
+                input.acc[MD][k] = random_element();
+                input.acc[HI][k] = random_element();
+                input.ne[k] = random_element() & 1;
+                input.co[k] = random_element() & 1;
+                input.clip[k] = random_element() & 1;
+                input.comp[k] = random_element() & 1;
+                input.vce[k] = random_element() & 1;
+            }
+
+            load_state(&input);
+            save_state(&sse2_output, ops[op].sse2(*(v16 *)vs, *(v16 *)vt));
+            load_state(&input);
+            save_state(&sse41_output, ops[op].sse41(*(v16 *)vs, *(v16 *)vt));
+
+            if (memcmp(&sse2_output, &sse41_output, sizeof(vu_state)) != 0) {
+                printf("%s: mismatch at iteration %ld\n", ops[op].name, i);
+                failed = 1;
+                break;
+            }
+        }
+        if (i == iterations)
+            printf("%s: %ld random inputs match\n", ops[op].name, iterations);
+    }
+
+    if (do_bench)
+        bench();
+    return (failed);
+}
+
+#else
+
+int main(void)
+{
+    puts("Built without the SSE4.1 backend, skipped.");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,335 @@
+/******************************************************************************\
+* Project:  MSP Emulation Layer for Vector Unit SSE4.1 Operations              *
+* Authors:  Mupen64plus development team                                       *
+* Release:  2026.10.19                                                         *
+* License:  CC0 Public Domain Dedication                                       *
+*                                                                              *
+* To the extent possible under law, the author(s) have dedicated all copyright *
+* and related and neighboring rights to this software to the public domain     *
+* worldwide. This software is distributed without any warranty.                *
+*                                                                              *
+* You should have received a copy of the CC0 Public Domain Dedication along    *
+* with this software.                                                          *
+* If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.             *
+\******************************************************************************/
+
+#include "sse41.h"
+
+#ifdef VU_HAVE_SSE41
+
+/*
+ * Only the functions in this file may use SSE4.1, and only once
+ * select_VU_backend() has confirmed the host supports it, so the rest of
+ * the plugin keeps its SSE2 baseline.
+ */
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SSE41_TARGET
+#else
+#define SSE41_TARGET    __attribute__((target("sse4.1")))
+#endif
+#include <smmintrin.h>
+
+/*
+ * The flags registers are stored as one Boolean (0 or 1) per element.
+ */
+static INLINE SSE41_TARGET v16 load_mask(const i16* flags)
+{ /* 0 or 1 to 0x0000 or 0xFFFF */
+    return _mm_sub_epi16(_mm_setzero_si128(), *(const v16 *)flags);
+}
+static INLINE SSE41_TARGET void store_mask(i16* flags, v16 mask)
+{ /* 0x0000 or 0xFFFF to 0 or 1 */
+    *(v16 *)flags = _mm_srli_epi16(mask, 15);
+}
+static INLINE SSE41_TARGET void wipe_mask(i16* flags)
+{
+    *(v16 *)flags = _mm_setzero_si128();
+}
+
+/*
+ * PMAXUW gives us unsigned comparisons in two instructions instead of the
+ * saturating-subtract emulation SSE2 needs.
+ */
+static INLINE SSE41_TARGET v16 cmpge_epu16(v16 dst, v16 src)
+{
+    return _mm_cmpeq_epi16(_mm_max_epu16(dst, src), dst);
+}
+static INLINE SSE41_TARGET v16 cmplt_epu16(v16 dst, v16 src)
+{
+    return _mm_xor_si128(cmpge_epu16(dst, src), _mm_set1_epi16(-1));
+}
+
+VECTOR_OPERATION SSE41_TARGET macu_v_sse41(v16 vs, v16 vt)
+{
+    v16 acc_hi, acc_md, acc_lo;
+    v16 prod_hi, prod_lo;
+    v16 overflow, overflow_new;
+    v16 prod_neg, old_acc_md;
+    v16 clamped, too_big;
+
+/*
+ * Accumulation is the same as VMACF's.  Only the clamp differs.
+ */
+    prod_hi = _mm_mulhi_epi16(vs, vt);
+    prod_lo = _mm_mullo_epi16(vs, vt);
+    prod_neg = _mm_srli_epi16(prod_hi, 15);
+
+    overflow = _mm_srli_epi16(prod_lo, 15);
+    prod_lo = _mm_add_epi16(prod_lo, prod_lo);
+    prod_hi = _mm_add_epi16(prod_hi, prod_hi);
+    prod_hi = _mm_or_si128(prod_hi, overflow);
+
+    acc_lo = *(v16 *)VACC_L;
+    acc_md = *(v16 *)VACC_M;
+    acc_hi = *(v16 *)VACC_H;
+
+    acc_lo = _mm_add_epi16(acc_lo, prod_lo);
+    *(v16 *)VACC_L = acc_lo;
+    overflow = cmplt_epu16(acc_lo, prod_lo);
+
+    acc_md = _mm_add_epi16(acc_md, prod_hi);
+    overflow_new = cmplt_epu16(acc_md, prod_hi);
+    old_acc_md = acc_md;
+    acc_md = _mm_sub_epi16(acc_md, overflow);
+    overflow = cmplt_epu16(acc_md, old_acc_md);
+    *(v16 *)VACC_M = acc_md;
+    overflow = _mm_or_si128(overflow, overflow_new);
+
+    acc_hi = _mm_sub_epi16(acc_hi, overflow);
+    acc_hi = _mm_sub_epi16(acc_hi, prod_neg);
+    *(v16 *)VACC_H = acc_hi;
+
+/*
+ * unsigned clamp of accumulator-mid:
+ *     if (acc_47..16 < 0) result = 0x0000;
+ *     else if (acc_47..16 > +32767) result = 0xFFFF;
+ *     else { result = acc_31..16; }
+ */
+    vt = _mm_unpackhi_epi16(acc_md, acc_hi);
+    vs = _mm_unpacklo_epi16(acc_md, acc_hi);
+    clamped = _mm_packs_epi32(vs, vt);
+    too_big = _mm_cmpgt_epi16(clamped, acc_md);
+    vs = _mm_andnot_si128(_mm_srai_epi16(clamped, 15), clamped);
+    return _mm_or_si128(vs, too_big);
+}
+
+VECTOR_OPERATION SSE41_TARGET lt_v_sse41(v16 vs, v16 vt)
+{
+    v16 eq, comp;
+
+    eq = _mm_cmpeq_epi16(vs, vt);
+    eq = _mm_and_si128(eq, load_mask(cf_ne));
+    eq = _mm_and_si128(eq, load_mask(cf_co));
+    comp = _mm_or_si128(_mm_cmplt_epi16(vs, vt), eq);
+
+    vs = _mm_blendv_epi8(vt, vs, comp);
+    *(v16 *)VACC_L = vs;
+    store_mask(cf_comp, comp);
+
+    wipe_mask(cf_ne);
+    wipe_mask(cf_co);
+    wipe_mask(cf_clip);
+    return (vs);
+}
+
+VECTOR_OPERATION SSE41_TARGET eq_v_sse41(v16 vs, v16 vt)
+{
+    v16 comp;
+
+    comp = _mm_andnot_si128(load_mask(cf_ne), _mm_cmpeq_epi16(vs, vt));
+    *(v16 *)VACC_L = vt;
+    store_mask(cf_comp, comp);
+
+    wipe_mask(cf_ne);
+    wipe_mask(cf_co);
+    wipe_mask(cf_clip);
+    return (vt);
+}
+
+VECTOR_OPERATION SSE41_TARGET ne_v_sse41(v16 vs, v16 vt)
+{
+    v16 comp;
+
+    comp = _mm_xor_si128(_mm_cmpeq_epi16(vs, vt), _mm_set1_epi16(-1));
+    comp = _mm_or_si128(comp, load_mask(cf_ne));
+    *(v16 *)VACC_L = vs;
+    store_mask(cf_comp, comp);
+
+    wipe_mask(cf_ne);
+    wipe_mask(cf_co);
+    wipe_mask(cf_clip);
+    return (vs);
+}
+
+VECTOR_OPERATION SSE41_TARGET ge_v_sse41(v16 vs, v16 vt)
+{
+    v16 eq, comp;
+
+    eq = _mm_and_si128(load_mask(cf_ne), load_mask(cf_co));
+    eq = _mm_andnot_si128(eq, _mm_cmpeq_epi16(vs, vt));
+    comp = _mm_or_si128(_mm_cmpgt_epi16(vs, vt), eq);
+
+    vs = _mm_blendv_epi8(vt, vs, comp);
+    *(v16 *)VACC_L = vs;
+    store_mask(cf_comp, comp);
+
+    wipe_mask(cf_ne);
+    wipe_mask(cf_co);
+    wipe_mask(cf_clip);
+    return (vs);
+}
+
+VECTOR_OPERATION SSE41_TARGET cl_v_sse41(v16 vs, v16 vt)
+{
+    v16 vc, diff, sn, eq, vce;
+    v16 lz, uz, gen, len;
+    v16 ge, le, cmp;
+
+    eq = _mm_xor_si128(load_mask(cf_ne), _mm_set1_epi16(-1));
+    sn = load_mask(cf_co);
+    vce = load_mask(cf_vce);
+
+    vc = _mm_xor_si128(vt, sn);
+    vc = _mm_sub_epi16(vc, sn); /* conditional negation, if sn */
+    diff = _mm_sub_epi16(vs, vc);
+
+    uz = _mm_add_epi16(vs, vt);
+    uz = cmpge_epu16(uz, vs); /* (u16)VS + (u16)VT did not carry out */
+    lz = _mm_cmpeq_epi16(diff, _mm_setzero_si128());
+    gen = _mm_or_si128(lz, uz);
+    len = _mm_and_si128(lz, uz);
+    gen = _mm_and_si128(gen, vce);
+    len = _mm_andnot_si128(vce, len);
+    len = _mm_or_si128(len, gen);
+    gen = cmpge_epu16(vs, vc);
+
+    cmp = _mm_and_si128(eq, sn);
+    le = _mm_blendv_epi8(load_mask(cf_comp), len, cmp);
+    cmp = _mm_andnot_si128(sn, eq);
+    ge = _mm_blendv_epi8(load_mask(cf_clip), gen, cmp);
+
+    cmp = _mm_blendv_epi8(ge, le, sn);
+    vs = _mm_blendv_epi8(vs, vc, cmp);
+    *(v16 *)VACC_L = vs;
+
+    wipe_mask(cf_ne);
+    wipe_mask(cf_co);
+    store_mask(cf_clip, ge);
+    store_mask(cf_comp, le);
+    wipe_mask(cf_vce);
+    return (vs);
+}
+
+VECTOR_OPERATION SSE41_TARGET ch_v_sse41(v16 vs, v16 vt)
+{
+    v16 vc, diff, sn, eq, vce, cch;
+    v16 ge, le;
+
+    cch = _mm_cmpeq_epi16(vt, _mm_set1_epi16(-32768));
+    sn = _mm_xor_si128(vs, vt);
+    sn = _mm_srai_epi16(sn, 15);
+    vc = _mm_xor_si128(vt, sn);
+    vce = _mm_cmpeq_epi16(vs, vc);
+    vce = _mm_and_si128(vce, sn);
+
+    vc = _mm_sub_epi16(vc, _mm_andnot_si128(cch, sn)); /* -(-32768) stays. */
+    eq = _mm_cmpeq_epi16(vs, vc);
+    eq = _mm_andnot_si128(cch, eq);
+    eq = _mm_or_si128(eq, vce);
+
+    diff = _mm_or_si128(sn, vs);
+    ge = _mm_cmpgt_epi16(vt, diff);
+    ge = _mm_xor_si128(ge, _mm_set1_epi16(-1)); /* (sn | VS) >= VT */
+
+    diff = _mm_sub_epi16(vc, vs);
+    diff = _mm_cmpgt_epi16(diff, _mm_set1_epi16(-1)); /* VC - VS >= 0 */
+    le = _mm_srai_epi16(vt, 15); /* VT < 0 */
+    le = _mm_blendv_epi8(le, diff, sn);
+
+    diff = _mm_blendv_epi8(ge, le, sn);
+    vs = _mm_blendv_epi8(vs, vc, diff);
+    *(v16 *)VACC_L = vs;
+
+    store_mask(cf_clip, ge);
+    store_mask(cf_comp, le);
+    store_mask(cf_ne, _mm_xor_si128(eq, _mm_set1_epi16(-1)));
+    store_mask(cf_co, sn);
+    store_mask(cf_vce, vce);
+    return (vs);
+}
+
+VECTOR_OPERATION SSE41_TARGET cr_v_sse41(v16 vs, v16 vt)
+{
+    v16 vc, sn, ge, le, cmp;
+    v16 ones;
+
+    ones = _mm_set1_epi16(-1);
+    sn = _mm_xor_si128(vs, vt);
+    sn = _mm_srai_epi16(sn, 15);
+
+    cmp = _mm_xor_si128(_mm_and_si128(vs, sn), ones);
+    le = _mm_xor_si128(_mm_cmpgt_epi16(vt, cmp), ones); /* VT <= ~(VS & sn) */
+    cmp = _mm_or_si128(vs, sn);
+    ge = _mm_xor_si128(_mm_cmpgt_epi16(vt, cmp), ones); /* (VS | sn) >= VT */
+    le = _mm_srli_epi16(le, 15);
+    ge = _mm_srli_epi16(ge, 15);
+    vc = _mm_xor_si128(vt, sn);
+
+/*
+ * select.c's merge() is arithmetic (fail + cmp*(pass - fail)), and VCR hands
+ * it sn as ~0 rather than 1, so a blend would not be bit-exact here.
+ */
+    cmp = _mm_sub_epi16(ge, _mm_and_si128(sn, _mm_sub_epi16(le, ge)));
+    vs = _mm_add_epi16(vs, _mm_mullo_epi16(cmp, _mm_sub_epi16(vc, vs)));
+    *(v16 *)VACC_L = vs;
+
+    wipe_mask(cf_ne);
+    wipe_mask(cf_co);
+    *(v16 *)cf_clip = ge;
+    *(v16 *)cf_comp = le;
+    wipe_mask(cf_vce);
+    return (vs);
+}
+
+VECTOR_OPERATION SSE41_TARGET mrg_v_sse41(v16 vs, v16 vt)
+{
+    vs = _mm_blendv_epi8(vt, vs, load_mask(cf_comp));
+    *(v16 *)VACC_L = vs;
+    return (vs);
+}
+
+static int cpu_has_sse41(void)
+{
+#ifdef _MSC_VER
+    int info[4];
+
+    __cpuid(info, 1);
+    return (info[2] >> 19) & 1;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+#endif
+}
+#endif
+
+int select_VU_backend(void)
+{
+#ifdef VU_HAVE_SSE41
+    if (!cpu_has_sse41())
+        return 0;
+
+    COP2_C2[011] = macu_v_sse41;
+
+    COP2_C2[040] = lt_v_sse41;
+    COP2_C2[041] = eq_v_sse41;
+    COP2_C2[042] = ne_v_sse41;
+    COP2_C2[043] = ge_v_sse41;
+    COP2_C2[044] = cl_v_sse41;
+    COP2_C2[045] = ch_v_sse41;
+    COP2_C2[046] = cr_v_sse41;
+    COP2_C2[047] = mrg_v_sse41;
+    return 1;
+#else
+    return 0;
+#endif
+}
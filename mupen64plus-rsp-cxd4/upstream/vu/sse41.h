@@ -0,0 +1,50 @@
+/******************************************************************************\
+* Project:  MSP Emulation Layer for Vector Unit SSE4.1 Operations              *
+* Authors:  Mupen64plus development team                                       *
+* Release:  2026.10.19                                                         *
+* License:  CC0 Public Domain Dedication                                       *
+*                                                                              *
+* To the extent possible under law, the author(s) have dedicated all copyright *
+* and related and neighboring rights to this software to the public domain     *
+* worldwide. This software is distributed without any warranty.                *
+*                                                                              *
+* You should have received a copy of the CC0 Public Domain Dedication along    *
+* with this software.                                                          *
+* If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.             *
+\******************************************************************************/
+
+#ifndef _SSE41_H_
+#define _SSE41_H_
+
+#include "vu.h"
+
+/*
+ * SSE4.1 versions of the vector operations that gain the most from native
+ * blends and unsigned 16-bit min/max (the selects, clip tests and VMACU,
+ * which the SSE2 build otherwise runs as auto-vectorized scalar loops).
+ * They are bit-exact with the SSE2 path and share its accumulator and flag
+ * storage, so the two backends can be swapped at any time.
+ */
+#if defined(ARCH_MIN_SSE2) && !defined(SSE2NEON) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define VU_HAVE_SSE41
+
+VECTOR_EXTERN macu_v_sse41(v16 vs, v16 vt);
+
+VECTOR_EXTERN lt_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN eq_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN ne_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN ge_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN cl_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN ch_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN cr_v_sse41(v16 vs, v16 vt);
+VECTOR_EXTERN mrg_v_sse41(v16 vs, v16 vt);
+#endif
+
+/*
+ * Points COP2_C2 at the fastest vector operations the host CPU supports.
+ * Returns nonzero if the SSE4.1 backend was selected.
+ */
+extern int select_VU_backend(void);
+
+#endif
@@ -1,3 +1,23 @@
+######################
+# mupen64plus-rsp-hle-jpeg
+######################
+include $(CLEAR_VARS)
+LOCAL_PATH := $(JNI_LOCAL_PATH)
+SRCDIR := ./upstream/src
+
+LOCAL_MODULE := mupen64plus-rsp-hle-jpeg
+LOCAL_ARM_MODE := arm
+
+LOCAL_C_INCLUDES := $(M64P_API_INCLUDES)
+
+LOCAL_SRC_FILES := $(SRCDIR)/jpeg.c
+
+# ndk-build has no per-file flags, so the jpeg IDCT gets its own module to
+# keep its float operations as written
+LOCAL_CFLAGS := $(COMMON_CFLAGS) -ffp-contract=off -fno-associative-math
+
+include $(BUILD_STATIC_LIBRARY)
+
 ######################
 # mupen64plus-rsp-hle
 ######################
@@ -6,6 +26,7 @@ LOCAL_PATH := $(JNI_LOCAL_PATH)
 SRCDIR := ./upstream/src
 
 LOCAL_MODULE := mupen64plus-rsp-hle
+LOCAL_STATIC_LIBRARIES := mupen64plus-rsp-hle-jpeg
 LOCAL_ARM_MODE := arm
 
 LOCAL_C_INCLUDES := $(M64P_API_INCLUDES)
@@ -18,7 +39,6 @@ LOCAL_SRC_FILES :=           \
     $(SRCDIR)/audio.c        \
     $(SRCDIR)/cicx105.c      \
     $(SRCDIR)/hle.c          \
-    $(SRCDIR)/jpeg.c         \
     $(SRCDIR)/memory.c       \
     $(SRCDIR)/mp3.c          \
     $(SRCDIR)/musyx.c        \
@@ -30,6 +30,27 @@
 #include "hle_internal.h"
 #include "memory.h"
 
+/* The vector paths do the same float and double operations in the same order
+ * as the scalar code so they give the same output bit for bit */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JPEG_SSE2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(M64P_BIG_ENDIAN)
+#include <arm_neon.h>
+#define JPEG_NEON
+#if defined(__aarch64__)
+#define JPEG_NEON_F64
+#endif
+#endif
+
+/* A fused multiply-add or a reassociated sum would round differently from
+ * the vector paths.  GCC ignores this pragma and -ffast-math makes clang
+ * ignore it too, so the build files also compile this file with
+ * -ffp-contract=off -fno-associative-math */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
 #define SUBBLOCK_SIZE 64
 
 typedef void (*tile_line_emitter_t)(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address);
@@ -43,13 +64,21 @@ static void jpeg_decode_std(struct hle_t* hle,
                             const tile_line_emitter_t emit_line);
 
 /* helper functions */
-static uint8_t clamp_u8(int16_t x);
 static int16_t clamp_s12(int16_t x);
+#if !defined(JPEG_SSE2) && !defined(JPEG_NEON)
+static uint8_t clamp_u8(int16_t x);
+#endif
+#if !defined(JPEG_SSE2) && !defined(JPEG_NEON_F64)
 static uint16_t clamp_RGBA_component(int16_t x);
+#endif
 
 /* pixel conversion & formatting */
+#if !defined(JPEG_SSE2) && !defined(JPEG_NEON)
 static uint32_t GetUYVY(int16_t y1, int16_t y2, int16_t u, int16_t v);
+#endif
+#if !defined(JPEG_SSE2) && !defined(JPEG_NEON_F64)
 static uint16_t GetRGBA(int16_t y, int16_t u, int16_t v);
+#endif
 
 /* tile line emitters */
 static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address);
@@ -72,7 +101,9 @@ static void ReorderSubBlock(int16_t *dst, const int16_t *src, const unsigned int
 static void MultSubBlocks(int16_t *dst, const int16_t *src1, const int16_t *src2, unsigned int shift);
 static void ScaleSubBlock(int16_t *dst, const int16_t *src, int16_t scale);
 static void RShiftSubBlock(int16_t *dst, const int16_t *src, unsigned int shift);
+#if !defined(JPEG_SSE2) && !defined(JPEG_NEON)
 static void InverseDCT1D(const float *const x, float *dst, unsigned int stride);
+#endif
 static void InverseDCTSubBlock(int16_t *dst, const int16_t *src);
 static void RescaleYSubBlock(int16_t *dst, const int16_t *src);
 static void RescaleUVSubBlock(int16_t *dst, const int16_t *src);
@@ -268,11 +299,6 @@ static void jpeg_decode_std(struct hle_t* hle,
     }
 }
 
-static uint8_t clamp_u8(int16_t x)
-{
-    return (x & (0xff00)) ? ((-x) >> 15) & 0xff : x;
-}
-
 static int16_t clamp_s12(int16_t x)
 {
     if (x < -0x800)
@@ -282,34 +308,154 @@ static int16_t clamp_s12(int16_t x)
     return x;
 }
 
-static uint16_t clamp_RGBA_component(int16_t x)
+#if defined(JPEG_SSE2)
+/* clamp_u8 maps -0x8000 to 1 because its negation still has bit 15 set */
+static __m128i clamp_u8_x8(__m128i x)
 {
-    if (x > 0xff0)
-        x = 0xff0;
-    else if (x < 0)
-        x = 0;
-    return (x & 0xf80);
+    const __m128i y = _mm_min_epi16(_mm_max_epi16(x, _mm_setzero_si128()), _mm_set1_epi16(0xff));
+
+    return _mm_or_si128(y, _mm_and_si128(_mm_cmpeq_epi16(x, _mm_set1_epi16(INT16_MIN)), _mm_set1_epi16(1)));
 }
 
-static uint32_t GetUYVY(int16_t y1, int16_t y2, int16_t u, int16_t v)
+/* x holds 8 components as 32 bit integers, the cast to int16_t keeps the low 16 bits */
+static __m128i clamp_RGBA_component_x8(__m128i lo, __m128i hi)
 {
-    return (uint32_t)clamp_u8(u)  << 24 |
-           (uint32_t)clamp_u8(y1) << 16 |
-           (uint32_t)clamp_u8(v)  << 8 |
-           (uint32_t)clamp_u8(y2);
+    __m128i x;
+
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    x = _mm_packs_epi32(lo, hi);
+    x = _mm_min_epi16(_mm_max_epi16(x, _mm_setzero_si128()), _mm_set1_epi16(0xff0));
+    return _mm_and_si128(x, _mm_set1_epi16(0xf80));
 }
 
-static uint16_t GetRGBA(int16_t y, int16_t u, int16_t v)
+/* y, u and v hold 4 pixels as 32 bit integers, fY already includes the 2048 bias */
+static void GetRGBA_x4(__m128i y, __m128i u, __m128i v, __m128i *r, __m128i *g, __m128i *b)
 {
-    const float fY = (float)y + 2048.0f;
-    const float fU = (float)u;
-    const float fV = (float)v;
+    __m128i rh[2], gh[2], bh[2];
+    unsigned int i;
 
-    const uint16_t r = clamp_RGBA_component((int16_t)(fY               + 1.4025 * fV));
-    const uint16_t g = clamp_RGBA_component((int16_t)(fY - 0.3443 * fU - 0.7144 * fV));
-    const uint16_t b = clamp_RGBA_component((int16_t)(fY + 1.7729 * fU));
+    for (i = 0; i < 2; ++i) {
+        const __m128d fY = _mm_cvtepi32_pd(y);
+        const __m128d fU = _mm_cvtepi32_pd(u);
+        const __m128d fV = _mm_cvtepi32_pd(v);
 
-    return (r << 4) | (g >> 1) | (b >> 6) | 1;
+        rh[i] = _mm_cvttpd_epi32(_mm_add_pd(fY, _mm_mul_pd(_mm_set1_pd(1.4025), fV)));
+        gh[i] = _mm_cvttpd_epi32(_mm_sub_pd(_mm_sub_pd(fY, _mm_mul_pd(_mm_set1_pd(0.3443), fU)),
+                                            _mm_mul_pd(_mm_set1_pd(0.7144), fV)));
+        bh[i] = _mm_cvttpd_epi32(_mm_add_pd(fY, _mm_mul_pd(_mm_set1_pd(1.7729), fU)));
+
+        y = _mm_srli_si128(y, 8);
+        u = _mm_srli_si128(u, 8);
+        v = _mm_srli_si128(v, 8);
+    }
+
+    *r = _mm_unpacklo_epi64(rh[0], rh[1]);
+    *g = _mm_unpacklo_epi64(gh[0], gh[1]);
+    *b = _mm_unpacklo_epi64(bh[0], bh[1]);
+}
+
+static __m128i GetRGBA_x8(__m128i y, __m128i u, __m128i v)
+{
+    const __m128i bias = _mm_set1_epi32(2048);
+    __m128i r[2], g[2], b[2];
+
+    GetRGBA_x4(_mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(y, y), 16), bias),
+               _mm_srai_epi32(_mm_unpacklo_epi16(u, u), 16),
+               _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16),
+               &r[0], &g[0], &b[0]);
+    GetRGBA_x4(_mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(y, y), 16), bias),
+               _mm_srai_epi32(_mm_unpackhi_epi16(u, u), 16),
+               _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16),
+               &r[1], &g[1], &b[1]);
+
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(clamp_RGBA_component_x8(r[0], r[1]), 4),
+                                     _mm_srli_epi16(clamp_RGBA_component_x8(g[0], g[1]), 1)),
+                        _mm_or_si128(_mm_srli_epi16(clamp_RGBA_component_x8(b[0], b[1]), 6),
+                                     _mm_set1_epi16(1)));
+}
+
+static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address)
+{
+    uint32_t uyvy[8];
+
+    const int16_t *const v  = u + SUBBLOCK_SIZE;
+    const int16_t *const y2 = y + SUBBLOCK_SIZE;
+
+    /* each 16 bit lane holds an even pixel in its low byte and the next odd pixel in its high byte */
+    const __m128i yy = _mm_packus_epi16(clamp_u8_x8(_mm_loadu_si128((const __m128i *)y)),
+                                        clamp_u8_x8(_mm_loadu_si128((const __m128i *)y2)));
+    const __m128i lo = _mm_or_si128(_mm_srli_epi16(yy, 8),
+                                    _mm_slli_epi16(clamp_u8_x8(_mm_loadu_si128((const __m128i *)v)), 8));
+    const __m128i hi = _mm_or_si128(_mm_and_si128(yy, _mm_set1_epi16(0xff)),
+                                    _mm_slli_epi16(clamp_u8_x8(_mm_loadu_si128((const __m128i *)u)), 8));
+
+    _mm_storeu_si128((__m128i *)&uyvy[0], _mm_unpacklo_epi16(lo, hi));
+    _mm_storeu_si128((__m128i *)&uyvy[4], _mm_unpackhi_epi16(lo, hi));
+
+    dram_store_u32(hle, uyvy, address, 8);
+}
+
+static void EmitRGBATileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address)
+{
+    uint16_t rgba[16];
+
+    const int16_t *const v  = u + SUBBLOCK_SIZE;
+    const int16_t *const y2 = y + SUBBLOCK_SIZE;
+
+    /* every chroma sample is shared by two horizontally adjacent pixels */
+    const __m128i uu = _mm_loadu_si128((const __m128i *)u);
+    const __m128i vv = _mm_loadu_si128((const __m128i *)v);
+
+    _mm_storeu_si128((__m128i *)&rgba[0], GetRGBA_x8(_mm_loadu_si128((const __m128i *)y),
+                                                     _mm_unpacklo_epi16(uu, uu),
+                                                     _mm_unpacklo_epi16(vv, vv)));
+    _mm_storeu_si128((__m128i *)&rgba[8], GetRGBA_x8(_mm_loadu_si128((const __m128i *)y2),
+                                                     _mm_unpackhi_epi16(uu, uu),
+                                                     _mm_unpackhi_epi16(vv, vv)));
+
+    dram_store_u16(hle, rgba, address, 16);
+}
+#else
+#if defined(JPEG_NEON)
+/* clamp_u8 maps -0x8000 to 1 because its negation still has bit 15 set */
+static int16x8_t clamp_u8_x8(int16x8_t x)
+{
+    const int16x8_t y = vminq_s16(vmaxq_s16(x, vdupq_n_s16(0)), vdupq_n_s16(0xff));
+
+    return vorrq_s16(y, vandq_s16(vreinterpretq_s16_u16(vceqq_s16(x, vdupq_n_s16(INT16_MIN))), vdupq_n_s16(1)));
+}
+
+static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address)
+{
+    uint32_t uyvy[8];
+
+    const int16_t *const v  = u + SUBBLOCK_SIZE;
+    const int16_t *const y2 = y + SUBBLOCK_SIZE;
+
+    /* val[0] gets the even pixels and val[1] the odd ones */
+    const int16x8x2_t yy = vuzpq_s16(clamp_u8_x8(vld1q_s16(y)), clamp_u8_x8(vld1q_s16(y2)));
+    const int16x8_t lo = vorrq_s16(yy.val[1], vshlq_n_s16(clamp_u8_x8(vld1q_s16(v)), 8));
+    const int16x8_t hi = vorrq_s16(yy.val[0], vshlq_n_s16(clamp_u8_x8(vld1q_s16(u)), 8));
+    const int16x8x2_t words = vzipq_s16(lo, hi);
+
+    vst1q_u32(&uyvy[0], vreinterpretq_u32_s16(words.val[0]));
+    vst1q_u32(&uyvy[4], vreinterpretq_u32_s16(words.val[1]));
+
+    dram_store_u32(hle, uyvy, address, 8);
+}
+#else
+static uint8_t clamp_u8(int16_t x)
+{
+    return (x & (0xff00)) ? ((-x) >> 15) & 0xff : x;
+}
+
+static uint32_t GetUYVY(int16_t y1, int16_t y2, int16_t u, int16_t v)
+{
+    return (uint32_t)clamp_u8(u)  << 24 |
+           (uint32_t)clamp_u8(y1) << 16 |
+           (uint32_t)clamp_u8(v)  << 8 |
+           (uint32_t)clamp_u8(y2);
 }
 
 static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address)
@@ -330,6 +476,103 @@ static void EmitYUVTileLine(struct hle_t* hle, const int16_t *y, const int16_t *
 
     dram_store_u32(hle, uyvy, address, 8);
 }
+#endif
+
+#if defined(JPEG_NEON_F64)
+/* x holds 8 components as 32 bit integers, the cast to int16_t keeps the low 16 bits */
+static uint16x8_t clamp_RGBA_component_x8(int32x4_t lo, int32x4_t hi)
+{
+    int16x8_t x = vcombine_s16(vmovn_s32(lo), vmovn_s32(hi));
+
+    x = vminq_s16(vmaxq_s16(x, vdupq_n_s16(0)), vdupq_n_s16(0xff0));
+    return vreinterpretq_u16_s16(vandq_s16(x, vdupq_n_s16(0xf80)));
+}
+
+static int32x2_t cvt_s32_f64(float64x2_t x)
+{
+    return vmovn_s64(vcvtq_s64_f64(x));
+}
+
+/* y, u and v hold 4 pixels as 32 bit integers, fY already includes the 2048 bias */
+static void GetRGBA_x4(int32x4_t y, int32x4_t u, int32x4_t v, int32x4_t *r, int32x4_t *g, int32x4_t *b)
+{
+    int32x2_t rh[2], gh[2], bh[2];
+    unsigned int i;
+
+    for (i = 0; i < 2; ++i) {
+        const float64x2_t fY = vcvtq_f64_s64(vmovl_s32(i == 0 ? vget_low_s32(y) : vget_high_s32(y)));
+        const float64x2_t fU = vcvtq_f64_s64(vmovl_s32(i == 0 ? vget_low_s32(u) : vget_high_s32(u)));
+        const float64x2_t fV = vcvtq_f64_s64(vmovl_s32(i == 0 ? vget_low_s32(v) : vget_high_s32(v)));
+
+        rh[i] = cvt_s32_f64(vaddq_f64(fY, vmulq_f64(vdupq_n_f64(1.4025), fV)));
+        gh[i] = cvt_s32_f64(vsubq_f64(vsubq_f64(fY, vmulq_f64(vdupq_n_f64(0.3443), fU)),
+                                      vmulq_f64(vdupq_n_f64(0.7144), fV)));
+        bh[i] = cvt_s32_f64(vaddq_f64(fY, vmulq_f64(vdupq_n_f64(1.7729), fU)));
+    }
+
+    *r = vcombine_s32(rh[0], rh[1]);
+    *g = vcombine_s32(gh[0], gh[1]);
+    *b = vcombine_s32(bh[0], bh[1]);
+}
+
+static uint16x8_t GetRGBA_x8(int16x8_t y, int16x8_t u, int16x8_t v)
+{
+    const int32x4_t bias = vdupq_n_s32(2048);
+    int32x4_t r[2], g[2], b[2];
+
+    GetRGBA_x4(vaddq_s32(vmovl_s16(vget_low_s16(y)), bias),
+               vmovl_s16(vget_low_s16(u)),
+               vmovl_s16(vget_low_s16(v)),
+               &r[0], &g[0], &b[0]);
+    GetRGBA_x4(vaddq_s32(vmovl_s16(vget_high_s16(y)), bias),
+               vmovl_s16(vget_high_s16(u)),
+               vmovl_s16(vget_high_s16(v)),
+               &r[1], &g[1], &b[1]);
+
+    return vorrq_u16(vorrq_u16(vshlq_n_u16(clamp_RGBA_component_x8(r[0], r[1]), 4),
+                               vshrq_n_u16(clamp_RGBA_component_x8(g[0], g[1]), 1)),
+                     vorrq_u16(vshrq_n_u16(clamp_RGBA_component_x8(b[0], b[1]), 6),
+                               vdupq_n_u16(1)));
+}
+
+static void EmitRGBATileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address)
+{
+    uint16_t rgba[16];
+
+    const int16_t *const v  = u + SUBBLOCK_SIZE;
+    const int16_t *const y2 = y + SUBBLOCK_SIZE;
+
+    /* every chroma sample is shared by two horizontally adjacent pixels */
+    const int16x8x2_t uu = vzipq_s16(vld1q_s16(u), vld1q_s16(u));
+    const int16x8x2_t vv = vzipq_s16(vld1q_s16(v), vld1q_s16(v));
+
+    vst1q_u16(&rgba[0], GetRGBA_x8(vld1q_s16(y),  uu.val[0], vv.val[0]));
+    vst1q_u16(&rgba[8], GetRGBA_x8(vld1q_s16(y2), uu.val[1], vv.val[1]));
+
+    dram_store_u16(hle, rgba, address, 16);
+}
+#else
+static uint16_t clamp_RGBA_component(int16_t x)
+{
+    if (x > 0xff0)
+        x = 0xff0;
+    else if (x < 0)
+        x = 0;
+    return (x & 0xf80);
+}
+
+static uint16_t GetRGBA(int16_t y, int16_t u, int16_t v)
+{
+    const float fY = (float)y + 2048.0f;
+    const float fU = (float)u;
+    const float fV = (float)v;
+
+    const uint16_t r = clamp_RGBA_component((int16_t)(fY               + 1.4025 * fV));
+    const uint16_t g = clamp_RGBA_component((int16_t)(fY - 0.3443 * fU - 0.7144 * fV));
+    const uint16_t b = clamp_RGBA_component((int16_t)(fY + 1.7729 * fU));
+
+    return (r << 4) | (g >> 1) | (b >> 6) | 1;
+}
 
 static void EmitRGBATileLine(struct hle_t* hle, const int16_t *y, const int16_t *u, uint32_t address)
 {
@@ -357,6 +600,8 @@ static void EmitRGBATileLine(struct hle_t* hle, const int16_t *y, const int16_t
 
     dram_store_u16(hle, rgba, address, 16);
 }
+#endif
+#endif
 
 static void EmitTilesMode0(struct hle_t* hle, const tile_line_emitter_t emit_line, const int16_t *macroblock, uint32_t address)
 {
@@ -485,10 +730,35 @@ static void MultSubBlocks(int16_t *dst, const int16_t *src1, const int16_t *src2
 {
     unsigned int i;
 
+#if defined(JPEG_SSE2)
+    const __m128i count = _mm_cvtsi32_si128(shift);
+
+    for (i = 0; i < SUBBLOCK_SIZE; i += 8) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)&src1[i]);
+        const __m128i y = _mm_loadu_si128((const __m128i *)&src2[i]);
+        const __m128i lo = _mm_mullo_epi16(x, y);
+        const __m128i hi = _mm_mulhi_epi16(x, y);
+        const __m128i v = _mm_packs_epi32(_mm_unpacklo_epi16(lo, hi), _mm_unpackhi_epi16(lo, hi));
+
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_sll_epi16(v, count));
+    }
+#elif defined(JPEG_NEON)
+    const int16x8_t count = vdupq_n_s16(shift);
+
+    for (i = 0; i < SUBBLOCK_SIZE; i += 8) {
+        const int16x8_t x = vld1q_s16(&src1[i]);
+        const int16x8_t y = vld1q_s16(&src2[i]);
+        const int16x8_t v = vcombine_s16(vqmovn_s32(vmull_s16(vget_low_s16(x), vget_low_s16(y))),
+                                         vqmovn_s32(vmull_s16(vget_high_s16(x), vget_high_s16(y))));
+
+        vst1q_s16(&dst[i], vshlq_s16(v, count));
+    }
+#else
     for (i = 0; i < SUBBLOCK_SIZE; ++i) {
         int32_t v = src1[i] * src2[i];
         dst[i] = clamp_s16(v) << shift;
     }
+#endif
 }
 
 static void ScaleSubBlock(int16_t *dst, const int16_t *src, int16_t scale)
@@ -515,6 +785,145 @@ static void RShiftSubBlock(int16_t *dst, const int16_t *src, unsigned int shift)
  * Implementation based on Wikipedia :
  * http://fr.wikipedia.org/wiki/Transform%C3%A9e_en_cosinus_discr%C3%A8te
  **************************************************************************/
+#if defined(JPEG_SSE2) || defined(JPEG_NEON)
+/* Each lane runs the scalar 1D IDCT on a different row, so the rows are
+ * transposed into lanes before each pass */
+#if defined(JPEG_SSE2)
+typedef __m128 v4f;
+
+static inline v4f v4f_add(v4f a, v4f b) { return _mm_add_ps(a, b); }
+static inline v4f v4f_sub(v4f a, v4f b) { return _mm_sub_ps(a, b); }
+static inline v4f v4f_mul(float k, v4f a) { return _mm_mul_ps(_mm_set1_ps(k), a); }
+
+static void v4f_load_s16(const int16_t *src, v4f *lo, v4f *hi)
+{
+    const __m128i x = _mm_loadu_si128((const __m128i *)src);
+
+    *lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+    *hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+}
+
+/* (int16_t)x >> 3, the cast keeps the low 16 bits of the truncated value */
+static void v4f_store_s16(int16_t *dst, v4f lo, v4f hi)
+{
+    const __m128i l = _mm_srai_epi32(_mm_slli_epi32(_mm_cvttps_epi32(lo), 16), 16);
+    const __m128i h = _mm_srai_epi32(_mm_slli_epi32(_mm_cvttps_epi32(hi), 16), 16);
+
+    _mm_storeu_si128((__m128i *)dst, _mm_srai_epi16(_mm_packs_epi32(l, h), 3));
+}
+
+static void v4f_transpose(const v4f *src, v4f *dst)
+{
+    __m128 r0 = src[0], r1 = src[1], r2 = src[2], r3 = src[3];
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    dst[0] = r0;
+    dst[1] = r1;
+    dst[2] = r2;
+    dst[3] = r3;
+}
+#else
+typedef float32x4_t v4f;
+
+static inline v4f v4f_add(v4f a, v4f b) { return vaddq_f32(a, b); }
+static inline v4f v4f_sub(v4f a, v4f b) { return vsubq_f32(a, b); }
+static inline v4f v4f_mul(float k, v4f a) { return vmulq_n_f32(a, k); }
+
+static void v4f_load_s16(const int16_t *src, v4f *lo, v4f *hi)
+{
+    const int16x8_t x = vld1q_s16(src);
+
+    *lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+    *hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+}
+
+/* (int16_t)x >> 3, the cast keeps the low 16 bits of the truncated value */
+static void v4f_store_s16(int16_t *dst, v4f lo, v4f hi)
+{
+    const int16x8_t x = vcombine_s16(vmovn_s32(vcvtq_s32_f32(lo)), vmovn_s32(vcvtq_s32_f32(hi)));
+
+    vst1q_s16(dst, vshrq_n_s16(x, 3));
+}
+
+static void v4f_transpose(const v4f *src, v4f *dst)
+{
+    const float32x4x2_t t0 = vtrnq_f32(src[0], src[1]);
+    const float32x4x2_t t1 = vtrnq_f32(src[2], src[3]);
+
+    dst[0] = vcombine_f32(vget_low_f32(t0.val[0]), vget_low_f32(t1.val[0]));
+    dst[1] = vcombine_f32(vget_low_f32(t0.val[1]), vget_low_f32(t1.val[1]));
+    dst[2] = vcombine_f32(vget_high_f32(t0.val[0]), vget_high_f32(t1.val[0]));
+    dst[3] = vcombine_f32(vget_high_f32(t0.val[1]), vget_high_f32(t1.val[1]));
+}
+#endif
+
+/* block[h][i] holds columns 4h to 4h+3 of row i */
+static void TransposeBlock(v4f dst[2][8], v4f src[2][8])
+{
+    unsigned int h, k;
+
+    for (h = 0; h < 2; ++h)
+        for (k = 0; k < 2; ++k)
+            v4f_transpose(&src[k][4 * h], &dst[h][4 * k]);
+}
+
+static void InverseDCT1DLanes(const v4f *x, v4f *dst)
+{
+    v4f e[4];
+    v4f f[4];
+    v4f x26, x1357, x15, x37, x17, x35;
+
+    x15   = v4f_mul(IDCT_K[2], v4f_add(x[1], x[5]));
+    x37   = v4f_mul(IDCT_K[3], v4f_add(x[3], x[7]));
+    x17   = v4f_mul(IDCT_K[8], v4f_add(x[1], x[7]));
+    x35   = v4f_mul(IDCT_K[9], v4f_add(x[3], x[5]));
+    x1357 = v4f_mul(IDCT_C3,   v4f_add(v4f_add(v4f_add(x[1], x[3]), x[5]), x[7]));
+    x26   = v4f_mul(IDCT_C6,   v4f_add(x[2], x[6]));
+
+    f[0] = v4f_add(x[0], x[4]);
+    f[1] = v4f_sub(x[0], x[4]);
+    f[2] = v4f_add(x26, v4f_mul(IDCT_K[0], x[2]));
+    f[3] = v4f_add(x26, v4f_mul(IDCT_K[1], x[6]));
+
+    e[0] = v4f_add(v4f_add(v4f_add(x1357, x15), v4f_mul(IDCT_K[4], x[1])), x17);
+    e[1] = v4f_add(v4f_add(v4f_add(x1357, x37), v4f_mul(IDCT_K[6], x[3])), x35);
+    e[2] = v4f_add(v4f_add(v4f_add(x1357, x15), v4f_mul(IDCT_K[5], x[5])), x35);
+    e[3] = v4f_add(v4f_add(v4f_add(x1357, x37), v4f_mul(IDCT_K[7], x[7])), x17);
+
+    dst[0] = v4f_add(v4f_add(f[0], f[2]), e[0]);
+    dst[1] = v4f_add(v4f_add(f[1], f[3]), e[1]);
+    dst[2] = v4f_add(v4f_sub(f[1], f[3]), e[2]);
+    dst[3] = v4f_add(v4f_sub(f[0], f[2]), e[3]);
+    dst[4] = v4f_sub(v4f_sub(f[0], f[2]), e[3]);
+    dst[5] = v4f_sub(v4f_sub(f[1], f[3]), e[2]);
+    dst[6] = v4f_sub(v4f_add(f[1], f[3]), e[1]);
+    dst[7] = v4f_sub(v4f_add(f[0], f[2]), e[0]);
+}
+
+static void InverseDCTSubBlock(int16_t *dst, const int16_t *src)
+{
+    v4f rows[2][8];
+    v4f lanes[2][8];
+    unsigned int i;
+
+    for (i = 0; i < 8; ++i)
+        v4f_load_s16(&src[i * 8], &rows[0][i], &rows[1][i]);
+
+    /* idct 1d on rows, the result is the transposed block like the scalar version */
+    TransposeBlock(lanes, rows);
+    InverseDCT1DLanes(lanes[0], rows[0]);
+    InverseDCT1DLanes(lanes[1], rows[1]);
+
+    /* idct 1d on columns */
+    TransposeBlock(lanes, rows);
+    InverseDCT1DLanes(lanes[0], rows[0]);
+    InverseDCT1DLanes(lanes[1], rows[1]);
+
+    /* C4 = 1 normalization implies a division by 8 */
+    for (i = 0; i < 8; ++i)
+        v4f_store_s16(&dst[i * 8], rows[0][i], rows[1][i]);
+}
+#else
 static void InverseDCT1D(const float *const x, float *dst, unsigned int stride)
 {
     float e[4];
@@ -578,6 +987,7 @@ static void InverseDCTSubBlock(int16_t *dst, const int16_t *src)
             dst[i + j * 8] = (int16_t)x[j] >> 3;
     }
 }
+#endif
 
 static void RescaleYSubBlock(int16_t *dst, const int16_t *src)
 {
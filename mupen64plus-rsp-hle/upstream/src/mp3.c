@@ -28,9 +28,19 @@
 #include "hle_internal.h"
 #include "memory.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MP3_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MP3_NEON
+#endif
+
 static void InnerLoop(struct hle_t* hle,
                       uint32_t outPtr, uint32_t inPtr,
                       uint32_t t6, uint32_t t5, uint32_t t4);
+static void DeWindowSums(const uint8_t *samples, const uint16_t *window,
+                         int32_t *even, int32_t *odd);
 
 static const uint16_t DeWindowLUT [0x420] = {
     0x0000, 0xFFF3, 0x005D, 0xFF38, 0x037A, 0xF736, 0x0B37, 0xC00E,
@@ -167,6 +177,19 @@ static const uint16_t DeWindowLUT [0x420] = {
     0x0B37, 0xF736, 0x037A, 0xFF38, 0x005D, 0xFFF3, 0x0000, 0x0000
 };
 
+#if defined(MP3_SSE2)
+/* (x * k) >> 16 keeping the low 32 bits of the product like the scalar code */
+static __m128i mp3_mulshift(__m128i x, __m128i k)
+{
+    const __m128i even = _mm_mul_epu32(x, k);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), _mm_srli_epi64(k, 32));
+    const __m128i product = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                               _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+
+    return _mm_srai_epi32(product, 16);
+}
+#endif
+
 static void MP3AB0(int32_t* v)
 {
     /* Part 2 - 100% Accurate */
@@ -177,6 +200,75 @@ static void MP3AB0(int32_t* v)
     static const uint16_t LUT3[4] = { 0xFB14, 0xD4DC, 0x31F2, 0x8E3A };
     int i;
 
+#if defined(MP3_SSE2)
+    const __m128i lut3 = _mm_setr_epi32(LUT3[0], LUT3[1], LUT3[2], LUT3[3]);
+    const __m128i lut4 = _mm_setr_epi32(0xEC84, 0x61F8, 0xEC84, 0x61F8);
+    __m128i a, b;
+
+    for (i = 0; i < 8; i += 4) {
+        a = _mm_loadu_si128((const __m128i *)&v[0 + i]);
+        b = _mm_loadu_si128((const __m128i *)&v[8 + i]);
+        _mm_storeu_si128((__m128i *)&v[16 + i], _mm_add_epi32(a, b));
+        _mm_storeu_si128((__m128i *)&v[24 + i], mp3_mulshift(_mm_sub_epi32(a, b),
+                         _mm_setr_epi32(LUT2[i + 0], LUT2[i + 1], LUT2[i + 2], LUT2[i + 3])));
+    }
+
+    for (i = 0; i < 16; i += 8) {
+        a = _mm_loadu_si128((const __m128i *)&v[16 + i]);
+        b = _mm_loadu_si128((const __m128i *)&v[20 + i]);
+        _mm_storeu_si128((__m128i *)&v[0 + i], _mm_add_epi32(a, b));
+        _mm_storeu_si128((__m128i *)&v[4 + i], mp3_mulshift(_mm_sub_epi32(a, b), lut3));
+    }
+
+    /* a gets v[i], v[i + 1] of two groups and b their v[i + 2], v[i + 3] */
+    for (i = 0; i < 16; i += 8) {
+        const __m128i x0 = _mm_loadu_si128((const __m128i *)&v[0 + i]);
+        const __m128i x1 = _mm_loadu_si128((const __m128i *)&v[4 + i]);
+        __m128i sum, product;
+
+        a = _mm_unpacklo_epi64(x0, x1);
+        b = _mm_unpackhi_epi64(x0, x1);
+        sum = _mm_add_epi32(a, b);
+        product = mp3_mulshift(_mm_sub_epi32(a, b), lut4);
+        _mm_storeu_si128((__m128i *)&v[16 + i], _mm_unpacklo_epi64(sum, product));
+        _mm_storeu_si128((__m128i *)&v[20 + i], _mm_unpackhi_epi64(sum, product));
+    }
+#elif defined(MP3_NEON)
+    static const int32_t LUT4[4] = { 0xEC84, 0x61F8, 0xEC84, 0x61F8 };
+
+    const int32x4_t lut3 = vreinterpretq_s32_u32(vmovl_u16(vld1_u16(LUT3)));
+    int32x4_t a, b;
+
+    for (i = 0; i < 8; i += 4) {
+        const int32x4_t lut2 = vreinterpretq_s32_u32(vmovl_u16(vld1_u16(&LUT2[i])));
+
+        a = vld1q_s32(&v[0 + i]);
+        b = vld1q_s32(&v[8 + i]);
+        vst1q_s32(&v[16 + i], vaddq_s32(a, b));
+        vst1q_s32(&v[24 + i], vshrq_n_s32(vmulq_s32(vsubq_s32(a, b), lut2), 16));
+    }
+
+    for (i = 0; i < 16; i += 8) {
+        a = vld1q_s32(&v[16 + i]);
+        b = vld1q_s32(&v[20 + i]);
+        vst1q_s32(&v[0 + i], vaddq_s32(a, b));
+        vst1q_s32(&v[4 + i], vshrq_n_s32(vmulq_s32(vsubq_s32(a, b), lut3), 16));
+    }
+
+    /* a gets v[i], v[i + 1] of two groups and b their v[i + 2], v[i + 3] */
+    for (i = 0; i < 16; i += 8) {
+        const int32x4_t x0 = vld1q_s32(&v[0 + i]);
+        const int32x4_t x1 = vld1q_s32(&v[4 + i]);
+        int32x4_t sum, product;
+
+        a = vcombine_s32(vget_low_s32(x0), vget_low_s32(x1));
+        b = vcombine_s32(vget_high_s32(x0), vget_high_s32(x1));
+        sum = vaddq_s32(a, b);
+        product = vshrq_n_s32(vmulq_s32(vsubq_s32(a, b), vld1q_s32(LUT4)), 16);
+        vst1q_s32(&v[16 + i], vcombine_s32(vget_low_s32(sum), vget_low_s32(product)));
+        vst1q_s32(&v[20 + i], vcombine_s32(vget_high_s32(sum), vget_high_s32(product)));
+    }
+#else
     for (i = 0; i < 8; i++) {
         v[16 + i] = v[0 + i] + v[8 + i];
         v[24 + i] = ((v[0 + i] - v[8 + i]) * LUT2[i]) >> 0x10;
@@ -201,6 +293,7 @@ static void MP3AB0(int32_t* v)
         v[17 + i] = v[1 + i] + v[3 + i];
         v[19 + i] = ((v[1 + i] - v[3 + i]) * 0x61F8) >> 0x10;
     }
+#endif
 }
 
 void mp3_task(struct hle_t* hle, unsigned int index, uint32_t address)
@@ -579,16 +672,13 @@ static void InnerLoop(struct hle_t* hle,
     for (x = 0; x < 8; x++) {
         int32_t v0;
         int32_t v18;
-        v2 = v4 = v6 = v8 = 0;
-
-        for (i = 7; i >= 0; i--) {
-            v2 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x00) * (short)DeWindowLUT[offset + 0x00] + 0x4000) >> 0xF;
-            v4 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x10) * (short)DeWindowLUT[offset + 0x08] + 0x4000) >> 0xF;
-            v6 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x20) * (short)DeWindowLUT[offset + 0x20] + 0x4000) >> 0xF;
-            v8 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x30) * (short)DeWindowLUT[offset + 0x28] + 0x4000) >> 0xF;
-            addptr += 2;
-            offset++;
-        }
+
+        /* v2 and v4 cover 16 consecutive samples, as do v6 and v8 */
+        DeWindowSums(hle->mp3_buffer + addptr + 0x00, &DeWindowLUT[offset + 0x00], &v2, &v4);
+        DeWindowSums(hle->mp3_buffer + addptr + 0x20, &DeWindowLUT[offset + 0x20], &v6, &v8);
+        addptr += 0x10;
+        offset += 8;
+
         v0  = v2 + v4;
         v18 = v6 + v8;
         /* Clamp(v0); */
@@ -602,17 +692,9 @@ static void InnerLoop(struct hle_t* hle,
     }
 
     offset = 0x10 - (t4 >> 1) + 8 * 0x40;
-    v2 = v4 = 0;
-    for (i = 0; i < 4; i++) {
-        v2 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x00) * (short)DeWindowLUT[offset + 0x00] + 0x4000) >> 0xF;
-        v2 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x10) * (short)DeWindowLUT[offset + 0x08] + 0x4000) >> 0xF;
-        addptr += 2;
-        offset++;
-        v4 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x00) * (short)DeWindowLUT[offset + 0x00] + 0x4000) >> 0xF;
-        v4 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x10) * (short)DeWindowLUT[offset + 0x08] + 0x4000) >> 0xF;
-        addptr += 2;
-        offset++;
-    }
+    /* v2 takes the even samples and v4 the odd ones */
+    DeWindowSums(hle->mp3_buffer + addptr, &DeWindowLUT[offset], &v2, &v4);
+    addptr += 0x10;
     mult6 = *(int32_t *)(hle->mp3_buffer + 0xCE8);
     mult4 = *(int32_t *)(hle->mp3_buffer + 0xCEC);
     if (t4 & 0x2) {
@@ -628,24 +710,16 @@ static void InnerLoop(struct hle_t* hle,
     for (x = 0; x < 8; x++) {
         int32_t v0;
         int32_t v18;
-        v2 = v4 = v6 = v8 = 0;
 
         offset = (0x22F - (t4 >> 1) + x * 0x40);
 
-        for (i = 0; i < 4; i++) {
-            v2 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x20) * (short)DeWindowLUT[offset + 0x00] + 0x4000) >> 0xF;
-            v2 -= ((int) * (int16_t *)(hle->mp3_buffer + ((addptr + 2)) + 0x20) * (short)DeWindowLUT[offset + 0x01] + 0x4000) >> 0xF;
-            v4 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x30) * (short)DeWindowLUT[offset + 0x08] + 0x4000) >> 0xF;
-            v4 -= ((int) * (int16_t *)(hle->mp3_buffer + ((addptr + 2)) + 0x30) * (short)DeWindowLUT[offset + 0x09] + 0x4000) >> 0xF;
-            v6 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x00) * (short)DeWindowLUT[offset + 0x20] + 0x4000) >> 0xF;
-            v6 -= ((int) * (int16_t *)(hle->mp3_buffer + ((addptr + 2)) + 0x00) * (short)DeWindowLUT[offset + 0x21] + 0x4000) >> 0xF;
-            v8 += ((int) * (int16_t *)(hle->mp3_buffer + (addptr) + 0x10) * (short)DeWindowLUT[offset + 0x28] + 0x4000) >> 0xF;
-            v8 -= ((int) * (int16_t *)(hle->mp3_buffer + ((addptr + 2)) + 0x10) * (short)DeWindowLUT[offset + 0x29] + 0x4000) >> 0xF;
-            addptr += 4;
-            offset += 2;
-        }
-        v0  = v2 + v4;
-        v18 = v6 + v8;
+        /* even samples are added and odd ones subtracted */
+        DeWindowSums(hle->mp3_buffer + addptr + 0x20, &DeWindowLUT[offset + 0x00], &v2, &v4);
+        DeWindowSums(hle->mp3_buffer + addptr + 0x00, &DeWindowLUT[offset + 0x20], &v6, &v8);
+        addptr += 0x10;
+
+        v0  = v2 - v4;
+        v18 = v6 - v8;
         /* Clamp(v0); */
         /* Clamp(v18); */
         /* clamp??? */
@@ -682,3 +756,60 @@ static void InnerLoop(struct hle_t* hle,
     }
 }
 
+/* Sums the dewindowed products of 16 consecutive samples, split by sample
+ * parity. Like the RSP, every product is rounded to 16 bits before it is
+ * accumulated. */
+static void DeWindowSums(const uint8_t *samples, const uint16_t *window,
+                         int32_t *even, int32_t *odd)
+{
+    const int16_t *const x = (const int16_t *)samples;
+    const int16_t *const w = (const int16_t *)window;
+    unsigned int i;
+
+#if defined(MP3_SSE2)
+    const __m128i round = _mm_set1_epi32(0x4000);
+    __m128i sum = _mm_setzero_si128();
+
+    for (i = 0; i < 16; i += 8) {
+        const __m128i a = _mm_loadu_si128((const __m128i *)&x[i]);
+        const __m128i b = _mm_loadu_si128((const __m128i *)&w[i]);
+        const __m128i lo = _mm_mullo_epi16(a, b);
+        const __m128i hi = _mm_mulhi_epi16(a, b);
+
+        sum = _mm_add_epi32(sum, _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), round), 15));
+        sum = _mm_add_epi32(sum, _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), round), 15));
+    }
+
+    /* lanes 0 and 2 hold even samples, lanes 1 and 3 odd ones */
+    sum = _mm_add_epi32(sum, _mm_unpackhi_epi64(sum, sum));
+    *even = _mm_cvtsi128_si32(sum);
+    *odd  = _mm_cvtsi128_si32(_mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 1, 1, 1)));
+#elif defined(MP3_NEON)
+    const int32x4_t round = vdupq_n_s32(0x4000);
+    int32x4_t sum = vdupq_n_s32(0);
+    int32x2_t pairs;
+
+    for (i = 0; i < 16; i += 8) {
+        const int16x8_t a = vld1q_s16(&x[i]);
+        const int16x8_t b = vld1q_s16(&w[i]);
+
+        sum = vaddq_s32(sum, vshrq_n_s32(vaddq_s32(vmull_s16(vget_low_s16(a), vget_low_s16(b)), round), 15));
+        sum = vaddq_s32(sum, vshrq_n_s32(vaddq_s32(vmull_s16(vget_high_s16(a), vget_high_s16(b)), round), 15));
+    }
+
+    /* lanes 0 and 2 hold even samples, lanes 1 and 3 odd ones */
+    pairs = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+    *even = vget_lane_s32(pairs, 0);
+    *odd  = vget_lane_s32(pairs, 1);
+#else
+    int32_t sum[2] = { 0, 0 };
+
+    for (i = 0; i < 16; i += 2) {
+        sum[0] += ((int)x[i + 0] * w[i + 0] + 0x4000) >> 0xF;
+        sum[1] += ((int)x[i + 1] * w[i + 1] + 0x4000) >> 0xF;
+    }
+
+    *even = sum[0];
+    *odd  = sum[1];
+#endif
+}
@@ -31,6 +31,22 @@
 #include "hle_internal.h"
 #include "memory.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MUSYX_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MUSYX_NEON
+#endif
+
+#ifdef ENABLE_MUSYX_TIMING
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#endif
+
 /* various constants */
 enum { SUBFRAME_SIZE = 192 };
 enum { MAX_VOICES = 32 };
@@ -161,6 +177,18 @@ static void adpcm_predict_frame(int16_t *dst, const uint8_t *src,
                                 const uint8_t *nibbles,
                                 unsigned int rshift);
 
+#if defined(MUSYX_SSE2) || defined(MUSYX_NEON)
+static void adpcm_build_columns(int16_t *columns, const int16_t *book);
+static void adpcm_compute_residuals_x8(int16_t *dst, const int16_t *src,
+                                       const int16_t *columns,
+                                       const int16_t *last_samples);
+
+static void resample_x8(int16_t *dst, const int16_t *const *samples,
+                        const int16_t *const *luts);
+static void envmix_subframe(int16_t *dst, const int16_t *v,
+                            int32_t env, int32_t env_step);
+#endif
+
 static void mix_voice_samples(struct hle_t* hle, musyx_t *musyx,
                               uint32_t voice_ptr, const int16_t *samples,
                               unsigned segbase, unsigned offset, uint32_t last_sample_ptr);
@@ -186,6 +214,76 @@ static void interleave_stage_v2(struct hle_t* hle, musyx_t *musyx,
                                 uint16_t mask_16, uint32_t ptr_18,
                                 uint32_t ptr_1c, uint32_t output_ptr);
 
+#ifdef ENABLE_MUSYX_TIMING
+/* time spent in each stage, reported every TIMING_REPORT_TASKS tasks */
+enum {
+    STAGE_PCM16_VOICE,
+    STAGE_ADPCM_VOICE,
+    STAGE_SFX,
+    STAGE_INTERLEAVE,
+    STAGE_COUNT
+};
+
+enum { TIMING_REPORT_TASKS = 1000 };
+
+static const char *const stage_names[STAGE_COUNT] = {
+    "PCM16 voice", "ADPCM voice", "sfx", "interleave"
+};
+
+static uint64_t stage_ns[STAGE_COUNT];
+static uint32_t stage_runs[STAGE_COUNT];
+static uint32_t timed_tasks;
+
+static uint64_t timing_now(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t)(counter.QuadPart * 1000000000.0 / frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static void stage_done(unsigned int stage, uint64_t start)
+{
+    stage_ns[stage] += timing_now() - start;
+    ++stage_runs[stage];
+}
+
+static void task_done(struct hle_t* hle)
+{
+    unsigned int i;
+
+    if (++timed_tasks < TIMING_REPORT_TASKS)
+        return;
+
+    for (i = 0; i < STAGE_COUNT; ++i) {
+        if (stage_runs[i] == 0)
+            continue;
+        HleInfoMessage(hle->user_defined,
+                       "musyx %s stage: %u runs, %.2f us each",
+                       stage_names[i], stage_runs[i],
+                       stage_ns[i] / 1000.0 / stage_runs[i]);
+        stage_ns[i] = 0;
+        stage_runs[i] = 0;
+    }
+    timed_tasks = 0;
+}
+
+#define STAGE_START(start)          uint64_t start = timing_now()
+#define STAGE_DONE(stage, start)    stage_done(stage, start)
+#define TASK_DONE(hle)              task_done(hle)
+#else
+#define STAGE_START(start)
+#define STAGE_DONE(stage, start)
+#define TASK_DONE(hle)
+#endif
+
+#if !defined(MUSYX_SSE2) && !defined(MUSYX_NEON)
 static int32_t dot4(const int16_t *x, const int16_t *y)
 {
     size_t i;
@@ -196,6 +294,7 @@ static int32_t dot4(const int16_t *x, const int16_t *y)
 
     return accu;
 }
+#endif
 
 /**************************************************************************
  * MusyX v1 audio ucode
@@ -237,11 +336,19 @@ void musyx_v1_task(struct hle_t* hle)
         output_ptr = voice_stage(hle, &musyx, voice_ptr, last_sample_ptr);
 
         /* apply delay-based effects (optional) */
-        sfx_stage(hle, mix_sfx_with_main_subframes_v1,
-                  &musyx, sfx_ptr, sfx_index);
+        {
+            STAGE_START(start);
+            sfx_stage(hle, mix_sfx_with_main_subframes_v1,
+                      &musyx, sfx_ptr, sfx_index);
+            STAGE_DONE(STAGE_SFX, start);
+        }
 
         /* emit interleaved L,R subframes */
-        interleave_stage_v1(hle, &musyx, output_ptr);
+        {
+            STAGE_START(start);
+            interleave_stage_v1(hle, &musyx, output_ptr);
+            STAGE_DONE(STAGE_INTERLEAVE, start);
+        }
 
         --sfd_count;
         if (sfd_count == 0)
@@ -257,6 +364,7 @@ void musyx_v1_task(struct hle_t* hle)
     dram_store_u16(hle, (uint16_t *)musyx.subframe_740_last4, state_ptr + STATE_740_LAST4_V1,
               4);
 
+    TASK_DONE(hle);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
@@ -314,8 +422,12 @@ void musyx_v2_task(struct hle_t* hle)
         output_ptr = voice_stage(hle, &musyx, voice_ptr, last_sample_ptr);
 
         /* apply delay-based effects (optional) */
-        sfx_stage(hle, mix_sfx_with_main_subframes_v2,
-                  &musyx, sfx_ptr, sfx_index);
+        {
+            STAGE_START(start);
+            sfx_stage(hle, mix_sfx_with_main_subframes_v2,
+                      &musyx, sfx_ptr, sfx_index);
+            STAGE_DONE(STAGE_SFX, start);
+        }
 
         dram_store_u16(hle, (uint16_t*)musyx.left,  output_ptr                  , SUBFRAME_SIZE);
         dram_store_u16(hle, (uint16_t*)musyx.right, output_ptr + 2*SUBFRAME_SIZE, SUBFRAME_SIZE);
@@ -326,8 +438,11 @@ void musyx_v2_task(struct hle_t* hle)
         dram_store_u16(hle, (uint16_t*)musyx.subframe_740_last4,
                 state_ptr + STATE_740_LAST4_V2, 4);
 
-        if (mask_16)
+        if (mask_16) {
+            STAGE_START(start);
             interleave_stage_v2(hle, &musyx, mask_16, ptr_18, ptr_1c, ptr_20);
+            STAGE_DONE(STAGE_INTERLEAVE, start);
+        }
 
         --sfd_count;
         if (sfd_count == 0)
@@ -336,6 +451,7 @@ void musyx_v2_task(struct hle_t* hle)
         sfd_ptr += SFD2_VOICES + MAX_VOICES * VOICE_SIZE;
     }
 
+    TASK_DONE(hle);
     rsp_break(hle, SP_STATUS_TASKDONE);
 }
 
@@ -473,10 +589,12 @@ static uint32_t voice_stage(struct hle_t* hle, musyx_t *musyx,
             int16_t samples[SAMPLE_BUFFER_SIZE];
             unsigned segbase;
             unsigned offset;
+            bool adpcm = (*dram_u8(hle, voice_ptr + VOICE_ADPCM_FRAMES) != 0);
+            STAGE_START(start);
 
             HleVerboseMessage(hle->user_defined, "Processing Voice #%d", i);
 
-            if (*dram_u8(hle, voice_ptr + VOICE_ADPCM_FRAMES) == 0)
+            if (!adpcm)
                 load_samples_PCM16(hle, voice_ptr, samples, &segbase, &offset);
             else
                 load_samples_ADPCM(hle, voice_ptr, samples, &segbase, &offset);
@@ -484,6 +602,7 @@ static uint32_t voice_stage(struct hle_t* hle, musyx_t *musyx,
             /* mix them with each internal subframes */
             mix_voice_samples(hle, musyx, voice_ptr, samples, segbase, offset,
                               last_sample_ptr + i * 8);
+            STAGE_DONE(adpcm ? STAGE_ADPCM_VOICE : STAGE_PCM16_VOICE, start);
 
             /* check break condition */
             output_ptr = *dram_u32(hle, voice_ptr + VOICE_INTERLEAVED_PTR);
@@ -613,6 +732,11 @@ static void adpcm_decode_frames(struct hle_t* hle,
     const uint8_t *nibbles = src + 8;
     unsigned i;
     bool jump_gap = false;
+#if defined(MUSYX_SSE2) || defined(MUSYX_NEON)
+    /* predictor columns of each codebook entry, built on first use */
+    int16_t columns[16][10 * 8];
+    uint16_t built = 0;
+#endif
 
     HleVerboseMessage(hle->user_defined,
                       "ADPCM decode: count=%d, skip=%d",
@@ -633,10 +757,23 @@ static void adpcm_decode_frames(struct hle_t* hle,
         adpcm_predict_frame(frame, src, nibbles, rshift);
 
         memcpy(dst, frame, 2 * sizeof(frame[0]));
+#if defined(MUSYX_SSE2) || defined(MUSYX_NEON)
+        if ((built & (1 << (c2 >> 4))) == 0) {
+            adpcm_build_columns(columns[c2 >> 4], book);
+            built |= 1 << (c2 >> 4);
+        }
+
+        /* the first quarter also writes dst[8..9], the next one overwrites them */
+        adpcm_compute_residuals_x8(dst +  2, frame +  2, columns[c2 >> 4], dst     );
+        adpcm_compute_residuals_x8(dst +  8, frame +  8, columns[c2 >> 4], dst +  6);
+        adpcm_compute_residuals_x8(dst + 16, frame + 16, columns[c2 >> 4], dst + 14);
+        adpcm_compute_residuals_x8(dst + 24, frame + 24, columns[c2 >> 4], dst + 22);
+#else
         adpcm_compute_residuals(dst +  2, frame +  2, book, dst     , 6);
         adpcm_compute_residuals(dst +  8, frame +  8, book, dst +  6, 8);
         adpcm_compute_residuals(dst + 16, frame + 16, book, dst + 14, 8);
         adpcm_compute_residuals(dst + 24, frame + 24, book, dst + 22, 8);
+#endif
 
         if (jump_gap) {
             nibbles += 8;
@@ -667,6 +804,227 @@ static void adpcm_predict_frame(int16_t *dst, const uint8_t *src,
     }
 }
 
+#if defined(MUSYX_SSE2) || defined(MUSYX_NEON)
+/* Lays out the predictor of a codebook entry as one column per input, so that
+ * adpcm_compute_residuals computes sum(columns[c] * in[c]) >> 11 with
+ * in = { l1, l2, src[0..7] } */
+static void adpcm_build_columns(int16_t *columns, const int16_t *book)
+{
+    unsigned c, i;
+
+    for (i = 0; i < 8; ++i) {
+        columns[0 * 8 + i] = book[i];
+        columns[1 * 8 + i] = book[8 + i];
+    }
+
+    for (c = 0; c < 8; ++c) {
+        for (i = 0; i < 8; ++i)
+            columns[(2 + c) * 8 + i] = (i < c) ? 0 : (i == c) ? 0x800 : book[8 + i - 1 - c];
+    }
+}
+
+/* adpcm_compute_residuals for 8 samples, the 32-bit sums wrap like the scalar ones */
+static void adpcm_compute_residuals_x8(int16_t *dst, const int16_t *src,
+                                       const int16_t *columns,
+                                       const int16_t *last_samples)
+{
+    int16_t in[10];
+    unsigned c;
+#if defined(MUSYX_SSE2)
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+#else
+    int32x4_t lo = vdupq_n_s32(0);
+    int32x4_t hi = vdupq_n_s32(0);
+#endif
+
+    in[0] = last_samples[0];
+    in[1] = last_samples[1];
+    memcpy(in + 2, src, 8 * sizeof(in[0]));
+
+#if defined(MUSYX_SSE2)
+    for (c = 0; c < 10; c += 2) {
+        const __m128i a = _mm_loadu_si128((const __m128i *)&columns[(c + 0) * 8]);
+        const __m128i b = _mm_loadu_si128((const __m128i *)&columns[(c + 1) * 8]);
+        const __m128i x = _mm_set1_epi32((uint16_t)in[c] | ((uint32_t)(uint16_t)in[c + 1] << 16));
+
+        lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), x));
+        hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), x));
+    }
+
+    _mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(_mm_srai_epi32(lo, 11),
+                                                     _mm_srai_epi32(hi, 11)));
+#else
+    for (c = 0; c < 10; ++c) {
+        const int16x8_t column = vld1q_s16(&columns[c * 8]);
+
+        lo = vmlal_n_s16(lo, vget_low_s16(column), in[c]);
+        hi = vmlal_n_s16(hi, vget_high_s16(column), in[c]);
+    }
+
+    vst1q_s16(dst, vcombine_s16(vqshrn_n_s32(lo, 11), vqshrn_n_s32(hi, 11)));
+#endif
+}
+
+#if defined(MUSYX_SSE2)
+/* Loads 4 samples from each of 8 rows and transposes them so that taps[k]
+ * holds sample k of every row */
+static void load_taps_x8(__m128i *taps, const int16_t *const *rows)
+{
+    const __m128i a0 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)rows[0]),
+                                          _mm_loadl_epi64((const __m128i *)rows[1]));
+    const __m128i a1 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)rows[2]),
+                                          _mm_loadl_epi64((const __m128i *)rows[3]));
+    const __m128i a2 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)rows[4]),
+                                          _mm_loadl_epi64((const __m128i *)rows[5]));
+    const __m128i a3 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)rows[6]),
+                                          _mm_loadl_epi64((const __m128i *)rows[7]));
+
+    /* rows 0,2 / 1,3 / 4,6 / 5,7 interleaved */
+    const __m128i b0 = _mm_unpacklo_epi16(a0, a1);
+    const __m128i b1 = _mm_unpackhi_epi16(a0, a1);
+    const __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+    const __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+
+    /* samples 0,1 / 2,3 of rows 0-3 and rows 4-7 */
+    const __m128i c0 = _mm_unpacklo_epi16(b0, b1);
+    const __m128i c1 = _mm_unpackhi_epi16(b0, b1);
+    const __m128i c2 = _mm_unpacklo_epi16(b2, b3);
+    const __m128i c3 = _mm_unpackhi_epi16(b2, b3);
+
+    taps[0] = _mm_unpacklo_epi64(c0, c2);
+    taps[1] = _mm_unpackhi_epi64(c0, c2);
+    taps[2] = _mm_unpacklo_epi64(c1, c3);
+    taps[3] = _mm_unpackhi_epi64(c1, c3);
+}
+#else
+static void load_taps_x8(int16x8_t *taps, const int16_t *const *rows)
+{
+    const int16x8_t a0 = vcombine_s16(vld1_s16(rows[0]), vld1_s16(rows[1]));
+    const int16x8_t a1 = vcombine_s16(vld1_s16(rows[2]), vld1_s16(rows[3]));
+    const int16x8_t a2 = vcombine_s16(vld1_s16(rows[4]), vld1_s16(rows[5]));
+    const int16x8_t a3 = vcombine_s16(vld1_s16(rows[6]), vld1_s16(rows[7]));
+
+    /* rows 0,2 / 1,3 / 4,6 / 5,7 interleaved */
+    const int16x8x2_t b01 = vzipq_s16(a0, a1);
+    const int16x8x2_t b23 = vzipq_s16(a2, a3);
+
+    /* samples 0,1 / 2,3 of rows 0-3 and rows 4-7 */
+    const int16x8x2_t c01 = vzipq_s16(b01.val[0], b01.val[1]);
+    const int16x8x2_t c23 = vzipq_s16(b23.val[0], b23.val[1]);
+
+    taps[0] = vcombine_s16(vget_low_s16(c01.val[0]), vget_low_s16(c23.val[0]));
+    taps[1] = vcombine_s16(vget_high_s16(c01.val[0]), vget_high_s16(c23.val[0]));
+    taps[2] = vcombine_s16(vget_low_s16(c01.val[1]), vget_low_s16(c23.val[1]));
+    taps[3] = vcombine_s16(vget_high_s16(c01.val[1]), vget_high_s16(c23.val[1]));
+}
+#endif
+
+/* dst[j] = dot4(samples[j], luts[j]) for 8 output samples, keeping the
+ * clamp after each tap */
+static void resample_x8(int16_t *dst, const int16_t *const *samples,
+                        const int16_t *const *luts)
+{
+    unsigned k;
+
+#if defined(MUSYX_SSE2)
+    __m128i x[4];
+    __m128i h[4];
+    __m128i v = _mm_setzero_si128();
+
+    load_taps_x8(x, samples);
+    load_taps_x8(h, luts);
+
+    for (k = 0; k < 4; ++k) {
+        const __m128i lo = _mm_mullo_epi16(x[k], h[k]);
+        const __m128i hi = _mm_mulhi_epi16(x[k], h[k]);
+
+        v = _mm_packs_epi32(
+                _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16),
+                              _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15)),
+                _mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16),
+                              _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15)));
+    }
+
+    _mm_storeu_si128((__m128i *)dst, v);
+#else
+    int16x8_t x[4];
+    int16x8_t h[4];
+    int16x8_t v = vdupq_n_s16(0);
+
+    load_taps_x8(x, samples);
+    load_taps_x8(h, luts);
+
+    for (k = 0; k < 4; ++k) {
+        const int32x4_t lo = vaddq_s32(vmovl_s16(vget_low_s16(v)),
+                vshrq_n_s32(vmull_s16(vget_low_s16(x[k]), vget_low_s16(h[k])), 15));
+        const int32x4_t hi = vaddq_s32(vmovl_s16(vget_high_s16(v)),
+                vshrq_n_s32(vmull_s16(vget_high_s16(x[k]), vget_high_s16(h[k])), 15));
+
+        v = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+    }
+
+    vst1q_s16(dst, v);
+#endif
+}
+
+/* Mixes a resampled subframe into dst with a linear envelope, like the
+ * envmix step of mix_voice_samples */
+static void envmix_subframe(int16_t *dst, const int16_t *v,
+                            int32_t env, int32_t env_step)
+{
+    unsigned i;
+    const uint32_t e = (uint32_t)env;
+    const uint32_t s = (uint32_t)env_step;
+
+#if defined(MUSYX_SSE2)
+    const __m128i step = _mm_set1_epi32((int32_t)(s * 8));
+    __m128i env_lo = _mm_setr_epi32((int32_t)e, (int32_t)(e + s),
+                                    (int32_t)(e + s * 2), (int32_t)(e + s * 3));
+    __m128i env_hi = _mm_add_epi32(env_lo, _mm_set1_epi32((int32_t)(s * 4)));
+
+    for (i = 0; i < SUBFRAME_SIZE; i += 8) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)&v[i]);
+        const __m128i y = _mm_loadu_si128((const __m128i *)&dst[i]);
+        const __m128i gain = _mm_packs_epi32(_mm_srai_epi32(env_lo, 16),
+                                             _mm_srai_epi32(env_hi, 16));
+        const __m128i lo = _mm_mullo_epi16(x, gain);
+        const __m128i hi = _mm_mulhi_epi16(x, gain);
+
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packs_epi32(
+                _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15),
+                              _mm_srai_epi32(_mm_unpacklo_epi16(y, y), 16)),
+                _mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15),
+                              _mm_srai_epi32(_mm_unpackhi_epi16(y, y), 16))));
+
+        env_lo = _mm_add_epi32(env_lo, step);
+        env_hi = _mm_add_epi32(env_hi, step);
+    }
+#else
+    const int32_t lanes[4] = {
+        (int32_t)e, (int32_t)(e + s), (int32_t)(e + s * 2), (int32_t)(e + s * 3)
+    };
+    const int32x4_t step = vdupq_n_s32((int32_t)(s * 8));
+    int32x4_t env_lo = vld1q_s32(lanes);
+    int32x4_t env_hi = vaddq_s32(env_lo, vdupq_n_s32((int32_t)(s * 4)));
+
+    for (i = 0; i < SUBFRAME_SIZE; i += 8) {
+        const int16x8_t x = vld1q_s16(&v[i]);
+        const int16x8_t y = vld1q_s16(&dst[i]);
+        const int32x4_t lo = vaddw_s16(vshrq_n_s32(vmull_s16(vget_low_s16(x),
+                                       vshrn_n_s32(env_lo, 16)), 15), vget_low_s16(y));
+        const int32x4_t hi = vaddw_s16(vshrq_n_s32(vmull_s16(vget_high_s16(x),
+                                       vshrn_n_s32(env_hi, 16)), 15), vget_high_s16(y));
+
+        vst1q_s16(&dst[i], vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+
+        env_lo = vaddq_s32(env_lo, step);
+        env_hi = vaddq_s32(env_hi, step);
+    }
+#endif
+}
+#endif
+
 static void mix_voice_samples(struct hle_t* hle, musyx_t *musyx,
                               uint32_t voice_ptr, const int16_t *samples,
                               unsigned segbase, unsigned offset, uint32_t last_sample_ptr)
@@ -696,6 +1054,9 @@ static void mix_voice_samples(struct hle_t* hle, musyx_t *musyx,
     int32_t  v4_env_step[4];
     int16_t *v4_dst[4];
     int16_t  v4[4];
+#if defined(MUSYX_SSE2) || defined(MUSYX_NEON)
+    int16_t  resampled[SUBFRAME_SIZE];
+#endif
 
     dram_load_u32(hle, (uint32_t *)v4_env,      voice_ptr + VOICE_ENV_BEGIN, 4);
     dram_load_u32(hle, (uint32_t *)v4_env_step, voice_ptr + VOICE_ENV_STEP,  4);
@@ -719,6 +1080,43 @@ static void mix_voice_samples(struct hle_t* hle, musyx_t *musyx,
                       v4_env[0],      v4_env[1],      v4_env[2],      v4_env[3],
                       v4_env_step[0], v4_env_step[1], v4_env_step[2], v4_env_step[3]);
 
+#if defined(MUSYX_SSE2) || defined(MUSYX_NEON)
+    /* resample the whole subframe first, then envmix it into each destination */
+    for (i = 0; i < SUBFRAME_SIZE; i += 8) {
+        const int16_t *taps[8];
+        const int16_t *luts[8];
+        int j;
+
+        for (j = 0; j < 8; ++j) {
+            /* update sample and lut pointers and then pitch_accu */
+            int dist;
+
+            luts[j] = RESAMPLE_LUT + ((pitch_accu & 0xfc00) >> 8);
+
+            sample += (pitch_accu >> 16);
+            pitch_accu &= 0xffff;
+            pitch_accu += pitch_step;
+
+            /* handle end/restart points */
+            dist = sample - sample_end;
+            if (dist >= 0)
+                sample = sample_restart + dist;
+
+            taps[j] = sample;
+        }
+
+        resample_x8(&resampled[i], taps, luts);
+    }
+
+    for (k = 0; k < 4; ++k) {
+        /* envelope value of the last sample */
+        int32_t env = (int32_t)((uint32_t)v4_env[k] +
+                                (uint32_t)v4_env_step[k] * (SUBFRAME_SIZE - 1));
+
+        envmix_subframe(v4_dst[k], resampled, v4_env[k], v4_env_step[k]);
+        v4[k] = clamp_s16((resampled[SUBFRAME_SIZE - 1] * (env >> 16)) >> 15);
+    }
+#else
     for (i = 0; i < SUBFRAME_SIZE; ++i) {
         /* update sample and lut pointers and then pitch_accu */
         const int16_t *lut = (RESAMPLE_LUT + ((pitch_accu & 0xfc00) >> 8));
@@ -748,6 +1146,7 @@ static void mix_voice_samples(struct hle_t* hle, musyx_t *musyx,
             v4_env[k] += v4_env_step[k];
         }
     }
+#endif
 
     /* save last resampled sample */
     dram_store_u16(hle, (uint16_t *)v4, last_sample_ptr, 4);
@@ -856,11 +1255,29 @@ static void mix_sfx_with_main_subframes_v1(musyx_t *musyx, const int16_t *subfra
 {
     unsigned i;
 
+#if defined(MUSYX_SSE2)
+    for (i = 0; i < SUBFRAME_SIZE; i += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)&subframe[i]);
+        __m128i *left  = (__m128i *)&musyx->left[i];
+        __m128i *right = (__m128i *)&musyx->right[i];
+
+        _mm_storeu_si128(left,  _mm_adds_epi16(_mm_loadu_si128(left),  v));
+        _mm_storeu_si128(right, _mm_adds_epi16(_mm_loadu_si128(right), v));
+    }
+#elif defined(MUSYX_NEON)
+    for (i = 0; i < SUBFRAME_SIZE; i += 8) {
+        const int16x8_t v = vld1q_s16(&subframe[i]);
+
+        vst1q_s16(&musyx->left[i],  vqaddq_s16(vld1q_s16(&musyx->left[i]),  v));
+        vst1q_s16(&musyx->right[i], vqaddq_s16(vld1q_s16(&musyx->right[i]), v));
+    }
+#else
     for (i = 0; i < SUBFRAME_SIZE; ++i) {
         int16_t v = subframe[i];
         musyx->left[i]  = clamp_s16(musyx->left[i]  + v);
         musyx->right[i] = clamp_s16(musyx->right[i] + v);
     }
+#endif
 }
 
 static void mix_sfx_with_main_subframes_v2(musyx_t *musyx, const int16_t *subframe,
@@ -868,6 +1285,40 @@ static void mix_sfx_with_main_subframes_v2(musyx_t *musyx, const int16_t *subfra
 {
     unsigned i;
 
+#if defined(MUSYX_SSE2)
+    /* mulhi treats a gain >= 0x8000 as gain - 0x10000, adding v back fixes that up */
+    const __m128i g0 = _mm_set1_epi16((int16_t)gains[0]);
+    const __m128i g1 = _mm_set1_epi16((int16_t)gains[1]);
+    const __m128i fix0 = _mm_set1_epi16((gains[0] & 0x8000) ? -1 : 0);
+    const __m128i fix1 = _mm_set1_epi16((gains[1] & 0x8000) ? -1 : 0);
+
+    for (i = 0; i < SUBFRAME_SIZE; i += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)&subframe[i]);
+        const __m128i v1 = _mm_add_epi16(_mm_mulhi_epi16(v, g0), _mm_and_si128(v, fix0));
+        const __m128i v2 = _mm_add_epi16(_mm_mulhi_epi16(v, g1), _mm_and_si128(v, fix1));
+        __m128i *left  = (__m128i *)&musyx->left[i];
+        __m128i *right = (__m128i *)&musyx->right[i];
+        __m128i *cc0   = (__m128i *)&musyx->cc0[i];
+
+        _mm_storeu_si128(left,  _mm_adds_epi16(_mm_loadu_si128(left),  v1));
+        _mm_storeu_si128(right, _mm_adds_epi16(_mm_loadu_si128(right), v1));
+        _mm_storeu_si128(cc0,   _mm_adds_epi16(_mm_loadu_si128(cc0),   v2));
+    }
+#elif defined(MUSYX_NEON)
+    for (i = 0; i < SUBFRAME_SIZE; i += 8) {
+        const int16x8_t v = vld1q_s16(&subframe[i]);
+        const int32x4_t lo = vmovl_s16(vget_low_s16(v));
+        const int32x4_t hi = vmovl_s16(vget_high_s16(v));
+        const int16x8_t v1 = vcombine_s16(vshrn_n_s32(vmulq_n_s32(lo, gains[0]), 16),
+                                          vshrn_n_s32(vmulq_n_s32(hi, gains[0]), 16));
+        const int16x8_t v2 = vcombine_s16(vshrn_n_s32(vmulq_n_s32(lo, gains[1]), 16),
+                                          vshrn_n_s32(vmulq_n_s32(hi, gains[1]), 16));
+
+        vst1q_s16(&musyx->left[i],  vqaddq_s16(vld1q_s16(&musyx->left[i]),  v1));
+        vst1q_s16(&musyx->right[i], vqaddq_s16(vld1q_s16(&musyx->right[i]), v1));
+        vst1q_s16(&musyx->cc0[i],   vqaddq_s16(vld1q_s16(&musyx->cc0[i]),   v2));
+    }
+#else
     for (i = 0; i < SUBFRAME_SIZE; ++i) {
         int16_t v = subframe[i];
         int16_t v1 = (int32_t)(v * gains[0]) >> 16;
@@ -877,6 +1328,7 @@ static void mix_sfx_with_main_subframes_v2(musyx_t *musyx, const int16_t *subfra
         musyx->right[i] = clamp_s16(musyx->right[i] + v1);
         musyx->cc0[i]   = clamp_s16(musyx->cc0[i]   + v2);
     }
+#endif
 }
 
 static void mix_samples(int16_t *y, int16_t x, int16_t hgain)
@@ -888,8 +1340,37 @@ static void mix_subframes(int16_t *y, const int16_t *x, int16_t hgain)
 {
     unsigned int i;
 
+#if defined(MUSYX_SSE2)
+    const __m128i gain = _mm_set1_epi16(hgain);
+    const __m128i round = _mm_set1_epi32(0x4000);
+
+    for (i = 0; i < SUBFRAME_SIZE; i += 8) {
+        const __m128i a = _mm_loadu_si128((const __m128i *)&x[i]);
+        const __m128i b = _mm_loadu_si128((const __m128i *)&y[i]);
+        const __m128i lo = _mm_mullo_epi16(a, gain);
+        const __m128i hi = _mm_mulhi_epi16(a, gain);
+
+        _mm_storeu_si128((__m128i *)&y[i], _mm_packs_epi32(
+                _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), round), 15),
+                              _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16)),
+                _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), round), 15),
+                              _mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16))));
+    }
+#elif defined(MUSYX_NEON)
+    for (i = 0; i < SUBFRAME_SIZE; i += 8) {
+        const int16x8_t a = vld1q_s16(&x[i]);
+        const int16x8_t b = vld1q_s16(&y[i]);
+        const int32x4_t lo = vaddw_s16(vrshrq_n_s32(vmull_n_s16(vget_low_s16(a), hgain), 15),
+                                       vget_low_s16(b));
+        const int32x4_t hi = vaddw_s16(vrshrq_n_s32(vmull_n_s16(vget_high_s16(a), hgain), 15),
+                                       vget_high_s16(b));
+
+        vst1q_s16(&y[i], vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+#else
     for (i = 0; i < SUBFRAME_SIZE; ++i)
         mix_samples(&y[i], x[i], hgain);
+#endif
 }
 
 static void mix_fir4(int16_t *y, const int16_t *x, int16_t hgain, const int16_t *hcoeffs)
@@ -902,6 +1383,49 @@ static void mix_fir4(int16_t *y, const int16_t *x, int16_t hgain, const int16_t
     h[2] = (hgain * hcoeffs[2]) >> 15;
     h[3] = (hgain * hcoeffs[3]) >> 15;
 
+#if defined(MUSYX_SSE2) || defined(MUSYX_NEON)
+    /* h is 0x8000 only when both factors are -0x8000, which 16-bit lanes cannot hold */
+    if (h[0] <= INT16_MAX && h[1] <= INT16_MAX && h[2] <= INT16_MAX && h[3] <= INT16_MAX) {
+#if defined(MUSYX_SSE2)
+        const __m128i h01 = _mm_set1_epi32((uint16_t)h[0] | ((uint32_t)(uint16_t)h[1] << 16));
+        const __m128i h23 = _mm_set1_epi32((uint16_t)h[2] | ((uint32_t)(uint16_t)h[3] << 16));
+
+        for (i = 0; i < SUBFRAME_SIZE; i += 8) {
+            const __m128i x0 = _mm_loadu_si128((const __m128i *)&x[i + 0]);
+            const __m128i x1 = _mm_loadu_si128((const __m128i *)&x[i + 1]);
+            const __m128i x2 = _mm_loadu_si128((const __m128i *)&x[i + 2]);
+            const __m128i x3 = _mm_loadu_si128((const __m128i *)&x[i + 3]);
+            const __m128i b = _mm_loadu_si128((const __m128i *)&y[i]);
+            const __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(x0, x1), h01),
+                                             _mm_madd_epi16(_mm_unpacklo_epi16(x2, x3), h23));
+            const __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(x0, x1), h01),
+                                             _mm_madd_epi16(_mm_unpackhi_epi16(x2, x3), h23));
+
+            _mm_storeu_si128((__m128i *)&y[i], _mm_packs_epi32(
+                    _mm_add_epi32(_mm_srai_epi32(lo, 15), _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16)),
+                    _mm_add_epi32(_mm_srai_epi32(hi, 15), _mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16))));
+        }
+#else
+        for (i = 0; i < SUBFRAME_SIZE; i += 8) {
+            int32x4_t lo = vmull_n_s16(vld1_s16(&x[i + 0]), h[0]);
+            int32x4_t hi = vmull_n_s16(vld1_s16(&x[i + 4]), h[0]);
+            const int16x8_t b = vld1q_s16(&y[i]);
+            unsigned k;
+
+            for (k = 1; k < 4; ++k) {
+                lo = vmlal_n_s16(lo, vld1_s16(&x[i + k + 0]), h[k]);
+                hi = vmlal_n_s16(hi, vld1_s16(&x[i + k + 4]), h[k]);
+            }
+
+            lo = vaddw_s16(vshrq_n_s32(lo, 15), vget_low_s16(b));
+            hi = vaddw_s16(vshrq_n_s32(hi, 15), vget_high_s16(b));
+            vst1q_s16(&y[i], vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+        }
+#endif
+        return;
+    }
+#endif
+
     for (i = 0; i < SUBFRAME_SIZE; ++i) {
         int32_t v = (h[0] * x[i] + h[1] * x[i + 1] + h[2] * x[i + 2] + h[3] * x[i + 3]) >> 15;
         y[i] = clamp_s16(y[i] + v);
@@ -0,0 +1,235 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-hle - jpeg_test.c                                     *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Runs generated PS, PS0 and OB jpeg tasks and checks that RDRAM ends up
+ * with the content recorded from the scalar decoder, before it had vector
+ * paths.
+ *
+ * Macroblocks use full range, typical (small, mostly zero high frequency)
+ * and saturated coefficients, with both subsampling modes and a range of
+ * OB quantization scales.  The scalar fallback is checked by building the
+ * plugin objects without vector units, e.g.
+ *   make clean test CPPFLAGS=-U__SSE2__
+ *
+ * The recorded hashes were generated with the same test linked against
+ * jpeg.c and memory.c of the tree before the vector paths.  The scalar
+ * fallback still produces them, so after an intended change of output
+ * they are regenerated with
+ *   make clean jpeg_test CPPFLAGS=-U__SSE2__ && ./jpeg_test record
+ * which prints the recorded_hash table.
+ *
+ * Usage: jpeg_test [bench|record]
+ *   bench also prints the decoding time of a 256 macroblock task.
+ *   record prints the hashes of this build as the recorded_hash table.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "hle_internal.h"
+#include "memory.h"
+#include "ucodes.h"
+
+enum { DRAM_SIZE = 0x100000 };
+enum { MACROBLOCK_SIZE = 6 * 64 * 2 };
+enum { TASKS_PER_CASE = 16 };
+
+typedef void (*jpeg_task_t)(struct hle_t* hle);
+
+static const struct {
+    const char *name;
+    jpeg_task_t task;
+} tasks[] = {
+    { "PS",  jpeg_decode_PS },
+    { "PS0", jpeg_decode_PS0 },
+    { "OB",  jpeg_decode_OB },
+};
+
+/* RDRAM hashes of each task kind, as the scalar decoder left them */
+static const uint64_t recorded_hash[] = {
+    0x97F34EE618076E83ull, 0x00B42E6CD4DDE88Full, 0x263451B1E8474CE2ull
+};
+
+static uint32_t dram_words[DRAM_SIZE / 4];
+static uint32_t dmem_words[0x1000 / 4];
+static struct hle_t hle;
+
+/* the jpeg tasks do not talk to the core */
+void HleVerboseMessage(void* user_defined, const char *message, ...) { }
+void HleWarnMessage(void* user_defined, const char *message, ...) { }
+void rsp_break(struct hle_t* hle, unsigned int setbits) { }
+
+static uint64_t seed = 88172645463325252ull;
+
+static uint32_t random_u32(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return (uint32_t)seed;
+}
+
+enum { FULL_RANGE, TYPICAL, SATURATED };
+
+static int16_t random_coefficient(int distribution)
+{
+    uint32_t r;
+
+    switch (distribution) {
+    case FULL_RANGE:
+        return (int16_t)random_u32();
+    case TYPICAL:
+        return (int16_t)((int)(random_u32() % 512) - 256);
+    default:
+        r = random_u32() % 8;
+        return (r == 0) ? INT16_MIN
+             : (r == 1) ? INT16_MAX
+             : (int16_t)((int)(random_u32() % 64) - 32);
+    }
+}
+
+static int16_t random_quantizer(int distribution)
+{
+    switch (distribution) {
+    case FULL_RANGE: return (int16_t)random_u32();
+    case TYPICAL:    return (int16_t)(1 + random_u32() % 100);
+    default:         return (int16_t)(1 + random_u32() % 4000);
+    }
+}
+
+/* lays out a task of count macroblocks in DRAM and DMEM */
+static void setup_task(unsigned int kind, unsigned int count, uint32_t mode,
+                       int32_t qscale, int distribution)
+{
+    const uint32_t macroblocks = 0x10000;
+    unsigned int i;
+
+    memset(dram_words, 0, sizeof(dram_words));
+    memset(dmem_words, 0, sizeof(dmem_words));
+
+    for (i = 0; i < count * MACROBLOCK_SIZE / 2; ++i)
+        *dram_u16(&hle, macroblocks + 2 * i) = (distribution != TYPICAL || i % 64 < 12)
+            ? (uint16_t)random_coefficient(distribution) : 0;
+
+    if (tasks[kind].task == jpeg_decode_OB) {
+        *dmem_u32(&hle, TASK_DATA_PTR) = macroblocks;
+        *dmem_u32(&hle, TASK_DATA_SIZE) = count;
+        *dmem_u32(&hle, TASK_YIELD_DATA_SIZE) = (uint32_t)qscale;
+    } else {
+        const uint32_t header = 0x1000;
+        const uint32_t qtables = 0x2000;
+
+        *dmem_u32(&hle, TASK_DATA_PTR) = header;
+        *dram_u32(&hle, header) = macroblocks;
+        *dram_u32(&hle, header + 4) = count;
+        *dram_u32(&hle, header + 8) = mode;
+        for (i = 0; i < 3; ++i)
+            *dram_u32(&hle, header + 12 + 4 * i) = qtables + 128 * i;
+        for (i = 0; i < 3 * 64; ++i)
+            *dram_u16(&hle, qtables + 2 * i) = (uint16_t)random_quantizer(distribution);
+    }
+}
+
+static uint64_t hash_dram(uint64_t hash)
+{
+    size_t i;
+
+    for (i = 0; i < DRAM_SIZE / 4; ++i)
+        hash = (hash ^ dram_words[i]) * 0x00000100000001B3ull;
+    return hash;
+}
+
+static double bench_task(unsigned int kind)
+{
+    enum { COUNT = 256, RUNS = 200 };
+    struct timespec start, end;
+    static uint32_t initial[DRAM_SIZE / 4];
+    unsigned int run;
+
+    setup_task(kind, COUNT, 2, 2, TYPICAL);
+    memcpy(initial, dram_words, sizeof(initial));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (run = 0; run < RUNS; ++run) {
+        /* tasks decode in place */
+        memcpy(dram_words, initial, sizeof(initial));
+        tasks[kind].task(&hle);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / RUNS;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int kind;
+    uint64_t hashes[sizeof(tasks) / sizeof(tasks[0])];
+    int record = (argc > 1 && strcmp(argv[1], "record") == 0);
+    int failed = 0;
+
+    hle.dram = (unsigned char *)dram_words;
+    hle.dmem = (unsigned char *)dmem_words;
+
+    for (kind = 0; kind < sizeof(tasks) / sizeof(tasks[0]); ++kind) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        int distribution;
+        unsigned int mode, i;
+
+        for (distribution = FULL_RANGE; distribution <= SATURATED; ++distribution) {
+            for (mode = 0; mode <= 2; mode += 2) {
+                for (i = 0; i < TASKS_PER_CASE; ++i) {
+                    int32_t qscale = (int32_t)(random_u32() % 9) - 4;
+
+                    setup_task(kind, 32, mode, qscale, distribution);
+                    tasks[kind].task(&hle);
+                    hash = hash_dram(hash);
+                }
+            }
+        }
+
+        hashes[kind] = hash;
+        if (record)
+            continue;
+
+        if (hash != recorded_hash[kind]) {
+            printf("%s: RDRAM hash %016llX, recorded %016llX\n", tasks[kind].name,
+                   (unsigned long long)hash, (unsigned long long)recorded_hash[kind]);
+            failed = 1;
+        } else {
+            printf("%s: %u tasks match\n", tasks[kind].name, 6 * TASKS_PER_CASE);
+        }
+    }
+
+    if (record) {
+        printf("static const uint64_t recorded_hash[] = {\n    0x%016llXull, 0x%016llXull, 0x%016llXull\n};\n",
+               (unsigned long long)hashes[0], (unsigned long long)hashes[1], (unsigned long long)hashes[2]);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        for (kind = 0; kind < sizeof(tasks) / sizeof(tasks[0]); ++kind)
+            printf("%s: %.1f us per 256 macroblock task\n", tasks[kind].name,
+                   bench_task(kind) / 1000.0);
+    }
+
+    return failed;
+}
@@ -0,0 +1,187 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-hle - mp3_test.c                                      *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Runs generated streams of mp3 tasks and checks that RDRAM and the mp3
+ * buffer end up with the content recorded from the scalar filter bank,
+ * before it had vector paths.
+ *
+ * Streams decode full range, typical and saturated samples with random
+ * indices and addresses, starting from a cleared or a random mp3 buffer.
+ * The scalar fallback is checked by building the plugin objects without
+ * vector units, e.g.
+ *   make clean test CPPFLAGS=-U__SSE2__
+ *
+ * The recorded hashes were generated with the same test linked against
+ * mp3.c and memory.c of the tree before the vector paths.  The scalar
+ * fallback still produces them, so after an intended change of output
+ * they are regenerated with
+ *   make clean mp3_test CPPFLAGS=-U__SSE2__ && ./mp3_test record
+ * which prints the recorded_hash table.
+ *
+ * Usage: mp3_test [bench|record]
+ *   bench also prints the time of one mp3 task.
+ *   record prints the hashes of this build as the recorded_hash table.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "hle_internal.h"
+#include "ucodes.h"
+
+enum { DRAM_SIZE = 0x100000 };
+enum { STREAMS_PER_CASE = 16 };
+enum { TASKS_PER_STREAM = 64 };
+
+enum { FULL_RANGE, TYPICAL, SATURATED, DISTRIBUTIONS };
+
+static const char *const distribution_names[DISTRIBUTIONS] = {
+    "full range", "typical", "saturated"
+};
+
+/* RDRAM and mp3 buffer hashes of each distribution, as the scalar filter
+ * bank left them */
+static const uint64_t recorded_hash[DISTRIBUTIONS] = {
+    0xC581F0561E77317Bull, 0x07A7C1B35E3D389Aull, 0x465A71876D1AE4F9ull
+};
+
+static uint32_t dram_words[DRAM_SIZE / 4];
+static struct hle_t hle;
+
+static uint64_t seed = 88172645463325252ull;
+
+static uint32_t random_u32(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return (uint32_t)seed;
+}
+
+static uint16_t random_sample(int distribution)
+{
+    uint32_t r;
+
+    switch (distribution) {
+    case FULL_RANGE:
+        return (uint16_t)random_u32();
+    case TYPICAL:
+        return (uint16_t)((int)(random_u32() % 4096) - 2048);
+    default:
+        r = random_u32() % 4;
+        return (r == 0) ? 0x8000 : (r == 1) ? 0x7FFF : (uint16_t)random_u32();
+    }
+}
+
+static void fill_dram(int distribution)
+{
+    size_t i;
+
+    for (i = 0; i < DRAM_SIZE / 4; ++i)
+        dram_words[i] = ((uint32_t)random_sample(distribution) << 16) | random_sample(distribution);
+}
+
+static uint64_t hash_words(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = data;
+    size_t i;
+
+    for (i = 0; i < size; i += 4) {
+        uint32_t word;
+        memcpy(&word, bytes + i, 4);
+        hash = (hash ^ word) * 0x00000100000001B3ull;
+    }
+    return hash;
+}
+
+static double bench_task(void)
+{
+    enum { RUNS = 20000 };
+    struct timespec start, end;
+    unsigned int run;
+
+    fill_dram(TYPICAL);
+    memset(hle.mp3_buffer, 0, sizeof(hle.mp3_buffer));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (run = 0; run < RUNS; ++run)
+        mp3_task(&hle, (run % 16) * 2, 0x1000 + (run % 64) * 0x500);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / RUNS;
+}
+
+int main(int argc, char **argv)
+{
+    int distribution;
+    uint64_t hashes[DISTRIBUTIONS];
+    int record = (argc > 1 && strcmp(argv[1], "record") == 0);
+    int failed = 0;
+
+    hle.dram = (unsigned char *)dram_words;
+
+    for (distribution = FULL_RANGE; distribution < DISTRIBUTIONS; ++distribution) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        unsigned int stream, task, i;
+
+        for (stream = 0; stream < STREAMS_PER_CASE; ++stream) {
+            fill_dram(distribution);
+            for (i = 0; i < sizeof(hle.mp3_buffer); ++i)
+                hle.mp3_buffer[i] = (stream % 2) ? (uint8_t)random_u32() : 0;
+
+            /* a game decoding a song */
+            for (task = 0; task < TASKS_PER_STREAM; ++task) {
+                unsigned int index = (random_u32() % 16) * 2;
+                uint32_t address = 0x1000 + (random_u32() % 0x100) * 0x500;
+
+                mp3_task(&hle, index, address);
+            }
+
+            hash = hash_words(hash, dram_words, sizeof(dram_words));
+            hash = hash_words(hash, hle.mp3_buffer, sizeof(hle.mp3_buffer));
+        }
+
+        hashes[distribution] = hash;
+        if (record)
+            continue;
+
+        if (hash != recorded_hash[distribution]) {
+            printf("%s: hash %016llX, recorded %016llX\n", distribution_names[distribution],
+                   (unsigned long long)hash, (unsigned long long)recorded_hash[distribution]);
+            failed = 1;
+        } else {
+            printf("%s: %u streams match\n", distribution_names[distribution], STREAMS_PER_CASE);
+        }
+    }
+
+    if (record) {
+        printf("static const uint64_t recorded_hash[DISTRIBUTIONS] = {\n"
+               "    0x%016llXull, 0x%016llXull, 0x%016llXull\n};\n",
+               (unsigned long long)hashes[0], (unsigned long long)hashes[1], (unsigned long long)hashes[2]);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+        printf("%.2f us per mp3 task\n", bench_task() / 1000.0);
+
+    return failed;
+}
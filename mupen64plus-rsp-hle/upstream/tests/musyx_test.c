@@ -0,0 +1,506 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-rsp-hle - musyx_test.c                                    *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2026 Mupen64plus development team                       *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Runs generated MusyX v1 and v2 tasks and checks that RDRAM ends up with
+ * the content recorded from the scalar voice, ADPCM and sfx code, before it
+ * had vector paths.
+ *
+ * Tasks chain up to 3 sound frames.  Voices are PCM16 or ADPCM, with
+ * random skips, end and restart points, envelopes and pitches.  Sfx use up
+ * to 8 taps and an optional FIR4, v2 tasks also interleave subframes.
+ * Samples are full range, typical or saturated.  The scalar fallback is
+ * checked by building the plugin objects without vector units, e.g.
+ *   make clean test CPPFLAGS=-U__SSE2__
+ *
+ * The recorded hashes were generated with the same test linked against
+ * musyx.c, audio.c and memory.c of the tree before the vector paths.  The
+ * scalar fallback still produces them, so after an intended change of
+ * output they are regenerated with
+ *   make clean musyx_test CPPFLAGS=-U__SSE2__ && ./musyx_test record
+ * which prints the recorded_hash table.
+ *
+ * Usage: musyx_test [bench|record]
+ *   bench also prints the time of a task for each workload.  With a plugin
+ *   built with MUSYX_TIMING=1 the time of each stage is printed as well.
+ *   record prints the hashes of this build as the recorded_hash table.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hle_internal.h"
+#include "memory.h"
+#include "ucodes.h"
+
+enum { DRAM_SIZE = 0x1000000 };
+enum { TASKS_PER_CASE = 12 };
+
+/* the parts of the MusyX structures the tasks are built from */
+enum { MAX_VOICES = 32 };
+
+enum {
+    SFD_SFX_INDEX       = 0x2,
+    SFD_VOICE_BITMASK   = 0x4,
+    SFD_STATE_PTR       = 0x8,
+    SFD_SFX_PTR         = 0xc,
+    SFD_VOICES          = 0x10,
+
+    /* v2 only */
+    SFD2_10_PTR         = 0x10,
+    SFD2_15_BITMASK     = 0x15,
+    SFD2_16_BITMASK     = 0x16,
+    SFD2_18_PTR         = 0x18,
+    SFD2_1C_PTR         = 0x1c,
+    SFD2_20_PTR         = 0x20,
+    SFD2_24_PTR         = 0x24,
+    SFD2_VOICES         = 0x28
+};
+
+enum {
+    VOICE_ENV_BEGIN         = 0x00,
+    VOICE_ENV_STEP          = 0x10,
+    VOICE_PITCH_Q16         = 0x20,
+    VOICE_PITCH_SHIFT       = 0x22,
+    VOICE_CATSRC_0          = 0x24,
+    VOICE_CATSRC_1          = 0x30,
+    VOICE_ADPCM_FRAMES      = 0x3c,
+    VOICE_SKIP_SAMPLES      = 0x3e,
+    VOICE_U16_40            = 0x40,
+    VOICE_U16_42            = 0x42,
+    VOICE_ADPCM_TABLE_PTR   = 0x40,
+    VOICE_INTERLEAVED_PTR   = 0x44,
+    VOICE_END_POINT         = 0x48,
+    VOICE_RESTART_POINT     = 0x4a,
+    VOICE_U16_4E            = 0x4e,
+    VOICE_SIZE              = 0x50
+};
+
+enum {
+    CATSRC_PTR1     = 0x00,
+    CATSRC_PTR2     = 0x04,
+    CATSRC_SIZE1    = 0x08,
+    CATSRC_SIZE2    = 0x0a
+};
+
+enum {
+    SFX_CBUFFER_PTR     = 0x00,
+    SFX_CBUFFER_LENGTH  = 0x04,
+    SFX_TAP_COUNT       = 0x08,
+    SFX_FIR4_HGAIN      = 0x0a,
+    SFX_TAP_DELAYS      = 0x0c,
+    SFX_FIR4_HCOEFFS    = 0x40
+};
+
+enum { SAMPLE_BUFFER_SIZE = 0x200 };
+enum { SUBFRAME_SIZE = 192 };
+
+/* what the generated voices and sfx exercise */
+enum {
+    WORKLOAD_MIXED,
+    WORKLOAD_PCM16,
+    WORKLOAD_ADPCM,
+    WORKLOAD_SFX,
+    WORKLOAD_INTERLEAVE,
+    WORKLOADS
+};
+
+static const char *const workload_names[WORKLOADS] = {
+    "mixed", "PCM16 voices", "ADPCM voices", "sfx", "interleave"
+};
+
+enum { FULL_RANGE, TYPICAL, SATURATED, DISTRIBUTIONS };
+
+/* RDRAM hashes of each workload for v1 and v2, as the scalar code left them */
+static const uint64_t recorded_hash[WORKLOADS][2] = {
+    { 0x4D376E98B2886BA3ull, 0x469A88DD2D333CF5ull },
+    { 0x958F15F820F63BCDull, 0x3A5FE2CA67D7F1D5ull },
+    { 0x15508A9E6B4D5387ull, 0xE283B8A4442611A4ull },
+    { 0xF4A937B6E57D2180ull, 0xFC34423B37575E23ull },
+    { 0xA1E91544BA2DDFF5ull, 0xE979BDECC09B599Bull },
+};
+
+static uint32_t *dram_words;
+static uint32_t *initial_dram_words;
+static uint32_t dmem_words[0x1000 / 4];
+static struct hle_t hle;
+static int distribution;
+
+/* the musyx tasks only report to the core */
+void HleVerboseMessage(void* user_defined, const char *message, ...) { }
+void HleWarnMessage(void* user_defined, const char *message, ...) { }
+void rsp_break(struct hle_t* hle, unsigned int setbits) { }
+
+/* stage times of a MUSYX_TIMING build */
+void HleInfoMessage(void* user_defined, const char *message, ...)
+{
+    va_list args;
+
+    va_start(args, message);
+    vprintf(message, args);
+    va_end(args);
+    putchar('\n');
+}
+
+static uint64_t seed = 88172645463325252ull;
+
+static uint32_t random_u32(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return (uint32_t)seed;
+}
+
+static uint32_t random_range(uint32_t lo, uint32_t hi)
+{
+    return lo + random_u32() % (hi - lo + 1);
+}
+
+static uint16_t random_sample(void)
+{
+    uint32_t r;
+
+    switch (distribution) {
+    case FULL_RANGE:
+        return (uint16_t)random_u32();
+    case TYPICAL:
+        return (uint16_t)((int)(random_u32() % 8192) - 4096);
+    default:
+        r = random_u32() % 4;
+        return (r == 0) ? 0x8000 : (r == 1) ? 0x7fff : (uint16_t)random_u32();
+    }
+}
+
+static void fill_samples(uint32_t address, uint32_t size)
+{
+    uint32_t i;
+
+    for (i = 0; i < size; i += 2)
+        *dram_u16(&hle, address + i) = random_sample();
+}
+
+/* writes a catsrc of size bytes split in two 1KiB DRAM chunks */
+static void write_catsrc(uint32_t catsrc, uint32_t size, uint32_t *chunks, int even)
+{
+    uint32_t size1 = size ? random_range(1, size) : 0;
+
+    if (even)
+        size1 &= ~1u;
+    if (size1 == 0 && size != 0)
+        size1 = even ? 2 : 1;
+
+    *dram_u32(&hle, catsrc + CATSRC_PTR1) = *chunks;
+    *chunks += 0x400;
+    *dram_u32(&hle, catsrc + CATSRC_PTR2) = *chunks;
+    *chunks += 0x400;
+    *dram_u16(&hle, catsrc + CATSRC_SIZE1) = (uint16_t)size1;
+    *dram_u16(&hle, catsrc + CATSRC_SIZE2) = (uint16_t)(size - size1);
+}
+
+static void write_voice(uint32_t voice, int adpcm, uint32_t *chunks, uint32_t *tables)
+{
+    unsigned int segbase, start, lo, end, restart, u4e, i;
+    int full;
+
+    if (!adpcm) {
+        unsigned int skip = random_range(0, 31);
+        unsigned int count = (random_range(8, 440) + skip + 3) & ~3u;
+        unsigned int samples = count - skip;
+
+        segbase = SAMPLE_BUFFER_SIZE - count;
+        full = random_u32() % 2;
+        *dram_u8(&hle, voice + VOICE_ADPCM_FRAMES) = 0;
+        *dram_u8(&hle, voice + VOICE_SKIP_SAMPLES) = (uint8_t)skip;
+        *dram_u16(&hle, voice + VOICE_U16_40) = (uint16_t)samples;
+        *dram_u16(&hle, voice + VOICE_U16_42) = (uint16_t)full;
+        write_catsrc(voice + VOICE_CATSRC_0, count * 2, chunks, 1);
+        write_catsrc(voice + VOICE_CATSRC_1, full ? segbase * 2 : 0, chunks, 1);
+        start = segbase + skip;
+    } else {
+        unsigned int frames = random_range(1, 16), skip = random_range(0, 63);
+        unsigned int frames2, skip2 = random_range(0, 63);
+        int c;
+
+        if (skip >= 32 && frames == 16)
+            frames = 15;
+        segbase = SAMPLE_BUFFER_SIZE - frames * 32;
+        full = random_u32() % 2;
+        frames2 = full ? 16 - frames : 0;
+        if (skip2 >= 32 && frames2 == 16)
+            skip2 = 0;
+        *dram_u8(&hle, voice + VOICE_ADPCM_FRAMES) = (uint8_t)frames;
+        *dram_u8(&hle, voice + VOICE_ADPCM_FRAMES + 1) = (uint8_t)frames2;
+        *dram_u8(&hle, voice + VOICE_SKIP_SAMPLES) = (uint8_t)skip;
+        *dram_u8(&hle, voice + VOICE_SKIP_SAMPLES + 1) = (uint8_t)skip2;
+        *dram_u32(&hle, voice + VOICE_ADPCM_TABLE_PTR) = *tables;
+        fill_samples(*tables, 0x100);
+        *tables += 0x100;
+
+        for (c = 0; c < 2; ++c) {
+            uint32_t catsrc = voice + (c ? VOICE_CATSRC_1 : VOICE_CATSRC_0);
+            uint32_t ptr1, ptr2, size1, frame, nibble;
+
+            write_catsrc(catsrc, 320, chunks, 0);
+            ptr1 = *dram_u32(&hle, catsrc + CATSRC_PTR1);
+            ptr2 = *dram_u32(&hle, catsrc + CATSRC_PTR2);
+            size1 = *dram_u16(&hle, catsrc + CATSRC_SIZE1);
+
+            /* keep the predictor indices of each frame in the codebook */
+            for (frame = 0; frame < 8; ++frame) {
+                for (nibble = 8; nibble <= 24; nibble += 16) {
+                    uint32_t k = frame * 40 + nibble;
+                    uint32_t address = (k < size1) ? ptr1 + k : ptr2 + k - size1;
+                    *dram_u8(&hle, address) &= 0x7f;
+                }
+            }
+        }
+        start = segbase + (skip & 0x1f);
+    }
+
+    u4e = random_range(0, 8);
+    if (start + u4e > 500)
+        u4e = 0;
+    start += u4e;
+    if (start > 504) {
+        start = 504;
+        u4e = 0;
+    }
+    *dram_u16(&hle, voice + VOICE_U16_4E) = (uint16_t)u4e;
+
+    lo = full ? 0 : segbase;
+    end = random_range(start, 507);
+    if (end < lo + 3)
+        end = lo + 3;
+    restart = random_range(lo, end - 3);
+    *dram_u16(&hle, voice + VOICE_END_POINT) = (uint16_t)(end - segbase);
+    if (full && (restart < segbase || random_u32() % 2))
+        *dram_u16(&hle, voice + VOICE_RESTART_POINT) = (uint16_t)(0x8000 | restart);
+    else
+        *dram_u16(&hle, voice + VOICE_RESTART_POINT) = (uint16_t)(restart - segbase);
+
+    for (i = 0; i < 8; ++i)
+        *dram_u32(&hle, voice + VOICE_ENV_BEGIN + i * 4) = random_u32();
+    if (random_u32() % 4 == 0) {
+        /* saturated envelope */
+        *dram_u32(&hle, voice + VOICE_ENV_BEGIN) = 0x80000000u;
+        *dram_u32(&hle, voice + VOICE_ENV_STEP) = (random_u32() % 3) ? 0 : 0xfff00000u;
+    }
+    *dram_u16(&hle, voice + VOICE_PITCH_Q16) = (uint16_t)random_u32();
+    *dram_u16(&hle, voice + VOICE_PITCH_SHIFT) = (uint16_t)random_range(0, 0x1fff);
+    *dram_u32(&hle, voice + VOICE_INTERLEAVED_PTR) = 0;
+}
+
+static void write_sfx(uint32_t sfd, uint32_t sfx, unsigned int frame, int workload)
+{
+    uint32_t length = random_range(200, 8192);
+    uint32_t taps = (workload == WORKLOAD_SFX) ? 8 : random_range(0, 8);
+    unsigned int i;
+
+    *dram_u32(&hle, sfx + SFX_CBUFFER_PTR) = 0x310000 + frame * 0x8000;
+    *dram_u32(&hle, sfx + SFX_CBUFFER_LENGTH) = length;
+    *dram_u16(&hle, sfx + SFX_TAP_COUNT) = (uint16_t)taps;
+    for (i = 0; i < 8; ++i)
+        *dram_u32(&hle, sfx + SFX_TAP_DELAYS + i * 4) = random_range(1, length - 1);
+
+    *dram_u16(&hle, sfd + SFD_SFX_INDEX) = (uint16_t)(random_u32() % (length / SUBFRAME_SIZE + 1));
+    if ((uint32_t)*dram_u16(&hle, sfd + SFD_SFX_INDEX) * SUBFRAME_SIZE >= length)
+        *dram_u16(&hle, sfd + SFD_SFX_INDEX) = 0;
+
+    if (random_u32() % 4 == 0) {
+        /* gains and coefficients the vector FIR4 cannot hold */
+        *dram_u16(&hle, sfx + SFX_FIR4_HGAIN) = 0x8000;
+        *dram_u16(&hle, sfx + SFX_FIR4_HCOEFFS + 2 * (random_u32() % 4)) = 0x8000;
+    }
+    *dram_u32(&hle, sfd + SFD_SFX_PTR) = sfx;
+}
+
+/* lays out a task in DRAM and DMEM, with random DRAM around it */
+static void setup_task(int version, int workload)
+{
+    const uint32_t sfd_base = 0x10000;
+    const unsigned int sfd_size = (version == 1 ? SFD_VOICES : SFD2_VOICES) + MAX_VOICES * VOICE_SIZE;
+    uint32_t chunks = 0x100000;
+    uint32_t tables = 0x200000;
+    unsigned int frames = (workload == WORKLOAD_MIXED) ? random_range(1, 3) : 1;
+    unsigned int frame, i;
+
+    for (i = 0; i < DRAM_SIZE / 4; ++i)
+        dram_words[i] = random_u32();
+    if (distribution != FULL_RANGE)
+        fill_samples(0, 0x800000);
+
+    for (frame = 0; frame < frames; ++frame) {
+        uint32_t sfd = sfd_base + frame * sfd_size;
+        uint32_t voices = sfd + (version == 1 ? SFD_VOICES : SFD2_VOICES);
+        uint32_t output = 0x400000 + frame * 0x1000;
+        unsigned int voice_count = (workload == WORKLOAD_MIXED) ? random_range(1, 8) : 8;
+        int skip_voices = workload == WORKLOAD_SFX || workload == WORKLOAD_INTERLEAVE
+                       || (workload == WORKLOAD_MIXED && random_u32() % 8 == 0);
+
+        *dram_u32(&hle, sfd + SFD_VOICE_BITMASK) = random_u32();
+        *dram_u32(&hle, sfd + SFD_STATE_PTR) = 0x20000 + frame * 0x400;
+        *dram_u16(&hle, sfd + SFD_SFX_INDEX) = 0;
+        *dram_u32(&hle, sfd + SFD_SFX_PTR) = 0;
+        if ((workload == WORKLOAD_MIXED) ? (random_u32() % 4 != 0) : (workload == WORKLOAD_SFX))
+            write_sfx(sfd, 0x300000 + frame * 0x100, frame, workload);
+
+        if (version == 2) {
+            *dram_u32(&hle, sfd + SFD2_10_PTR) = 0;
+            *dram_u8(&hle, sfd + SFD2_15_BITMASK) = (workload == WORKLOAD_INTERLEAVE)
+                ? 0 : (uint8_t)random_u32();
+            *dram_u16(&hle, sfd + SFD2_16_BITMASK) = (workload == WORKLOAD_INTERLEAVE) ? 0xff
+                : (workload == WORKLOAD_MIXED) ? (uint16_t)random_u32() : 0;
+            *dram_u32(&hle, sfd + SFD2_18_PTR) = 0x500000;
+            for (i = 0; i < 8; ++i) {
+                *dram_u32(&hle, 0x500000 + i * 8) = 0x510000 + random_range(0, 0x1000) * 2;
+                *dram_u16(&hle, 0x500000 + i * 8 + 4) = (uint16_t)random_u32();
+            }
+            *dram_u32(&hle, sfd + SFD2_1C_PTR) = 0x520000 + frame * 0x400;
+            *dram_u32(&hle, sfd + SFD2_20_PTR) = 0x530000 + frame * 0x400;
+            *dram_u32(&hle, sfd + SFD2_24_PTR) = 0x540000;
+        }
+
+        for (i = 0; i < voice_count; ++i) {
+            int adpcm = (workload == WORKLOAD_PCM16) ? 0
+                      : (workload == WORKLOAD_ADPCM) ? 1
+                      : (int)(random_u32() % 2);
+            write_voice(voices + i * VOICE_SIZE, adpcm, &chunks, &tables);
+        }
+
+        /* an empty first voice skips the voice stage */
+        if (skip_voices)
+            *dram_u16(&hle, voices + VOICE_CATSRC_0 + CATSRC_SIZE1) = 0;
+        *dram_u32(&hle, voices + (skip_voices ? 0 : voice_count - 1) * VOICE_SIZE
+                  + VOICE_INTERLEAVED_PTR) = output;
+    }
+
+    memset(dmem_words, 0, sizeof(dmem_words));
+    *dmem_u32(&hle, TASK_DATA_PTR) = sfd_base;
+    *dmem_u32(&hle, TASK_DATA_SIZE) = frames;
+}
+
+static void run_task(int version)
+{
+    if (version == 1)
+        musyx_v1_task(&hle);
+    else
+        musyx_v2_task(&hle);
+}
+
+static uint64_t hash_dram(uint64_t hash)
+{
+    size_t i;
+
+    for (i = 0; i < DRAM_SIZE / 4; ++i)
+        hash = (hash ^ dram_words[i]) * 0x00000100000001B3ull;
+    return hash;
+}
+
+static double bench_task(int version, int workload)
+{
+    enum { RUNS = 2000 };
+    struct timespec start, end;
+    unsigned int run;
+
+    distribution = TYPICAL;
+    setup_task(version, workload);
+    memcpy(initial_dram_words, dram_words, DRAM_SIZE);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (run = 0; run < RUNS; ++run)
+        run_task(version);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    memcpy(dram_words, initial_dram_words, DRAM_SIZE);
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / RUNS;
+}
+
+int main(int argc, char **argv)
+{
+    int workload, version;
+    uint64_t hashes[WORKLOADS][2];
+    int record = (argc > 1 && strcmp(argv[1], "record") == 0);
+    int failed = 0;
+
+    dram_words = malloc(DRAM_SIZE);
+    initial_dram_words = malloc(DRAM_SIZE);
+    if (dram_words == NULL || initial_dram_words == NULL) {
+        puts("out of memory");
+        return 1;
+    }
+    hle.dram = (unsigned char *)dram_words;
+    hle.dmem = (unsigned char *)dmem_words;
+
+    for (workload = 0; workload < WORKLOADS; ++workload) {
+        for (version = 1; version <= 2; ++version) {
+            uint64_t hash = 0xCBF29CE484222325ull;
+            unsigned int i;
+
+            for (i = 0; i < TASKS_PER_CASE; ++i) {
+                distribution = i % DISTRIBUTIONS;
+                setup_task(version, workload);
+                run_task(version);
+                hash = hash_dram(hash);
+            }
+
+            hashes[workload][version - 1] = hash;
+            if (record)
+                continue;
+
+            if (hash != recorded_hash[workload][version - 1]) {
+                printf("v%d %s: RDRAM hash %016llX, recorded %016llX\n", version,
+                       workload_names[workload], (unsigned long long)hash,
+                       (unsigned long long)recorded_hash[workload][version - 1]);
+                failed = 1;
+            } else {
+                printf("v%d %s: %u tasks match\n", version, workload_names[workload],
+                       TASKS_PER_CASE);
+            }
+        }
+    }
+
+    if (record) {
+        printf("static const uint64_t recorded_hash[WORKLOADS][2] = {\n");
+        for (workload = 0; workload < WORKLOADS; ++workload)
+            printf("    { 0x%016llXull, 0x%016llXull },\n", (unsigned long long)hashes[workload][0],
+                   (unsigned long long)hashes[workload][1]);
+        printf("};\n");
+    }
+
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        for (workload = 0; workload < WORKLOADS; ++workload) {
+            for (version = 1; version <= 2; ++version) {
+                if (workload == WORKLOAD_INTERLEAVE && version == 1)
+                    continue;
+                printf("v%d %s: %.2f us per task\n", version, workload_names[workload],
+                       bench_task(version, workload) / 1000.0);
+            }
+        }
+    }
+
+    free(initial_dram_words);
+    free(dram_words);
+    return failed;
+}
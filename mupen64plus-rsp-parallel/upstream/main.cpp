@@ -347,7 +347,9 @@ int main(int argc, char *argv[])
 		reference_state.cp0.cr[i] = &reference_cr[i];
 #endif
 
-	if (argc == 3)
+	// Optional third argument is a persistent block cache to load before and save after running,
+	// so running twice compares cold and warm startup.
+	if (argc == 3 || argc == 4)
 	{
 		auto dmem = read_binary(argv[1], true);
 		auto imem = read_binary(argv[2], true);
@@ -371,8 +373,18 @@ int main(int argc, char *argv[])
 		printf("=== Running Lightning CPU ===\n");
 		fflush(stdout);
 		fflush(stderr);
+		if (argc == 4)
+			cpu.load_block_cache(argv[3]);
 		cpu.invalidate_imem();
 		cpu.run();
+		if (argc == 4)
+			cpu.save_block_cache(argv[3]);
+
+		const auto &stats = cpu.get_block_cache_stats();
+		printf("Block cache: %llu precompiled (%.3f ms), %llu lookups (%.3f ms), %llu compiles (%.3f ms), %.3f ms in RSP code\n",
+		       (unsigned long long)stats.preloads, stats.preload_ns * 1e-6,
+		       (unsigned long long)stats.lookups, stats.lookup_ns * 1e-6,
+		       (unsigned long long)stats.compiles, stats.compile_ns * 1e-6, stats.run_ns * 1e-6);
 		fflush(stdout);
 		fflush(stderr);
 
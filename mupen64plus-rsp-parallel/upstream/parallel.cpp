@@ -3,17 +3,34 @@
 #else
 #include "rsp_jit.hpp"
 #endif
+#include <stdarg.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string>
 
+#include "m64p_config.h"
 #include "m64p_plugin.h"
 #include "rsp_1.1.h"
 
+#ifdef _WIN32
+#define DLSYM(a, b) GetProcAddress(a, b)
+#else
+#include <dlfcn.h>
+#define DLSYM(a, b) dlsym(a, b)
+#endif
+
 #define RSP_PARALLEL_VERSION 0x0101
 #define RSP_PLUGIN_API_VERSION 0x020000
 
 static void (*l_DebugCallback)(void *, int, const char *) = NULL;
 static void *l_DebugCallContext = NULL;
 
+// Compiled blocks are remembered across sessions in a file per ROM, in this directory.
+// Empty if the core has no cache directory.
+static std::string l_BlockCacheDir;
+static std::string l_BlockCachePath;
+static m64p_error (*l_CoreDoCommand)(m64p_command, int, void *) = NULL;
+
 
 #define ATTR_FMT(fmtpos, attrpos) __attribute__ ((format (printf, fmtpos, attrpos)))
 static void DebugMessage(int level, const char *message, ...) ATTR_FMT(2, 3);
@@ -140,6 +157,18 @@ extern "C"
 	EXPORT void CALL RomClosed(void)
 	{
 		*RSP::rsp.SP_PC_REG = 0x00000000;
+
+#ifndef DEBUG_JIT
+		const auto &stats = RSP::cpu.get_block_cache_stats();
+		DebugMessage(M64MSG_VERBOSE, "Block cache: %llu lookups (%.3f ms), %llu compiles (%.3f ms), %.3f ms in RSP code",
+		             (unsigned long long)stats.lookups, stats.lookup_ns * 1e-6,
+		             (unsigned long long)stats.compiles, stats.compile_ns * 1e-6, stats.run_ns * 1e-6);
+
+		// Only rewrite the file if this session compiled something new. Statistics restart with each ROM.
+		if (!l_BlockCachePath.empty() && stats.compiles != 0 &&
+		    !RSP::cpu.save_block_cache(l_BlockCachePath.c_str()))
+			DebugMessage(M64MSG_WARNING, "Failed to write block cache %s", l_BlockCachePath.c_str());
+#endif
 	}
 
 	EXPORT void CALL InitiateRSP(RSP_INFO Rsp_Info, unsigned int *CycleCount)
@@ -182,6 +211,28 @@ extern "C"
 		RSP::cpu.set_dmem(reinterpret_cast<uint32_t *>(Rsp_Info.DMEM));
 		RSP::cpu.set_imem(reinterpret_cast<uint32_t *>(Rsp_Info.IMEM));
 		RSP::cpu.set_rdram(reinterpret_cast<uint32_t *>(Rsp_Info.RDRAM));
+
+#ifndef DEBUG_JIT
+		// Key the block cache file on the ROM, so a game only precompiles and saves its own blocks.
+		RSP::cpu.reset_block_cache();
+		m64p_rom_settings rom_settings;
+		l_BlockCachePath.clear();
+		if (!l_BlockCacheDir.empty() && l_CoreDoCommand &&
+		    l_CoreDoCommand(M64CMD_ROM_GET_SETTINGS, sizeof(rom_settings), &rom_settings) == M64ERR_SUCCESS &&
+		    rom_settings.MD5[0] != '\0')
+		{
+			rom_settings.MD5[sizeof(rom_settings.MD5) - 1] = '\0';
+			l_BlockCachePath = l_BlockCacheDir + "parallel_rsp_blocks_" + rom_settings.MD5 + ".bin";
+		}
+
+		if (!l_BlockCachePath.empty())
+		{
+			unsigned loaded = RSP::cpu.load_block_cache(l_BlockCachePath.c_str());
+			const auto &stats = RSP::cpu.get_block_cache_stats();
+			DebugMessage(M64MSG_VERBOSE, "Block cache: precompiled %u blocks (%.3f ms)", loaded,
+			             stats.preload_ns * 1e-6);
+		}
+#endif
 	}
 
 	EXPORT m64p_error CALL PluginStartup(m64p_dynlib_handle CoreLibHandle, void *Context,
@@ -194,6 +245,16 @@ extern "C"
 
         DebugMessage(M64MSG_ERROR, "PluginStartup");
 
+		auto ConfigGetUserCachePath = (ptr_ConfigGetUserCachePath)DLSYM(CoreLibHandle, "ConfigGetUserCachePath");
+		const char *cache_dir = ConfigGetUserCachePath ? ConfigGetUserCachePath() : NULL;
+		if (cache_dir && *cache_dir)
+		{
+			l_BlockCacheDir = cache_dir;
+			if (l_BlockCacheDir.back() != '/' && l_BlockCacheDir.back() != '\\')
+				l_BlockCacheDir += '/';
+		}
+		l_CoreDoCommand = (m64p_error (*)(m64p_command, int, void *))DLSYM(CoreLibHandle, "CoreDoCommand");
+
 		return M64ERR_SUCCESS;
 	}
 
@@ -1,7 +1,18 @@
 #include "rsp_jit.hpp"
 #include "rsp_disasm.hpp"
+#include <algorithm>
+#include <chrono>
+#include <string>
 #include <utility>
 #include <assert.h>
+#include <stdio.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
 
 using namespace std;
 
@@ -43,6 +54,12 @@ CPU::~CPU()
 
 void CPU::invalidate_imem()
 {
+	// IMEM writes done by our own DMA engine are already tracked in dirty_blocks.
+	// Only writes from the outside (host SP DMA, savestates) need to be found here,
+	// and in the common case IMEM is untouched, so check all of it in one go first.
+	if (!memcmp(cached_imem, state.imem, IMEM_SIZE))
+		return;
+
 	for (unsigned i = 0; i < CODE_BLOCKS; i++)
 		if (memcmp(cached_imem + i * CODE_BLOCK_WORDS, state.imem + i * CODE_BLOCK_WORDS, CODE_BLOCK_SIZE))
 			state.dirty_blocks |= (0x3 << i) >> 1;
@@ -65,21 +82,223 @@ void CPU::invalidate_code()
 	state.dirty_blocks = 0;
 }
 
-// Need super-fast hash here.
+// Need super-fast hash here. Only computed when blocks[] misses.
+// FNV-1 over four interleaved lanes, so the multiply chains do not serialize
+// (and can be vectorized where the target has 64-bit lane multiplies).
 uint64_t CPU::hash_imem(unsigned pc, unsigned count) const
 {
 	size_t size = count;
 
-	// FNV-1.
 	const auto *data = state.imem + pc;
+	uint64_t lanes[4];
+	for (unsigned l = 0; l < 4; l++)
+		lanes[l] = 0xcbf29ce484222325ull + l;
+
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4)
+		for (unsigned l = 0; l < 4; l++)
+			lanes[l] = (lanes[l] * 0x100000001b3ull) ^ data[i + l];
+	for (; i < size; i++)
+		lanes[i & 3] = (lanes[i & 3] * 0x100000001b3ull) ^ data[i];
+
 	uint64_t h = 0xcbf29ce484222325ull;
 	h = (h * 0x100000001b3ull) ^ pc;
 	h = (h * 0x100000001b3ull) ^ count;
-	for (size_t i = 0; i < size; i++)
-		h = (h * 0x100000001b3ull) ^ data[i];
+	for (unsigned l = 0; l < 4; l++)
+		h = (h * 0x100000001b3ull) ^ lanes[l];
 	return h;
 }
 
+void CPU::grow_block_cache()
+{
+	std::vector<BlockCacheEntry> old_cache;
+	old_cache.swap(block_cache);
+	block_cache.resize(old_cache.empty() ? 1024 : old_cache.size() * 2);
+
+	for (auto &entry : old_cache)
+		if (entry.func)
+			find_cached_block(entry.hash, entry.pc) = entry;
+}
+
+CPU::BlockCacheEntry &CPU::find_cached_block(uint64_t hash, uint32_t pc)
+{
+	size_t mask = block_cache.size() - 1;
+	size_t index = size_t(hash ^ (hash >> 32)) & mask;
+
+	for (;;)
+	{
+		auto &entry = block_cache[index];
+		if (!entry.func || (entry.hash == hash && entry.pc == pc))
+			return entry;
+		index = (index + 1) & mask;
+	}
+}
+
+CPU::BlockCacheEntry &CPU::reserve_cached_block(uint64_t hash, uint32_t pc)
+{
+	// Keep the load factor at or below 1/2 so probe sequences stay short.
+	if ((block_cache_count + 1) * 2 > block_cache.size())
+		grow_block_cache();
+	return find_cached_block(hash, pc);
+}
+
+void CPU::compile_cached_block(BlockCacheEntry &entry, uint64_t hash, unsigned pc, unsigned count)
+{
+	entry.func = jit_region(hash, pc, count);
+	entry.hash = hash;
+	entry.pc = pc;
+	entry.count = count;
+	entry.code_offset = block_cache_code.size();
+	entry.last_use = ++block_cache_clock;
+	block_cache_code.insert(block_cache_code.end(), state.imem + pc, state.imem + pc + count);
+	block_cache_count++;
+}
+
+namespace
+{
+// Bump whenever hash_imem() or the block splitting in get_jit_block() changes.
+enum { BLOCK_CACHE_VERSION = 1 };
+// Blocks kept in the file, least recently used ones are dropped beyond that.
+enum { BLOCK_CACHE_MAX_BLOCKS = 4096 };
+const char block_cache_magic[8] = { 'R', 'S', 'P', 'B', 'L', 'O', 'C', 'K' };
+
+struct BlockCacheHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t num_blocks;
+};
+
+struct BlockCacheRecord
+{
+	uint64_t hash;
+	uint32_t pc;
+	uint32_t count;
+};
+} // namespace
+
+static bool replace_file(const char *from, const char *to)
+{
+#ifdef _WIN32
+	// rename() fails on Windows when the target exists.
+	return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(from, to) == 0;
+#endif
+}
+
+bool CPU::save_block_cache(const char *path) const
+{
+	// Most recently used first, so a load keeps their order and trimming drops the oldest.
+	std::vector<const BlockCacheEntry *> entries;
+	entries.reserve(block_cache_count);
+	for (auto &entry : block_cache)
+		if (entry.func)
+			entries.push_back(&entry);
+	std::sort(entries.begin(), entries.end(),
+	          [](const BlockCacheEntry *a, const BlockCacheEntry *b) { return a->last_use > b->last_use; });
+	if (entries.size() > BLOCK_CACHE_MAX_BLOCKS)
+		entries.resize(BLOCK_CACHE_MAX_BLOCKS);
+
+	// Write a temporary file and rename it over the old one, so an interrupted save never truncates the cache.
+	std::string tmp_path = std::string(path) + ".tmp";
+	FILE *file = fopen(tmp_path.c_str(), "wb");
+	if (!file)
+		return false;
+
+	BlockCacheHeader header = {};
+	memcpy(header.magic, block_cache_magic, sizeof(header.magic));
+	header.version = BLOCK_CACHE_VERSION;
+	header.num_blocks = uint32_t(entries.size());
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	for (auto *entry : entries)
+	{
+		if (!ok)
+			break;
+
+		BlockCacheRecord record = { entry->hash, entry->pc, entry->count };
+		ok = fwrite(&record, sizeof(record), 1, file) == 1 &&
+		     fwrite(block_cache_code.data() + entry->code_offset, sizeof(uint32_t), entry->count, file) == entry->count;
+	}
+
+	if (fflush(file) != 0)
+		ok = false;
+	if (fclose(file) != 0)
+		ok = false;
+	if (ok)
+		ok = replace_file(tmp_path.c_str(), path);
+	if (!ok)
+		remove(tmp_path.c_str());
+	return ok;
+}
+
+void CPU::reset_block_cache()
+{
+	// The generated code stays allocated, the allocator cannot free single blocks.
+	block_cache.clear();
+	block_cache_count = 0;
+	block_cache_clock = 0;
+	block_cache_code.clear();
+	block_cache_stats = {};
+	memset(blocks, 0, sizeof(blocks));
+}
+
+unsigned CPU::load_block_cache(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+		return 0;
+
+	auto start = chrono::steady_clock::now();
+	BlockCacheHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+	    memcmp(header.magic, block_cache_magic, sizeof(header.magic)) != 0 ||
+	    header.version != BLOCK_CACHE_VERSION)
+	{
+		fclose(file);
+		return 0;
+	}
+
+	// Blocks are compiled straight out of state.imem, so rebuild each one in a scratch IMEM.
+	std::vector<uint32_t> scratch_imem(IMEM_WORDS);
+	uint32_t *imem = state.imem;
+	state.imem = scratch_imem.data();
+
+	unsigned loaded = 0;
+	for (uint32_t i = 0; i < header.num_blocks; i++)
+	{
+		// Anything malformed means the rest of the file cannot be trusted either.
+		BlockCacheRecord record;
+		if (fread(&record, sizeof(record), 1, file) != 1)
+			break;
+		if (record.count == 0 || record.count > CODE_BLOCK_WORDS * 2 || record.pc >= IMEM_WORDS ||
+		    record.count > IMEM_WORDS - record.pc)
+			break;
+		if (fread(scratch_imem.data() + record.pc, sizeof(uint32_t), record.count, file) != record.count)
+			break;
+		if (hash_imem(record.pc, record.count) != record.hash)
+			break;
+
+		auto &entry = reserve_cached_block(record.hash, record.pc);
+		if (entry.func)
+			continue;
+		compile_cached_block(entry, record.hash, record.pc, record.count);
+		// Records are stored most recently used first, and rank below anything used in this session.
+		entry.last_use = header.num_blocks - i;
+		loaded++;
+	}
+	block_cache_clock = std::max<uint64_t>(block_cache_clock, header.num_blocks);
+
+	state.imem = imem;
+	fclose(file);
+
+	block_cache_stats.preloads += loaded;
+	block_cache_stats.preload_ns +=
+	    chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+	return loaded;
+}
+
 #ifdef TRACE
 static uint64_t hash_registers(const CPUState *rsp)
 {
@@ -458,12 +677,22 @@ Func CPU::get_jit_block(uint32_t pc)
 		end = min(end, unsigned(IMEM_SIZE >> 2));
 		end = analyze_static_end(word_pc, end);
 
+		auto lookup_start = chrono::steady_clock::now();
 		uint64_t hash = hash_imem(word_pc, end - word_pc);
-		auto &ptr = cached_blocks[word_pc][hash];
-		if (ptr)
-			block = ptr;
-		else
-			block = ptr = jit_region(hash, word_pc, end - word_pc);
+		auto &entry = reserve_cached_block(hash, word_pc);
+		auto lookup_end = chrono::steady_clock::now();
+		block_cache_stats.lookups++;
+		block_cache_stats.lookup_ns += chrono::duration_cast<chrono::nanoseconds>(lookup_end - lookup_start).count();
+
+		if (!entry.func)
+		{
+			compile_cached_block(entry, hash, word_pc, end - word_pc);
+			block_cache_stats.compiles++;
+			block_cache_stats.compile_ns +=
+			    chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - lookup_end).count();
+		}
+		entry.last_use = ++block_cache_clock;
+		block = entry.func;
 	}
 	return block;
 }
@@ -1917,9 +2146,20 @@ Func CPU::jit_region(uint64_t hash, unsigned pc_word, unsigned instruction_count
 ReturnMode CPU::run()
 {
 	invalidate_code();
+	auto run_start = chrono::steady_clock::now();
+	// Blocks are looked up and compiled from inside compiled code, keep that time out of run_ns.
+	uint64_t jit_ns_start = block_cache_stats.lookup_ns + block_cache_stats.compile_ns;
 	for (;;)
 	{
 		int ret = enter(state.pc);
+		if (ret == MODE_BREAK || ret == MODE_CHECK_FLAGS || ret == MODE_DMA_READ)
+		{
+			uint64_t elapsed_ns =
+			    chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - run_start).count();
+			uint64_t jit_ns = block_cache_stats.lookup_ns + block_cache_stats.compile_ns - jit_ns_start;
+			block_cache_stats.run_ns += (elapsed_ns > jit_ns) ? elapsed_ns - jit_ns : 0;
+		}
+
 		switch (ret)
 		{
 		case MODE_BREAK:
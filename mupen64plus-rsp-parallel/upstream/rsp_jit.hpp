@@ -5,7 +5,6 @@
 #include <stdint.h>
 #include <string.h>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "rsp_op.hpp"
@@ -120,6 +119,33 @@ public:
 
 	Func get_jit_block(uint32_t pc);
 
+	// Lookup overhead versus time spent inside compiled code, accumulated over all run() calls.
+	// run_ns excludes the lookups and compiles which happen while a run() is in progress.
+	struct BlockCacheStats
+	{
+		uint64_t lookups = 0;
+		uint64_t compiles = 0;
+		uint64_t lookup_ns = 0;
+		uint64_t compile_ns = 0;
+		uint64_t run_ns = 0;
+		uint64_t preloads = 0;
+		uint64_t preload_ns = 0;
+	};
+
+	const BlockCacheStats &get_block_cache_stats() const
+	{
+		return block_cache_stats;
+	}
+
+	// Persistent block cache. Generated code is not relocatable between sessions,
+	// so the file records the instructions of the most recently used blocks,
+	// and loading it compiles them all up front instead of on first execution.
+	// The file is written to <path>.tmp first and renamed over the previous one.
+	bool save_block_cache(const char *path) const;
+	unsigned load_block_cache(const char *path);
+	// Forgets every cached block and the statistics, so a new ROM starts from its own file.
+	void reset_block_cache();
+
 private:
 	CPUState state;
 	Func blocks[IMEM_WORDS] = {};
@@ -130,7 +156,29 @@ private:
 
 	alignas(64) uint32_t cached_imem[IMEM_WORDS] = {};
 
-	std::unordered_map<uint64_t, Func> cached_blocks[IMEM_WORDS];
+	// Every block compiled so far, keyed on PC and IMEM contents.
+	// Flat open-addressed table with linear probing, power-of-two sized.
+	struct BlockCacheEntry
+	{
+		uint64_t hash;
+		uint32_t pc;
+		uint32_t count;
+		size_t code_offset;
+		uint64_t last_use;
+		Func func;
+	};
+	std::vector<BlockCacheEntry> block_cache;
+	size_t block_cache_count = 0;
+	uint64_t block_cache_clock = 0;
+	BlockCacheStats block_cache_stats;
+
+	// Instructions of every cached block, referenced by BlockCacheEntry::code_offset.
+	std::vector<uint32_t> block_cache_code;
+
+	BlockCacheEntry &find_cached_block(uint64_t hash, uint32_t pc);
+	BlockCacheEntry &reserve_cached_block(uint64_t hash, uint32_t pc);
+	void grow_block_cache();
+	void compile_cached_block(BlockCacheEntry &entry, uint64_t hash, unsigned pc, unsigned count);
 
 	Func jit_region(uint64_t hash, unsigned pc_word, unsigned instruction_count);
 
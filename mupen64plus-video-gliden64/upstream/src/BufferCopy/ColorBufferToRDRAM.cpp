@@ -1,5 +1,14 @@
 #include <assert.h>
 #include <algorithm>
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CB_TO_RDRAM_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CB_TO_RDRAM_NEON
+#endif
 
 #include "ColorBufferToRDRAM.h"
 #include "WriteToRDRAM.h"
@@ -11,6 +20,7 @@
 #include <VI.h>
 #include "Log.h"
 #include "MemoryStatus.h"
+#include "Performance.h"
 
 /*
 #include "ColorBufferToRDRAM_GL.h"
@@ -245,6 +255,96 @@ u32 ColorBufferToRDRAM::_RGBAtoRGBA32(u32 _c) {
 	return (c.r << 24) | (c.g << 16) | (c.b << 8) | c.a;
 }
 
+u32 ColorBufferToRDRAM::_RGBAtoRGBA16Row(const u32* _src, u16* _dst, u32 _count)
+{
+	// Converts 8 pixels per step. Pixels equal to zero are left untouched in RDRAM,
+	// and halfwords are swapped pairwise to match the xor 1 addressing of 16bit RDRAM.
+	u32 x = 0;
+#if defined(CB_TO_RDRAM_SSE2)
+	const __m128i maskR = _mm_set1_epi32(0xf8);
+	const __m128i maskG = _mm_set1_epi32(0x7c0);
+	const __m128i maskB = _mm_set1_epi32(0x3e);
+	const __m128i maskA = _mm_set1_epi32(static_cast<int>(0xff000000));
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i zero = _mm_setzero_si128();
+	for (; x + 8 <= _count; x += 8) {
+		__m128i p[2], c[2], z[2];
+		p[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + x));
+		p[1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + x + 4));
+		for (u32 i = 0; i < 2; ++i) {
+			c[i] = _mm_slli_epi32(_mm_and_si128(p[i], maskR), 8);
+			c[i] = _mm_or_si128(c[i], _mm_and_si128(_mm_srli_epi32(p[i], 5), maskG));
+			c[i] = _mm_or_si128(c[i], _mm_and_si128(_mm_srli_epi32(p[i], 18), maskB));
+			c[i] = _mm_or_si128(c[i], _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(p[i], maskA), zero), one));
+			// Sign extend so that signed saturation in the pack below keeps all 16 bits.
+			c[i] = _mm_srai_epi32(_mm_slli_epi32(c[i], 16), 16);
+			z[i] = _mm_cmpeq_epi32(p[i], zero);
+		}
+		__m128i color = _mm_packs_epi32(c[0], c[1]);
+		__m128i keep = _mm_packs_epi32(z[0], z[1]);
+		color = _mm_shufflehi_epi16(_mm_shufflelo_epi16(color, 0xB1), 0xB1);
+		keep = _mm_shufflehi_epi16(_mm_shufflelo_epi16(keep, 0xB1), 0xB1);
+		__m128i * dst = reinterpret_cast<__m128i*>(_dst + x);
+		const __m128i old = _mm_loadu_si128(dst);
+		_mm_storeu_si128(dst, _mm_or_si128(_mm_and_si128(keep, old), _mm_andnot_si128(keep, color)));
+	}
+#elif defined(CB_TO_RDRAM_NEON)
+	const uint32x4_t maskR = vdupq_n_u32(0xf8);
+	const uint32x4_t maskG = vdupq_n_u32(0x7c0);
+	const uint32x4_t maskB = vdupq_n_u32(0x3e);
+	const uint32x4_t maskA = vdupq_n_u32(0xff000000);
+	const uint32x4_t one = vdupq_n_u32(1);
+	for (; x + 8 <= _count; x += 8) {
+		uint32x4_t p[2];
+		uint16x4_t c[2], z[2];
+		p[0] = vld1q_u32(_src + x);
+		p[1] = vld1q_u32(_src + x + 4);
+		for (u32 i = 0; i < 2; ++i) {
+			uint32x4_t v = vshlq_n_u32(vandq_u32(p[i], maskR), 8);
+			v = vorrq_u32(v, vandq_u32(vshrq_n_u32(p[i], 5), maskG));
+			v = vorrq_u32(v, vandq_u32(vshrq_n_u32(p[i], 18), maskB));
+			v = vorrq_u32(v, vandq_u32(vtstq_u32(p[i], maskA), one));
+			c[i] = vrev32_u16(vmovn_u32(v));
+			z[i] = vrev32_u16(vmovn_u32(vceqq_u32(p[i], vdupq_n_u32(0))));
+		}
+		const uint16x8_t color = vcombine_u16(c[0], c[1]);
+		const uint16x8_t keep = vcombine_u16(z[0], z[1]);
+		vst1q_u16(_dst + x, vbslq_u16(keep, vld1q_u16(_dst + x), color));
+	}
+#endif
+	(void)_src;
+	(void)_dst;
+	return x;
+}
+
+u32 ColorBufferToRDRAM::_RGBAtoRGBA32Row(const u32* _src, u32* _dst, u32 _count)
+{
+	// Byte swaps 4 pixels per step. Pixels equal to zero are left untouched in RDRAM.
+	u32 x = 0;
+#if defined(CB_TO_RDRAM_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	for (; x + 4 <= _count; x += 4) {
+		const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + x));
+		__m128i color = _mm_or_si128(_mm_slli_epi16(p, 8), _mm_srli_epi16(p, 8));
+		color = _mm_shufflehi_epi16(_mm_shufflelo_epi16(color, 0xB1), 0xB1);
+		const __m128i keep = _mm_cmpeq_epi32(p, zero);
+		__m128i * dst = reinterpret_cast<__m128i*>(_dst + x);
+		const __m128i old = _mm_loadu_si128(dst);
+		_mm_storeu_si128(dst, _mm_or_si128(_mm_and_si128(keep, old), _mm_andnot_si128(keep, color)));
+	}
+#elif defined(CB_TO_RDRAM_NEON)
+	for (; x + 4 <= _count; x += 4) {
+		const uint32x4_t p = vld1q_u32(_src + x);
+		const uint32x4_t color = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(p)));
+		const uint32x4_t keep = vceqq_u32(p, vdupq_n_u32(0));
+		vst1q_u32(_dst + x, vbslq_u32(keep, vld1q_u32(_dst + x), color));
+	}
+#endif
+	(void)_src;
+	(void)_dst;
+	return x;
+}
+
 void ColorBufferToRDRAM::_copy(u32 _startAddress, u32 _endAddress, bool _sync)
 {
 	const u32 stride = m_pCurFrameBuffer->m_width << m_pCurFrameBuffer->m_size >> 1;
@@ -262,11 +362,17 @@ void ColorBufferToRDRAM::_copy(u32 _startAddress, u32 _endAddress, bool _sync)
 	const u32 y1 = (_endAddress - m_pCurFrameBuffer->m_startAddress) / stride;
 	const u32 height = std::min(max_height, 1u + y1 - y0);
 
+	const std::chrono::steady_clock::time_point readStart = std::chrono::steady_clock::now();
 	const u8* pPixels = m_bufferReader->readPixels(x0, y0, width, height, m_pCurFrameBuffer->m_size, _sync);
+	const std::chrono::steady_clock::duration readTime = std::chrono::steady_clock::now() - readStart;
+	perf.addCounter(Performance::pcFBCopyStallTime,
+		static_cast<u32>(std::chrono::duration_cast<std::chrono::microseconds>(readTime).count()));
 	frameBufferList().setCurrentDrawBuffer();
 	if (pPixels == nullptr)
 		return;
 
+	perf.addCounter(Performance::pcFBCopyBytes, numPixels << m_pCurFrameBuffer->m_size >> 1);
+
 	if (m_pCurFrameBuffer->m_size == G_IM_SIZ_32b) {
 		u32 *ptr_src = (u32*)pPixels;
 		u32 *ptr_dst = (u32*)(RDRAM + _startAddress);
@@ -275,7 +381,8 @@ void ColorBufferToRDRAM::_copy(u32 _startAddress, u32 _endAddress, bool _sync)
 			memset(ptr_dst, 0, numPixels * 4);
 		}
 
-		writeToRdram<u32, u32>(ptr_src, ptr_dst, &ColorBufferToRDRAM::_RGBAtoRGBA32, 0, 0, width, height, numPixels, _startAddress, m_pCurFrameBuffer->m_startAddress, m_pCurFrameBuffer->m_size);
+		writeToRdram<u32, u32>(ptr_src, ptr_dst, &ColorBufferToRDRAM::_RGBAtoRGBA32, 0, 0, width, height, numPixels, _startAddress, m_pCurFrameBuffer->m_startAddress, m_pCurFrameBuffer->m_size,
+			&ColorBufferToRDRAM::_RGBAtoRGBA32Row);
 	} else if (m_pCurFrameBuffer->m_size == G_IM_SIZ_16b) {
 		u32 *ptr_src = (u32*)pPixels;
 		u16 *ptr_dst = (u16*)(RDRAM + _startAddress);
@@ -284,7 +391,8 @@ void ColorBufferToRDRAM::_copy(u32 _startAddress, u32 _endAddress, bool _sync)
 			memset(ptr_dst, 0, numPixels * 2);
 		}
 
-		writeToRdram<u32, u16>(ptr_src, ptr_dst, &ColorBufferToRDRAM::_RGBAtoRGBA16, 0, 1, width, height, numPixels, _startAddress, m_pCurFrameBuffer->m_startAddress, m_pCurFrameBuffer->m_size);
+		writeToRdram<u32, u16>(ptr_src, ptr_dst, &ColorBufferToRDRAM::_RGBAtoRGBA16, 0, 1, width, height, numPixels, _startAddress, m_pCurFrameBuffer->m_startAddress, m_pCurFrameBuffer->m_size,
+			&ColorBufferToRDRAM::_RGBAtoRGBA16Row);
 	} else if (m_pCurFrameBuffer->m_size == G_IM_SIZ_8b) {
 		u8 *ptr_src = (u8*)pPixels;
 		u8 *ptr_dst = RDRAM + _startAddress;
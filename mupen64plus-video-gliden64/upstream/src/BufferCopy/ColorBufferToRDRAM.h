@@ -53,6 +53,10 @@ private:
 	static u16 _RGBAtoRGBA16(u32 _c);
 	static u32 _RGBAtoRGBA32(u32 _c);
 
+	// Vectorized versions of the converters above for whole rows.
+	static u32 _RGBAtoRGBA16Row(const u32* _src, u16* _dst, u32 _count);
+	static u32 _RGBAtoRGBA32Row(const u32* _src, u32* _dst, u32 _count);
+
 	graphics::ObjectHandle m_FBO;
 	FrameBuffer * m_pCurFrameBuffer;
 	u32 m_frameCount;
@@ -11,14 +11,28 @@
 #include <Graphics/Context.h>
 #include <Graphics/Parameters.h>
 #include <DisplayWindow.h>
+#include <Performance.h>
+#include <CRC.h>
 #include <algorithm>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RDRAM_TO_CB_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RDRAM_TO_CB_NEON
+#endif
+
 using namespace graphics;
 
 RDRAMtoColorBuffer::RDRAMtoColorBuffer()
 	: m_pCurBuffer(nullptr)
 	, m_pTexture(nullptr)
-	, m_pbuf(nullptr) {
+	, m_pbuf(nullptr)
+	, m_rowsAddress(0)
+	, m_rowsWidth(0)
+	, m_rowsSize(0)
+	, m_rowsFullAlpha(false) {
 }
 
 RDRAMtoColorBuffer & RDRAMtoColorBuffer::get()
@@ -63,6 +77,7 @@ void RDRAMtoColorBuffer::init()
 	gfxContext.setTextureParameters(setParams);
 
 	m_pbuf = (u8*)malloc(m_pTexture->textureBytes);
+	m_rows.clear();
 }
 
 void RDRAMtoColorBuffer::destroy()
@@ -73,6 +88,7 @@ void RDRAMtoColorBuffer::destroy()
 	}
 	free(m_pbuf);
 	m_pbuf = nullptr;
+	m_rows.clear();
 }
 
 void RDRAMtoColorBuffer::addAddress(u32 _address, u32 _size)
@@ -90,29 +106,140 @@ void RDRAMtoColorBuffer::addAddress(u32 _address, u32 _size)
 	gDP.colorImage.changed = TRUE;
 }
 
-// Write the whole buffer
+// Vectorized RGBA16 to ABGR32 conversion. Converts pixels in groups of 8 and returns
+// the number of converted pixels. Source halfwords are swapped pairwise as RDRAM addressing requires.
+static
+u32 _convertRowRGBA16(const u16 * _src, u32 * _dst, u32 _count, bool _fullAlpha, u32 & _summ)
+{
+	u32 x = 0;
+#if defined(RDRAM_TO_CB_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i maskR = _mm_set1_epi32(0xf8);
+	const __m128i maskG = _mm_set1_epi32(0xf800);
+	const __m128i maskB = _mm_set1_epi32(0xf80000);
+	const __m128i maskA = _mm_set1_epi32(static_cast<int>(0xff000000));
+	const __m128i one = _mm_set1_epi32(1);
+	__m128i summ = zero;
+	for (; x + 8 <= _count; x += 8) {
+		__m128i c16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + x));
+		summ = _mm_or_si128(summ, c16);
+		c16 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c16, 0xB1), 0xB1);
+		__m128i c[2] = { _mm_unpacklo_epi16(c16, zero), _mm_unpackhi_epi16(c16, zero) };
+		for (u32 i = 0; i < 2; ++i) {
+			__m128i res = _mm_and_si128(_mm_srli_epi32(c[i], 8), maskR);
+			res = _mm_or_si128(res, _mm_and_si128(_mm_slli_epi32(c[i], 5), maskG));
+			res = _mm_or_si128(res, _mm_and_si128(_mm_slli_epi32(c[i], 18), maskB));
+			if (_fullAlpha)
+				res = _mm_or_si128(res, maskA);
+			else
+				res = _mm_or_si128(res, _mm_and_si128(_mm_sub_epi32(zero, _mm_and_si128(c[i], one)), maskA));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + x + i * 4), res);
+		}
+	}
+	summ = _mm_or_si128(summ, _mm_srli_si128(summ, 8));
+	summ = _mm_or_si128(summ, _mm_srli_si128(summ, 4));
+	_summ |= static_cast<u32>(_mm_cvtsi128_si32(summ));
+#elif defined(RDRAM_TO_CB_NEON)
+	const uint32x4_t maskR = vdupq_n_u32(0xf8);
+	const uint32x4_t maskG = vdupq_n_u32(0xf800);
+	const uint32x4_t maskB = vdupq_n_u32(0xf80000);
+	const uint32x4_t maskA = vdupq_n_u32(0xff000000);
+	const uint32x4_t one = vdupq_n_u32(1);
+	uint16x8_t summ = vdupq_n_u16(0);
+	for (; x + 8 <= _count; x += 8) {
+		uint16x8_t c16 = vld1q_u16(_src + x);
+		summ = vorrq_u16(summ, c16);
+		c16 = vrev32q_u16(c16);
+		const uint32x4_t c[2] = { vmovl_u16(vget_low_u16(c16)), vmovl_u16(vget_high_u16(c16)) };
+		for (u32 i = 0; i < 2; ++i) {
+			uint32x4_t res = vandq_u32(vshrq_n_u32(c[i], 8), maskR);
+			res = vorrq_u32(res, vandq_u32(vshlq_n_u32(c[i], 5), maskG));
+			res = vorrq_u32(res, vandq_u32(vshlq_n_u32(c[i], 18), maskB));
+			if (_fullAlpha)
+				res = vorrq_u32(res, maskA);
+			else
+				res = vorrq_u32(res, vandq_u32(vtstq_u32(c[i], one), maskA));
+			vst1q_u32(_dst + x + i * 4, res);
+		}
+	}
+	const uint16x4_t summ4 = vorr_u16(vget_low_u16(summ), vget_high_u16(summ));
+	_summ |= vget_lane_u32(vreinterpret_u32_u16(summ4), 0) | vget_lane_u32(vreinterpret_u32_u16(summ4), 1);
+#endif
+	(void)_src;
+	(void)_dst;
+	(void)_fullAlpha;
+	return x;
+}
+
+// Vectorized RGBA32 to ABGR32 conversion. Converts pixels in groups of 4 and returns
+// the number of converted pixels.
+static
+u32 _convertRowRGBA32(const u32 * _src, u32 * _dst, u32 _count, bool _fullAlpha, u32 & _summ)
+{
+	u32 x = 0;
+#if defined(RDRAM_TO_CB_SSE2)
+	const __m128i alpha = _fullAlpha ? _mm_set1_epi32(static_cast<int>(0xff000000)) : _mm_setzero_si128();
+	__m128i summ = _mm_setzero_si128();
+	for (; x + 4 <= _count; x += 4) {
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + x));
+		summ = _mm_or_si128(summ, c);
+		__m128i res = _mm_or_si128(_mm_slli_epi16(c, 8), _mm_srli_epi16(c, 8));
+		res = _mm_shufflehi_epi16(_mm_shufflelo_epi16(res, 0xB1), 0xB1);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + x), _mm_or_si128(res, alpha));
+	}
+	summ = _mm_or_si128(summ, _mm_srli_si128(summ, 8));
+	summ = _mm_or_si128(summ, _mm_srli_si128(summ, 4));
+	_summ |= static_cast<u32>(_mm_cvtsi128_si32(summ));
+#elif defined(RDRAM_TO_CB_NEON)
+	const uint32x4_t alpha = vdupq_n_u32(_fullAlpha ? 0xff000000 : 0);
+	uint32x4_t summ = vdupq_n_u32(0);
+	for (; x + 4 <= _count; x += 4) {
+		const uint32x4_t c = vld1q_u32(_src + x);
+		summ = vorrq_u32(summ, c);
+		const uint32x4_t res = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(c)));
+		vst1q_u32(_dst + x, vorrq_u32(res, alpha));
+	}
+	const uint32x2_t summ2 = vorr_u32(vget_low_u32(summ), vget_high_u32(summ));
+	_summ |= vget_lane_u32(summ2, 0) | vget_lane_u32(summ2, 1);
+#endif
+	(void)_src;
+	(void)_dst;
+	(void)_fullAlpha;
+	return x;
+}
+
+static inline
+u32 _convertRow(const u16 * _src, u32 * _dst, u32 _count, bool _fullAlpha, u32 & _summ)
+{
+	return _convertRowRGBA16(_src, _dst, _count, _fullAlpha, _summ);
+}
+
+static inline
+u32 _convertRow(const u32 * _src, u32 * _dst, u32 _count, bool _fullAlpha, u32 & _summ)
+{
+	return _convertRowRGBA32(_src, _dst, _count, _fullAlpha, _summ);
+}
+
+// Write one row of the buffer. Returns true if the row has non-zero pixels.
 template <typename TSrc>
-bool _copyBufferFromRdram(u32 _address, u32* _dst, u32(*converter)(TSrc _c, bool _bCFB), u32 _xor, u32 _x0, u32 _y0, u32 _width, u32 _height, bool _fullAlpha)
+bool _copyRowFromRdram(u32 _address, u32* _dst, u32(*converter)(TSrc _c, bool _bCFB), u32 _xor, u32 _y, u32 _width, bool _fullAlpha)
 {
-	TSrc * src = reinterpret_cast<TSrc*>(RDRAM + _address);
+	const TSrc * src = reinterpret_cast<const TSrc*>(RDRAM + _address);
 	const u32 bound = (RDRAMSize + 1 - _address) >> (sizeof(TSrc) / 2);
-	TSrc col;
-	u32 idx;
+	const u32 rowStart = _y * _width;
 	u32 summ = 0;
-	u32 dsty = 0;
-	const u32 y1 = _y0 + _height;
-	for (u32 y = _y0; y < y1; ++y) {
-		for (u32 x = _x0; x < _width; ++x) {
-			idx = (x + y *_width) ^ _xor;
-			if (idx >= bound)
-				break;
-			col = src[idx];
-			summ += col;
-			_dst[x + dsty*_width] = converter(col, _fullAlpha);
-		}
-		++dsty;
+	u32 x = 0;
+	// Vector path keeps xor swapped pixel pairs inside the row.
+	if (((rowStart | _width) & 1) == 0 && rowStart + _width <= bound)
+		x = _convertRow(src + rowStart, _dst + rowStart, _width, _fullAlpha, summ);
+	for (; x < _width; ++x) {
+		const u32 idx = (x + rowStart) ^ _xor;
+		if (idx >= bound)
+			break;
+		const TSrc col = src[idx];
+		summ |= col;
+		_dst[x + rowStart] = converter(col, _fullAlpha);
 	}
-
 	return summ != 0;
 }
 
@@ -201,13 +328,51 @@ void RDRAMtoColorBuffer::_copyFromRDRAM(u32 _height, bool _fullAlpha)
 		pDst = reinterpret_cast<u32*>(m_pbuf);
 	}
 
-	bool bCopy;
+	bool bCopy = false;
+	// Rows of the texture to upload
+	u32 uploadY0 = y0;
+	u32 uploadY1 = y1;
 	if (m_vecAddress.empty()) {
-		if (m_pCurBuffer->m_size == G_IM_SIZ_16b)
-			bCopy = _copyBufferFromRdram<u16>(address, pDst, RGBA16ToABGR32, 1, x0, y0, width, height, _fullAlpha);
-		else
-			bCopy = _copyBufferFromRdram<u32>(address, pDst, RGBA32ToABGR32, 0, x0, y0, width, height, _fullAlpha);
+		// Only rows whose RDRAM content changed since the last copy of the same buffer are converted.
+		// Float and 16bit textures are converted through a different layout, so they are always copied in full.
+		const bool bTrackRows = fbTexFormats.colorType != datatype::FLOAT && fbTexFormats.colorFormatBytes == 4;
+		const bool bSameSource = bTrackRows &&
+			m_rowsAddress == address &&
+			m_rowsWidth == width &&
+			m_rowsSize == m_pCurBuffer->m_size &&
+			m_rowsFullAlpha == _fullAlpha;
+		if (!bSameSource)
+			m_rows.clear();
+		if (m_rows.size() < height)
+			m_rows.resize(height);
+		m_rowsAddress = address;
+		m_rowsWidth = width;
+		m_rowsSize = m_pCurBuffer->m_size;
+		m_rowsFullAlpha = _fullAlpha;
+
+		const u32 rowBytes = width << m_pCurBuffer->m_size >> 1;
+		uploadY0 = y1;
+		uploadY1 = y0;
+		for (u32 y = y0; y < y1; ++y) {
+			RowState & row = m_rows[y];
+			const u32 rowAddress = address + y * rowBytes;
+			const bool bInRdram = rowAddress + rowBytes <= RDRAMSize + 1;
+			const u64 hash = bInRdram ? XXH3_64bits(RDRAM + rowAddress, rowBytes) : 0;
+			if (!bTrackRows || !bInRdram || !row.valid || row.hash != hash) {
+				if (m_pCurBuffer->m_size == G_IM_SIZ_16b)
+					row.nonZero = _copyRowFromRdram<u16>(address, pDst, RGBA16ToABGR32, 1, y, width, _fullAlpha);
+				else
+					row.nonZero = _copyRowFromRdram<u32>(address, pDst, RGBA32ToABGR32, 0, y, width, _fullAlpha);
+				row.hash = hash;
+				row.valid = bTrackRows && bInRdram;
+				uploadY0 = std::min(uploadY0, y);
+				uploadY1 = y + 1;
+			}
+			bCopy |= row.nonZero;
+		}
 	} else {
+		// The texture is filled from scratch here, so content of converted rows is lost.
+		m_rows.clear();
 		if (m_pCurBuffer->m_size == G_IM_SIZ_16b)
 			bCopy = _copyPixelsFromRdram<u16>(address, m_vecAddress, pDst, RGBA16ToABGR32, 1, width, height, _fullAlpha);
 		else
@@ -245,15 +410,20 @@ void RDRAMtoColorBuffer::_copyFromRDRAM(u32 _height, bool _fullAlpha)
 	CombinerInfo::get().setPolygonMode(DrawingState::TexRect);
 	CombinerInfo::get().update();
 
-	Context::UpdateTextureDataParams updateParams;
-	updateParams.handle = m_pTexture->name;
-	updateParams.textureUnitIndex = textureIndices::Tex[0];
-	updateParams.width = width;
-	updateParams.height = height;
-	updateParams.format = fbTexFormats.colorFormat;
-	updateParams.dataType = fbTexFormats.colorType;
-	updateParams.data = m_pbuf;
-	gfxContext.update2DTexture(updateParams);
+	if (uploadY0 < uploadY1) {
+		const u32 rowBytes = width * fbTexFormats.colorFormatBytes;
+		Context::UpdateTextureDataParams updateParams;
+		updateParams.handle = m_pTexture->name;
+		updateParams.textureUnitIndex = textureIndices::Tex[0];
+		updateParams.y = uploadY0;
+		updateParams.width = width;
+		updateParams.height = uploadY1 - uploadY0;
+		updateParams.format = fbTexFormats.colorFormat;
+		updateParams.dataType = fbTexFormats.colorType;
+		updateParams.data = m_pbuf + uploadY0 * rowBytes;
+		gfxContext.update2DTexture(updateParams);
+		perf.addCounter(Performance::pcFBUploadBytes, updateParams.height * rowBytes);
+	}
 
 	m_pTexture->scaleS = 1.0f / (float)m_pTexture->realWidth;
 	m_pTexture->scaleT = 1.0f / (float)m_pTexture->realHeight;
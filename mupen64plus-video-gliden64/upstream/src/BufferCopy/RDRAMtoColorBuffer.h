@@ -43,10 +43,24 @@ private:
 		FrameBuffer * m_pCurrentBuffer;
 	};
 
+	// State of a texture row, converted from RDRAM by the previous copy.
+	struct RowState {
+		u64 hash = 0;
+		bool valid = false;
+		bool nonZero = false;
+	};
+
 	FrameBuffer * m_pCurBuffer;
 	CachedTexture * m_pTexture;
 	std::vector<u32> m_vecAddress;
 	u8* m_pbuf;
+
+	// Source of the rows currently stored in the texture
+	std::vector<RowState> m_rows;
+	u32 m_rowsAddress;
+	u32 m_rowsWidth;
+	u32 m_rowsSize;
+	bool m_rowsFullAlpha;
 };
 
 #endif // RDRAMtoColorBuffer_H
@@ -2,10 +2,18 @@
 #define WriteToRDRAM_H
 
 
+#include <algorithm>
 #include "../Types.h"
 
+// Optional batch converter. Converts up to _count pixels from _src to _dst, applying
+// the same xor and test value rules as the per-pixel converter, and returns the
+// number of pixels processed. The returned value must be even.
 template <typename TSrc, typename TDst>
-void writeToRdram(TSrc* _src, TDst* _dst, TDst(*converter)(TSrc _c), TSrc _testValue, u32 _xor, u32 _width, u32 _height, u32 _numPixels, u32 _startAddress, u32 _bufferAddress, u32 _bufferSize)
+using RowConverter = u32(*)(const TSrc* _src, TDst* _dst, u32 _count);
+
+template <typename TSrc, typename TDst>
+void writeToRdram(TSrc* _src, TDst* _dst, TDst(*converter)(TSrc _c), TSrc _testValue, u32 _xor, u32 _width, u32 _height, u32 _numPixels, u32 _startAddress, u32 _bufferAddress, u32 _bufferSize,
+				  RowConverter<TSrc, TDst> _rowConverter = nullptr)
 {
 	u32 chunkStart = ((_startAddress - _bufferAddress) >> (_bufferSize - 1)) % _width;
 	if (chunkStart % 2 != 0) {
@@ -28,9 +36,18 @@ void writeToRdram(TSrc* _src, TDst* _dst, TDst(*converter)(TSrc _c), TSrc _testV
 		_dst += numStored;
 	}
 
+	// Xor addressing stays inside the row only when rows start at even pixel indices.
+	if ((_width & 1) != 0)
+		_rowConverter = nullptr;
+
 	u32 dsty = 0;
 	for (; y < _height; ++y) {
-		for (u32 x = 0; x < _width && numStored < _numPixels; ++x) {
+		u32 x = 0;
+		if (_rowConverter != nullptr && numStored < _numPixels) {
+			x = _rowConverter(_src + y * _width, _dst + dsty * _width, std::min(_width, _numPixels - numStored));
+			numStored += x;
+		}
+		for (; x < _width && numStored < _numPixels; ++x) {
 			c = _src[x + y *_width];
 			if (c != _testValue)
 				_dst[(x + dsty*_width) ^ _xor] = converter(c);
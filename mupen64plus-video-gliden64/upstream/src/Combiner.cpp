@@ -1,3 +1,4 @@
+#include <chrono>
 #include <fstream>
 #include <functional>
 #include <cstring>
@@ -9,6 +10,7 @@
 #include "gDP.h"
 #include "Config.h"
 #include "PluginAPI.h"
+#include "Performance.h"
 #include "RSP.h"
 #include "Graphics/Context.h"
 
@@ -348,9 +350,17 @@ void CombinerInfo::setCombine(u64 _mux )
 	if (iter != m_combiners.end()) {
 		m_pCurrent = iter->second;
 	} else {
+		// The first draw with a new combiner waits for its program here. There is no compile thread,
+		// since the video extension API can't create a shared GL context, and no ubershader to draw with
+		// meanwhile. The stall is counted so that its cost shows in the logged counters.
+		const std::chrono::steady_clock::time_point compileStart = std::chrono::steady_clock::now();
 		m_pCurrent = Combiner_Compile(key);
 		m_pCurrent->update(true);
 		m_combiners[m_pCurrent->getKey()] = m_pCurrent;
+		const std::chrono::steady_clock::duration compileTime = std::chrono::steady_clock::now() - compileStart;
+		perf.addCounter(Performance::pcShaderCompileCount, 1);
+		perf.addCounter(Performance::pcShaderCompileStallTime,
+			static_cast<u32>(std::chrono::duration_cast<std::chrono::microseconds>(compileTime).count()));
 	}
 	m_bChanged = true;
 }
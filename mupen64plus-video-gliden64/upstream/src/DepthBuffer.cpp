@@ -455,6 +455,9 @@ void DepthBufferList::saveBuffer(u32 _address)
 		return;
 	}
 
+	// Batched triangles belong to the current depth buffer.
+	dwnd().getDrawer().flushTriangles();
+
 	FrameBuffer * pFrameBuffer = frameBufferList().findBuffer(_address);
 	if (pFrameBuffer != nullptr)
 		pFrameBuffer->m_isDepthBuffer = true;
@@ -21,13 +21,25 @@
 #include "DepthBuffer.h"
 #include "DepthBufferRender.h"
 
-static vertexi * max_vtx;                   // Max y vertex (ending vertex)
-static vertexi * start_vtx, *end_vtx;      // First and last vertex in array
-static vertexi * right_vtx, *left_vtx;     // Current right and left vertex
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DEPTH_RENDER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DEPTH_RENDER_NEON
+#endif
+
+// Edge walker state. Kept per call, so Rasterize can be used from any thread.
+struct EdgeState
+{
+	vertexi * max_vtx;                   // Max y vertex (ending vertex)
+	vertexi * start_vtx, *end_vtx;      // First and last vertex in array
+	vertexi * right_vtx, *left_vtx;     // Current right and left vertex
 
-static int right_height, left_height;
-static int right_x, right_dxdy, left_x, left_dxdy;
-static int left_z, left_dzdy;
+	int right_height, left_height;
+	int right_x, right_dxdy, left_x, left_dxdy;
+	int left_z, left_dzdy;
+};
 
 __inline int imul16(int x, int y)        // (x * y) >> 16
 {
@@ -51,106 +63,188 @@ __inline int iceil(int x)
 }
 
 static
-void RightSection(void)
+void RightSection(EdgeState & e)
 {
 	// Walk backwards trough the vertex array
 
-	vertexi * v2, *v1 = right_vtx;
-	if (right_vtx > start_vtx)
-		v2 = right_vtx - 1;
+	vertexi * v2, *v1 = e.right_vtx;
+	if (e.right_vtx > e.start_vtx)
+		v2 = e.right_vtx - 1;
 	else
-		v2 = end_vtx;         // Wrap to end of array
-	right_vtx = v2;
+		v2 = e.end_vtx;         // Wrap to end of array
+	e.right_vtx = v2;
 
 	// v1 = top vertex
 	// v2 = bottom vertex
 
 	// Calculate number of scanlines in this section
 
-	right_height = iceil(v2->y) - iceil(v1->y);
-	if (right_height <= 0)
+	e.right_height = iceil(v2->y) - iceil(v1->y);
+	if (e.right_height <= 0)
 		return;
 
 	// Guard against possible div overflows
 
-	if (right_height > 1) {
+	if (e.right_height > 1) {
 		// OK, no worries, we have a section that is at least
 		// one pixel high. Calculate slope as usual.
 
 		int height = v2->y - v1->y;
-		right_dxdy = idiv16(v2->x - v1->x, height);
+		e.right_dxdy = idiv16(v2->x - v1->x, height);
 	} else {
 		// Height is less or equal to one pixel.
 		// Calculate slope = width * 1/height
 		// using 18:14 bit precision to avoid overflows.
 
 		int inv_height = (0x10000 << 14) / (v2->y - v1->y);
-		right_dxdy = imul14(v2->x - v1->x, inv_height);
+		e.right_dxdy = imul14(v2->x - v1->x, inv_height);
 	}
 
 	// Prestep initial values
 
 	int prestep = (iceil(v1->y) << 16) - v1->y;
-	right_x = v1->x + imul16(prestep, right_dxdy);
+	e.right_x = v1->x + imul16(prestep, e.right_dxdy);
 }
 
 static
-void LeftSection(void)
+void LeftSection(EdgeState & e)
 {
 	// Walk forward trough the vertex array
 
-	vertexi * v2, *v1 = left_vtx;
-	if (left_vtx < end_vtx)
-		v2 = left_vtx + 1;
+	vertexi * v2, *v1 = e.left_vtx;
+	if (e.left_vtx < e.end_vtx)
+		v2 = e.left_vtx + 1;
 	else
-		v2 = start_vtx;      // Wrap to start of array
-	left_vtx = v2;
+		v2 = e.start_vtx;      // Wrap to start of array
+	e.left_vtx = v2;
 
 	// v1 = top vertex
 	// v2 = bottom vertex
 
 	// Calculate number of scanlines in this section
 
-	left_height = iceil(v2->y) - iceil(v1->y);
-	if (left_height <= 0)
+	e.left_height = iceil(v2->y) - iceil(v1->y);
+	if (e.left_height <= 0)
 		return;
 
 	// Guard against possible div overflows
 
-	if (left_height > 1) {
+	if (e.left_height > 1) {
 		// OK, no worries, we have a section that is at least
 		// one pixel high. Calculate slope as usual.
 
 		int height = v2->y - v1->y;
-		left_dxdy = idiv16(v2->x - v1->x, height);
-		left_dzdy = idiv16(v2->z - v1->z, height);
+		e.left_dxdy = idiv16(v2->x - v1->x, height);
+		e.left_dzdy = idiv16(v2->z - v1->z, height);
 	} else {
 		// Height is less or equal to one pixel.
 		// Calculate slope = width * 1/height
 		// using 18:14 bit precision to avoid overflows.
 
 		int inv_height = (0x10000 << 14) / (v2->y - v1->y);
-		left_dxdy = imul14(v2->x - v1->x, inv_height);
-		left_dzdy = imul14(v2->z - v1->z, inv_height);
+		e.left_dxdy = imul14(v2->x - v1->x, inv_height);
+		e.left_dzdy = imul14(v2->z - v1->z, inv_height);
 	}
 
 	// Prestep initial values
 
 	int prestep = (iceil(v1->y) << 16) - v1->y;
-	left_x = v1->x + imul16(prestep, left_dxdy);
-	left_z = v1->z + imul16(prestep, left_dzdy);
+	e.left_x = v1->x + imul16(prestep, e.left_dxdy);
+	e.left_z = v1->z + imul16(prestep, e.left_dzdy);
+}
+
+
+static
+void DrawPixel(u16 * destptr, int idx, long long z, const u16 * zLUT)
+{
+	// Depth saturates at 0x7fffffff, negative depth is clamped to zero. This is deliberate: the old
+	// min(z + dzdx, 0x7fffffff) step overflowed, and wrote spans running past the far plane as the
+	// nearest depth. test/depth_render_test.cpp has the sets where this differs.
+	const int trueZ = static_cast<int>(std::min(std::max(z, 0LL), 0x7fffffffLL) >> 13);
+	const u16 encodedZ = zLUT[trueZ];
+	idx ^= 1;
+	if (encodedZ < destptr[idx])
+		destptr[idx] = encodedZ;
 }
 
+static
+void DrawSpan(u16 * destptr, int shift, int width, int z, int dzdx, const u16 * zLUT)
+{
+	// Find the range of pixels where z stays inside [0, 0x7fffffff].
+	// There depth can be stepped with plain 32bit adds, so it is processed 8 pixels at a time.
+	// Spans too short for a vector step skip the search, as do spans that stay in range.
+	long long linStart = 0, linEnd = width;
+	const long long lastZ = z + (long long)(width - 1) * dzdx;
+	if (width < 9) {
+		linEnd = 0;
+	} else if (z < 0 || lastZ < 0 || lastZ > 0x7fffffffLL) {
+		if (dzdx > 0) {
+			if (z < 0)
+				linStart = (-(long long)z + dzdx - 1) / dzdx;
+			linEnd = (0x7fffffffLL - z) / dzdx + 1;
+		} else if (dzdx < 0) {
+			linEnd = z < 0 ? 0 : (long long)z / -(long long)dzdx + 1;
+		} else {
+			linEnd = 0;
+		}
+	}
+	linEnd = std::min(linEnd, (long long)width);
+
+	int x = 0;
+#if defined(DEPTH_RENDER_SSE2) || defined(DEPTH_RENDER_NEON)
+	if (linStart < linEnd) {
+		// Scalar head up to an even RDRAM index, so pixel pairs swapped by the xor addressing stay together
+		int vecStart = static_cast<int>(linStart);
+		if (((shift + vecStart) & 1) != 0)
+			++vecStart;
+		for (; x < vecStart && x < width; ++x)
+			DrawPixel(destptr, shift + x, z + (long long)x * dzdx, zLUT);
+
+		for (; x + 8 <= linEnd; x += 8) {
+			const int zx = static_cast<int>(z + (long long)x * dzdx);
+			u16 * dst = destptr + shift + x;
+			u16 encoded[8];
+#if defined(DEPTH_RENDER_SSE2)
+			const __m128i step = _mm_set1_epi32(dzdx * 4);
+			const __m128i z0 = _mm_set_epi32(zx + 2 * dzdx, zx + 3 * dzdx, zx, zx + dzdx);
+			alignas(16) u32 trueZ[8];
+			_mm_store_si128(reinterpret_cast<__m128i*>(trueZ), _mm_srli_epi32(z0, 13));
+			_mm_store_si128(reinterpret_cast<__m128i*>(trueZ + 4), _mm_srli_epi32(_mm_add_epi32(z0, step), 13));
+			for (u32 i = 0; i < 8; ++i)
+				encoded[i] = zLUT[trueZ[i]];
+			const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+			const __m128i enc = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(encoded)), bias);
+			const __m128i old = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dst)), bias);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_xor_si128(_mm_min_epi16(enc, old), bias));
+#else
+			const int32_t laneOrder[4] = { 1, 0, 3, 2 };
+			const int32x4_t z0 = vmlaq_n_s32(vdupq_n_s32(zx), vld1q_s32(laneOrder), dzdx);
+			const int32x4_t z1 = vaddq_s32(z0, vdupq_n_s32(dzdx * 4));
+			uint32_t trueZ[8];
+			vst1q_u32(trueZ, vshrq_n_u32(vreinterpretq_u32_s32(z0), 13));
+			vst1q_u32(trueZ + 4, vshrq_n_u32(vreinterpretq_u32_s32(z1), 13));
+			for (u32 i = 0; i < 8; ++i)
+				encoded[i] = zLUT[trueZ[i]];
+			vst1q_u16(dst, vminq_u16(vld1q_u16(encoded), vld1q_u16(dst)));
+#endif
+		}
+	}
+#endif
+
+	for (; x < width; ++x)
+		DrawPixel(destptr, shift + x, z + (long long)x * dzdx, zLUT);
+}
 
 void Rasterize(vertexi * vtx, int vertices, int dzdx)
 {
-	start_vtx = vtx;        // First vertex in array
+	EdgeState e;
+	e.start_vtx = vtx;        // First vertex in array
 
 	// Search trough the vtx array to find min y, max y
 	// and the location of these structures.
 
 	vertexi * min_vtx = vtx;
-	max_vtx = vtx;
+	e.max_vtx = vtx;
 
 	int min_y = vtx->y;
 	int max_y = vtx->y;
@@ -163,7 +257,7 @@ void Rasterize(vertexi * vtx, int vertices, int dzdx)
 			min_vtx = vtx;
 		} else if (vtx->y > max_y) {
 			max_y = vtx->y;
-			max_vtx = vtx;
+			e.max_vtx = vtx;
 		}
 		vtx++;
 	}
@@ -171,94 +265,81 @@ void Rasterize(vertexi * vtx, int vertices, int dzdx)
 	// OK, now we know where in the array we should start and
 	// where to end while scanning the edges of the polygon
 
-	left_vtx = min_vtx;    // Left side starting vertex
-	right_vtx = min_vtx;    // Right side starting vertex
-	end_vtx = vtx - 1;      // Last vertex in array
+	e.left_vtx = min_vtx;    // Left side starting vertex
+	e.right_vtx = min_vtx;    // Right side starting vertex
+	e.end_vtx = vtx - 1;      // Last vertex in array
 
 	// Search for the first usable right section
 
 	do {
-		if (right_vtx == max_vtx)
+		if (e.right_vtx == e.max_vtx)
 			return;
-		RightSection();
-	} while (right_height <= 0);
+		RightSection(e);
+	} while (e.right_height <= 0);
 
 	// Search for the first usable left section
 
 	do {
-		if (left_vtx == max_vtx)
+		if (e.left_vtx == e.max_vtx)
 			return;
-		LeftSection();
-	} while (left_height <= 0);
+		LeftSection(e);
+	} while (e.left_height <= 0);
 
 	u16 * destptr = (u16*)(RDRAM + gDP.depthImageAddress);
+	const gDPScissor scissor = gDP.scissor;
 	int y1 = iceil(min_y);
-	if (y1 >= (int)gDP.scissor.lry)
+	if (y1 >= (int)scissor.lry)
 		return;
-	int shift;
 
 	const u16 * const zLUT = depthBufferList().getZLUT();
 	const u32 depthBufferWidth = depthBufferList().getCurrent()->m_width;
 
 	for (;;) {
-		int x1 = iceil(left_x);
-		if (x1 < (int)gDP.scissor.ulx)
-			x1 = (int)gDP.scissor.ulx;
-		int width = iceil(right_x) - x1;
-		if (x1 + width >= (int)gDP.scissor.lrx)
-			width = (int)(gDP.scissor.lrx - x1 - 1);
+		int x1 = iceil(e.left_x);
+		if (x1 < (int)scissor.ulx)
+			x1 = (int)scissor.ulx;
+		int width = iceil(e.right_x) - x1;
+		if (x1 + width >= (int)scissor.lrx)
+			width = (int)(scissor.lrx - x1 - 1);
 
-		if (width > 0 && y1 >= (int)gDP.scissor.uly) {
+		if (width > 0 && y1 >= (int)scissor.uly) {
 
 			// Prestep initial z
 
-			int prestep = (x1 << 16) - left_x;
-			int z = left_z + imul16(prestep, dzdx);
+			int prestep = (x1 << 16) - e.left_x;
+			int z = e.left_z + imul16(prestep, dzdx);
 
-			shift = x1 + y1*depthBufferWidth;
 			//draw to depth buffer
-			int trueZ;
-			int idx;
-			u16 encodedZ;
-			for (int x = 0; x < width; x++)	{
-				trueZ = z / 8192;
-				if (trueZ < 0)
-					trueZ = 0;
-				encodedZ = zLUT[trueZ];
-				idx = (shift + x) ^ 1;
-				if (encodedZ < destptr[idx])
-					destptr[idx] = encodedZ;
-				z = std::min(z + dzdx, 0x7fffffff);
-			}
+			DrawSpan(destptr, x1 + y1*depthBufferWidth, width, z, dzdx, zLUT);
 		}
 
 		//destptr += rdp.zi_width;
 		y1++;
-		if (y1 >= (int)gDP.scissor.lry)
+		if (y1 >= (int)scissor.lry)
 			return;
 
 		// Scan the right side
 
-		if (--right_height <= 0) {               // End of this section?
+		if (--e.right_height <= 0) {               // End of this section?
 			do {
-				if (right_vtx == max_vtx)
+				if (e.right_vtx == e.max_vtx)
 					return;
-				RightSection();
-			} while (right_height <= 0);
+				RightSection(e);
+			} while (e.right_height <= 0);
 		} else
-			right_x += right_dxdy;
+			e.right_x += e.right_dxdy;
 
 		// Scan the left side
 
-		if (--left_height <= 0) {                // End of this section?
+		if (--e.left_height <= 0) {                // End of this section?
 			do {
-				if (left_vtx == max_vtx)
+				if (e.left_vtx == e.max_vtx)
 					return;
-				LeftSection();
-			} while (left_height <= 0);
+				LeftSection(e);
+			} while (e.left_height <= 0);
 		} else {
-			left_x += left_dxdy;
-			left_z += left_dzdy;
+			e.left_x += e.left_dxdy;
+			e.left_z += e.left_dzdy;
 		}
 	}
 }
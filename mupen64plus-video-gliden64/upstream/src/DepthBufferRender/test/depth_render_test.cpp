@@ -0,0 +1,351 @@
+//****************************************************************
+//
+// Depth buffer software render test
+//
+// Rasterizes fixed sets of polygons into an N64 depth buffer and
+// checks a hash of the buffer after each set against recordedHash.
+//
+// referenceHash holds the hashes of the scalar span loop and global
+// edge walker state DepthBufferRender.cpp had before its spans were
+// vectorized. The sets match bit for bit except the slivers and the
+// saturation set. The old loop stepped depth with
+// min(z + dzdx, 0x7fffffff), which overflows instead of saturating:
+// a span running past the far plane wrapped to negative depth and
+// was written as the nearest value. The current code clamps to
+// [0, 0x7fffffff] on both ends. Slivers reach that case through the
+// 18:14 slope path, whose slopes can be far off for sections a
+// fraction of a pixel high. The old code with only its depth step
+// made saturating reproduces recordedHash for every set.
+//
+// Building against another DepthBufferRender.cpp, e.g. the one from
+// before vectorization:
+//     make depth_render_reference REFERENCE=/path/to/old/DepthBufferRender
+// checks against referenceHash and gives the bench figures to
+// compare with.
+//
+// Usage: depth_render_test [record|bench]
+//   record prints the hash table in the form used below
+//   bench prints the time per polygon of each set
+//
+//****************************************************************
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "N64.h"
+#include "gDP.h"
+#include "DepthBuffer.h"
+#include "../DepthBufferRender.h"
+
+u8 *RDRAM;
+gDPInfo gDP;
+
+DepthBufferList & DepthBufferList::get()
+{
+	static DepthBufferList list;
+	return list;
+}
+
+namespace {
+
+const u32 bufferWidth = 320;
+const u32 bufferHeight = 240;
+const u32 depthImageAddress = 0x1000;
+
+struct Polygon
+{
+	vertexi vtx[8];
+	int vertices;
+	int dzdx;
+};
+
+struct PolygonSet
+{
+	const char * name;
+	gDPScissor scissor;
+	std::vector<Polygon> polygons;
+};
+
+u32 randState;
+
+u32 rand32()
+{
+	// xorshift32, the same sequence on every host
+	randState ^= randState << 13;
+	randState ^= randState >> 17;
+	randState ^= randState << 5;
+	return randState;
+}
+
+double randRange(double _min, double _max)
+{
+	return _min + (_max - _min) * (rand32() / 4294967296.0);
+}
+
+int toFixed16(double _v)
+{
+	return static_cast<int>(_v * 65536.0);
+}
+
+// Builds a convex polygon on an ellipse around (cx, cy), with depth following the plane
+// z = z0 + dzdx * x + dzdy * y, in the clockwise order SoftwareRender.cpp passes to Rasterize
+Polygon makePolygon(int _vertices, double _cx, double _cy, double _rx, double _ry,
+					double _z0, double _dzdx, double _dzdy)
+{
+	const double pi = 3.14159265358979323846;
+	std::vector<double> angles(_vertices);
+	for (int i = 0; i < _vertices; ++i)
+		angles[i] = randRange(0.0, 2.0 * pi);
+	for (int i = 1; i < _vertices; ++i)
+		for (int j = i; j > 0 && angles[j] < angles[j - 1]; --j)
+			std::swap(angles[j], angles[j - 1]);
+
+	Polygon p;
+	p.vertices = _vertices;
+	p.dzdx = toFixed16(_dzdx);
+	double x[8], y[8];
+	for (int i = 0; i < _vertices; ++i) {
+		x[i] = _cx + _rx * cos(angles[i]);
+		y[i] = _cy + _ry * sin(angles[i]);
+	}
+
+	// Same winding test as calcScreenCoordinates
+	const bool clockwise = (x[0] - x[1]) * (y[2] - y[1]) - (y[0] - y[1]) * (x[2] - x[1]) >= 0.0;
+	for (int i = 0; i < _vertices; ++i) {
+		const int idx = clockwise ? i : _vertices - i - 1;
+		p.vtx[i].x = toFixed16(x[idx]);
+		p.vtx[i].y = toFixed16(y[idx]);
+		p.vtx[i].z = toFixed16(_z0 + _dzdx * x[idx] + _dzdy * y[idx]);
+	}
+	return p;
+}
+
+// Depth in the units SoftwareRender.cpp uses, 32767 is the far plane
+Polygon makeDepthPolygon(int _vertices, double _cx, double _cy, double _rx, double _ry,
+						 double _zmin, double _zmax)
+{
+	// Pick the depth at the centre and a slope that keeps the whole polygon in [_zmin, _zmax]
+	const double zc = randRange(_zmin, _zmax);
+	const double room = std::min(zc - _zmin, _zmax - zc);
+	const double dzdx = _rx > 0.0 ? randRange(-0.5, 0.5) * room / _rx : 0.0;
+	const double dzdy = _ry > 0.0 ? randRange(-0.5, 0.5) * room / _ry : 0.0;
+	return makePolygon(_vertices, _cx, _cy, _rx, _ry, zc - dzdx * _cx - dzdy * _cy, dzdx, dzdy);
+}
+
+gDPScissor fullScissor()
+{
+	gDPScissor scissor = {};
+	scissor.lrx = static_cast<f32>(bufferWidth);
+	scissor.lry = static_cast<f32>(bufferHeight);
+	return scissor;
+}
+
+std::vector<PolygonSet> makeSets()
+{
+	std::vector<PolygonSet> sets;
+	randState = 0x2545f491;
+
+	// Small triangles, the common case in N64 scenes
+	PolygonSet small = { "small triangles", fullScissor(), {} };
+	for (int i = 0; i < 20000; ++i)
+		small.polygons.push_back(makeDepthPolygon(3, randRange(-8.0, 328.0), randRange(-8.0, 248.0),
+			randRange(0.5, 12.0), randRange(0.5, 12.0), 100.0, 32000.0));
+	sets.push_back(small);
+
+	// Large triangles crossing the screen edges
+	PolygonSet large = { "large triangles", fullScissor(), {} };
+	for (int i = 0; i < 1000; ++i)
+		large.polygons.push_back(makeDepthPolygon(3, randRange(0.0, 320.0), randRange(0.0, 240.0),
+			randRange(40.0, 300.0), randRange(40.0, 300.0), 100.0, 32000.0));
+	sets.push_back(large);
+
+	// Polygons left by near plane clipping
+	PolygonSet clipped = { "clipped polygons", fullScissor(), {} };
+	for (int i = 0; i < 2000; ++i)
+		clipped.polygons.push_back(makeDepthPolygon(4 + static_cast<int>(rand32() % 5), randRange(0.0, 320.0),
+			randRange(0.0, 240.0), randRange(5.0, 120.0), randRange(5.0, 120.0), 100.0, 32000.0));
+	sets.push_back(clipped);
+
+	// Slivers less than a pixel high or wide, which take the 18:14 slope path
+	PolygonSet slivers = { "slivers", fullScissor(), {} };
+	for (int i = 0; i < 10000; ++i) {
+		const bool wide = (rand32() & 1) != 0;
+		slivers.polygons.push_back(makeDepthPolygon(3, randRange(0.0, 320.0), randRange(0.0, 240.0),
+			wide ? randRange(10.0, 200.0) : randRange(0.05, 0.9), wide ? randRange(0.05, 0.9) : randRange(10.0, 200.0),
+			100.0, 32000.0));
+	}
+	sets.push_back(slivers);
+
+	// Medium triangles against a smaller scissor
+	PolygonSet scissored = { "scissored", fullScissor(), {} };
+	scissored.scissor.ulx = 17.0f;
+	scissored.scissor.uly = 9.0f;
+	scissored.scissor.lrx = 301.0f;
+	scissored.scissor.lry = 203.0f;
+	for (int i = 0; i < 5000; ++i)
+		scissored.polygons.push_back(makeDepthPolygon(3, randRange(0.0, 320.0), randRange(0.0, 240.0),
+			randRange(2.0, 60.0), randRange(2.0, 60.0), 100.0, 32000.0));
+	sets.push_back(scissored);
+
+	// Spans that leave [0, 0x7fffffff], see the top of the file. The vertices stay near the
+	// planes while dzdx doesn't agree with them, as when it comes from the unclipped triangle.
+	PolygonSet saturation = { "saturation", fullScissor(), {} };
+	for (int i = 0; i < 2000; ++i) {
+		const double z0 = (rand32() & 1) != 0 ? randRange(32600.0, 32760.0) : randRange(5.0, 200.0);
+		Polygon polygon = makePolygon(3, randRange(0.0, 320.0), randRange(0.0, 240.0), randRange(20.0, 200.0),
+			randRange(2.0, 30.0), z0, 0.0, 0.0);
+		polygon.dzdx = toFixed16(randRange(-3000.0, 3000.0));
+		saturation.polygons.push_back(polygon);
+	}
+	sets.push_back(saturation);
+
+	return sets;
+}
+
+void clearDepthBuffer()
+{
+	u16 * depth = reinterpret_cast<u16*>(RDRAM + depthImageAddress);
+	for (u32 i = 0; i < bufferWidth * bufferHeight; ++i)
+		depth[i] = 0xfffc;
+}
+
+void rasterizeSet(const PolygonSet & _set)
+{
+	gDP.scissor = _set.scissor;
+	for (const Polygon & polygon : _set.polygons) {
+		// Rasterize takes a mutable array
+		vertexi vtx[8];
+		memcpy(vtx, polygon.vtx, sizeof(vtx));
+		Rasterize(vtx, polygon.vertices, polygon.dzdx);
+	}
+}
+
+u64 hashDepthBuffer()
+{
+	// FNV-1a
+	const u8 * data = RDRAM + depthImageAddress;
+	u64 hash = 0xcbf29ce484222325ULL;
+	for (u32 i = 0; i < bufferWidth * bufferHeight * 2; ++i)
+		hash = (hash ^ data[i]) * 0x100000001b3ULL;
+	return hash;
+}
+
+const u64 recordedHash[] = {
+	0xDC68CB622F72A15FULL,
+	0x44AE4CCC0055BB28ULL,
+	0x6E91FF07D2C62112ULL,
+	0xBE026B4A05D25928ULL,
+	0x9650CFB02A3215F4ULL,
+	0x486B2C7990E922C0ULL,
+};
+
+const u64 referenceHash[] = {
+	0xDC68CB622F72A15FULL,
+	0x44AE4CCC0055BB28ULL,
+	0x6E91FF07D2C62112ULL,
+	0x9784956B0EBFE17BULL,
+	0x9650CFB02A3215F4ULL,
+	0x6ED2C10A6194FCB7ULL,
+};
+
+#ifdef DEPTH_RENDER_TEST_REFERENCE
+const u64 * const expectedHash = referenceHash;
+const char * const expectedName = "referenceHash";
+#else
+const u64 * const expectedHash = recordedHash;
+const char * const expectedName = "recordedHash";
+#endif
+
+void initDepthBufferList()
+{
+	static DepthBuffer buffer;
+	buffer.m_address = depthImageAddress;
+	buffer.m_width = bufferWidth;
+
+	// Same encoding as DepthBufferList::DepthBufferList
+	static std::vector<u16> zLUT(0x40000);
+	for (int i = 0; i < 0x40000; i++) {
+		u32 exponent = 0;
+		u32 testbit = 1 << 17;
+		while ((i & testbit) && (exponent < 7)) {
+			exponent++;
+			testbit = 1 << (17 - exponent);
+		}
+
+		const u32 mantissa = (i >> (6 - (6 < exponent ? 6 : exponent))) & 0x7ff;
+		zLUT[i] = (u16)(((exponent << 11) | mantissa) << 2);
+	}
+
+	DepthBufferList::get().m_pCurrent = &buffer;
+	DepthBufferList::get().m_pzLUT = zLUT.data();
+}
+
+void bench(const std::vector<PolygonSet> & _sets)
+{
+	const int rounds = 50;
+	for (const PolygonSet & set : _sets) {
+		clearDepthBuffer();
+		auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < rounds; ++round)
+			rasterizeSet(set);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		printf("%s: %.1f ns per polygon\n", set.name, elapsed.count() * 1e9 / (rounds * set.polygons.size()));
+	}
+}
+
+}
+
+int main(int argc, char ** argv)
+{
+	const bool record = argc == 2 && strcmp(argv[1], "record") == 0;
+	const bool benchmark = argc == 2 && strcmp(argv[1], "bench") == 0;
+
+	if (argc > 1 && !record && !benchmark) {
+		printf("usage: %s [record|bench]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<u8> rdram(depthImageAddress + bufferWidth * bufferHeight * 2 + 0x1000);
+	RDRAM = rdram.data();
+	gDP.depthImageAddress = depthImageAddress;
+	initDepthBufferList();
+
+	const std::vector<PolygonSet> sets = makeSets();
+
+	if (benchmark) {
+		bench(sets);
+		return 0;
+	}
+
+	int failures = 0;
+	if (record)
+		printf("const u64 %s[] = {\n", expectedName);
+
+	for (u32 i = 0; i < sets.size(); ++i) {
+		clearDepthBuffer();
+		rasterizeSet(sets[i]);
+		const u64 hash = hashDepthBuffer();
+
+		if (record) {
+			printf("\t0x%016llXULL,\n", (unsigned long long)hash);
+			continue;
+		}
+
+		if (hash != expectedHash[i]) {
+			printf("%s: hash %016llX, expected %016llX\n", sets[i].name,
+				   (unsigned long long)hash, (unsigned long long)expectedHash[i]);
+			++failures;
+		}
+	}
+
+	if (record) {
+		printf("};\n");
+		return 0;
+	}
+
+	printf(failures == 0 ? "PASSED\n" : "FAILED\n");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+// Stand-in for DepthBuffer.h with the current buffer and the depth encoding table
+
+#ifndef DEPTHBUFFER_H
+#define DEPTHBUFFER_H
+
+#include "Types.h"
+
+struct DepthBuffer
+{
+	u32 m_address, m_width;
+};
+
+class DepthBufferList
+{
+public:
+	DepthBuffer * getCurrent() const {return m_pCurrent;}
+
+	static DepthBufferList & get();
+
+	const u16 * const getZLUT() const {return m_pzLUT;}
+
+	DepthBuffer *m_pCurrent;
+	u16 * m_pzLUT;
+};
+
+inline
+DepthBufferList & depthBufferList()
+{
+	return DepthBufferList::get();
+}
+
+#endif
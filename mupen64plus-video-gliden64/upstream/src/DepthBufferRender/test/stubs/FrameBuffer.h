@@ -0,0 +1,6 @@
+// Stand-in for FrameBuffer.h, nothing from it is used by Rasterize
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#endif
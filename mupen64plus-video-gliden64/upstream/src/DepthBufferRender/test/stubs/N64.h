@@ -0,0 +1,10 @@
+// Stand-in for N64.h, the depth buffer test only needs RDRAM
+
+#ifndef N64_H
+#define N64_H
+
+#include "Types.h"
+
+extern u8 *RDRAM;
+
+#endif
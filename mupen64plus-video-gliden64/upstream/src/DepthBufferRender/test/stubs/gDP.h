@@ -0,0 +1,23 @@
+// Stand-in for gDP.h with the state read by Rasterize
+
+#ifndef GDP_H
+#define GDP_H
+
+#include "Types.h"
+
+struct gDPScissor
+{
+	u32 mode;
+	f32 ulx, uly, lrx, lry;
+	s16 xh, yh, xl, yl;
+};
+
+struct gDPInfo
+{
+	gDPScissor scissor;
+	u32	depthImageAddress;
+};
+
+extern gDPInfo gDP;
+
+#endif
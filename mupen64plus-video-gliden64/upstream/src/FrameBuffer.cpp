@@ -688,6 +688,9 @@ void FrameBufferList::saveBuffer(u32 _address, u16 _format, u16 _size, u16 _widt
 		return;
 	}
 
+	// Batched triangles belong to the current buffer.
+	dwnd().getDrawer().flushTriangles();
+
 	if (m_pCurrent != nullptr &&
 		config.frameBufferEmulation.copyAuxToRDRAM != 0 &&
 		(config.generalEmulation.hacks & hack_Snap) == 0) {
@@ -1608,16 +1611,19 @@ void FrameBuffer_ActivateBufferTextureBG(u32 t, u32 _frameBufferAddress)
 
 void FrameBuffer_CopyToRDRAM(u32 _address, bool _sync)
 {
+	dwnd().getDrawer().flushTriangles();
 	ColorBufferToRDRAM::get().copyToRDRAM(_address, _sync);
 }
 
 void FrameBuffer_CopyChunkToRDRAM(u32 _address)
 {
+	dwnd().getDrawer().flushTriangles();
 	ColorBufferToRDRAM::get().copyChunkToRDRAM(_address);
 }
 
 bool FrameBuffer_CopyDepthBuffer( u32 address )
 {
+	dwnd().getDrawer().flushTriangles();
 	FrameBufferList & fblist = frameBufferList();
 	FrameBuffer * pCopyBuffer = fblist.getCopyBuffer();
 	if (pCopyBuffer != nullptr) {
@@ -1638,11 +1644,13 @@ bool FrameBuffer_CopyDepthBuffer( u32 address )
 
 bool FrameBuffer_CopyDepthBufferChunk(u32 address)
 {
+	dwnd().getDrawer().flushTriangles();
 	return DepthBufferToRDRAM::get().copyChunkToRDRAM(address);
 }
 
 void FrameBuffer_CopyFromRDRAM(u32 _address, bool _bCFB)
 {
+	dwnd().getDrawer().flushTriangles();
 	RDRAMtoColorBuffer::get().copyFromRDRAM(_address, _bCFB);
 }
 
@@ -1,5 +1,6 @@
 #include "Context.h"
 #include "OpenGLContext/opengl_ContextImpl.h"
+#include "Performance.h"
 
 using namespace graphics;
 
@@ -308,16 +309,22 @@ void Context::resetShaderProgram()
 
 void Context::drawTriangles(const DrawTriangleParameters & _params)
 {
+	perf.addCounter(Performance::pcDrawCalls, 1);
+	perf.addCounter(Performance::pcVertices, _params.verticesCount);
 	m_impl->drawTriangles(_params);
 }
 
 void Context::drawRects(const DrawRectParameters & _params)
 {
+	perf.addCounter(Performance::pcDrawCalls, 1);
+	perf.addCounter(Performance::pcVertices, _params.verticesCount);
 	m_impl->drawRects(_params);
 }
 
 void Context::drawLine(f32 _width, SPVertex * _vertices)
 {
+	perf.addCounter(Performance::pcDrawCalls, 1);
+	perf.addCounter(Performance::pcVertices, 2);
 	m_impl->drawLine(_width, _vertices);
 }
 
@@ -193,6 +193,7 @@ PFNGLDRAWRANGEELEMENTSBASEVERTEXPROC g_glDrawRangeElementsBaseVertex;
 PFNGLFLUSHMAPPEDBUFFERRANGEPROC g_glFlushMappedBufferRange;
 PFNGLTEXTUREBARRIERPROC g_glTextureBarrier;
 PFNGLTEXTUREBARRIERNVPROC g_glTextureBarrierNV;
+PFNGLMAXSHADERCOMPILERTHREADSARBPROC g_glMaxShaderCompilerThreadsKHR;
 PFNGLCLEARBUFFERFVPROC g_glClearBufferfv;
 PFNGLENABLEIPROC g_glEnablei;
 PFNGLDISABLEIPROC g_glDisablei;
@@ -383,6 +384,7 @@ void initGLFunctions()
     GL_GET_PROC_ADR(PFNGLFLUSHMAPPEDBUFFERRANGEPROC, FlushMappedBufferRange);
     GL_GET_PROC_ADR(PFNGLTEXTUREBARRIERPROC, TextureBarrier);
     GL_GET_PROC_ADR(PFNGLTEXTUREBARRIERNVPROC, TextureBarrierNV);
+    GL_GET_PROC_ADR(PFNGLMAXSHADERCOMPILERTHREADSARBPROC, MaxShaderCompilerThreadsKHR);
     GL_GET_PROC_ADR(PFNGLCLEARBUFFERFVPROC, ClearBufferfv);
     GL_GET_PROC_ADR(PFNGLENABLEIPROC, Enablei);
     GL_GET_PROC_ADR(PFNGLDISABLEIPROC, Disablei);
@@ -49,12 +49,14 @@ extern "C" void KHRONOS_APIENTRY glBufferStorageEXT(GLenum target, GLsizeiptr si
 #define glCreateTextures(...) assert(0 && "glCreateTextures")
 #define glCreateFramebuffers(...) assert(0 && "glCreateFramebuffers")
 #define glTextureBarrier(...) assert(0 && "glTextureBarrier")
+#define glMaxShaderCompilerThreadsKHR(...) assert(0 && "glMaxShaderCompilerThreadsKHR")
 
 struct GLValidFunctions
 {
 	bool glEnablei;
 	bool glDisablei;
 	bool glProgramParameteri;
+	bool glMaxShaderCompilerThreadsKHR;
 };
 
 extern GLValidFunctions g_GLValidFunctions;
@@ -258,6 +260,7 @@ extern PFNGLBLENDCOLORPROC g_glBlendColor;
 #define glFlushMappedBufferRange(...) CHECKED_GL_FUNCTION(g_glFlushMappedBufferRange, __VA_ARGS__)
 #define glTextureBarrier(...) CHECKED_GL_FUNCTION(g_glTextureBarrier, __VA_ARGS__)
 #define glTextureBarrierNV(...) CHECKED_GL_FUNCTION(g_glTextureBarrierNV, __VA_ARGS__)
+#define glMaxShaderCompilerThreadsKHR(...) CHECKED_GL_FUNCTION(g_glMaxShaderCompilerThreadsKHR, __VA_ARGS__)
 #define glClearBufferfv(...) CHECKED_GL_FUNCTION(g_glClearBufferfv, __VA_ARGS__)
 #define glEnablei(...) CHECKED_GL_FUNCTION(g_glEnablei, __VA_ARGS__)
 #define glDisablei(...) CHECKED_GL_FUNCTION(g_glDisablei, __VA_ARGS__)
@@ -358,6 +361,7 @@ extern PFNGLDRAWRANGEELEMENTSBASEVERTEXPROC g_glDrawRangeElementsBaseVertex;
 extern PFNGLFLUSHMAPPEDBUFFERRANGEPROC g_glFlushMappedBufferRange;
 extern PFNGLTEXTUREBARRIERPROC g_glTextureBarrier;
 extern PFNGLTEXTUREBARRIERNVPROC g_glTextureBarrierNV;
+extern PFNGLMAXSHADERCOMPILERTHREADSARBPROC g_glMaxShaderCompilerThreadsKHR;
 extern PFNGLCLEARBUFFERFVPROC g_glClearBufferfv;
 extern PFNGLENABLEIPROC g_glEnablei;
 extern PFNGLDISABLEIPROC g_glDisablei;
@@ -2741,9 +2741,19 @@ graphics::CombinerProgram * CombinerProgramBuilder::buildCombinerProgram(Combine
 			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	}
 	glLinkProgram(program);
-	assert(Utils::checkProgramLinkStatus(program));
 	glDeleteShader(fragmentShader);
 
+	if (m_deferUniforms) {
+		// Do not wait for the link here, so that the driver can compile several programs at once.
+		CombinerProgramUniformFactory uniformFactory(*m_uniformFactory);
+		return new CombinerProgramImpl(_key, program, m_useProgram, combinerInputs,
+			[uniformFactory, combinerInputs, _key](GLuint _program, UniformGroups & _uniforms) mutable {
+				assert(Utils::checkProgramLinkStatus(_program));
+				uniformFactory.buildUniforms(_program, combinerInputs, _key, _uniforms);
+			});
+	}
+
+	assert(Utils::checkProgramLinkStatus(program));
 	UniformGroups uniforms;
 	m_uniformFactory->buildUniforms(program, combinerInputs, _key, uniforms);
 
@@ -2833,6 +2843,7 @@ CombinerProgramBuilder::CombinerProgramBuilder(const opengl::GLInfo & _glinfo, o
 , m_shaderN64DepthRender(new ShaderN64DepthRender(_glinfo))
 , m_useProgram(_useProgram)
 , m_combinerOptionsBits(graphics::CombinerProgram::getShaderCombinerOptionsBits())
+, m_deferUniforms(_glinfo.parallelShaderCompile)
 {
 	m_vertexShaderRect = _createVertexShader(m_vertexHeader.get(), m_vertexRect.get(), m_vertexEnd.get());
 	m_vertexShaderTriangle = _createVertexShader(m_vertexHeader.get(), m_vertexTriangle.get(), m_vertexEnd.get());
@@ -96,6 +96,7 @@ namespace glsl {
 		GLuint  m_vertexShaderTexturedTriangle;
 		opengl::CachedUseProgram * m_useProgram;
 		u32 m_combinerOptionsBits;
+		bool m_deferUniforms;
 	};
 
 }
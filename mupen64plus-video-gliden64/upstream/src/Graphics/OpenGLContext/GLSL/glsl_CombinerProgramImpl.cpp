@@ -27,6 +27,20 @@ CombinerProgramImpl::CombinerProgramImpl(const CombinerKey & _key,
 {
 }
 
+CombinerProgramImpl::CombinerProgramImpl(const CombinerKey & _key,
+	GLuint _program,
+	opengl::CachedUseProgram * _useProgram,
+	const CombinerInputs & _inputs,
+	UniformsBuilder _uniformsBuilder)
+: m_bNeedUpdate(true)
+, m_key(_key)
+, m_program(_program)
+, m_useProgram(_useProgram)
+, m_inputs(_inputs)
+, m_uniformsBuilder(std::move(_uniformsBuilder))
+{
+}
+
 
 CombinerProgramImpl::~CombinerProgramImpl()
 {
@@ -41,6 +55,10 @@ void CombinerProgramImpl::activate()
 
 void CombinerProgramImpl::update(bool _force)
 {
+	if (m_uniformsBuilder) {
+		m_uniformsBuilder(GLuint(m_program), m_uniforms);
+		m_uniformsBuilder = nullptr;
+	}
 	_force |= m_bNeedUpdate;
 	m_bNeedUpdate = false;
 	m_useProgram->useProgram(m_program);
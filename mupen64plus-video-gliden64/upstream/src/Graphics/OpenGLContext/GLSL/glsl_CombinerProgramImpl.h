@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include <memory>
 #include <vector>
 #include <Graphics/CombinerProgram.h>
@@ -19,6 +20,10 @@ namespace glsl {
 
 	typedef std::vector< std::unique_ptr<UniformGroup> > UniformGroups;
 
+	// Builds uniforms of a program. Querying uniform locations waits for the program link to complete,
+	// so with parallel shader compilation it is postponed until the program is used for the first time.
+	typedef std::function<void(GLuint _program, UniformGroups & _uniforms)> UniformsBuilder;
+
 	class CombinerProgramImpl : public graphics::CombinerProgram
 	{
 	public:
@@ -28,6 +33,11 @@ namespace glsl {
 			const CombinerInputs & _inputs,
 			std::string _programCode,
 			UniformGroups && _uniforms);
+		CombinerProgramImpl(const CombinerKey & _key,
+			GLuint _program,
+			opengl::CachedUseProgram * _useProgram,
+			const CombinerInputs & _inputs,
+			UniformsBuilder _uniformsBuilder);
 		~CombinerProgramImpl();
 
 		void activate() override;
@@ -49,6 +59,7 @@ namespace glsl {
 		opengl::CachedUseProgram * m_useProgram;
 		CombinerInputs m_inputs;
 		UniformGroups m_uniforms;
+		UniformsBuilder m_uniformsBuilder;
 
 #if 0
 		std::string m_programCode;
@@ -13,6 +13,7 @@
 #include <PluginAPI.h>
 #include <Combiner.h>
 #include <DisplayLoadProgress.h>
+#include <Performance.h>
 #include <osal_files.h>
 #include "glsl_Utils.h"
 #include "glsl_ShaderStorage.h"
@@ -282,11 +283,13 @@ bool ShaderStorage::_loadFromCombinerKeys(graphics::Combiners & _combiners)
 	f32 progress = 0.0f;
 	f32 percents = percent;
 	u64 key;
+	std::vector<graphics::CombinerProgram*> loaded;
+	loaded.reserve(szCombiners);
 	for (u32 i = 0; i < szCombiners; ++i) {
 		fin >> std::hex >> key;
 		graphics::CombinerProgram * pCombiner = Combiner_Compile(CombinerKey(key, false));
-		pCombiner->update(true);
 		_combiners[pCombiner->getKey()] = pCombiner;
+		loaded.push_back(pCombiner);
 		progress += step;
 		if (progress > percents) {
 			displayLoadProgress(L"LOAD COMBINER SHADERS %.1f%%", f32(i + 1) * 100.f / f32(szCombiners));
@@ -294,6 +297,12 @@ bool ShaderStorage::_loadFromCombinerKeys(graphics::Combiners & _combiners)
 		}
 	}
 	fin.close();
+	perf.addCounter(Performance::pcShaderCompileCount, static_cast<u32>(loaded.size()));
+
+	// Update programs after all of them were submitted for compilation.
+	// With parallel shader compile the driver builds them concurrently meanwhile.
+	for (graphics::CombinerProgram * pCombiner : loaded)
+		pCombiner->update(true);
 
 	if (opengl::Utils::isGLError())
 		return false;
@@ -47,6 +47,10 @@ void ContextImpl::init()
 	if (!m_cachedFunctions)
 		m_cachedFunctions.reset(new CachedFunctions(m_glInfo));
 
+	if (m_glInfo.parallelShaderCompile)
+		// Let the driver compile and link shader programs on as many threads as it wants.
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFFU);
+
 	{
 		TextureManipulationObjectFactory textureObjectsFactory(m_glInfo, *m_cachedFunctions.get());
 		m_createTexture.reset(textureObjectsFactory.getCreate2DTexture());
@@ -173,6 +173,8 @@ void GLInfo::init() {
 
 	ext_fetch = Utils::isExtensionSupported(*this, "GL_EXT_shader_framebuffer_fetch") && !isGLES2 && (!isGLESX || ext_draw_buffers_indexed) && !imageTextures;
 	eglImage = (Utils::isEGLExtensionSupported("EGL_KHR_image_base") || Utils::isEGLExtensionSupported("EGL_KHR_image"));
+	parallelShaderCompile = Utils::isExtensionSupported(*this, "GL_KHR_parallel_shader_compile") &&
+		IS_GL_FUNCTION_VALID(glMaxShaderCompilerThreadsKHR);
 
 #ifdef OS_ANDROID
 	eglImage = eglImage &&
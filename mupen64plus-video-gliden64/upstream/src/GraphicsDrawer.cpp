@@ -29,12 +29,15 @@ using namespace graphics;
 GraphicsDrawer::GraphicsDrawer()
 : m_drawingState(DrawingState::Non)
 , m_dmaVerticesNum(0)
+, m_bBatchTriangles(false)
 , m_modifyVertices(0)
 , m_maxLineWidth(1.0f)
 , m_bFlatColors(false)
 , m_bBGMode(false)
 {
 	memset(m_rect, 0, sizeof(m_rect));
+	m_trianglesBatch.vertices.resize(BATCH_VERTBUFF_SIZE);
+	m_trianglesBatch.elements.resize(BATCH_ELEMBUFF_SIZE);
 }
 
 GraphicsDrawer::~GraphicsDrawer()
@@ -640,6 +643,8 @@ void GraphicsDrawer::_updateTextures() const
 
 void GraphicsDrawer::_updateStates(DrawingState _drawingState) const
 {
+	perf.addCounter(Performance::pcStateChanges, 1);
+
 	CombinerInfo & cmbInfo = CombinerInfo::get();
 	cmbInfo.setPolygonMode(_drawingState);
 	cmbInfo.update();
@@ -736,6 +741,56 @@ bool GraphicsDrawer::_canDraw() const
 	return config.frameBufferEmulation.enable == 0 || frameBufferList().getCurrent() != nullptr;
 }
 
+void GraphicsDrawer::_saveTrianglesBatchState()
+{
+	TrianglesBatchState & state = m_trianglesBatch.state;
+	state.otherMode = gDP.otherMode._u64;
+	state.mux = gDP.combine.mux;
+	state.primColor = gDP.primColor;
+	state.envColor = gDP.envColor;
+	state.fogColor = gDP.fogColor;
+	state.blendColor = gDP.blendColor;
+	state.primDepth = gDP.primDepth;
+	state.convert = gDP.convert;
+	state.key = gDP.key;
+	state.fog = gSP.fog;
+}
+
+#define STATE_EQUAL(field, value) (memcmp(&m_trianglesBatch.state.field, &value, sizeof(value)) == 0)
+
+bool GraphicsDrawer::_canMergeTriangles() const
+{
+	// Changed flags which _updateStates() clears once applied.
+	const u32 gSPStateChanges = CHANGED_VIEWPORT | CHANGED_TEXTURE | CHANGED_GEOMETRYMODE;
+	const u32 gDPStateChanges = CHANGED_RENDERMODE | CHANGED_CYCLETYPE | CHANGED_SCISSOR |
+		CHANGED_TMEM | CHANGED_TILE | CHANGED_COMBINE | CHANGED_FB_TEXTURE;
+
+	// Hardware lighting reads the lights at draw time, and they have no state to compare.
+	// Frame buffer and depth buffer switches and copies flush the batch themselves.
+	return m_trianglesBatch.elementsNum != 0 &&
+		m_drawingState == DrawingState::Triangle &&
+		(gSP.changed & gSPStateChanges) == 0 &&
+		(gDP.changed & gDPStateChanges) == 0 &&
+		m_modifyVertices == m_trianglesBatch.modifyVertices &&
+		m_trianglesBatch.vertices[0].HWLight == 0 &&
+		triangles.vertices[triangles.elements[0]].HWLight == 0 &&
+		m_texrectDrawer.isEmpty() &&
+		STATE_EQUAL(otherMode, gDP.otherMode._u64) &&
+		STATE_EQUAL(mux, gDP.combine.mux) &&
+		STATE_EQUAL(primColor, gDP.primColor) &&
+		STATE_EQUAL(envColor, gDP.envColor) &&
+		STATE_EQUAL(fogColor, gDP.fogColor) &&
+		STATE_EQUAL(blendColor, gDP.blendColor) &&
+		STATE_EQUAL(primDepth, gDP.primDepth) &&
+		STATE_EQUAL(convert, gDP.convert) &&
+		STATE_EQUAL(key, gDP.key) &&
+		STATE_EQUAL(fog, gSP.fog) &&
+		m_trianglesBatch.verticesNum + triangles.maxElement + 1 <= m_trianglesBatch.vertices.size() &&
+		m_trianglesBatch.elementsNum + triangles.num <= m_trianglesBatch.elements.size();
+}
+
+#undef STATE_EQUAL
+
 void GraphicsDrawer::drawTriangles()
 {
 	if (triangles.num == 0 || !_canDraw()) {
@@ -744,19 +799,22 @@ void GraphicsDrawer::drawTriangles()
 		return;
 	}
 
-	_prepareDrawTriangle();
+	if (!_canMergeTriangles()) {
+		flushTriangles();
+		m_trianglesBatch.modifyVertices = m_modifyVertices;
+		_prepareDrawTriangle();
+		_saveTrianglesBatchState();
+	} else
+		m_modifyVertices = 0;
 
-	Context::DrawTriangleParameters triParams;
-	triParams.mode = drawmode::TRIANGLES;
-	triParams.flatColors = m_bFlatColors;
-	triParams.elementsType = datatype::UNSIGNED_BYTE;
-	triParams.verticesCount = static_cast<u32>(triangles.maxElement) + 1;
-	triParams.elementsCount = triangles.num;
-	triParams.vertices = triangles.vertices.data();
-	triParams.elements = triangles.elements.data();
-	triParams.combiner = currentCombiner();
-	gfxContext.drawTriangles(triParams);
-	g_debugger.addTriangles(triParams);
+	const u32 verticesCount = static_cast<u32>(triangles.maxElement) + 1;
+	const u32 firstVertex = m_trianglesBatch.verticesNum;
+	std::copy_n(triangles.vertices.begin(), verticesCount, m_trianglesBatch.vertices.begin() + firstVertex);
+	u16 * pElements = m_trianglesBatch.elements.data() + m_trianglesBatch.elementsNum;
+	for (u32 i = 0; i < triangles.num; ++i)
+		pElements[i] = static_cast<u16>(triangles.elements[i] + firstVertex);
+	m_trianglesBatch.verticesNum += verticesCount;
+	m_trianglesBatch.elementsNum += triangles.num;
 
 	if (config.frameBufferEmulation.enable != 0) {
 		const f32 maxY = renderTriangles(triangles.vertices.data(), triangles.elements.data(), triangles.num);
@@ -771,10 +829,41 @@ void GraphicsDrawer::drawTriangles()
 
 	triangles.num = 0;
 	triangles.maxElement = 0;
+
+	if (!m_bBatchTriangles)
+		flushTriangles();
+}
+
+void GraphicsDrawer::flushTriangles()
+{
+	if (m_trianglesBatch.elementsNum == 0)
+		return;
+
+	Context::DrawTriangleParameters triParams;
+	triParams.mode = drawmode::TRIANGLES;
+	triParams.flatColors = m_bFlatColors;
+	triParams.elementsType = datatype::UNSIGNED_SHORT;
+	triParams.verticesCount = m_trianglesBatch.verticesNum;
+	triParams.elementsCount = m_trianglesBatch.elementsNum;
+	triParams.vertices = m_trianglesBatch.vertices.data();
+	triParams.elements = m_trianglesBatch.elements.data();
+	triParams.combiner = currentCombiner();
+	gfxContext.drawTriangles(triParams);
+	g_debugger.addTriangles(triParams);
+	m_trianglesBatch.verticesNum = 0;
+	m_trianglesBatch.elementsNum = 0;
+}
+
+void GraphicsDrawer::setTrianglesBatching(bool _enable)
+{
+	if (!_enable)
+		flushTriangles();
+	m_bBatchTriangles = _enable;
 }
 
 void GraphicsDrawer::drawScreenSpaceTriangle(u32 _numVtx, graphics::DrawModeParam _mode)
 {
+	flushTriangles();
 	if (_numVtx == 0 || !_canDraw())
 		return;
 
@@ -806,6 +895,7 @@ void GraphicsDrawer::drawScreenSpaceTriangle(u32 _numVtx, graphics::DrawModePara
 
 void GraphicsDrawer::drawDMATriangles(u32 _numVtx)
 {
+	flushTriangles();
 	if (_numVtx == 0 || !_canDraw())
 		return;
 	_prepareDrawTriangle();
@@ -913,6 +1003,7 @@ void GraphicsDrawer::_drawThickLine(int _v0, int _v1, float _width)
 
 void GraphicsDrawer::drawLine(int _v0, int _v1, float _width)
 {
+	flushTriangles();
 	m_texrectDrawer.draw();
 
 	if (!_canDraw())
@@ -944,6 +1035,7 @@ void GraphicsDrawer::drawLine(int _v0, int _v1, float _width)
 
 void GraphicsDrawer::drawRect(int _ulx, int _uly, int _lrx, int _lry)
 {
+	flushTriangles();
 	m_texrectDrawer.draw();
 
 	if (!_canDraw())
@@ -1143,6 +1235,7 @@ bool(*texturedRectSpecial)(const GraphicsDrawer::TexturedRectParams & _params) =
 
 void GraphicsDrawer::drawTexturedRect(const TexturedRectParams & _params)
 {
+	flushTriangles();
 	gSP.changed &= ~CHANGED_GEOMETRYMODE; // Don't update cull mode
 	m_drawingState = DrawingState::TexRect;
 
@@ -1538,6 +1631,7 @@ void GraphicsDrawer::_removeOSDMessage(OSDMessages::iterator _iter, Milliseconds
 
 void GraphicsDrawer::clearDepthBuffer()
 {
+	flushTriangles();
 	if (!_canDraw())
 		return;
 
@@ -1548,6 +1642,7 @@ void GraphicsDrawer::clearDepthBuffer()
 
 void GraphicsDrawer::clearColorBuffer(float *_pColor)
 {
+	flushTriangles();
 	if (_pColor != nullptr)
 		gfxContext.clearColorBuffer(_pColor[0], _pColor[1], _pColor[2], _pColor[3]);
 	else
@@ -1589,6 +1684,7 @@ bool GraphicsDrawer::isRejected(s32 _v0, s32 _v1, s32 _v2) const
 
 void GraphicsDrawer::copyTexturedRect(const CopyRectParams & _params)
 {
+	flushTriangles();
 	m_drawingState = DrawingState::TexRect;
 
 	const float scaleX = 1.0f / _params.dstWidth;
@@ -1770,6 +1866,8 @@ void GraphicsDrawer::_setSpecialTexrect() const
 
 void GraphicsDrawer::_initData()
 {
+	// Reset counters first, so that shaders loaded from the storage are counted.
+	perf.reset();
 	_initStates();
 	_setSpecialTexrect();
 
@@ -1783,7 +1881,6 @@ void GraphicsDrawer::_initData()
 	g_zlutTexture.init();
 	g_noiseTexture.init();
 	g_paletteTexture.init();
-	perf.reset();
 	FBInfo::fbInfo.reset();
 	m_texrectDrawer.init();
 	m_drawingState = DrawingState::Non;
@@ -1797,10 +1894,15 @@ void GraphicsDrawer::_initData()
 		vtx.w = 1.0f;
 	triangles.num = 0;
 	m_dmaVerticesNum = 0;
+	m_trianglesBatch.verticesNum = 0;
+	m_trianglesBatch.elementsNum = 0;
+	m_bBatchTriangles = false;
 }
 
 void GraphicsDrawer::_destroyData()
 {
+	// Counters are reset by _initData()
+	perf.logCounters();
 	m_drawingState = DrawingState::Non;
 	m_texrectDrawer.destroy();
 	g_paletteTexture.destroy();
@@ -19,6 +19,8 @@ struct FrameBuffer;
 
 #define VERTBUFF_SIZE 256U
 #define ELEMBUFF_SIZE 1024U
+#define BATCH_VERTBUFF_SIZE 4096U
+#define BATCH_ELEMBUFF_SIZE 16384U
 
 enum class DrawingState
 {
@@ -44,6 +46,13 @@ public:
 
 	void drawTriangles();
 
+	// Draw triangles kept back by drawTriangles() while batching is enabled.
+	void flushTriangles();
+
+	// While enabled, consecutive drawTriangles() calls with unchanged render state
+	// are merged into one draw call. Disabling batching flushes pending triangles.
+	void setTrianglesBatching(bool _enable);
+
 	void drawScreenSpaceTriangle(u32 _numVtx, graphics::DrawModeParam _mode = graphics::drawmode::TRIANGLE_STRIP);
 
 	void drawDMATriangles(u32 _numVtx);
@@ -151,7 +160,7 @@ public:
 
 	void dropRenderState() { m_drawingState = DrawingState::Non; }
 
-	void flush() { m_texrectDrawer.draw(); }
+	void flush() { flushTriangles(); m_texrectDrawer.draw(); }
 
 	bool isTexrectDrawerMode() const { return !m_texrectDrawer.isEmpty(); }
 
@@ -183,6 +192,8 @@ private:
 	void _updateStates(DrawingState _drawingState) const;
 	void _prepareDrawTriangle();
 	bool _canDraw() const;
+	bool _canMergeTriangles() const;
+	void _saveTrianglesBatchState();
 	void _drawThickLine(int _v0, int _v1, float _width);
 
 	void _drawOSD(const char *_pText, float _x, float & _y);
@@ -203,6 +214,30 @@ private:
 	std::vector<SPVertex> m_dmaVertices;
 	u32 m_dmaVerticesNum;
 
+	// Draw time state which either has no changed flag or keeps its flag set after it is applied.
+	struct TrianglesBatchState
+	{
+		u64 otherMode;
+		u64 mux;
+		gDPInfo::PrimColor primColor;
+		gDPInfo::Color envColor, fogColor, blendColor;
+		decltype(gDP.primDepth) primDepth;
+		decltype(gDP.convert) convert;
+		decltype(gDP.key) key;
+		decltype(gSP.fog) fog;
+	};
+
+	// Triangles already prepared for drawing but not yet sent to the GPU.
+	struct {
+		std::vector<SPVertex> vertices;
+		std::vector<u16> elements;
+		u32 verticesNum = 0;
+		u32 elementsNum = 0;
+		u32 modifyVertices = 0;
+		TrianglesBatchState state;
+	} m_trianglesBatch;
+	bool m_bBatchTriangles;
+
 	RectVertex m_rect[4];
 
 	u32 m_modifyVertices;
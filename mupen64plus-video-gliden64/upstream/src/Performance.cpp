@@ -1,5 +1,6 @@
 #include "VI.h"
 #include "Config.h"
+#include "Log.h"
 #include "Performance.h"
 
 Performance perf;
@@ -9,7 +10,12 @@ Performance::Performance()
 	, m_frames(0)
 	, m_fps(0)
 	, m_vis(0)
-	, m_enabled(false) {
+	, m_enabled(false)
+	, m_totalFrames(0) {
+	m_curCounters.fill(0);
+	m_lastCounters.fill(0);
+	m_maxCounters.fill(0);
+	m_totalCounters.fill(0);
 }
 
 void Performance::reset()
@@ -18,6 +24,11 @@ void Performance::reset()
 	m_frames = 0;
 	m_fps = 0;
 	m_vis = 0;
+	m_totalFrames = 0;
+	m_curCounters.fill(0);
+	m_lastCounters.fill(0);
+	m_maxCounters.fill(0);
+	m_totalCounters.fill(0);
 	m_enabled = (config.onScreenDisplay.fps | config.onScreenDisplay.vis | config.onScreenDisplay.percent) != 0;
 	if (m_enabled)
 		m_startTime = std::chrono::steady_clock::now();
@@ -58,7 +69,50 @@ void Performance::increaseVICount()
 
 void Performance::increaseFramesCount()
 {
+	for (u32 i = 0; i < pcCount; ++i) {
+		if (m_curCounters[i] > m_maxCounters[i])
+			m_maxCounters[i] = m_curCounters[i];
+	}
+	++m_totalFrames;
+	m_lastCounters = m_curCounters;
+	m_curCounters.fill(0);
 	if (!m_enabled)
 		return;
 	m_frames++;
 }
+
+void Performance::addCounter(Counter _counter, u32 _value)
+{
+	m_curCounters[_counter] += _value;
+	m_totalCounters[_counter] += _value;
+}
+
+u32 Performance::getCounter(Counter _counter) const
+{
+	return m_lastCounters[_counter];
+}
+
+u64 Performance::getTotalCounter(Counter _counter) const
+{
+	return m_totalCounters[_counter];
+}
+
+void Performance::logCounters() const
+{
+	if (m_totalFrames == 0)
+		return;
+
+	const f64 frames = f64(m_totalFrames);
+	LOG(LOG_MINIMAL, "[GLideN64]: %u frames, per frame average (worst): %.0f (%u) draw calls, %.0f (%u) vertices, %.0f (%u) state changes\n",
+		m_totalFrames,
+		getTotalCounter(pcDrawCalls) / frames, m_maxCounters[pcDrawCalls],
+		getTotalCounter(pcVertices) / frames, m_maxCounters[pcVertices],
+		getTotalCounter(pcStateChanges) / frames, m_maxCounters[pcStateChanges]);
+	LOG(LOG_MINIMAL, "[GLideN64]: color buffer copies: %llu bytes to RDRAM, %llu us stalled (worst frame %u us), %llu bytes from RDRAM\n",
+		(unsigned long long)getTotalCounter(pcFBCopyBytes),
+		(unsigned long long)getTotalCounter(pcFBCopyStallTime), m_maxCounters[pcFBCopyStallTime],
+		(unsigned long long)getTotalCounter(pcFBUploadBytes));
+	LOG(LOG_MINIMAL, "[GLideN64]: %llu shaders compiled, %llu us stalled (worst frame %u us)\n",
+		(unsigned long long)getTotalCounter(pcShaderCompileCount),
+		(unsigned long long)getTotalCounter(pcShaderCompileStallTime), m_maxCounters[pcShaderCompileStallTime]);
+}
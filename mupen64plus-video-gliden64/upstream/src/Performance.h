@@ -1,11 +1,26 @@
 #ifndef PERFORMANCE_H
 #define PERFORMANCE_H
+#include <array>
 #include <chrono>
 #include "Types.h"
 
 class Performance
 {
 public:
+	// Per-frame counters. Values are accumulated during the current frame
+	// and can be read back for the last completed frame or for the whole session.
+	enum Counter {
+		pcFBCopyBytes,				// bytes copied from color buffers to RDRAM
+		pcFBCopyStallTime,			// microseconds spent waiting for color buffer readback
+		pcFBUploadBytes,			// bytes uploaded from RDRAM to color buffers
+		pcShaderCompileCount,		// number of compiled combiner programs
+		pcShaderCompileStallTime,	// microseconds spent compiling combiner programs on first use
+		pcDrawCalls,				// number of triangle, rect and line draw calls
+		pcStateChanges,				// number of render state updates before drawing
+		pcVertices,					// number of vertices sent to draw calls
+		pcCount
+	};
+
 	Performance();
 	void reset();
 	f32 getFps() const;
@@ -13,6 +28,11 @@ public:
 	f32 getPercent() const;
 	void increaseVICount();
 	void increaseFramesCount();
+	void addCounter(Counter _counter, u32 _value);
+	u32 getCounter(Counter _counter) const;
+	u64 getTotalCounter(Counter _counter) const;
+	// Logs the counters accumulated since the last reset.
+	void logCounters() const;
 
 private:
 	u32 m_vi;
@@ -21,6 +41,11 @@ private:
 	f32 m_vis;
 	std::chrono::steady_clock::time_point m_startTime;
 	bool m_enabled;
+	u32 m_totalFrames;
+	std::array<u32, pcCount> m_curCounters;
+	std::array<u32, pcCount> m_lastCounters;
+	std::array<u32, pcCount> m_maxCounters;
+	std::array<u64, pcCount> m_totalCounters;
 };
 
 extern Performance perf;
@@ -29,6 +29,9 @@ RSPInfo		RSP;
 static
 void _ProcessDList()
 {
+	GraphicsDrawer & drawer = dwnd().getDrawer();
+	drawer.setTrianglesBatching(true);
+
 	while (!RSP.halt) {
 		if ((RSP.PC[RSP.PCi] + 8) > RDRAMSize) {
 #ifdef DEBUG_DUMP
@@ -59,6 +62,8 @@ void _ProcessDList()
 		GBI.cmd[RSP.cmd](RSP.w0, RSP.w1);
 		RSP_CheckDLCounter();
 	}
+
+	drawer.setTrianglesBatching(false);
 }
 
 static
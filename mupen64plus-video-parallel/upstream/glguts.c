@@ -58,6 +58,9 @@ static PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
 static PFNGLUNMAPBUFFERPROC glUnmapBuffer;
 static PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation;
 static PFNGLUNIFORM1IPROC glUniform1i;
+static PFNGLFENCESYNCPROC glFenceSync;
+static PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+static PFNGLDELETESYNCPROC glDeleteSync;
 #define SHADER_HEADER "#version 330 core\n"
 #else
 static PFNGLBUFFERSTORAGEPROC glBufferStorage;
@@ -83,6 +86,7 @@ static GLuint buffer;
 static GLuint texture[2];
 static uint8_t *buffer_data;
 static uint32_t buffer_size = (640*8) * (480*8) * sizeof(uint32_t);
+static GLsync buffer_fence[2];
 
 int32_t tex_width[2];
 int32_t tex_height[2];
@@ -185,8 +189,10 @@ static GLuint gl_shader_link(GLuint vert, GLuint frag)
 void screen_write(struct frame_buffer *fb)
 {
     bool buffer_size_changed = tex_width[toggle_buffer] != fb->width || tex_height[toggle_buffer] != fb->height;
+    // upload from the half of the unpack buffer the pixels were written to
+    int index = fb->pixels ? ((uint8_t*)fb->pixels - buffer_data) / buffer_size : toggle_buffer;
     char* offset = NULL;
-    offset += toggle_buffer * buffer_size;
+    offset += index * buffer_size;
 
     glBindTexture(GL_TEXTURE_2D, texture[toggle_buffer]);
     // check if the framebuffer size has changed
@@ -207,6 +213,11 @@ void screen_write(struct frame_buffer *fb)
                         TEX_FORMAT, TEX_TYPE, offset);
     }
 
+    // the half must not be overwritten until the upload has been consumed
+    if (buffer_fence[index])
+        glDeleteSync(buffer_fence[index]);
+    buffer_fence[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
     toggle_buffer = !toggle_buffer;
 }
 
@@ -262,6 +273,12 @@ void gl_screen_clear(void)
 
 void gl_screen_close(void)
 {
+    for (int i = 0; i < 2; i++)
+    {
+        if (buffer_fence[i])
+            glDeleteSync(buffer_fence[i]);
+        buffer_fence[i] = NULL;
+    }
     glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
     glDeleteTextures(2, &texture[0]);
     glDeleteVertexArrays(1, &vao);
@@ -269,9 +286,24 @@ void gl_screen_close(void)
     glDeleteProgram(program);
 }
 
-uint8_t* screen_get_texture_data()
+uint8_t* screen_get_buffer_data(int index)
+{
+    return buffer_data + (index * buffer_size);
+}
+
+uint32_t screen_get_buffer_size()
 {
-    return buffer_data + (toggle_buffer * buffer_size);
+    return buffer_size;
+}
+
+void screen_wait_buffer(int index)
+{
+    if (!buffer_fence[index])
+        return;
+
+    glClientWaitSync(buffer_fence[index], GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+    glDeleteSync(buffer_fence[index]);
+    buffer_fence[index] = NULL;
 }
 
 void screen_init()
@@ -330,6 +362,9 @@ void screen_init()
     glUnmapBuffer = (PFNGLUNMAPBUFFERPROC) CoreVideo_GL_GetProcAddress("glUnmapBuffer");
     glGetUniformLocation = (PFNGLGETUNIFORMLOCATIONPROC) CoreVideo_GL_GetProcAddress("glGetUniformLocation");
     glUniform1i = (PFNGLUNIFORM1IPROC) CoreVideo_GL_GetProcAddress("glUniform1i");
+    glFenceSync = (PFNGLFENCESYNCPROC) CoreVideo_GL_GetProcAddress("glFenceSync");
+    glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC) CoreVideo_GL_GetProcAddress("glClientWaitSync");
+    glDeleteSync = (PFNGLDELETESYNCPROC) CoreVideo_GL_GetProcAddress("glDeleteSync");
 #else
     glBufferStorage = (PFNGLBUFFERSTORAGEPROC) eglGetProcAddress("glBufferStorageEXT");
 #endif
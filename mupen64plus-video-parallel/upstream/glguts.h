@@ -33,7 +33,9 @@ extern "C"
     void screen_toggle_fullscreen(void);
     void screen_close(void);
     void screen_swap(bool blank);
-    uint8_t* screen_get_texture_data();
+    uint8_t* screen_get_buffer_data(int index);
+    uint32_t screen_get_buffer_size();
+    void screen_wait_buffer(int index);
 
     extern int32_t window_width;
     extern int32_t window_height;
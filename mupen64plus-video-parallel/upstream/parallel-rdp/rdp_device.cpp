@@ -69,6 +69,8 @@ CommandProcessor::CommandProcessor(Vulkan::Device &device_, void *rdram_ptr,
 		{
 			LOGI("Dumping RDP commands to: %s.\n", env);
 			flags |= COMMAND_PROCESSOR_FLAG_HOST_VISIBLE_HIDDEN_RDRAM_BIT;
+			if (const char *frames = getenv("PARALLEL_RDP_DUMP_FRAMES"))
+				dump_frames_remaining = strtoul(frames, nullptr, 0);
 		}
 	}
 
@@ -1085,6 +1087,12 @@ Vulkan::ImageHandle CommandProcessor::scanout(const ScanoutOptions &opts, VkImag
 		dump_writer->flush_dram(begin_read_rdram(), rdram_size);
 		dump_writer->flush_hidden_dram(begin_read_hidden_rdram(), hidden_rdram->get_create_info().size);
 		dump_writer->end_frame();
+
+		if (dump_frames_remaining && --dump_frames_remaining == 0)
+		{
+			LOGI("RDP dump complete.\n");
+			dump_writer.reset();
+		}
 	}
 
 	// Block idle callbacks triggering while we're doing this.
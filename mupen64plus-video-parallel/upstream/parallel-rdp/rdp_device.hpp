@@ -282,5 +282,6 @@ private:
 
 	std::unique_ptr<RDPDumpWriter> dump_writer;
 	bool dump_in_command_list = false;
+	unsigned dump_frames_remaining = 0;
 };
 }
@@ -0,0 +1,47 @@
+/* Copyright (c) 2021 Themaister
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace RDP
+{
+// A dump starts with the magic, then the RDRAM and hidden RDRAM sizes as 32-bit words.
+static const char RDP_DUMP_MAGIC[8] = { 'R', 'D', 'P', 'D', 'U', 'M', 'P', '2' };
+
+// Record types of an RDP dump, as written by RDPDumpWriter.
+enum RDPDumpCmd : uint32_t
+{
+	RDP_DUMP_CMD_INVALID = 0,
+	RDP_DUMP_CMD_UPDATE_DRAM = 1,
+	RDP_DUMP_CMD_RDP_COMMAND = 2,
+	RDP_DUMP_CMD_SET_VI_REGISTER = 3,
+	RDP_DUMP_CMD_END_FRAME = 4,
+	RDP_DUMP_CMD_SIGNAL_COMPLETE = 5,
+	RDP_DUMP_CMD_EOF = 6,
+	RDP_DUMP_CMD_UPDATE_DRAM_FLUSH = 7,
+	RDP_DUMP_CMD_UPDATE_HIDDEN_DRAM = 8,
+	RDP_DUMP_CMD_UPDATE_HIDDEN_DRAM_FLUSH = 9,
+	RDP_DUMP_CMD_INT_MAX = 0x7fffffff
+};
+}
@@ -48,7 +48,7 @@ bool RDPDumpWriter::init(const char *path, uint32_t dram_size, uint32_t hidden_d
 	if (!file)
 		return false;
 
-	fwrite("RDPDUMP2", 8, 1, file);
+	fwrite(RDP_DUMP_MAGIC, sizeof(RDP_DUMP_MAGIC), 1, file);
 	fwrite(&dram_size, sizeof(dram_size), 1, file);
 	fwrite(&hidden_dram_size, sizeof(hidden_dram_size), 1, file);
 	return true;
@@ -25,6 +25,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <vector>
+#include "rdp_dump_common.hpp"
 
 namespace RDP
 {
@@ -41,21 +42,6 @@ public:
 	void end_frame();
 
 private:
-	enum RDPDumpCmd : uint32_t
-	{
-		RDP_DUMP_CMD_INVALID = 0,
-		RDP_DUMP_CMD_UPDATE_DRAM = 1,
-		RDP_DUMP_CMD_RDP_COMMAND = 2,
-		RDP_DUMP_CMD_SET_VI_REGISTER = 3,
-		RDP_DUMP_CMD_END_FRAME = 4,
-		RDP_DUMP_CMD_SIGNAL_COMPLETE = 5,
-		RDP_DUMP_CMD_EOF = 6,
-		RDP_DUMP_CMD_UPDATE_DRAM_FLUSH = 7,
-		RDP_DUMP_CMD_UPDATE_HIDDEN_DRAM = 8,
-		RDP_DUMP_CMD_UPDATE_HIDDEN_DRAM_FLUSH = 9,
-		RDP_DUMP_CMD_INT_MAX = 0x7fffffff
-	};
-
 	FILE *file = nullptr;
 	std::vector<uint8_t> rdp_dram_cache;
 	std::vector<uint8_t> rdp_hidden_dram_cache;
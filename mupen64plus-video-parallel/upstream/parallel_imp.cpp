@@ -1,6 +1,8 @@
 #include "parallel_imp.h"
+#include <chrono>
 #include <memory>
 #include <vector>
+#include <stdio.h>
 #include "rdp_device.hpp"
 #include "context.hpp"
 #include "device.hpp"
@@ -16,6 +18,33 @@ static unique_ptr<RDP::CommandProcessor> frontend;
 static unique_ptr<Device> device;
 static unique_ptr<Context> context;
 
+// Scanouts are double buffered to match the two halves of the presenter's
+// pixel unpack buffer. When possible, those halves are imported into Vulkan
+// so that the scanout is copied straight into the memory GL uploads from.
+// Without synchronous RDP, a frame is presented on the following VI update,
+// by which time its copy has normally completed.
+#define SCANOUT_BUFFERS 2
+
+struct ScanoutFrame
+{
+	RDP::VIScanoutBuffer scanout;
+	BufferHandle imported;
+	bool pending;
+};
+
+struct ScanoutStats
+{
+	uint64_t frames;
+	uint64_t zero_copy_frames;
+	uint64_t wait_ns;
+	uint64_t copy_ns;
+	uint64_t upload_ns;
+};
+
+static ScanoutFrame scanout_frames[SCANOUT_BUFFERS];
+static unsigned scanout_index;
+static ScanoutStats scanout_stats;
+
 int32_t vk_rescaling;
 bool vk_ssreadbacks;
 bool vk_ssdither;
@@ -36,7 +65,43 @@ static const unsigned cmd_len_lut[64] = {
 	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  1,  1,  1,  1,  1,
 };
 
-void vk_blit(unsigned &width, unsigned &height)
+static uint64_t elapsed_ns(chrono::steady_clock::time_point start)
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+static void vk_import_scanout_buffers()
+{
+	for (unsigned i = 0; i < SCANOUT_BUFFERS; i++)
+	{
+		BufferCreateInfo info = {};
+		info.size = screen_get_buffer_size();
+		info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		info.domain = BufferDomain::Host;
+
+		scanout_frames[i] = {};
+		scanout_frames[i].imported = device->create_imported_host_buffer(info,
+			VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_MAPPED_FOREIGN_MEMORY_BIT_EXT, screen_get_buffer_data(i));
+		scanout_frames[i].scanout.buffer = scanout_frames[i].imported;
+	}
+}
+
+static void vk_log_scanout_stats()
+{
+	if (!debug_callback || !scanout_stats.frames)
+		return;
+
+	char msg[256];
+	snprintf(msg, sizeof(msg),
+			 "Scanout: %llu frames (%llu zero-copy), average wait %.1f us, copy %.1f us, upload %.1f us",
+			 (unsigned long long)scanout_stats.frames, (unsigned long long)scanout_stats.zero_copy_frames,
+			 scanout_stats.wait_ns * 1e-3 / scanout_stats.frames,
+			 scanout_stats.copy_ns * 1e-3 / scanout_stats.frames,
+			 scanout_stats.upload_ns * 1e-3 / scanout_stats.frames);
+	debug_callback(debug_call_context, M64MSG_VERBOSE, msg);
+}
+
+void vk_blit(unsigned &width, unsigned &height, unsigned &index)
 {
 	if (running)
 	{
@@ -53,24 +118,49 @@ void vk_blit(unsigned &width, unsigned &height)
 		opts.downscale_steps = vk_downscaling_steps;
 		opts.crop_overscan_pixels = vk_overscan;
 
-		RDP::VIScanoutBuffer scanout;
-		frontend->scanout_async_buffer(scanout, opts);
+		ScanoutFrame &frame = scanout_frames[scanout_index];
+
+		// GL may still be uploading the previous frame from this half
+		auto start = chrono::steady_clock::now();
+		if (frame.imported)
+			screen_wait_buffer(scanout_index);
+		scanout_stats.wait_ns += elapsed_ns(start);
+
+		frontend->scanout_async_buffer(frame.scanout, opts);
+		frame.pending = frame.scanout.width && frame.scanout.height &&
+						frame.scanout.width * frame.scanout.height * sizeof(uint32_t) <= screen_get_buffer_size();
 
-		if (!scanout.width || !scanout.height)
+		index = scanout_index;
+		if (!vk_synchronous)
+			index = (index + SCANOUT_BUFFERS - 1) % SCANOUT_BUFFERS;
+		scanout_index = (scanout_index + 1) % SCANOUT_BUFFERS;
+
+		ScanoutFrame &present = scanout_frames[index];
+		if (!present.pending)
 		{
 			width = 0;
 			height = 0;
 			return;
 		}
+		present.pending = false;
+
+		width = present.scanout.width;
+		height = present.scanout.height;
 
-		width = scanout.width;
-		height = scanout.height;
+		start = chrono::steady_clock::now();
+		present.scanout.fence->wait();
+		if (present.scanout.buffer != present.imported)
+			screen_wait_buffer(index);
+		scanout_stats.wait_ns += elapsed_ns(start);
 
-		scanout.fence->wait();
-		uint8_t* color_data = screen_get_texture_data();
-		memcpy(color_data, device->map_host_buffer(*scanout.buffer, Vulkan::MEMORY_ACCESS_READ_BIT),
-			   width * height * sizeof(uint32_t));
-		device->unmap_host_buffer(*scanout.buffer, Vulkan::MEMORY_ACCESS_READ_BIT);
+		start = chrono::steady_clock::now();
+		const void *color_data = device->map_host_buffer(*present.scanout.buffer, Vulkan::MEMORY_ACCESS_READ_BIT);
+		if (present.scanout.buffer != present.imported)
+			memcpy(screen_get_buffer_data(index), color_data, width * height * sizeof(uint32_t));
+		else
+			scanout_stats.zero_copy_frames++;
+		device->unmap_host_buffer(*present.scanout.buffer, Vulkan::MEMORY_ACCESS_READ_BIT);
+		scanout_stats.copy_ns += elapsed_ns(start);
 	}
 }
 
@@ -103,7 +193,8 @@ void vk_rasterize()
 
 		unsigned width = 0;
 		unsigned height = 0;
-		vk_blit(width, height);
+		unsigned index = 0;
+		vk_blit(width, height, index);
 
 		if (width == 0 || height == 0)
 		{
@@ -112,11 +203,17 @@ void vk_rasterize()
 		}
 
 		struct frame_buffer buf = {0};
+		buf.pixels = reinterpret_cast<struct video_pixel *>(screen_get_buffer_data(index));
 		buf.valid = true;
 		buf.height = height;
 		buf.width = width;
 		buf.pitch = width;
+
+		auto start = chrono::steady_clock::now();
 		screen_write(&buf);
+		scanout_stats.upload_ns += elapsed_ns(start);
+		scanout_stats.frames++;
+
 		screen_swap(false);
 	}
 }
@@ -204,7 +301,10 @@ void vk_process_commands()
 void vk_destroy()
 {
 	running = false;
+	vk_log_scanout_stats();
 	frontend.reset();
+	for (auto &frame : scanout_frames)
+		frame = {};
 	device.reset();
 	context.reset();
 
@@ -279,6 +379,10 @@ bool vk_init()
 	quirks.set_native_resolution_tex_rect(vk_native_tex_rect);
 	frontend->set_quirks(quirks);
 
+	vk_import_scanout_buffers();
+	scanout_index = 0;
+	scanout_stats = {};
+
 	running = true;
 	return true;
 }
@@ -0,0 +1,438 @@
+// Headless replayer for RDP dumps written by RDPDumpWriter
+// (set PARALLEL_RDP_DUMP_PATH, and optionally PARALLEL_RDP_DUMP_FRAMES, while running the plugin).
+//
+// Every frame in the dump is played back through RDP::CommandProcessor without a window.
+// Per frame it reports the number of RDP commands and RDRAM updates, the CPU time spent
+// submitting them, the time spent waiting for the GPU to finish them, and the scanout time.
+// A checksum of each scanout can be written out and later verified against, which catches
+// rendering regressions without running a game.
+//
+// Any Vulkan 1.1 implementation can be used, including software ones such as lavapipe:
+// select it with VK_ICD_FILENAMES or GRANITE_VULKAN_DEVICE_INDEX.
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rdp_device.hpp"
+#include "rdp_dump_common.hpp"
+#include "context.hpp"
+#include "device.hpp"
+#include "hash.hpp"
+
+using namespace Vulkan;
+using namespace std;
+
+struct FrameStats
+{
+	unsigned commands;
+	unsigned syncs;
+	unsigned dram_blocks;
+	double submit_ms;
+	double wait_ms;
+	double scanout_ms;
+	unsigned width;
+	unsigned height;
+	uint64_t checksum;
+};
+
+struct ReplayOptions
+{
+	const char *dump_path = nullptr;
+	const char *write_checksums = nullptr;
+	const char *verify_checksums = nullptr;
+	unsigned max_frames = 0;
+	unsigned upscale = 1;
+	bool quiet = false;
+};
+
+static double elapsed_ms(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+static bool read_u32(FILE *file, uint32_t &value)
+{
+	return fread(&value, sizeof(value), 1, file) == 1;
+}
+
+class Replayer
+{
+public:
+	bool init(FILE *file, const ReplayOptions &opts);
+	// Returns false at the end of the dump or on error.
+	bool replay_frame(FrameStats &stats);
+	bool failed() const
+	{
+		return error;
+	}
+
+private:
+	FILE *file = nullptr;
+	Context context;
+	unique_ptr<Device> device;
+	unique_ptr<RDP::CommandProcessor> processor;
+
+	uint32_t dram_size = 0;
+	uint32_t hidden_dram_size = 0;
+	uint8_t *dram = nullptr;
+	uint8_t *hidden_dram = nullptr;
+	vector<uint32_t> words;
+	vector<RDP::RGBA> colors;
+	bool error = false;
+
+	bool update_dram(bool hidden, FrameStats &stats);
+	void sync_dram();
+};
+
+bool Replayer::init(FILE *file_, const ReplayOptions &opts)
+{
+	file = file_;
+
+	char magic[8];
+	if (fread(magic, sizeof(magic), 1, file) != 1 || memcmp(magic, RDP::RDP_DUMP_MAGIC, sizeof(magic)) != 0)
+	{
+		fprintf(stderr, "Not an RDP dump.\n");
+		return false;
+	}
+
+	if (!read_u32(file, dram_size) || !read_u32(file, hidden_dram_size))
+		return false;
+
+	if (!Context::init_loader(nullptr))
+		return false;
+	if (!context.init_instance_and_device(nullptr, 0, nullptr, 0, CONTEXT_CREATION_DISABLE_BINDLESS_BIT))
+		return false;
+
+	device.reset(new Device);
+	device->set_context(context);
+	device->init_frame_contexts(3);
+	fprintf(stderr, "Replaying on: %s\n", device->get_gpu_properties().deviceName);
+
+	RDP::CommandProcessorFlags flags = RDP::COMMAND_PROCESSOR_FLAG_HOST_VISIBLE_HIDDEN_RDRAM_BIT;
+	switch (opts.upscale)
+	{
+	case 2:
+		flags |= RDP::COMMAND_PROCESSOR_FLAG_UPSCALING_2X_BIT;
+		break;
+	case 4:
+		flags |= RDP::COMMAND_PROCESSOR_FLAG_UPSCALING_4X_BIT;
+		break;
+	case 8:
+		flags |= RDP::COMMAND_PROCESSOR_FLAG_UPSCALING_8X_BIT;
+		break;
+	default:
+		break;
+	}
+
+	processor.reset(new RDP::CommandProcessor(*device, nullptr, 0, dram_size, hidden_dram_size, flags));
+	if (!processor->device_is_supported())
+	{
+		fprintf(stderr, "Vulkan device is not supported by paraLLEl-RDP.\n");
+		return false;
+	}
+
+	return true;
+}
+
+void Replayer::sync_dram()
+{
+	if (dram)
+		processor->end_write_rdram();
+	if (hidden_dram)
+		processor->end_write_hidden_rdram();
+	dram = nullptr;
+	hidden_dram = nullptr;
+}
+
+bool Replayer::update_dram(bool hidden, FrameStats &stats)
+{
+	uint32_t offset, size;
+	if (!read_u32(file, offset) || !read_u32(file, size))
+		return false;
+
+	uint8_t *&base = hidden ? hidden_dram : dram;
+	if (!base)
+	{
+		// RDRAM may only be touched once the GPU is done with prior commands.
+		if (!dram && !hidden_dram)
+			processor->idle();
+		base = static_cast<uint8_t *>(hidden ? processor->begin_read_hidden_rdram() : processor->begin_read_rdram());
+	}
+
+	if (uint64_t(offset) + size > (hidden ? hidden_dram_size : dram_size))
+		return false;
+	if (fread(base + offset, 1, size, file) != size)
+		return false;
+
+	stats.dram_blocks++;
+	return true;
+}
+
+bool Replayer::replay_frame(FrameStats &stats)
+{
+	stats = {};
+	processor->begin_frame_context();
+
+	auto start = chrono::steady_clock::now();
+	for (;;)
+	{
+		uint32_t cmd;
+		if (!read_u32(file, cmd))
+		{
+			fprintf(stderr, "Unexpected end of dump.\n");
+			error = true;
+			return false;
+		}
+
+		switch (cmd)
+		{
+		case RDP::RDP_DUMP_CMD_UPDATE_DRAM:
+		case RDP::RDP_DUMP_CMD_UPDATE_HIDDEN_DRAM:
+			if (!update_dram(cmd == RDP::RDP_DUMP_CMD_UPDATE_HIDDEN_DRAM, stats))
+			{
+				fprintf(stderr, "Invalid RDRAM update in dump.\n");
+				error = true;
+				return false;
+			}
+			break;
+
+		case RDP::RDP_DUMP_CMD_UPDATE_DRAM_FLUSH:
+		case RDP::RDP_DUMP_CMD_UPDATE_HIDDEN_DRAM_FLUSH:
+			sync_dram();
+			break;
+
+		case RDP::RDP_DUMP_CMD_RDP_COMMAND:
+		{
+			uint32_t command, num_words;
+			if (!read_u32(file, command) || !read_u32(file, num_words) || num_words == 0 || num_words > 64)
+			{
+				error = true;
+				return false;
+			}
+			words.resize(num_words);
+			if (fread(words.data(), sizeof(uint32_t), num_words, file) != num_words)
+			{
+				error = true;
+				return false;
+			}
+			processor->enqueue_command(num_words, words.data());
+			stats.commands++;
+			break;
+		}
+
+		case RDP::RDP_DUMP_CMD_SET_VI_REGISTER:
+		{
+			uint32_t reg, value;
+			if (!read_u32(file, reg) || !read_u32(file, value))
+			{
+				error = true;
+				return false;
+			}
+			processor->set_vi_register(RDP::VIRegister(reg), value);
+			break;
+		}
+
+		case RDP::RDP_DUMP_CMD_SIGNAL_COMPLETE:
+		{
+			const uint32_t sync_full[2] = { uint32_t(RDP::Op::SyncFull) << 24, 0 };
+			processor->enqueue_command(2, sync_full);
+			stats.syncs++;
+			break;
+		}
+
+		case RDP::RDP_DUMP_CMD_END_FRAME:
+		{
+			stats.submit_ms = elapsed_ms(start);
+
+			start = chrono::steady_clock::now();
+			processor->idle();
+			stats.wait_ms = elapsed_ms(start);
+
+			start = chrono::steady_clock::now();
+			processor->scanout_sync(colors, stats.width, stats.height);
+			stats.scanout_ms = elapsed_ms(start);
+
+			Util::Hasher h;
+			h.u32(stats.width);
+			h.u32(stats.height);
+			h.data(reinterpret_cast<const uint32_t *>(colors.data()), colors.size() * sizeof(RDP::RGBA));
+			stats.checksum = h.get();
+			return true;
+		}
+
+		case RDP::RDP_DUMP_CMD_EOF:
+			return false;
+
+		default:
+			fprintf(stderr, "Unknown dump command %u.\n", cmd);
+			error = true;
+			return false;
+		}
+	}
+}
+
+static void print_help()
+{
+	fprintf(stderr, "Usage: parallel-rdp-replay [options] <dump>\n"
+	                "  --frames <count>            Stop after this many frames.\n"
+	                "  --upscale <1|2|4|8>         Replay with upscaling.\n"
+	                "  --write-checksums <path>    Write one scanout checksum per frame.\n"
+	                "  --verify-checksums <path>   Compare scanouts against a checksum file.\n"
+	                "  --quiet                     Only print the summary.\n");
+}
+
+static bool parse_options(int argc, char **argv, ReplayOptions &opts)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const char *arg = argv[i];
+		bool has_value = i + 1 < argc;
+
+		if (strcmp(arg, "--frames") == 0 && has_value)
+			opts.max_frames = strtoul(argv[++i], nullptr, 0);
+		else if (strcmp(arg, "--upscale") == 0 && has_value)
+			opts.upscale = strtoul(argv[++i], nullptr, 0);
+		else if (strcmp(arg, "--write-checksums") == 0 && has_value)
+			opts.write_checksums = argv[++i];
+		else if (strcmp(arg, "--verify-checksums") == 0 && has_value)
+			opts.verify_checksums = argv[++i];
+		else if (strcmp(arg, "--quiet") == 0)
+			opts.quiet = true;
+		else if (arg[0] != '-' && !opts.dump_path)
+			opts.dump_path = arg;
+		else
+			return false;
+	}
+
+	return opts.dump_path != nullptr;
+}
+
+static vector<uint64_t> load_checksums(const char *path)
+{
+	vector<uint64_t> checksums;
+	FILE *file = fopen(path, "r");
+	if (!file)
+		return checksums;
+
+	unsigned frame;
+	unsigned long long checksum;
+	while (fscanf(file, "%u %llx", &frame, &checksum) == 2)
+		checksums.push_back(checksum);
+
+	fclose(file);
+	return checksums;
+}
+
+int main(int argc, char **argv)
+{
+	ReplayOptions opts;
+	if (!parse_options(argc, argv, opts))
+	{
+		print_help();
+		return EXIT_FAILURE;
+	}
+
+	FILE *file = fopen(opts.dump_path, "rb");
+	if (!file)
+	{
+		fprintf(stderr, "Failed to open %s.\n", opts.dump_path);
+		return EXIT_FAILURE;
+	}
+
+	vector<uint64_t> expected;
+	if (opts.verify_checksums)
+	{
+		expected = load_checksums(opts.verify_checksums);
+		if (expected.empty())
+		{
+			fprintf(stderr, "No checksums found in %s.\n", opts.verify_checksums);
+			fclose(file);
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE *checksum_file = nullptr;
+	if (opts.write_checksums && !(checksum_file = fopen(opts.write_checksums, "w")))
+	{
+		fprintf(stderr, "Failed to open %s.\n", opts.write_checksums);
+		fclose(file);
+		return EXIT_FAILURE;
+	}
+
+	int ret = EXIT_SUCCESS;
+	{
+		Replayer replayer;
+		if (!replayer.init(file, opts))
+		{
+			fprintf(stderr, "Failed to initialize replayer.\n");
+			ret = EXIT_FAILURE;
+		}
+		else
+		{
+			FrameStats stats, total = {};
+			unsigned frames = 0, mismatches = 0;
+
+			while ((!opts.max_frames || frames < opts.max_frames) && replayer.replay_frame(stats))
+			{
+				if (!opts.quiet)
+				{
+					printf("frame %5u: %6u cmds %4u syncs %5u dram blocks, submit %7.3f ms, "
+					       "wait %7.3f ms, scanout %7.3f ms, %ux%u %016llx\n",
+					       frames, stats.commands, stats.syncs, stats.dram_blocks,
+					       stats.submit_ms, stats.wait_ms, stats.scanout_ms,
+					       stats.width, stats.height, (unsigned long long)stats.checksum);
+				}
+
+				if (checksum_file)
+					fprintf(checksum_file, "%u %016llx\n", frames, (unsigned long long)stats.checksum);
+
+				if (frames < expected.size() && expected[frames] != stats.checksum)
+				{
+					fprintf(stderr, "Frame %u: checksum %016llx, expected %016llx.\n",
+					        frames, (unsigned long long)stats.checksum, (unsigned long long)expected[frames]);
+					mismatches++;
+				}
+
+				total.commands += stats.commands;
+				total.syncs += stats.syncs;
+				total.dram_blocks += stats.dram_blocks;
+				total.submit_ms += stats.submit_ms;
+				total.wait_ms += stats.wait_ms;
+				total.scanout_ms += stats.scanout_ms;
+				frames++;
+			}
+
+			if (frames)
+			{
+				printf("%u frames, %u cmds, %u syncs, %u dram blocks; per frame: submit %.3f ms, "
+				       "wait %.3f ms, scanout %.3f ms\n",
+				       frames, total.commands, total.syncs, total.dram_blocks,
+				       total.submit_ms / frames, total.wait_ms / frames, total.scanout_ms / frames);
+			}
+
+			if (replayer.failed())
+				ret = EXIT_FAILURE;
+
+			if (!expected.empty())
+			{
+				if (frames < expected.size())
+				{
+					fprintf(stderr, "Replayed %u frames, but %u checksums were expected.\n",
+					        frames, unsigned(expected.size()));
+					mismatches++;
+				}
+				printf("%s: %u checksum mismatches.\n", mismatches ? "FAILED" : "PASSED", mismatches);
+				if (mismatches)
+					ret = EXIT_FAILURE;
+			}
+		}
+	}
+
+	if (checksum_file)
+		fclose(checksum_file);
+	fclose(file);
+	return ret;
+}